@@ -0,0 +1,386 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <cmath>
+#include <sstream>
+#include <vector>
+#include "m3d/Aabb.h"
+using namespace std;
+namespace M3d {
+
+
+/*
+ * Task computing the bounds of chunks of a point array.
+ */
+class Aabb::PointsReduction : public ParallelTask {
+public:
+// Methods
+    PointsReduction(const Vec3* points, const Vec3Array* array, size_t chunks);
+    Aabb getResult() const;
+    virtual void run(size_t chunk, size_t begin, size_t end);
+private:
+// Attributes
+    const Vec3* points;
+    const Vec3Array* array;
+    vector<Aabb> results;
+// Helpers
+    static void findRange(const double* values, size_t size, double& lower, double& upper);
+};
+
+// HELPERS
+
+/*
+ * Returns the smaller of two values.
+ */
+static inline double minimum(double a, double b) {
+    return (a < b) ? a : b;
+}
+
+/*
+ * Returns the larger of two values.
+ */
+static inline double maximum(double a, double b) {
+    return (a > b) ? a : b;
+}
+
+// METHODS
+
+/**
+ * Constructs an empty box.
+ */
+Aabb::Aabb() : lower(HUGE_VAL), upper(-HUGE_VAL) {
+    // pass
+}
+
+/**
+ * Constructs a box around a single point.
+ *
+ * @param point Point to use for both corners
+ */
+Aabb::Aabb(const Vec3& point) : lower(point), upper(point) {
+    // pass
+}
+
+/**
+ * Constructs a box from its corners.
+ *
+ * @param lower Minimum corner
+ * @param upper Maximum corner
+ */
+Aabb::Aabb(const Vec3& lower, const Vec3& upper) : lower(lower), upper(upper) {
+    // pass
+}
+
+/**
+ * Computes the bounds of an array of points.
+ *
+ * Large arrays are split across threads.
+ *
+ * @param points Array of points
+ * @param size Number of points in the array
+ * @return Smallest box containing all the points, or an empty box if there are none
+ */
+Aabb Aabb::fromPoints(const Vec3* points, size_t size) {
+    PointsReduction reduction(points, NULL, Parallel::countChunks(size, GRAIN_SIZE));
+    Parallel::run(reduction, size, GRAIN_SIZE);
+    return reduction.getResult();
+}
+
+/**
+ * Computes the bounds of an array of points stored as separate component arrays.
+ *
+ * Each component is reduced separately in a loop the compiler can vectorize, and large arrays are split across
+ * threads.
+ *
+ * @param points Array of points
+ * @return Smallest box containing all the points, or an empty box if there are none
+ */
+Aabb Aabb::fromPoints(const Vec3Array& points) {
+    const size_t size = points.size();
+    PointsReduction reduction(NULL, &points, Parallel::countChunks(size, GRAIN_SIZE));
+    Parallel::run(reduction, size, GRAIN_SIZE);
+    return reduction.getResult();
+}
+
+/**
+ * Checks if a point is inside or on the box.
+ *
+ * @param point Point to check
+ * @return `true` if the point is inside or on the box
+ */
+bool Aabb::contains(const Vec3& point) const {
+    return (point.x >= lower.x) && (point.x <= upper.x)
+            && (point.y >= lower.y) && (point.y <= upper.y)
+            && (point.z >= lower.z) && (point.z <= upper.z);
+}
+
+/**
+ * Checks if another box is completely inside this box.
+ *
+ * @param box Box to check, which should not be empty
+ * @return `true` if the box is inside or on this box
+ */
+bool Aabb::contains(const Aabb& box) const {
+    return (box.lower.x >= lower.x) && (box.upper.x <= upper.x)
+            && (box.lower.y >= lower.y) && (box.upper.y <= upper.y)
+            && (box.lower.z >= lower.z) && (box.upper.z <= upper.z);
+}
+
+/**
+ * Returns the point halfway between the corners.
+ */
+Vec3 Aabb::getCenter() const {
+    return (lower + upper) * 0.5;
+}
+
+/**
+ * Returns the size of the box along each axis.
+ */
+Vec3 Aabb::getExtent() const {
+    return upper - lower;
+}
+
+/**
+ * Returns the total area of the box's six faces, or zero if the box is empty.
+ */
+double Aabb::getSurfaceArea() const {
+    if (isEmpty()) {
+        return 0;
+    }
+    const Vec3 e = upper - lower;
+    return 2 * ((e.x * e.y) + (e.y * e.z) + (e.z * e.x));
+}
+
+/**
+ * Checks if another box overlaps this box.
+ *
+ * @param box Box to check
+ * @return `true` if the boxes overlap or touch
+ */
+bool Aabb::intersects(const Aabb& box) const {
+    return (box.lower.x <= upper.x) && (box.upper.x >= lower.x)
+            && (box.lower.y <= upper.y) && (box.upper.y >= lower.y)
+            && (box.lower.z <= upper.z) && (box.upper.z >= lower.z);
+}
+
+/**
+ * Checks if the box contains no points.
+ */
+bool Aabb::isEmpty() const {
+    return (lower.x > upper.x) || (lower.y > upper.y) || (lower.z > upper.z);
+}
+
+/**
+ * Grows the box to include a point.
+ *
+ * @param point Point to include
+ */
+void Aabb::merge(const Vec3& point) {
+    lower = min(lower, point);
+    upper = max(upper, point);
+}
+
+/**
+ * Grows the box to include another box.
+ *
+ * @param box Box to include
+ */
+void Aabb::merge(const Aabb& box) {
+    lower = min(lower, box.lower);
+    upper = max(upper, box.upper);
+}
+
+/**
+ * Returns a string representation of the box.
+ */
+string Aabb::toString() const {
+    stringstream stream;
+    stream << (*this);
+    return stream.str();
+}
+
+// OPERATORS
+
+/**
+ * Checks if another box is equal to this one.
+ *
+ * @param box Box to compare
+ * @return `true` if both corners are exactly equal
+ */
+bool Aabb::operator==(const Aabb& box) const {
+    return (lower == box.lower) && (upper == box.upper);
+}
+
+/**
+ * Checks if another box is not equal to this one.
+ *
+ * @param box Box to compare
+ * @return `true` if either corner is not exactly equal
+ */
+bool Aabb::operator!=(const Aabb& box) const {
+    return (lower != box.lower) || (upper != box.upper);
+}
+
+// FRIENDS
+
+/**
+ * Computes the overlap of two boxes.
+ *
+ * @param a First box
+ * @param b Second box
+ * @return Box covering the overlap, which is empty if the boxes do not overlap
+ */
+Aabb intersection(const Aabb& a, const Aabb& b) {
+    return Aabb(max(a.lower, b.lower), min(a.upper, b.upper));
+}
+
+/**
+ * Computes the smallest box containing two boxes.
+ *
+ * @param a First box
+ * @param b Second box
+ * @return Box containing both boxes
+ */
+Aabb merge(const Aabb& a, const Aabb& b) {
+    return Aabb(min(a.lower, b.lower), max(a.upper, b.upper));
+}
+
+/**
+ * Computes the bounds of a box after it has been transformed by an affine matrix.
+ *
+ * Uses the method of Arvo from Graphics Gems, which finds each component of the new corners by summing the smaller
+ * and larger of each matrix element times the old corners, rather than transforming all eight corners.  The matrix's
+ * bottom row is assumed to be `(0, 0, 0, 1)`.
+ *
+ * @param mat Affine transformation to apply
+ * @param box Box to transform
+ * @return Smallest box containing the transformed box
+ */
+Aabb transform(const Mat4& mat, const Aabb& box) {
+
+    if (box.isEmpty()) {
+        return box;
+    }
+
+    const Vec4& translation = mat[3];
+    double lower[3] = { translation.x, translation.y, translation.z };
+    double upper[3] = { translation.x, translation.y, translation.z };
+
+    for (int j = 0; j < 3; ++j) {
+        const Vec4& column = mat[j];
+        const double l = box.lower[j];
+        const double u = box.upper[j];
+        for (int i = 0; i < 3; ++i) {
+            const double a = column[i] * l;
+            const double b = column[i] * u;
+            lower[i] += minimum(a, b);
+            upper[i] += maximum(a, b);
+        }
+    }
+    return Aabb(Vec3(lower), Vec3(upper));
+}
+
+// NESTED TYPES
+
+/**
+ * Constructs a reduction over either an array of points or an array of components.
+ *
+ * @param points Array of points, or `NULL` if using components
+ * @param array Array of components, or `NULL` if using points
+ * @param chunks Number of chunks the work will be split into
+ */
+Aabb::PointsReduction::PointsReduction(const Vec3* points, const Vec3Array* array, size_t chunks) :
+        points(points), array(array), results(chunks) {
+    // pass
+}
+
+/**
+ * Combines the bounds of all the chunks.
+ */
+Aabb Aabb::PointsReduction::getResult() const {
+    Aabb result;
+    for (size_t i = 0; i < results.size(); ++i) {
+        result.merge(results[i]);
+    }
+    return result;
+}
+
+/**
+ * Computes the bounds of one chunk.
+ */
+void Aabb::PointsReduction::run(size_t chunk, size_t begin, size_t end) {
+    Aabb& result = results[chunk];
+    if (array != NULL) {
+        findRange(&array->x[begin], end - begin, result.lower.x, result.upper.x);
+        findRange(&array->y[begin], end - begin, result.lower.y, result.upper.y);
+        findRange(&array->z[begin], end - begin, result.lower.z, result.upper.z);
+    } else {
+        for (size_t i = begin; i < end; ++i) {
+            result.merge(points[i]);
+        }
+    }
+}
+
+/*
+ * Finds the smallest and largest of a run of values.
+ *
+ * Keeps four independent running results so the comparisons do not depend on each other, which lets the compiler
+ * pack them into vector instructions without reordering a floating-point reduction.
+ */
+void Aabb::PointsReduction::findRange(const double* values, size_t size, double& lower, double& upper) {
+
+    double l[4] = { lower, lower, lower, lower };
+    double u[4] = { upper, upper, upper, upper };
+    size_t i = 0;
+
+    for (; i + 4 <= size; i += 4) {
+        for (int k = 0; k < 4; ++k) {
+            l[k] = minimum(l[k], values[i + k]);
+            u[k] = maximum(u[k], values[i + k]);
+        }
+    }
+    for (; i < size; ++i) {
+        l[0] = minimum(l[0], values[i]);
+        u[0] = maximum(u[0], values[i]);
+    }
+
+    lower = minimum(minimum(l[0], l[1]), minimum(l[2], l[3]));
+    upper = maximum(maximum(u[0], u[1]), maximum(u[2], u[3]));
+}
+
+} /* namespace M3d */
+
+/**
+ * Appends a box to a stream.
+ *
+ * @param stream Stream to append to
+ * @param box Box to append
+ * @return Reference to the stream
+ */
+ostream& operator<<(ostream& stream, const M3d::Aabb& box) {
+    stream << '[' << box.lower << ", " << box.upper << ']';
+    return stream;
+}
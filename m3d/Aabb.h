@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_AABB_H
+#define M3D_AABB_H
+#include "m3d/common.h"
+#include <iostream>
+#include <string>
+#include "m3d/Mat4.h"
+#include "m3d/Parallel.h"
+#include "m3d/Vec3.h"
+#include "m3d/Vec3Array.h"
+namespace M3d {
+
+
+/**
+ * Axis-aligned bounding box.
+ *
+ * A box is empty when any component of its lower corner is greater than the same component of its upper corner.  The
+ * default box is empty with infinite corners, so merging anything into it gives the bounds of that thing.
+ */
+class Aabb {
+public:
+// Attributes
+    Vec3 lower; ///< Minimum corner
+    Vec3 upper; ///< Maximum corner
+// Methods
+    explicit Aabb();
+    explicit Aabb(const Vec3& point);
+    explicit Aabb(const Vec3& lower, const Vec3& upper);
+    static Aabb fromPoints(const Vec3* points, size_t size);
+    static Aabb fromPoints(const Vec3Array& points);
+    bool contains(const Vec3& point) const;
+    bool contains(const Aabb& box) const;
+    Vec3 getCenter() const;
+    Vec3 getExtent() const;
+    double getSurfaceArea() const;
+    bool intersects(const Aabb& box) const;
+    bool isEmpty() const;
+    void merge(const Vec3& point);
+    void merge(const Aabb& box);
+    std::string toString() const;
+// Operators
+    bool operator==(const Aabb& box) const;
+    bool operator!=(const Aabb& box) const;
+// Friends
+    friend Aabb intersection(const Aabb& a, const Aabb& b);
+    friend Aabb merge(const Aabb& a, const Aabb& b);
+    friend Aabb transform(const Mat4& mat, const Aabb& box);
+private:
+// Types
+    class PointsReduction;
+// Constants
+    static const size_t GRAIN_SIZE = 65536;
+};
+
+Aabb intersection(const Aabb& a, const Aabb& b);
+Aabb merge(const Aabb& a, const Aabb& b);
+Aabb transform(const Mat4& mat, const Aabb& box);
+
+} /* namespace M3d */
+
+std::ostream& operator<<(std::ostream& stream, const M3d::Aabb& box);
+#endif
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cstdlib>
+#include <vector>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/Aabb.h"
+#include "m3d/Math.h"
+#include "m3d/Parallel.h"
+#include "m3d/Quat.h"
+using namespace std;
+
+/*
+ * Constants
+ */
+const double TOLERANCE = 1e-9;
+
+
+/**
+ * Unit test for Aabb.
+ */
+class AabbTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + (upper - lower) * (rand() / (double) RAND_MAX);
+    }
+
+    /**
+     * Checks that two vectors are equal within tolerance.
+     */
+    static void assertVectorsEqual(const M3d::Vec3& expected, const M3d::Vec3& actual) {
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.x, actual.x, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.y, actual.y, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.z, actual.z, TOLERANCE);
+    }
+
+public:
+
+    /**
+     * Restores the default concurrency after each test case.
+     */
+    void tearDown() {
+        M3d::Parallel::setConcurrency(0);
+    }
+
+    /**
+     * Ensures the default box is empty and merging into it gives the merged bounds.
+     */
+    void testConstructor() {
+        M3d::Aabb box;
+        CPPUNIT_ASSERT(box.isEmpty());
+        CPPUNIT_ASSERT_EQUAL(0.0, box.getSurfaceArea());
+        box.merge(M3d::Vec3(1, 2, 3));
+        CPPUNIT_ASSERT(!box.isEmpty());
+        CPPUNIT_ASSERT(box == M3d::Aabb(M3d::Vec3(1, 2, 3)));
+    }
+
+    /**
+     * Ensures merging boxes and points works correctly.
+     */
+    void testMerge() {
+        M3d::Aabb a(M3d::Vec3(0, 0, 0), M3d::Vec3(1, 1, 1));
+        M3d::Aabb b(M3d::Vec3(-1, 2, 0.5), M3d::Vec3(0, 3, 0.75));
+        M3d::Aabb c = M3d::merge(a, b);
+        CPPUNIT_ASSERT(c.lower == M3d::Vec3(-1, 0, 0));
+        CPPUNIT_ASSERT(c.upper == M3d::Vec3(1, 3, 1));
+        a.merge(b);
+        CPPUNIT_ASSERT(a == c);
+        a.merge(M3d::Vec3(5, -5, 0));
+        CPPUNIT_ASSERT(a.lower == M3d::Vec3(-1, -5, 0));
+        CPPUNIT_ASSERT(a.upper == M3d::Vec3(5, 3, 1));
+    }
+
+    /**
+     * Ensures contains works with points and boxes.
+     */
+    void testContains() {
+        const M3d::Aabb box(M3d::Vec3(0, 0, 0), M3d::Vec3(2, 2, 2));
+        CPPUNIT_ASSERT(box.contains(M3d::Vec3(1, 1, 1)));
+        CPPUNIT_ASSERT(box.contains(M3d::Vec3(2, 0, 2)));
+        CPPUNIT_ASSERT(!box.contains(M3d::Vec3(2.1, 1, 1)));
+        CPPUNIT_ASSERT(box.contains(M3d::Aabb(M3d::Vec3(0.5, 0.5, 0.5), M3d::Vec3(1, 2, 1))));
+        CPPUNIT_ASSERT(!box.contains(M3d::Aabb(M3d::Vec3(0.5, 0.5, 0.5), M3d::Vec3(1, 3, 1))));
+    }
+
+    /**
+     * Ensures intersects and intersection work correctly.
+     */
+    void testIntersects() {
+        const M3d::Aabb a(M3d::Vec3(0, 0, 0), M3d::Vec3(2, 2, 2));
+        const M3d::Aabb b(M3d::Vec3(1, 1, 1), M3d::Vec3(3, 3, 3));
+        const M3d::Aabb c(M3d::Vec3(3, 0, 0), M3d::Vec3(4, 1, 1));
+        CPPUNIT_ASSERT(a.intersects(b));
+        CPPUNIT_ASSERT(!a.intersects(c));
+        CPPUNIT_ASSERT(M3d::intersection(a, b) == M3d::Aabb(M3d::Vec3(1, 1, 1), M3d::Vec3(2, 2, 2)));
+        CPPUNIT_ASSERT(M3d::intersection(a, c).isEmpty());
+    }
+
+    /**
+     * Ensures the center, extent and surface area are computed correctly.
+     */
+    void testMeasurements() {
+        const M3d::Aabb box(M3d::Vec3(1, 2, 3), M3d::Vec3(2, 4, 6));
+        CPPUNIT_ASSERT(box.getCenter() == M3d::Vec3(1.5, 3, 4.5));
+        CPPUNIT_ASSERT(box.getExtent() == M3d::Vec3(1, 2, 3));
+        CPPUNIT_ASSERT_EQUAL(22.0, box.getSurfaceArea());
+    }
+
+    /**
+     * Ensures the bounds of points are the same whether stored as vectors or components, and with several threads.
+     */
+    void testFromPoints() {
+
+        const size_t n = 200003;
+        vector<M3d::Vec3> points(n);
+        M3d::Aabb expected;
+        for (size_t i = 0; i < n; ++i) {
+            points[i] = M3d::Vec3(random(-5, 5), random(-10, 1), random(3, 4));
+            expected.merge(points[i]);
+        }
+        const M3d::Vec3Array array = M3d::Vec3Array::fromVec3s(&points[0], n);
+
+        M3d::Parallel::setConcurrency(4);
+        CPPUNIT_ASSERT(M3d::Aabb::fromPoints(&points[0], n) == expected);
+        CPPUNIT_ASSERT(M3d::Aabb::fromPoints(array) == expected);
+        M3d::Parallel::setConcurrency(1);
+        CPPUNIT_ASSERT(M3d::Aabb::fromPoints(array) == expected);
+        CPPUNIT_ASSERT(M3d::Aabb::fromPoints(M3d::Vec3Array()).isEmpty());
+    }
+
+    /**
+     * Ensures transform gives the same bounds as transforming all eight corners.
+     */
+    void testTransform() {
+
+        const M3d::Aabb box(M3d::Vec3(-1, 2, 0), M3d::Vec3(3, 5, 1));
+        const M3d::Quat q = M3d::Quat::fromAxisAngle(M3d::normalize(M3d::Vec3(1, 2, 3)), M3d::toRadians(40));
+        M3d::Mat4 mat = q.toMat4();
+        mat[0] *= 2;
+        mat[3] = M3d::Vec4(7, -3, 2, 1);
+
+        M3d::Aabb expected;
+        for (int i = 0; i < 8; ++i) {
+            const M3d::Vec3 corner((i & 1) ? box.upper.x : box.lower.x,
+                                   (i & 2) ? box.upper.y : box.lower.y,
+                                   (i & 4) ? box.upper.z : box.lower.z);
+            expected.merge((mat * M3d::Vec4(corner, 1)).toVec3());
+        }
+
+        const M3d::Aabb actual = M3d::transform(mat, box);
+        assertVectorsEqual(expected.lower, actual.lower);
+        assertVectorsEqual(expected.upper, actual.upper);
+        CPPUNIT_ASSERT(M3d::transform(mat, M3d::Aabb()).isEmpty());
+    }
+
+    /**
+     * Ensures toString works correctly.
+     */
+    void testToString() {
+        const M3d::Aabb box(M3d::Vec3(1, 2, 3), M3d::Vec3(4, 5, 6));
+        CPPUNIT_ASSERT_EQUAL(string("[[1, 2, 3], [4, 5, 6]]"), box.toString());
+    }
+
+    CPPUNIT_TEST_SUITE(AabbTest);
+    CPPUNIT_TEST(testConstructor);
+    CPPUNIT_TEST(testMerge);
+    CPPUNIT_TEST(testContains);
+    CPPUNIT_TEST(testIntersects);
+    CPPUNIT_TEST(testMeasurements);
+    CPPUNIT_TEST(testFromPoints);
+    CPPUNIT_TEST(testTransform);
+    CPPUNIT_TEST(testToString);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(AabbTest::suite());
+    runner.run();
+    return 0;
+}
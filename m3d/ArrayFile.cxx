@@ -0,0 +1,802 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include "m3d/ArrayFile.h"
+using namespace std;
+namespace M3d {
+
+/* Elements must have exactly the layout of their components to be used in place */
+typedef char Vec3SizeCheck[(sizeof(Vec3) == 3 * sizeof(double)) ? 1 : -1];
+typedef char Vec4SizeCheck[(sizeof(Vec4) == 4 * sizeof(double)) ? 1 : -1];
+typedef char QuatSizeCheck[(sizeof(Quat) == 4 * sizeof(double)) ? 1 : -1];
+typedef char Mat3SizeCheck[(sizeof(Mat3) == 9 * sizeof(double)) ? 1 : -1];
+typedef char Mat4SizeCheck[(sizeof(Mat4) == 16 * sizeof(double)) ? 1 : -1];
+
+/* Constants */
+const char ArrayFile::MAGIC[4] = { 'M', '3', 'D', 'A' };
+
+
+/*
+ * Fixed-size block at the start of a file.
+ */
+struct ArrayFile::Header {
+    char magic[4];
+    uint32_t byteOrderMark;
+    uint32_t version;
+    uint32_t type;
+    uint32_t scalarSize;
+    uint32_t layout;
+    uint64_t count;
+    uint64_t checksum;
+    char reserved[24];
+};
+
+
+/*
+ * Task computing the running sums of the 32-bit words in a range.
+ */
+class ArrayFile::ChecksumTask : public ParallelTask {
+public:
+    ChecksumTask(const char* bytes, vector<uint64_t>& sums) : bytes(bytes), sums(sums) { }
+    virtual void run(size_t chunk, size_t begin, size_t end) {
+        uint64_t a = 0;
+        uint64_t b = 0;
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t word;
+            memcpy(&word, bytes + (i * 4), 4);
+            a += word;
+            b += a;
+        }
+        sums[2 * chunk] = a;
+        sums[(2 * chunk) + 1] = b;
+    }
+private:
+    const char* bytes;
+    vector<uint64_t>& sums;
+};
+
+// METHODS
+
+/**
+ * Constructs a closed file.
+ */
+ArrayFile::ArrayFile() : data(NULL), type(VEC3), layout(INTERLEAVED), scalarSize(0), count(0), checksum(0) {
+    // pass
+}
+
+/**
+ * Closes the file.
+ */
+ArrayFile::~ArrayFile() {
+    close();
+}
+
+/**
+ * Releases the file's memory, making any pointers to its elements invalid.
+ */
+void ArrayFile::close() {
+    file.close();
+    data = NULL;
+    count = 0;
+}
+
+/**
+ * Returns the number of scalars in each element of a type.
+ *
+ * @throws invalid_argument if the type is unknown
+ */
+size_t ArrayFile::countComponents(Type type) {
+    switch (type) {
+    case VEC3:
+        return 3;
+    case VEC4:
+    case QUAT:
+        return 4;
+    case MAT3:
+        return 9;
+    case MAT4:
+        return 16;
+    default:
+        throw invalid_argument("[ArrayFile] Unknown type!");
+    }
+}
+
+/**
+ * Computes the checksum stored in a file's header for a block of bytes, on several threads.
+ *
+ * The checksum is a pair of Fletcher-style running sums over the bytes read as native 32-bit words, with any bytes
+ * left over padded with zeroes.
+ *
+ * @param data Start of the bytes
+ * @param size Number of bytes
+ * @return Checksum of the bytes
+ */
+uint64_t ArrayFile::findChecksum(const void* data, size_t size) {
+    uint64_t sums[2] = { 0, 0 };
+    addSums(data, size, sums);
+    return (sums[1] << 32) ^ sums[0];
+}
+
+/**
+ * Returns the number of elements in the file.
+ */
+size_t ArrayFile::getCount() const {
+    return count;
+}
+
+/**
+ * Returns the start of the elements, as stored.
+ *
+ * @throws logic_error if the file is not open
+ */
+const void* ArrayFile::getData() const {
+    if (data == NULL) {
+        throw logic_error("[ArrayFile] File is not open!");
+    }
+    return data + HEADER_SIZE;
+}
+
+/**
+ * Returns the scalars of the file, if they are doubles.
+ *
+ * @throws logic_error if the file is not open or its scalars are not doubles
+ */
+const double* ArrayFile::getDoubles() const {
+    const void* const elements = getData();
+    if (scalarSize != sizeof(double)) {
+        throw logic_error("[ArrayFile] Scalars are not doubles!");
+    }
+    return static_cast<const double*>(elements);
+}
+
+/**
+ * Returns the scalars of the file, if they are floats.
+ *
+ * @throws logic_error if the file is not open or its scalars are not floats
+ */
+const float* ArrayFile::getFloats() const {
+    const void* const elements = getData();
+    if (scalarSize != sizeof(float)) {
+        throw logic_error("[ArrayFile] Scalars are not floats!");
+    }
+    return static_cast<const float*>(elements);
+}
+
+/**
+ * Returns the order of components in the file.
+ */
+ArrayFile::Layout ArrayFile::getLayout() const {
+    return layout;
+}
+
+/**
+ * Returns the elements of the file as matrices, if they are stored that way.
+ *
+ * @throws logic_error if the file is not open or is not an interleaved file of three-by-three matrices of doubles
+ */
+const Mat3* ArrayFile::getMat3s() const {
+    return static_cast<const Mat3*>(getElements(MAT3));
+}
+
+/**
+ * Returns the elements of the file as matrices, if they are stored that way.
+ *
+ * @throws logic_error if the file is not open or is not an interleaved file of four-by-four matrices of doubles
+ */
+const Mat4* ArrayFile::getMat4s() const {
+    return static_cast<const Mat4*>(getElements(MAT4));
+}
+
+/**
+ * Returns the elements of the file as quaternions, if they are stored that way.
+ *
+ * @throws logic_error if the file is not open or is not an interleaved file of quaternions of doubles
+ */
+const Quat* ArrayFile::getQuats() const {
+    return static_cast<const Quat*>(getElements(QUAT));
+}
+
+/**
+ * Returns the number of bytes in each scalar, either four or eight.
+ */
+size_t ArrayFile::getScalarSize() const {
+    return scalarSize;
+}
+
+/**
+ * Returns the kind of element in the file.
+ */
+ArrayFile::Type ArrayFile::getType() const {
+    return type;
+}
+
+/**
+ * Returns the elements of the file as vectors, if they are stored that way.
+ *
+ * @throws logic_error if the file is not open or is not an interleaved file of three-component vectors of doubles
+ */
+const Vec3* ArrayFile::getVec3s() const {
+    return static_cast<const Vec3*>(getElements(VEC3));
+}
+
+/**
+ * Returns the elements of the file as vectors, if they are stored that way.
+ *
+ * @throws logic_error if the file is not open or is not an interleaved file of four-component vectors of doubles
+ */
+const Vec4* ArrayFile::getVec4s() const {
+    return static_cast<const Vec4*>(getElements(VEC4));
+}
+
+/**
+ * Checks if a file has been opened.
+ */
+bool ArrayFile::isOpen() const {
+    return data != NULL;
+}
+
+/**
+ * Opens a file, closing any file opened before.
+ *
+ * @param filename Path to the file
+ * @throws runtime_error if the file cannot be read, is not an array file, is from a newer version, was written on a
+ *         machine with a different byte order, or is too short for its elements
+ */
+void ArrayFile::open(const string& filename) {
+
+    close();
+    file.open(filename);
+    data = file.getData();
+    const size_t size = file.getSize();
+
+    Header header;
+    memset(&header, 0, sizeof(Header));
+    if (size >= HEADER_SIZE) {
+        memcpy(&header, data, sizeof(Header));
+    }
+    try {
+        checkHeader(header, size);
+    } catch (...) {
+        close();
+        throw;
+    }
+
+    type = (Type) header.type;
+    layout = (Layout) header.layout;
+    scalarSize = header.scalarSize;
+    count = (size_t) header.count;
+    checksum = header.checksum;
+}
+
+/**
+ * Copies the elements of a file of three-component vectors into an array, converting them if needed.
+ *
+ * @param arr Array to store vectors in, replacing its contents
+ * @throws logic_error if the file is not open or does not hold three-component vectors
+ */
+void ArrayFile::read(Vec3Array& arr) const {
+
+    const void* const elements = getData();
+    if (type != VEC3) {
+        throw logic_error("[ArrayFile] Elements are not three-component vectors!");
+    }
+
+    arr.resize(count);
+    if (count == 0) {
+        return;
+    }
+    double* const out[3] = { &arr.x[0], &arr.y[0], &arr.z[0] };
+    const size_t step = (layout == INTERLEAVED) ? 3 : 1;
+    const size_t stride = (layout == INTERLEAVED) ? 1 : count;
+    for (int c = 0; c < 3; ++c) {
+        if (scalarSize == sizeof(double)) {
+            const double* const in = static_cast<const double*>(elements) + (c * stride);
+            for (size_t i = 0; i < count; ++i) {
+                out[c][i] = in[i * step];
+            }
+        } else {
+            const float* const in = static_cast<const float*>(elements) + (c * stride);
+            for (size_t i = 0; i < count; ++i) {
+                out[c][i] = in[i * step];
+            }
+        }
+    }
+}
+
+/**
+ * Checks that the elements of the file match the checksum in its header, which reads the whole file.
+ *
+ * @throws logic_error if the file is not open
+ */
+bool ArrayFile::verify() const {
+    const void* const elements = getData();
+    return findChecksum(elements, count * countComponents(type) * scalarSize) == checksum;
+}
+
+/**
+ * Writes vectors to an interleaved file of doubles.
+ *
+ * @param filename Path to the file, which is replaced
+ * @param arr Vectors to write
+ * @throws runtime_error if the file cannot be written
+ */
+void ArrayFile::write(const string& filename, const vector<Vec3>& arr) {
+    write(filename, VEC3, sizeof(double), INTERLEAVED, arr.empty() ? NULL : &arr[0], arr.size());
+}
+
+/**
+ * Writes vectors to an interleaved file of doubles.
+ *
+ * @param filename Path to the file, which is replaced
+ * @param arr Vectors to write
+ * @throws runtime_error if the file cannot be written
+ */
+void ArrayFile::write(const string& filename, const vector<Vec4>& arr) {
+    write(filename, VEC4, sizeof(double), INTERLEAVED, arr.empty() ? NULL : &arr[0], arr.size());
+}
+
+/**
+ * Writes quaternions to an interleaved file of doubles.
+ *
+ * @param filename Path to the file, which is replaced
+ * @param arr Quaternions to write
+ * @throws runtime_error if the file cannot be written
+ */
+void ArrayFile::write(const string& filename, const vector<Quat>& arr) {
+    write(filename, QUAT, sizeof(double), INTERLEAVED, arr.empty() ? NULL : &arr[0], arr.size());
+}
+
+/**
+ * Writes matrices to an interleaved file of doubles, in column-major order.
+ *
+ * @param filename Path to the file, which is replaced
+ * @param arr Matrices to write
+ * @throws runtime_error if the file cannot be written
+ */
+void ArrayFile::write(const string& filename, const vector<Mat3>& arr) {
+    write(filename, MAT3, sizeof(double), INTERLEAVED, arr.empty() ? NULL : &arr[0], arr.size());
+}
+
+/**
+ * Writes matrices to an interleaved file of doubles, in column-major order.
+ *
+ * @param filename Path to the file, which is replaced
+ * @param arr Matrices to write
+ * @throws runtime_error if the file cannot be written
+ */
+void ArrayFile::write(const string& filename, const vector<Mat4>& arr) {
+    write(filename, MAT4, sizeof(double), INTERLEAVED, arr.empty() ? NULL : &arr[0], arr.size());
+}
+
+/**
+ * Writes an array of vectors to a planar file of doubles, without interleaving its components.
+ *
+ * @param filename Path to the file, which is replaced
+ * @param arr Vectors to write
+ * @throws runtime_error if the file cannot be written
+ */
+void ArrayFile::write(const string& filename, const Vec3Array& arr) {
+    const size_t size = arr.size();
+    const size_t bytes = size * sizeof(double);
+    const void* const parts[3] = { (size > 0) ? &arr.x[0] : NULL, (size > 0) ? &arr.y[0] : NULL,
+                                   (size > 0) ? &arr.z[0] : NULL };
+    const size_t sizes[3] = { bytes, bytes, bytes };
+    writeParts(filename, VEC3, sizeof(double), PLANAR, size, parts, sizes, 3);
+}
+
+/**
+ * Writes elements to a file.
+ *
+ * @param filename Path to the file, which is replaced
+ * @param type Kind of element
+ * @param scalarSize Number of bytes in each scalar, either four for floats or eight for doubles
+ * @param layout Order of the components in the data
+ * @param data Start of the elements
+ * @param count Number of elements
+ * @throws invalid_argument if the type, scalar size or layout is unknown
+ * @throws runtime_error if the file cannot be written
+ */
+void ArrayFile::write(const string& filename, Type type, size_t scalarSize, Layout layout, const void* data,
+                      size_t count) {
+    const void* const parts[1] = { data };
+    const size_t sizes[1] = { count * countComponents(type) * scalarSize };
+    writeParts(filename, type, scalarSize, layout, count, parts, sizes, 1);
+}
+
+// HELPERS
+
+/*
+ * Adds the words in a block of bytes to running sums, on several threads.
+ */
+void ArrayFile::addSums(const void* data, size_t size, uint64_t sums[2]) {
+
+    const char* const bytes = static_cast<const char*>(data);
+    const size_t words = size / 4;
+    const size_t chunks = Parallel::countChunks(words, GRAIN_SIZE);
+
+    // Sum each chunk on its own
+    vector<uint64_t> partial(2 * chunks);
+    ChecksumTask task(bytes, partial);
+    Parallel::run(task, words, GRAIN_SIZE);
+
+    // Join them in order, as if summed in one pass
+    for (size_t i = 0; i < chunks; ++i) {
+        const size_t begin = (words * i) / chunks;
+        const size_t end = (words * (i + 1)) / chunks;
+        sums[1] += partial[(2 * i) + 1] + ((end - begin) * sums[0]);
+        sums[0] += partial[2 * i];
+    }
+
+    // Pad the last word
+    if ((size % 4) != 0) {
+        uint32_t word = 0;
+        memcpy(&word, bytes + (words * 4), size % 4);
+        sums[0] += word;
+        sums[1] += sums[0];
+    }
+}
+
+/*
+ * Checks that a header is from a readable array file of a number of bytes.
+ */
+void ArrayFile::checkHeader(const Header& header, size_t size) {
+
+    if ((size < HEADER_SIZE) || (memcmp(header.magic, MAGIC, 4) != 0)) {
+        throw runtime_error("[ArrayFile] Not an array file!");
+    } else if (header.byteOrderMark != BYTE_ORDER_MARK) {
+        throw runtime_error("[ArrayFile] File has a different byte order!");
+    } else if ((header.version == 0) || (header.version > VERSION)) {
+        throw runtime_error("[ArrayFile] Unsupported version!");
+    } else if ((header.type < VEC3) || (header.type > MAT4)
+            || ((header.scalarSize != sizeof(float)) && (header.scalarSize != sizeof(double)))
+            || (header.layout > PLANAR)) {
+        throw runtime_error("[ArrayFile] Unsupported element format!");
+    }
+
+    const size_t elementSize = countComponents((Type) header.type) * header.scalarSize;
+    if (header.count > (size - HEADER_SIZE) / elementSize) {
+        throw runtime_error("[ArrayFile] File is too short!");
+    }
+}
+
+/*
+ * Returns the elements, checking they can be used as an array of a type.
+ */
+const void* ArrayFile::getElements(Type type) const {
+    const void* const elements = getData();
+    if ((this->type != type) || (scalarSize != sizeof(double)) || (layout != INTERLEAVED)) {
+        throw logic_error("[ArrayFile] Elements are not stored as requested!");
+    }
+    return elements;
+}
+
+/*
+ * Fills in a header for a file with elements having running sums.
+ */
+void ArrayFile::makeHeader(Header& header, Type type, size_t scalarSize, Layout layout, size_t count,
+                           const uint64_t sums[2]) {
+    memset(&header, 0, sizeof(Header));
+    memcpy(header.magic, MAGIC, 4);
+    header.byteOrderMark = BYTE_ORDER_MARK;
+    header.version = VERSION;
+    header.type = (uint32_t) type;
+    header.scalarSize = (uint32_t) scalarSize;
+    header.layout = (uint32_t) layout;
+    header.count = count;
+    header.checksum = (sums[1] << 32) ^ sums[0];
+}
+
+/*
+ * Writes a header and then blocks of bytes to a file, with the checksum covering all of the blocks.
+ */
+void ArrayFile::writeParts(const string& filename, Type type, size_t scalarSize, Layout layout, size_t count,
+                           const void* const parts[], const size_t sizes[], size_t n) {
+
+    if ((scalarSize != sizeof(float)) && (scalarSize != sizeof(double))) {
+        throw invalid_argument("[ArrayFile] Scalar size must be four or eight!");
+    } else if ((layout != INTERLEAVED) && (layout != PLANAR)) {
+        throw invalid_argument("[ArrayFile] Unknown layout!");
+    }
+
+    // Make header
+    uint64_t sums[2] = { 0, 0 };
+    for (size_t i = 0; i < n; ++i) {
+        addSums(parts[i], sizes[i], sums);
+    }
+    Header header;
+    makeHeader(header, type, scalarSize, layout, count, sums);
+
+    // Write it and the elements
+    ofstream file(filename.c_str(), ios::out | ios::binary | ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    for (size_t i = 0; i < n; ++i) {
+        file.write(static_cast<const char*>(parts[i]), sizes[i]);
+    }
+    file.close();
+    if (!file) {
+        throw runtime_error("[ArrayFile] Could not write file!");
+    }
+}
+
+// READER METHODS
+
+/**
+ * Constructs a closed reader.
+ */
+ArrayFile::Reader::Reader() : type(VEC3), layout(INTERLEAVED), scalarSize(0), count(0) {
+    // pass
+}
+
+/**
+ * Closes the file.
+ */
+void ArrayFile::Reader::close() {
+    if (file.is_open()) {
+        file.close();
+    }
+    file.clear();
+    count = 0;
+    vector<char>().swap(scratch);
+}
+
+/**
+ * Returns the number of elements in the file.
+ */
+size_t ArrayFile::Reader::getCount() const {
+    return count;
+}
+
+/**
+ * Returns the order of components in the file.
+ */
+ArrayFile::Layout ArrayFile::Reader::getLayout() const {
+    return layout;
+}
+
+/**
+ * Returns the number of bytes in each scalar, either four or eight.
+ */
+size_t ArrayFile::Reader::getScalarSize() const {
+    return scalarSize;
+}
+
+/**
+ * Returns the kind of element in the file.
+ */
+ArrayFile::Type ArrayFile::Reader::getType() const {
+    return type;
+}
+
+/**
+ * Checks if a file has been opened.
+ */
+bool ArrayFile::Reader::isOpen() const {
+    return file.is_open();
+}
+
+/**
+ * Opens a file and reads its header, closing any file opened before.
+ *
+ * @param filename Path to the file
+ * @throws runtime_error if the file cannot be read, is not an array file, is from a newer version, was written on a
+ *         machine with a different byte order, or is too short for its elements
+ */
+void ArrayFile::Reader::open(const string& filename) {
+
+    close();
+    file.open(filename.c_str(), ios::in | ios::binary);
+    if (!file) {
+        close();
+        throw runtime_error("[ArrayFile] Could not open file!");
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(Header));
+    file.seekg(0, ios::end);
+    const size_t size = (size_t) file.tellg();
+    file.seekg(0, ios::beg);
+    file.read(reinterpret_cast<char*>(&header), sizeof(Header));
+    try {
+        checkHeader(header, file ? size : 0);
+    } catch (...) {
+        close();
+        throw;
+    }
+
+    type = (Type) header.type;
+    layout = (Layout) header.layout;
+    scalarSize = header.scalarSize;
+    count = (size_t) header.count;
+}
+
+/**
+ * Copies a range of elements into a buffer, with their components interleaved.
+ *
+ * @param first Index of the first element to read
+ * @param count Number of elements to read
+ * @param buf Buffer with room for the elements, aligned for their scalars
+ * @throws logic_error if the file is not open
+ * @throws invalid_argument if the range is not inside the file
+ * @throws runtime_error if the file cannot be read
+ */
+void ArrayFile::Reader::read(size_t first, size_t count, void* buf) {
+
+    if (!file.is_open()) {
+        throw logic_error("[ArrayFile] File is not open!");
+    } else if ((first > this->count) || (count > this->count - first)) {
+        throw invalid_argument("[ArrayFile] Range is outside of file!");
+    }
+
+    const size_t components = countComponents(type);
+    char* const bytes = static_cast<char*>(buf);
+    file.clear();
+    if (layout == INTERLEAVED) {
+        const size_t elementSize = components * scalarSize;
+        file.seekg(HEADER_SIZE + (first * elementSize), ios::beg);
+        file.read(bytes, count * elementSize);
+    } else {
+        scratch.resize(count * scalarSize);
+        for (size_t c = 0; (c < components) && file && (count > 0); ++c) {
+            file.seekg(HEADER_SIZE + (((c * this->count) + first) * scalarSize), ios::beg);
+            file.read(&scratch[0], count * scalarSize);
+            for (size_t i = 0; i < count; ++i) {
+                memcpy(bytes + (((i * components) + c) * scalarSize), &scratch[i * scalarSize], scalarSize);
+            }
+        }
+    }
+    if (!file) {
+        throw runtime_error("[ArrayFile] Could not read file!");
+    }
+}
+
+// WRITER METHODS
+
+/**
+ * Constructs a closed writer.
+ */
+ArrayFile::Writer::Writer() : type(VEC3), scalarSize(0), count(0) {
+    sums[0] = 0;
+    sums[1] = 0;
+}
+
+/**
+ * Abandons the file if it is still open, leaving it empty.
+ */
+ArrayFile::Writer::~Writer() {
+    abandon();
+}
+
+/**
+ * Closes the file without completing the header, so it reads as empty, such as after an error partway through.
+ */
+void ArrayFile::Writer::abandon() {
+    if (file.is_open()) {
+        file.close();
+    }
+    file.clear();
+    count = 0;
+    sums[0] = 0;
+    sums[1] = 0;
+}
+
+/**
+ * Completes the header with the number of elements and the checksum, and closes the file.
+ *
+ * @throws runtime_error if the file cannot be written
+ */
+void ArrayFile::Writer::close() {
+
+    if (!file.is_open()) {
+        return;
+    }
+
+    Header header;
+    makeHeader(header, type, scalarSize, INTERLEAVED, count, sums);
+    file.seekp(0, ios::beg);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    file.close();
+    const bool failed = !file;
+    file.clear();
+    count = 0;
+    sums[0] = 0;
+    sums[1] = 0;
+    if (failed) {
+        throw runtime_error("[ArrayFile] Could not write file!");
+    }
+}
+
+/**
+ * Returns the number of elements written so far.
+ */
+size_t ArrayFile::Writer::getCount() const {
+    return count;
+}
+
+/**
+ * Checks if a file has been opened.
+ */
+bool ArrayFile::Writer::isOpen() const {
+    return file.is_open();
+}
+
+/**
+ * Starts a file, closing any file opened before.
+ *
+ * @param filename Path to the file, which is replaced
+ * @param type Kind of element
+ * @param scalarSize Number of bytes in each scalar, either four for floats or eight for doubles
+ * @throws invalid_argument if the type or scalar size is unknown
+ * @throws runtime_error if the file cannot be written
+ */
+void ArrayFile::Writer::open(const string& filename, Type type, size_t scalarSize) {
+
+    close();
+    countComponents(type);
+    if ((scalarSize != sizeof(float)) && (scalarSize != sizeof(double))) {
+        throw invalid_argument("[ArrayFile] Scalar size must be four or eight!");
+    }
+    this->type = type;
+    this->scalarSize = scalarSize;
+
+    Header header;
+    makeHeader(header, type, scalarSize, INTERLEAVED, 0, sums);
+    file.open(filename.c_str(), ios::out | ios::binary | ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    file.flush();
+    if (!file) {
+        file.close();
+        file.clear();
+        throw runtime_error("[ArrayFile] Could not write file!");
+    }
+}
+
+/**
+ * Appends elements to the file.
+ *
+ * @param data Start of the elements, with their components interleaved
+ * @param count Number of elements
+ * @throws logic_error if the file is not open
+ * @throws runtime_error if the file cannot be written
+ */
+void ArrayFile::Writer::write(const void* data, size_t count) {
+
+    if (!file.is_open()) {
+        throw logic_error("[ArrayFile] File is not open!");
+    }
+
+    const size_t size = count * countComponents(type) * scalarSize;
+    addSums(data, size, sums);
+    file.write(static_cast<const char*>(data), size);
+    if (!file) {
+        throw runtime_error("[ArrayFile] Could not write file!");
+    }
+    this->count += count;
+}
+
+} /* namespace M3d */
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_ARRAYFILE_H
+#define M3D_ARRAYFILE_H
+#include "m3d/common.h"
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "m3d/MappedFile.h"
+#include "m3d/Mat3.h"
+#include "m3d/Mat4.h"
+#include "m3d/Parallel.h"
+#include "m3d/Quat.h"
+#include "m3d/Vec3.h"
+#include "m3d/Vec3Array.h"
+#include "m3d/Vec4.h"
+namespace M3d {
+
+
+/**
+ * Binary file holding an array of vectors, quaternions or matrices that can be used in place once opened.
+ *
+ * A file is a 64-byte header followed directly by the elements.  The header records a version, the element type, the
+ * width of each scalar, whether components are interleaved per element or stored as one run per component, the number
+ * of elements, and a checksum of the elements.  Scalars are stored in the byte order of the machine that wrote them;
+ * files from a machine with a different byte order are rejected when opened.
+ *
+ * Opening a file maps it into memory where the system supports it, so nothing is parsed or copied and elements are
+ * only paged in as they are touched.  Interleaved files of doubles have exactly the layout of arrays of Vec3, Vec4,
+ * Quat, Mat3 or Mat4 (matrices in column-major order), and can be used directly as such.  Checksums are only checked
+ * when `verify` is called, since doing so reads the whole file.  Files too large to map can be read and written a range
+ * of elements at a time with a Reader and a Writer.
+ */
+class ArrayFile {
+public:
+// Types
+    /** Kind of element stored */
+    enum Type { VEC3 = 1, VEC4 = 2, QUAT = 3, MAT3 = 4, MAT4 = 5 };
+    /** Order of components */
+    enum Layout { INTERLEAVED = 0, PLANAR = 1 };
+    class Reader;
+    class Writer;
+// Constants
+    static const uint32_t VERSION = 1; ///< Version of the format written
+    static const size_t HEADER_SIZE = 64; ///< Number of bytes before the elements
+// Methods
+    explicit ArrayFile();
+    ~ArrayFile();
+    void close();
+    static size_t countComponents(Type type);
+    static uint64_t findChecksum(const void* data, size_t size);
+    size_t getCount() const;
+    const void* getData() const;
+    const double* getDoubles() const;
+    const float* getFloats() const;
+    Layout getLayout() const;
+    const Mat3* getMat3s() const;
+    const Mat4* getMat4s() const;
+    const Quat* getQuats() const;
+    size_t getScalarSize() const;
+    Type getType() const;
+    const Vec3* getVec3s() const;
+    const Vec4* getVec4s() const;
+    bool isOpen() const;
+    void open(const std::string& filename);
+    void read(Vec3Array& arr) const;
+    bool verify() const;
+    static void write(const std::string& filename, const std::vector<Vec3>& arr);
+    static void write(const std::string& filename, const std::vector<Vec4>& arr);
+    static void write(const std::string& filename, const std::vector<Quat>& arr);
+    static void write(const std::string& filename, const std::vector<Mat3>& arr);
+    static void write(const std::string& filename, const std::vector<Mat4>& arr);
+    static void write(const std::string& filename, const Vec3Array& arr);
+    static void write(const std::string& filename, Type type, size_t scalarSize, Layout layout, const void* data,
+                      size_t count);
+// Friends
+    friend class Reader;
+    friend class Writer;
+private:
+// Types
+    struct Header;
+    class ChecksumTask;
+// Constants
+    static const char MAGIC[4];
+    static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+    static const size_t GRAIN_SIZE = 1048576;
+// Attributes
+    MappedFile file;
+    const char* data;
+    Type type;
+    Layout layout;
+    size_t scalarSize;
+    size_t count;
+    uint64_t checksum;
+// Helpers
+    ArrayFile(const ArrayFile&);
+    ArrayFile& operator=(const ArrayFile&);
+    static void addSums(const void* data, size_t size, uint64_t sums[2]);
+    static void checkHeader(const Header& header, size_t size);
+    const void* getElements(Type type) const;
+    static void makeHeader(Header& header, Type type, size_t scalarSize, Layout layout, size_t count,
+                           const uint64_t sums[2]);
+    static void writeParts(const std::string& filename, Type type, size_t scalarSize, Layout layout, size_t count,
+                           const void* const parts[], const size_t sizes[], size_t n);
+};
+
+
+/**
+ * Reads ranges of elements from an array file, without holding the whole file in memory.
+ *
+ * Ranges of elements are copied into a caller's buffer with their components interleaved, whatever the layout of the
+ * file, so files larger than memory can be processed in pieces.  Checksums are not checked.
+ */
+class ArrayFile::Reader {
+public:
+// Methods
+    explicit Reader();
+    void close();
+    size_t getCount() const;
+    Layout getLayout() const;
+    size_t getScalarSize() const;
+    Type getType() const;
+    bool isOpen() const;
+    void open(const std::string& filename);
+    void read(size_t first, size_t count, void* buf);
+private:
+// Attributes
+    std::ifstream file;
+    Type type;
+    Layout layout;
+    size_t scalarSize;
+    size_t count;
+    std::vector<char> scratch;
+// Helpers
+    Reader(const Reader&);
+    Reader& operator=(const Reader&);
+};
+
+
+/**
+ * Writes an interleaved array file a range of elements at a time.
+ *
+ * The header is written when the file is opened and completed with the number of elements and the checksum only when
+ * `close` is called, so a file that was abandoned, or never closed before the writer was destroyed, reads as empty.
+ */
+class ArrayFile::Writer {
+public:
+// Methods
+    explicit Writer();
+    ~Writer();
+    void abandon();
+    void close();
+    size_t getCount() const;
+    bool isOpen() const;
+    void open(const std::string& filename, Type type, size_t scalarSize);
+    void write(const void* data, size_t count);
+private:
+// Attributes
+    std::ofstream file;
+    Type type;
+    size_t scalarSize;
+    size_t count;
+    uint64_t sums[2];
+// Helpers
+    Writer(const Writer&);
+    Writer& operator=(const Writer&);
+};
+
+} /* namespace M3d */
+#endif
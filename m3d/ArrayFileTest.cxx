@@ -0,0 +1,332 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/ArrayFile.h"
+using namespace std;
+
+/*
+ * Constants
+ */
+const char* FILENAME = "ArrayFileTest.bin";
+
+
+/**
+ * Unit test for ArrayFile.
+ */
+class ArrayFileTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + (upper - lower) * (rand() / (double) RAND_MAX);
+    }
+
+    /**
+     * Replaces the byte at an offset in the test file.
+     */
+    static void overwrite(size_t offset, char value) {
+        fstream file(FILENAME, ios::in | ios::out | ios::binary);
+        file.seekp(offset);
+        file.put(value);
+    }
+
+public:
+
+    /**
+     * Removes the test file and resets the number of threads.
+     */
+    void tearDown() {
+        remove(FILENAME);
+        M3d::Parallel::setConcurrency(0);
+    }
+
+    /**
+     * Ensures checksums are the same on any number of threads and match running sums over each word.
+     */
+    void testFindChecksum() {
+        vector<uint32_t> words(3000001);
+        uint64_t a = 0;
+        uint64_t b = 0;
+        for (size_t i = 0; i < words.size(); ++i) {
+            words[i] = (uint32_t) rand();
+            a += words[i];
+            b += a;
+        }
+        const uint64_t expected = (b << 32) ^ a;
+
+        M3d::Parallel::setConcurrency(1);
+        CPPUNIT_ASSERT_EQUAL(expected, M3d::ArrayFile::findChecksum(&words[0], words.size() * 4));
+        M3d::Parallel::setConcurrency(4);
+        CPPUNIT_ASSERT_EQUAL(expected, M3d::ArrayFile::findChecksum(&words[0], words.size() * 4));
+
+        const char bytes[6] = { 1, 0, 0, 0, 2, 0 };
+        CPPUNIT_ASSERT_EQUAL((((uint64_t) 4) << 32) ^ 3, M3d::ArrayFile::findChecksum(bytes, 6));
+    }
+
+    /**
+     * Ensures opening a missing, foreign, truncated or damaged file is caught.
+     */
+    void testOpenInvalid() {
+        M3d::ArrayFile file;
+        CPPUNIT_ASSERT_THROW(file.open("ArrayFileTest.missing"), runtime_error);
+        CPPUNIT_ASSERT(!file.isOpen());
+        CPPUNIT_ASSERT_THROW(file.getData(), logic_error);
+
+        ofstream foreign(FILENAME, ios::out | ios::binary);
+        foreign << "Not an array file at all, but long enough to hold a header if it were one. ";
+        foreign.close();
+        CPPUNIT_ASSERT_THROW(file.open(FILENAME), runtime_error);
+
+        vector<M3d::Vec3> vecs(10, M3d::Vec3(1, 2, 3));
+        M3d::ArrayFile::write(FILENAME, vecs);
+        overwrite(4, 9);
+        CPPUNIT_ASSERT_THROW(file.open(FILENAME), runtime_error);
+
+        M3d::ArrayFile::write(FILENAME, vecs);
+        overwrite(24, 11);
+        CPPUNIT_ASSERT_THROW(file.open(FILENAME), runtime_error);
+        CPPUNIT_ASSERT(!file.isOpen());
+
+        M3d::ArrayFile::write(FILENAME, vecs);
+        overwrite(M3d::ArrayFile::HEADER_SIZE + 5, 7);
+        file.open(FILENAME);
+        CPPUNIT_ASSERT(!file.verify());
+    }
+
+    /**
+     * Ensures a file can be written and read a range of elements at a time.
+     */
+    void testReaderAndWriter() {
+        M3d::Vec3Array arr(100);
+        for (size_t i = 0; i < arr.size(); ++i) {
+            arr.set(i, M3d::Vec3(random(-10, 10), random(-10, 10), random(-10, 10)));
+        }
+        vector<M3d::Vec3> vecs(arr.size());
+        arr.toVec3s(&vecs[0]);
+
+        // Write in pieces, which should match writing all at once
+        M3d::ArrayFile::Writer writer;
+        CPPUNIT_ASSERT_THROW(writer.write(&vecs[0], 1), logic_error);
+        CPPUNIT_ASSERT_THROW(writer.open(FILENAME, M3d::ArrayFile::VEC3, 2), invalid_argument);
+        writer.open(FILENAME, M3d::ArrayFile::VEC3, sizeof(double));
+        writer.write(&vecs[0], 30);
+        writer.write(&vecs[30], 0);
+        writer.write(&vecs[30], 70);
+        CPPUNIT_ASSERT_EQUAL((size_t) 100, writer.getCount());
+        writer.close();
+        CPPUNIT_ASSERT(!writer.isOpen());
+        M3d::ArrayFile file;
+        file.open(FILENAME);
+        CPPUNIT_ASSERT(file.verify());
+        CPPUNIT_ASSERT_EQUAL((size_t) 100, file.getCount());
+        CPPUNIT_ASSERT_EQUAL(0, memcmp(&vecs[0], file.getVec3s(), 100 * sizeof(M3d::Vec3)));
+        file.close();
+
+        // Read ranges back from interleaved and planar files
+        M3d::ArrayFile::Reader reader;
+        M3d::Vec3 buf[10];
+        CPPUNIT_ASSERT_THROW(reader.read(0, 1, buf), logic_error);
+        for (int i = 0; i < 2; ++i) {
+            if (i == 1) {
+                M3d::ArrayFile::write(FILENAME, arr);
+            }
+            reader.open(FILENAME);
+            CPPUNIT_ASSERT_EQUAL((size_t) 100, reader.getCount());
+            CPPUNIT_ASSERT_EQUAL((i == 0) ? M3d::ArrayFile::INTERLEAVED : M3d::ArrayFile::PLANAR, reader.getLayout());
+            reader.read(95, 5, buf);
+            reader.read(10, 10, buf);
+            CPPUNIT_ASSERT_EQUAL(0, memcmp(&vecs[10], buf, 10 * sizeof(M3d::Vec3)));
+            CPPUNIT_ASSERT_THROW(reader.read(95, 6, buf), invalid_argument);
+        }
+
+        // Files that were never closed read as empty
+        writer.open(FILENAME, M3d::ArrayFile::QUAT, sizeof(float));
+        writer.write(&vecs[0], 3);
+        reader.open(FILENAME);
+        CPPUNIT_ASSERT_EQUAL(M3d::ArrayFile::QUAT, reader.getType());
+        CPPUNIT_ASSERT_EQUAL((size_t) 4, reader.getScalarSize());
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, reader.getCount());
+        writer.close();
+        reader.open(FILENAME);
+        CPPUNIT_ASSERT_EQUAL((size_t) 3, reader.getCount());
+
+        // Files abandoned or left open when the writer is destroyed read as empty
+        writer.open(FILENAME, M3d::ArrayFile::VEC3, sizeof(double));
+        writer.write(&vecs[0], 5);
+        writer.abandon();
+        CPPUNIT_ASSERT(!writer.isOpen());
+        reader.open(FILENAME);
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, reader.getCount());
+        {
+            M3d::ArrayFile::Writer scoped;
+            scoped.open(FILENAME, M3d::ArrayFile::VEC3, sizeof(double));
+            scoped.write(&vecs[0], 5);
+        }
+        file.open(FILENAME);
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, file.getCount());
+        file.close();
+        remove(FILENAME);
+        CPPUNIT_ASSERT_THROW(reader.open(FILENAME), runtime_error);
+        CPPUNIT_ASSERT(!reader.isOpen());
+    }
+
+    /**
+     * Ensures an array of vectors is written without interleaving and can be read back into an array.
+     */
+    void testWriteVec3Array() {
+        M3d::Vec3Array arr(100);
+        for (size_t i = 0; i < arr.size(); ++i) {
+            arr.set(i, M3d::Vec3(random(-10, 10), random(-10, 10), random(-10, 10)));
+        }
+        M3d::ArrayFile::write(FILENAME, arr);
+
+        M3d::ArrayFile file;
+        file.open(FILENAME);
+        CPPUNIT_ASSERT(file.verify());
+        CPPUNIT_ASSERT_EQUAL(M3d::ArrayFile::PLANAR, file.getLayout());
+        CPPUNIT_ASSERT_THROW(file.getVec3s(), logic_error);
+        const double* const doubles = file.getDoubles();
+        for (size_t i = 0; i < arr.size(); ++i) {
+            CPPUNIT_ASSERT_EQUAL(arr.x[i], doubles[i]);
+            CPPUNIT_ASSERT_EQUAL(arr.y[i], doubles[arr.size() + i]);
+            CPPUNIT_ASSERT_EQUAL(arr.z[i], doubles[(2 * arr.size()) + i]);
+        }
+
+        M3d::Vec3Array copy;
+        file.read(copy);
+        CPPUNIT_ASSERT(copy.x == arr.x);
+        CPPUNIT_ASSERT(copy.y == arr.y);
+        CPPUNIT_ASSERT(copy.z == arr.z);
+    }
+
+    /**
+     * Ensures vectors of floats can be written and read back as doubles.
+     */
+    void testWriteFloats() {
+        vector<float> floats(30);
+        for (size_t i = 0; i < floats.size(); ++i) {
+            floats[i] = (float) random(-10, 10);
+        }
+        M3d::ArrayFile::write(FILENAME, M3d::ArrayFile::VEC3, sizeof(float), M3d::ArrayFile::INTERLEAVED, &floats[0],
+                              10);
+        CPPUNIT_ASSERT_THROW(M3d::ArrayFile::write(FILENAME, M3d::ArrayFile::VEC3, 2, M3d::ArrayFile::INTERLEAVED,
+                                                   &floats[0], 10), invalid_argument);
+
+        M3d::ArrayFile file;
+        file.open(FILENAME);
+        CPPUNIT_ASSERT(file.verify());
+        CPPUNIT_ASSERT_EQUAL((size_t) 4, file.getScalarSize());
+        CPPUNIT_ASSERT_THROW(file.getDoubles(), logic_error);
+        CPPUNIT_ASSERT_EQUAL(floats[29], file.getFloats()[29]);
+
+        M3d::Vec3Array arr;
+        file.read(arr);
+        CPPUNIT_ASSERT_EQUAL((size_t) 10, arr.size());
+        for (size_t i = 0; i < arr.size(); ++i) {
+            CPPUNIT_ASSERT_EQUAL((double) floats[3 * i], arr.x[i]);
+            CPPUNIT_ASSERT_EQUAL((double) floats[(3 * i) + 1], arr.y[i]);
+            CPPUNIT_ASSERT_EQUAL((double) floats[(3 * i) + 2], arr.z[i]);
+        }
+    }
+
+    /**
+     * Ensures matrices and quaternions written to a file can be used in place.
+     */
+    void testWriteMatrices() {
+        vector<M3d::Mat4> mats(50);
+        vector<M3d::Quat> quats(50);
+        for (size_t i = 0; i < mats.size(); ++i) {
+            for (int j = 0; j < 4; ++j) {
+                mats[i][j] = M3d::Vec4(random(-1, 1), random(-1, 1), random(-1, 1), random(-1, 1));
+            }
+            quats[i] = M3d::Quat(random(-1, 1), random(-1, 1), random(-1, 1), random(-1, 1));
+        }
+
+        M3d::ArrayFile file;
+        M3d::ArrayFile::write(FILENAME, mats);
+        file.open(FILENAME);
+        CPPUNIT_ASSERT(file.verify());
+        CPPUNIT_ASSERT_EQUAL(M3d::ArrayFile::MAT4, file.getType());
+        CPPUNIT_ASSERT_EQUAL(mats.size(), file.getCount());
+        CPPUNIT_ASSERT_THROW(file.getMat3s(), logic_error);
+        const M3d::Mat4* const loadedMats = file.getMat4s();
+        for (size_t i = 0; i < mats.size(); ++i) {
+            CPPUNIT_ASSERT(mats[i] == loadedMats[i]);
+        }
+
+        M3d::ArrayFile::write(FILENAME, quats);
+        file.open(FILENAME);
+        CPPUNIT_ASSERT(file.verify());
+        const M3d::Quat* const loadedQuats = file.getQuats();
+        for (size_t i = 0; i < quats.size(); ++i) {
+            CPPUNIT_ASSERT(quats[i] == loadedQuats[i]);
+        }
+        file.close();
+        CPPUNIT_ASSERT(!file.isOpen());
+    }
+
+    /**
+     * Ensures an empty list of vectors makes a valid file.
+     */
+    void testWriteEmpty() {
+        M3d::ArrayFile::write(FILENAME, vector<M3d::Vec3>());
+        M3d::ArrayFile file;
+        file.open(FILENAME);
+        CPPUNIT_ASSERT(file.verify());
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, file.getCount());
+        M3d::Vec3Array arr(5);
+        file.read(arr);
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, arr.size());
+    }
+
+    CPPUNIT_TEST_SUITE(ArrayFileTest);
+    CPPUNIT_TEST(testFindChecksum);
+    CPPUNIT_TEST(testOpenInvalid);
+    CPPUNIT_TEST(testReaderAndWriter);
+    CPPUNIT_TEST(testWriteEmpty);
+    CPPUNIT_TEST(testWriteFloats);
+    CPPUNIT_TEST(testWriteMatrices);
+    CPPUNIT_TEST(testWriteVec3Array);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(ArrayFileTest::suite());
+    runner.run();
+    return 0;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include <stdexcept>
+#include "m3d/Bitmask.h"
+using namespace std;
+namespace M3d {
+
+/**
+ * Checks if the bit for an object is set.
+ *
+ * @param mask Bitmask to check
+ * @param i Index of the object
+ * @return `true` if the bit is set
+ * @throws std::out_of_range if the mask does not have a bit for the object
+ */
+bool Bitmask::get(const vector<uint32_t>& mask, size_t i) {
+    if ((i / 32) >= mask.size()) {
+        throw out_of_range("[Bitmask] Index out of bounds!");
+    }
+    return (mask[i / 32] >> (i % 32)) & 1;
+}
+
+/**
+ * Sets bits for a block of objects with non-negative margins, clearing the rest.
+ *
+ * @param margin Margin of each object in the block, starting from the first object in the block
+ * @param begin Index of the first object in the block, which must be a multiple of 32
+ * @param end Index one past the last object in the block
+ * @param mask Bitmask for all the objects, with room for the block
+ * @return Number of bits set
+ */
+size_t Bitmask::setFromMargins(const double* margin, size_t begin, size_t end, uint32_t* mask) {
+    size_t count = 0;
+    for (size_t i = begin; i < end; i += 32) {
+        const size_t stop = std::min(i + 32, end);
+        uint32_t word = 0;
+        for (size_t k = i; k < stop; ++k) {
+            const uint32_t bit = (margin[k - begin] >= 0);
+            word |= bit << (k - i);
+            count += bit;
+        }
+        mask[i / 32] = word;
+    }
+    return count;
+}
+
+} /* namespace M3d */
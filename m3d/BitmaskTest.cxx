@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/Bitmask.h"
+using namespace std;
+
+
+/**
+ * Unit test for Bitmask.
+ */
+class BitmaskTest : public CppUnit::TestFixture {
+public:
+
+    /**
+     * Ensures setFromMargins sets bits for non-negative margins only and counts them.
+     */
+    void testSetFromMargins() {
+
+        const size_t n = 70;
+        double margin[n];
+        for (size_t i = 0; i < n; ++i) {
+            margin[i] = (i % 3 == 0) ? 0.5 : ((i % 3 == 1) ? 0.0 : -0.5);
+        }
+
+        vector<uint32_t> mask(3, 0);
+        const size_t count = M3d::Bitmask::setFromMargins(margin, 0, n, &mask[0]);
+
+        size_t expected = 0;
+        for (size_t i = 0; i < n; ++i) {
+            CPPUNIT_ASSERT_EQUAL(i % 3 != 2, M3d::Bitmask::get(mask, i));
+            expected += (i % 3 != 2) ? 1 : 0;
+        }
+        CPPUNIT_ASSERT_EQUAL(expected, count);
+    }
+
+    /**
+     * Ensures setFromMargins handles blocks that end inside a word and clears the rest of that word.
+     */
+    void testSetFromMarginsPartialWords() {
+
+        double margin[40];
+        for (size_t i = 0; i < 40; ++i) {
+            margin[i] = 1;
+        }
+
+        vector<uint32_t> mask(3, 0xFFFFFFFF);
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, M3d::Bitmask::setFromMargins(margin, 0, 0, &mask[0]));
+        margin[10] = -1;
+        CPPUNIT_ASSERT_EQUAL((size_t) 39, M3d::Bitmask::setFromMargins(margin, 32, 72, &mask[0]));
+        CPPUNIT_ASSERT(M3d::Bitmask::get(mask, 0));
+        CPPUNIT_ASSERT(M3d::Bitmask::get(mask, 32));
+        CPPUNIT_ASSERT(!M3d::Bitmask::get(mask, 42));
+        CPPUNIT_ASSERT(M3d::Bitmask::get(mask, 71));
+        CPPUNIT_ASSERT(!M3d::Bitmask::get(mask, 72));
+    }
+
+    /**
+     * Ensures get rejects indices out of bounds.
+     */
+    void testGetOutOfBounds() {
+        vector<uint32_t> mask(2, 0);
+        CPPUNIT_ASSERT_THROW(M3d::Bitmask::get(mask, 64), out_of_range);
+    }
+
+    CPPUNIT_TEST_SUITE(BitmaskTest);
+    CPPUNIT_TEST(testSetFromMargins);
+    CPPUNIT_TEST(testSetFromMarginsPartialWords);
+    CPPUNIT_TEST(testGetOutOfBounds);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(BitmaskTest::suite());
+    runner.run();
+    return 0;
+}
@@ -0,0 +1,909 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include "m3d/Bvh.h"
+using namespace std;
+namespace M3d {
+
+
+/*
+ * Recursive builder for a hierarchy.
+ */
+class Bvh::Builder {
+public:
+// Attributes
+    std::vector<uint32_t> indices;
+// Methods
+    Builder(const Aabb* boxes, size_t size, size_t leafSize);
+    void build(vector<Node>& nodes, size_t index, size_t begin, size_t end, int depth);
+private:
+// Types
+    class BinPredicate;
+// Attributes
+    const Aabb* boxes;
+    vector<Vec3> centroids;
+    size_t leafSize;
+    int parallelDepth;
+// Helpers
+    bool split(size_t begin, size_t end, const Aabb& centroidBounds, size_t& mid);
+};
+
+
+/*
+ * Checks if a primitive falls in a bin before the split.
+ */
+class Bvh::Builder::BinPredicate {
+public:
+    BinPredicate(const vector<Vec3>& centroids, int axis, double lower, double scale, size_t split) :
+            centroids(centroids), axis(axis), lower(lower), scale(scale), split(split) { }
+    static size_t findBin(double value, double lower, double scale) {
+        const size_t bin = (size_t) ((value - lower) * scale);
+        return (bin < BIN_COUNT) ? bin : (BIN_COUNT - 1);
+    }
+    bool operator()(uint32_t i) const {
+        return findBin(centroids[i][axis], lower, scale) < split;
+    }
+private:
+    const vector<Vec3>& centroids;
+    int axis;
+    double lower;
+    double scale;
+    size_t split;
+};
+
+
+/*
+ * Task building the two halves of a node on separate threads.
+ */
+class Bvh::SubtreeTask : public ParallelTask {
+public:
+    vector<Node> subtrees[2];
+    SubtreeTask(Builder& builder, size_t begin, size_t mid, size_t end, int depth) :
+            builder(builder), depth(depth) {
+        ranges[0] = begin;
+        ranges[1] = mid;
+        ranges[2] = end;
+    }
+    virtual void run(size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            subtrees[i].resize(1);
+            builder.build(subtrees[i], 0, ranges[i], ranges[i + 1], depth);
+        }
+    }
+private:
+    Builder& builder;
+    size_t ranges[3];
+    int depth;
+};
+
+
+/*
+ * Task finding the centers of a range of boxes.
+ */
+class Bvh::CenterTask : public ParallelTask {
+public:
+    CenterTask(const Aabb* boxes, Vec3* centers) : boxes(boxes), centers(centers) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            centers[i] = boxes[i].getCenter();
+        }
+    }
+private:
+    const Aabb* boxes;
+    Vec3* centers;
+};
+
+
+/*
+ * Task finding where the ranges of a linear hierarchy split, for a range of its interior nodes.
+ *
+ * Follows Karras, "Maximizing Parallelism in the Construction of BVHs, Octrees, and k-d Trees" (2012).  With sorted
+ * codes, interior node `i` covers a range starting or ending at `i`, which can be found independently of every other
+ * node by searching for how far the common prefix of the codes stays longer than it is with the neighbour on the
+ * other side.  Its split is where the prefix gets shorter.  Equal codes are told apart by their positions.
+ */
+template <typename K>
+class Bvh::SplitTask : public ParallelTask {
+public:
+    SplitTask(const K* codes, size_t size, uint32_t* splits) : codes(codes), size(size), splits(splits) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            splits[i] = findSplit((ptrdiff_t) i);
+        }
+    }
+private:
+    const K* codes;
+    size_t size;
+    uint32_t* splits;
+    static int countLeadingZeros(uint64_t x) {
+#ifdef __GNUC__
+        return (x == 0) ? 64 : __builtin_clzll(x);
+#else
+        int n = 0;
+        for (uint64_t bit = UINT64_C(1) << 63; bit != 0 && (x & bit) == 0; bit >>= 1) {
+            ++n;
+        }
+        return n;
+#endif
+    }
+    int findPrefix(ptrdiff_t i, ptrdiff_t j) const {
+        if (j < 0 || j >= (ptrdiff_t) size) {
+            return -1;
+        } else if (codes[i] != codes[j]) {
+            return countLeadingZeros((uint64_t) (codes[i] ^ codes[j]));
+        } else {
+            return 64 + countLeadingZeros((uint64_t) (i ^ j));
+        }
+    }
+    uint32_t findSplit(ptrdiff_t i) const {
+
+        // Find which way the range goes
+        const ptrdiff_t d = (findPrefix(i, i + 1) > findPrefix(i, i - 1)) ? 1 : -1;
+        const int minPrefix = findPrefix(i, i - d);
+
+        // Find the other end of the range
+        ptrdiff_t lengthMax = 2;
+        while (findPrefix(i, i + (lengthMax * d)) > minPrefix) {
+            lengthMax *= 2;
+        }
+        ptrdiff_t length = 0;
+        for (ptrdiff_t t = lengthMax / 2; t >= 1; t /= 2) {
+            if (findPrefix(i, i + ((length + t) * d)) > minPrefix) {
+                length += t;
+            }
+        }
+        const int nodePrefix = findPrefix(i, i + (length * d));
+
+        // Find where the prefix gets shorter
+        ptrdiff_t s = 0;
+        ptrdiff_t t = length;
+        do {
+            t = (t + 1) / 2;
+            if (findPrefix(i, i + ((s + t) * d)) > nodePrefix) {
+                s += t;
+            }
+        } while (t > 1);
+        return (uint32_t) (i + (s * d) + std::min(d, (ptrdiff_t) 0));
+    }
+};
+
+
+/*
+ * Task refitting separate subtrees on separate threads.
+ */
+class Bvh::RefitTask : public ParallelTask {
+public:
+    RefitTask(Bvh& bvh, const vector<size_t>& roots, const Aabb* boxes) : bvh(bvh), roots(roots), boxes(boxes) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            bvh.refitSubtree(roots[i], boxes);
+        }
+    }
+private:
+    Bvh& bvh;
+    const vector<size_t>& roots;
+    const Aabb* boxes;
+};
+
+// METHODS
+
+/**
+ * Constructs an empty hierarchy.
+ */
+Bvh::Bvh() : nodes(NULL), nodeCount(0) {
+    // pass
+}
+
+/**
+ * Destroys the hierarchy.
+ */
+Bvh::~Bvh() {
+    free(nodes);
+}
+
+/**
+ * Builds the hierarchy over an array of boxes, replacing anything built before.
+ *
+ * @param boxes Bounds of each primitive, which must not be empty
+ * @param size Number of primitives
+ * @param leafSize Largest number of primitives to put in a leaf, unless they cannot be separated
+ */
+void Bvh::build(const Aabb* boxes, size_t size, size_t leafSize) {
+
+    Builder builder(boxes, size, leafSize);
+    vector<Node> tree;
+
+    if (size > 0) {
+        tree.resize(1);
+        builder.build(tree, 0, 0, size, 0);
+    }
+    indices.swap(builder.indices);
+    setNodes(tree);
+}
+
+/**
+ * Builds the hierarchy quickly over a very large array of boxes, replacing anything built before.
+ *
+ * Centers of the boxes are given Morton codes, 30-bit for up to about a million boxes and 63-bit beyond that, and
+ * sorted with a radix sort.  Each interior node then finds its own range and split directly from the codes, and
+ * ranges small enough become leaves.  Every step except laying out the nodes runs on several threads.
+ *
+ * @param boxes Bounds of each primitive, which must not be empty
+ * @param size Number of primitives
+ * @param leafSize Largest number of primitives to put in a leaf, unless the tree would be too deep
+ */
+void Bvh::buildLinear(const Aabb* boxes, size_t size, size_t leafSize) {
+
+    vector<Node> tree;
+
+    indices.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+        indices[i] = (uint32_t) i;
+    }
+
+    if (size > 0) {
+
+        // Find the center of each box and the bounds of the centers
+        vector<Vec3> centers(size);
+        CenterTask task(boxes, &centers[0]);
+        Parallel::run(task, size, GRAIN_SIZE);
+        const Aabb bounds = Aabb::fromPoints(&centers[0], size);
+
+        // Sort the centers along the curve and split them
+        vector<uint32_t> splits(size - 1);
+        if (size <= MAX_SHORT_CODE_SIZE) {
+            findSplits<uint32_t>(centers, bounds, &indices[0], splits.empty() ? NULL : &splits[0]);
+        } else {
+            findSplits<uint64_t>(centers, bounds, &indices[0], &splits[0]);
+        }
+
+        // Lay out the nodes, collapsing small ranges into leaves
+        tree.resize(1);
+        linearize(tree, splits, 0, 0, 0, size - 1, (leafSize > 0) ? leafSize : 1, 0);
+    }
+    setNodes(tree);
+    refit(boxes);
+}
+
+/**
+ * Finds the closest primitive hit by a ray.
+ *
+ * Children are visited nearest first, and the search range shrinks as hits are found, so most primitives behind the
+ * closest hit are never tested.
+ *
+ * @param ray Ray to test
+ * @param tMax Largest distance along the ray to accept
+ * @param intersector Callback for testing the ray against individual primitives
+ * @param primitive Index of the primitive hit, set only if there is a hit
+ * @param t Distance to the hit, set only if there is a hit
+ * @return `true` if any primitive was hit
+ */
+bool Bvh::findClosest(const Ray& ray, double tMax, Intersector& intersector, size_t& primitive, double& t) const {
+
+    uint32_t stack[MAX_DEPTH];
+    int top = 0;
+    bool found = false;
+    double tNear;
+
+    if (nodeCount == 0 || !ray.intersects(nodes[0].bounds, tMax, tNear)) {
+        return false;
+    }
+
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (!ray.intersects(node.bounds, tMax, tNear)) {
+            continue;
+        } else if (node.isLeaf()) {
+            for (uint32_t i = node.offset; i < node.offset + node.count; ++i) {
+                double tHit;
+                if (intersector.intersect(indices[i], ray, tMax, tHit)) {
+                    tMax = tHit;
+                    primitive = indices[i];
+                    t = tHit;
+                    found = true;
+                }
+            }
+        } else {
+            double tLeft, tRight;
+            const bool hitLeft = ray.intersects(nodes[node.offset].bounds, tMax, tLeft);
+            const bool hitRight = ray.intersects(nodes[node.offset + 1].bounds, tMax, tRight);
+            if (hitLeft && hitRight) {
+                const bool leftFirst = (tLeft <= tRight);
+                stack[top++] = leftFirst ? (node.offset + 1) : node.offset;
+                stack[top++] = leftFirst ? node.offset : (node.offset + 1);
+            } else if (hitLeft) {
+                stack[top++] = node.offset;
+            } else if (hitRight) {
+                stack[top++] = node.offset + 1;
+            }
+        }
+    }
+    return found;
+}
+
+/**
+ * Finds the primitives in leaves hit by a ray.
+ *
+ * @param ray Ray to test
+ * @param tMax Largest distance along the ray to accept
+ * @param result List to store indices of primitives in, which is cleared first
+ */
+void Bvh::findIntersections(const Ray& ray, double tMax, vector<size_t>& result) const {
+
+    uint32_t stack[MAX_DEPTH];
+    int top = 0;
+    double tNear;
+
+    result.clear();
+    if (nodeCount == 0) {
+        return;
+    }
+
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (!ray.intersects(node.bounds, tMax, tNear)) {
+            continue;
+        } else if (node.isLeaf()) {
+            for (uint32_t i = node.offset; i < node.offset + node.count; ++i) {
+                result.push_back(indices[i]);
+            }
+        } else {
+            stack[top++] = node.offset + 1;
+            stack[top++] = node.offset;
+        }
+    }
+}
+
+/**
+ * Finds the primitives in leaves overlapping a box.
+ *
+ * @param box Box to test
+ * @param result List to store indices of primitives in, which is cleared first
+ */
+void Bvh::findOverlaps(const Aabb& box, vector<size_t>& result) const {
+
+    uint32_t stack[MAX_DEPTH];
+    int top = 0;
+
+    result.clear();
+    if (nodeCount == 0) {
+        return;
+    }
+
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (!box.intersects(node.bounds)) {
+            continue;
+        } else if (node.isLeaf()) {
+            for (uint32_t i = node.offset; i < node.offset + node.count; ++i) {
+                result.push_back(indices[i]);
+            }
+        } else {
+            stack[top++] = node.offset + 1;
+            stack[top++] = node.offset;
+        }
+    }
+}
+
+/**
+ * Returns the bounds of all the primitives, or an empty box if there are none.
+ */
+Aabb Bvh::getBounds() const {
+    return (nodeCount > 0) ? nodes[0].bounds : Aabb();
+}
+
+/**
+ * Computes the surface area heuristic cost of the tree.
+ *
+ * Visiting a node and testing a primitive are both given a cost of one, and each is weighted by the surface area of
+ * its node relative to the root, which is roughly the chance a random ray hitting the root also hits the node.
+ *
+ * @return Expected cost of a ray hitting the root, or zero if the tree is empty or flat
+ */
+double Bvh::getCost() const {
+
+    if (nodeCount == 0 || nodes[0].bounds.getSurfaceArea() <= 0) {
+        return 0;
+    }
+
+    double cost = 0;
+    for (size_t i = 0; i < nodeCount; ++i) {
+        const double area = nodes[i].bounds.getSurfaceArea();
+        cost += nodes[i].isLeaf() ? (area * nodes[i].count) : area;
+    }
+    return cost / nodes[0].bounds.getSurfaceArea();
+}
+
+/**
+ * Returns the array of primitive indices that leaves refer to.
+ */
+const uint32_t* Bvh::getIndices() const {
+    return indices.empty() ? NULL : &indices[0];
+}
+
+/**
+ * Returns the number of nodes in the hierarchy.
+ */
+size_t Bvh::getNodeCount() const {
+    return nodeCount;
+}
+
+/**
+ * Returns the array of nodes, where the first node is the root.
+ */
+const Bvh::Node* Bvh::getNodes() const {
+    return nodes;
+}
+
+/**
+ * Returns the number of primitives the hierarchy was built from.
+ */
+size_t Bvh::getSize() const {
+    return indices.size();
+}
+
+/**
+ * Updates the bounds of every node after primitives have moved, without changing the tree.
+ *
+ * Subtrees below the top few levels are refit on separate threads, then the top levels are refit from them.
+ *
+ * @param boxes New bounds of each primitive, in the same order and with the same size as when built
+ */
+void Bvh::refit(const Aabb* boxes) {
+
+    if (nodeCount == 0) {
+        return;
+    }
+
+    // Split the top of the tree until there are a few subtrees for each thread
+    const size_t target = (Parallel::getConcurrency() > 1) ? (Parallel::getConcurrency() * 4) : 1;
+    vector<size_t> top, queue(1, 0);
+    size_t head = 0;
+    while ((head < queue.size()) && ((queue.size() - head) < target)) {
+        const size_t index = queue[head];
+        if (nodes[index].isLeaf()) {
+            break;
+        }
+        top.push_back(index);
+        queue.push_back(nodes[index].offset);
+        queue.push_back(nodes[index].offset + 1);
+        ++head;
+    }
+    const vector<size_t> roots(queue.begin() + head, queue.end());
+
+    // Refit the subtrees, then the nodes above them from the bottom up
+    RefitTask task(*this, roots, boxes);
+    Parallel::run(task, roots.size(), 1);
+    for (size_t i = top.size(); i > 0; --i) {
+        Node& node = nodes[top[i - 1]];
+        node.bounds = merge(nodes[node.offset].bounds, nodes[node.offset + 1].bounds);
+    }
+}
+
+/**
+ * Updates the bounds of the nodes above some primitives that have moved, without changing the tree.
+ *
+ * Only the leaves holding the primitives and the nodes above them are updated, stopping early where a node's bounds
+ * did not change.  Use the other version when most primitives have moved.
+ *
+ * @param boxes New bounds of each primitive, in the same order and with the same size as when built
+ * @param changed Indices of primitives that moved
+ * @param count Number of primitives that moved
+ * @throws std::out_of_range if an index is not less than the number of primitives
+ */
+void Bvh::refit(const Aabb* boxes, const size_t* changed, size_t count) {
+
+    for (size_t i = 0; i < count; ++i) {
+        if (changed[i] >= leaves.size()) {
+            throw out_of_range("[Bvh] Index out of bounds!");
+        }
+        size_t index = leaves[changed[i]];
+        if (!refitLeaf(index, boxes)) {
+            continue;
+        }
+        while (index != 0) {
+            Node& parent = nodes[nodes[index].parent];
+            const Aabb bounds = merge(nodes[parent.offset].bounds, nodes[parent.offset + 1].bounds);
+            if (bounds == parent.bounds) {
+                break;
+            }
+            parent.bounds = bounds;
+            index = nodes[index].parent;
+        }
+    }
+}
+
+/**
+ * Improves the tree by swapping children with grandchildren where that lowers the surface area heuristic cost.
+ *
+ * Following Kensler's tree rotations, each interior node is visited from the bottom up, and each of its children is
+ * tried in place of each child of the other child.  The bounds of the node itself do not change, so the swap that
+ * shrinks the other child the most is taken.  Swaps that would make the tree too deep for queries are skipped.
+ *
+ * @return Number of swaps made
+ */
+size_t Bvh::rotate() {
+
+    size_t count = 0;
+
+    if (nodeCount > 0) {
+        rotateSubtree(0, 0, count);
+    }
+    return count;
+}
+
+// HELPERS
+
+/*
+ * Sorts centers by their Morton codes and finds the split of each interior node of a linear hierarchy.
+ */
+template <typename K>
+void Bvh::findSplits(const vector<Vec3>& centers, const Aabb& bounds, uint32_t* order, uint32_t* splits) {
+
+    const size_t size = centers.size();
+    vector<K> codes(size);
+
+    findMortonCodes(&centers[0], size, bounds, &codes[0]);
+    sortMortonCodes(&codes[0], order, size);
+
+    SplitTask<K> task(&codes[0], size, splits);
+    Parallel::run(task, size - 1, GRAIN_SIZE);
+}
+
+/*
+ * Copies the subtree under an interior node of a linear hierarchy into a tree, depth first.
+ *
+ * The left child of a node split at `s` covers up to `s` and is the interior node `s`, and the right child covers from
+ * `s + 1` and is the interior node `s + 1`.
+ */
+void Bvh::linearize(vector<Node>& tree, const vector<uint32_t>& splits, size_t slot, size_t split, size_t first,
+                    size_t last, size_t leafSize, int depth) {
+
+    if ((last - first + 1) <= leafSize || depth >= (MAX_DEPTH - 1)) {
+        tree[slot].offset = (uint32_t) first;
+        tree[slot].count = (uint32_t) (last - first + 1);
+        return;
+    }
+
+    const size_t middle = splits[split];
+    const size_t child = tree.size();
+    tree.resize(child + 2);
+    tree[slot].offset = (uint32_t) child;
+    tree[slot].count = 0;
+    linearize(tree, splits, child, middle, first, middle, leafSize, depth + 1);
+    linearize(tree, splits, child + 1, middle + 1, middle + 1, last, leafSize, depth + 1);
+}
+
+/*
+ * Updates the bounds of a leaf from its primitives, returning `true` if they changed.
+ */
+bool Bvh::refitLeaf(size_t index, const Aabb* boxes) {
+
+    Node& node = nodes[index];
+    Aabb bounds;
+
+    for (uint32_t i = node.offset; i < node.offset + node.count; ++i) {
+        bounds.merge(boxes[indices[i]]);
+    }
+    if (bounds == node.bounds) {
+        return false;
+    }
+    node.bounds = bounds;
+    return true;
+}
+
+/*
+ * Updates the bounds of every node in a subtree from the bottom up.
+ */
+void Bvh::refitSubtree(size_t index, const Aabb* boxes) {
+
+    Node& node = nodes[index];
+
+    if (node.isLeaf()) {
+        refitLeaf(index, boxes);
+    } else {
+        refitSubtree(node.offset, boxes);
+        refitSubtree(node.offset + 1, boxes);
+        node.bounds = merge(nodes[node.offset].bounds, nodes[node.offset + 1].bounds);
+    }
+}
+
+/*
+ * Rotates the nodes in a subtree from the bottom up, returning an upper bound on the subtree's height.
+ */
+int Bvh::rotateSubtree(size_t index, int depth, size_t& count) {
+
+    if (nodes[index].isLeaf()) {
+        return 0;
+    }
+
+    const size_t first = nodes[index].offset;
+    int heights[2];
+    heights[0] = rotateSubtree(first, depth + 1, count);
+    heights[1] = rotateSubtree(first + 1, depth + 1, count);
+
+    // Find the swap that shrinks the other child the most
+    double bestGain = 0;
+    size_t bestChild = 0, bestGrandchild = 0;
+    for (size_t side = 0; side < 2; ++side) {
+        const size_t child = first + side;
+        const Node& sibling = nodes[first + 1 - side];
+        if (sibling.isLeaf() || (depth + 2 + heights[side]) > (MAX_DEPTH - 1)) {
+            continue;
+        }
+        for (size_t g = 0; g < 2; ++g) {
+            const Aabb bounds = merge(nodes[child].bounds, nodes[sibling.offset + 1 - g].bounds);
+            const double gain = sibling.bounds.getSurfaceArea() - bounds.getSurfaceArea();
+            if (gain > bestGain) {
+                bestGain = gain;
+                bestChild = child;
+                bestGrandchild = sibling.offset + g;
+            }
+        }
+    }
+    if (bestGain <= 0) {
+        return 1 + std::max(heights[0], heights[1]);
+    }
+
+    // Swap them and fix the bounds of the other child
+    const size_t side = bestChild - first;
+    Node& sibling = nodes[first + 1 - side];
+    swapNodes(bestChild, bestGrandchild);
+    sibling.bounds = merge(nodes[sibling.offset].bounds, nodes[sibling.offset + 1].bounds);
+    ++count;
+    return 1 + std::max(heights[1 - side], heights[side] + 1);
+}
+
+/*
+ * Points the children of a node back at it, or the primitives of a leaf.
+ */
+void Bvh::setChildren(size_t index) {
+
+    const Node& node = nodes[index];
+
+    if (node.isLeaf()) {
+        for (uint32_t i = node.offset; i < node.offset + node.count; ++i) {
+            leaves[indices[i]] = (uint32_t) index;
+        }
+    } else {
+        nodes[node.offset].parent = (uint32_t) index;
+        nodes[node.offset + 1].parent = (uint32_t) index;
+    }
+}
+
+/*
+ * Exchanges the subtrees at two slots, leaving each slot with the same parent.
+ */
+void Bvh::swapNodes(size_t a, size_t b) {
+
+    const uint32_t parentOfA = nodes[a].parent;
+    const uint32_t parentOfB = nodes[b].parent;
+
+    std::swap(nodes[a], nodes[b]);
+    nodes[a].parent = parentOfA;
+    nodes[b].parent = parentOfB;
+    setChildren(a);
+    setChildren(b);
+}
+
+/*
+ * Copies nodes into cache-aligned storage, and links nodes to their parents and primitives to their leaves.
+ */
+void Bvh::setNodes(const vector<Node>& tree) {
+
+    free(nodes);
+    nodes = NULL;
+    nodeCount = tree.size();
+    leaves.assign(indices.size(), 0);
+    if (nodeCount == 0) {
+        return;
+    }
+
+    void* ptr;
+    if (posix_memalign(&ptr, sizeof(Node), nodeCount * sizeof(Node)) != 0) {
+        nodeCount = 0;
+        throw bad_alloc();
+    }
+    memcpy(ptr, &tree[0], nodeCount * sizeof(Node));
+    nodes = (Node*) ptr;
+
+    nodes[0].parent = 0;
+    for (size_t i = 0; i < nodeCount; ++i) {
+        setChildren(i);
+    }
+}
+
+/*
+ * Moves a subtree built on its own into a tree, with its root at a slot already reserved for it.
+ *
+ * Nodes after the root of the subtree are appended, so a child index `i` in the subtree becomes `base + i - 1`.
+ */
+void Bvh::splice(vector<Node>& nodes, size_t slot, const vector<Node>& subtree) {
+
+    const uint32_t shift = nodes.size() - 1;
+
+    nodes[slot] = subtree[0];
+    if (!nodes[slot].isLeaf()) {
+        nodes[slot].offset += shift;
+    }
+    for (size_t i = 1; i < subtree.size(); ++i) {
+        nodes.push_back(subtree[i]);
+        if (!subtree[i].isLeaf()) {
+            nodes.back().offset += shift;
+        }
+    }
+}
+
+// NESTED TYPES
+
+/**
+ * Checks if the node is a leaf.
+ */
+bool Bvh::Node::isLeaf() const {
+    return count > 0;
+}
+
+/**
+ * Destroys the intersector.
+ */
+Bvh::Intersector::~Intersector() {
+    // pass
+}
+
+/*
+ * Prepares to build a hierarchy, computing the center of each box.
+ */
+Bvh::Builder::Builder(const Aabb* boxes, size_t size, size_t leafSize) :
+        indices(size), boxes(boxes), centroids(size), leafSize((leafSize > 0) ? leafSize : 1), parallelDepth(0) {
+
+    for (size_t i = 0; i < size; ++i) {
+        indices[i] = (uint32_t) i;
+        centroids[i] = boxes[i].getCenter();
+    }
+
+    // Split the upper levels across about one thread per processor
+    for (size_t n = 1; n < Parallel::getConcurrency(); n *= 2) {
+        ++parallelDepth;
+    }
+}
+
+/*
+ * Builds the subtree under a node from a range of primitives.
+ */
+void Bvh::Builder::build(vector<Node>& nodes, size_t index, size_t begin, size_t end, int depth) {
+
+    // Find bounds of primitives and their centers
+    Aabb bounds, centroidBounds;
+    for (size_t i = begin; i < end; ++i) {
+        bounds.merge(boxes[indices[i]]);
+        centroidBounds.merge(centroids[indices[i]]);
+    }
+    nodes[index].bounds = bounds;
+
+    // Make a leaf if the range is small enough or cannot be split
+    size_t mid;
+    if (((end - begin) <= leafSize) || (depth >= (MAX_DEPTH - 1)) || !split(begin, end, centroidBounds, mid)) {
+        nodes[index].offset = (uint32_t) begin;
+        nodes[index].count = (uint32_t) (end - begin);
+        return;
+    }
+
+    // Otherwise reserve a pair of children and build them
+    const size_t child = nodes.size();
+    nodes.resize(child + 2);
+    nodes[index].offset = (uint32_t) child;
+    nodes[index].count = 0;
+    if ((depth < parallelDepth) && ((end - begin) >= PARALLEL_SIZE)) {
+        SubtreeTask task(*this, begin, mid, end, depth + 1);
+        Parallel::run(task, 2, 1);
+        splice(nodes, child, task.subtrees[0]);
+        splice(nodes, child + 1, task.subtrees[1]);
+    } else {
+        build(nodes, child, begin, mid, depth + 1);
+        build(nodes, child + 1, mid, end, depth + 1);
+    }
+}
+
+/*
+ * Partitions a range of primitives at the bin boundary with the lowest surface area heuristic cost.
+ *
+ * The cost of a split is the surface area of each side times the number of primitives on it.
+ *
+ * @return `false` if all centers are in the same place and the range cannot be split
+ */
+bool Bvh::Builder::split(size_t begin, size_t end, const Aabb& centroidBounds, size_t& mid) {
+
+    const Vec3 extent = centroidBounds.getExtent();
+    double bestCost = HUGE_VAL;
+    size_t bestSplit = 0;
+    int bestAxis = -1;
+
+    for (int axis = 0; axis < 3; ++axis) {
+        if (extent[axis] <= 0) {
+            continue;
+        }
+
+        // Sort primitives into bins
+        const double lower = centroidBounds.lower[axis];
+        const double scale = BIN_COUNT / extent[axis];
+        Aabb bins[BIN_COUNT];
+        size_t counts[BIN_COUNT] = { 0 };
+        for (size_t i = begin; i < end; ++i) {
+            const uint32_t p = indices[i];
+            const size_t bin = BinPredicate::findBin(centroids[p][axis], lower, scale);
+            bins[bin].merge(boxes[p]);
+            ++counts[bin];
+        }
+
+        // Sweep from the right to find the cost of everything after each boundary
+        double rightCosts[BIN_COUNT];
+        Aabb right;
+        size_t rightCount = 0;
+        for (size_t b = BIN_COUNT - 1; b > 0; --b) {
+            right.merge(bins[b]);
+            rightCount += counts[b];
+            rightCosts[b] = right.getSurfaceArea() * rightCount;
+        }
+
+        // Sweep from the left, keeping the cheapest boundary with primitives on both sides
+        Aabb left;
+        size_t leftCount = 0;
+        for (size_t b = 0; b < BIN_COUNT - 1; ++b) {
+            left.merge(bins[b]);
+            leftCount += counts[b];
+            if (leftCount == 0 || leftCount == (end - begin)) {
+                continue;
+            }
+            const double cost = (left.getSurfaceArea() * leftCount) + rightCosts[b + 1];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestSplit = b + 1;
+                bestAxis = axis;
+            }
+        }
+    }
+
+    if (bestAxis < 0) {
+        return false;
+    }
+
+    // Move primitives before the boundary to the front of the range
+    const double lower = centroidBounds.lower[bestAxis];
+    const double scale = BIN_COUNT / extent[bestAxis];
+    const BinPredicate predicate(centroids, bestAxis, lower, scale, bestSplit);
+    mid = std::partition(indices.begin() + begin, indices.begin() + end, predicate) - indices.begin();
+    return true;
+}
+
+} /* namespace M3d */
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_BVH_H
+#define M3D_BVH_H
+#include "m3d/common.h"
+#include <stdint.h>
+#include <vector>
+#include "m3d/Aabb.h"
+#include "m3d/Morton.h"
+#include "m3d/Parallel.h"
+#include "m3d/Ray.h"
+#include "m3d/Vec3.h"
+namespace M3d {
+
+
+/**
+ * Bounding volume hierarchy over axis-aligned boxes.
+ *
+ * The hierarchy is a binary tree built top-down.  At each node the primitives are sorted into bins along each axis by
+ * the centers of their boxes, and the split between bins with the lowest surface area heuristic cost is chosen.  The
+ * two halves of the upper levels are built on separate threads.
+ *
+ * For very large inputs, `buildLinear` instead sorts the centers along a Morton curve and splits where the codes
+ * first differ, following Karras.  Every step runs on several threads in close to linear time, at the cost of a tree
+ * that is slower to query than one built with `build`.
+ *
+ * Nodes are stored in one array aligned to a cache line, with each node filling exactly one line.  The children of a
+ * node are stored next to each other, so a node only needs the index of its first child.  Leaves refer to a range of
+ * the primitive index array instead.
+ *
+ * Queries only know the bounds of the leaves, so they report every primitive in a leaf that passes.  Callers should
+ * test the reported primitives themselves if they need exact results.
+ *
+ * When primitives move, `refit` updates the bounds of the nodes without changing the tree, which is much cheaper than
+ * building it again.  The tree gets worse as primitives drift away from where it was built, so `rotate` can be called
+ * every so often to swap subtrees where that lowers the surface area heuristic cost.  Once the cost reported by
+ * `getCost` has grown too far, build the tree again.
+ */
+class Bvh {
+public:
+// Types
+    struct Node;
+    class Intersector;
+// Constants
+    static const size_t BIN_COUNT = 16; ///< Number of bins tried along each axis when splitting
+    static const size_t DEFAULT_LEAF_SIZE = 4; ///< Default largest number of primitives in a leaf
+// Methods
+    explicit Bvh();
+    ~Bvh();
+    void build(const Aabb* boxes, size_t size, size_t leafSize = DEFAULT_LEAF_SIZE);
+    void buildLinear(const Aabb* boxes, size_t size, size_t leafSize = DEFAULT_LEAF_SIZE);
+    bool findClosest(const Ray& ray, double tMax, Intersector& intersector, size_t& primitive, double& t) const;
+    void findIntersections(const Ray& ray, double tMax, std::vector<size_t>& result) const;
+    void findOverlaps(const Aabb& box, std::vector<size_t>& result) const;
+    Aabb getBounds() const;
+    double getCost() const;
+    const uint32_t* getIndices() const;
+    size_t getNodeCount() const;
+    const Node* getNodes() const;
+    size_t getSize() const;
+    void refit(const Aabb* boxes);
+    void refit(const Aabb* boxes, const size_t* changed, size_t count);
+    size_t rotate();
+private:
+// Types
+    class Builder;
+    class CenterTask;
+    class RefitTask;
+    template <typename K> class SplitTask;
+    class SubtreeTask;
+// Constants
+    static const size_t GRAIN_SIZE = 65536;
+    static const int MAX_DEPTH = 64;
+    static const size_t MAX_SHORT_CODE_SIZE = 1048576;
+    static const size_t PARALLEL_SIZE = 4096;
+// Attributes
+    Node* nodes;
+    size_t nodeCount;
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> leaves;
+// Helpers
+    Bvh(const Bvh&);
+    Bvh& operator=(const Bvh&);
+    template <typename K>
+    static void findSplits(const std::vector<Vec3>& centers, const Aabb& bounds, uint32_t* order, uint32_t* splits);
+    static void linearize(std::vector<Node>& tree, const std::vector<uint32_t>& splits, size_t slot, size_t split,
+                          size_t first, size_t last, size_t leafSize, int depth);
+    bool refitLeaf(size_t index, const Aabb* boxes);
+    void refitSubtree(size_t index, const Aabb* boxes);
+    int rotateSubtree(size_t index, int depth, size_t& count);
+    void setChildren(size_t index);
+    void setNodes(const std::vector<Node>& nodes);
+    void swapNodes(size_t a, size_t b);
+    static void splice(std::vector<Node>& nodes, size_t slot, const std::vector<Node>& subtree);
+};
+
+
+/**
+ * Node in a bounding volume hierarchy, sized to fill one 64-byte cache line.
+ */
+struct Bvh::Node {
+    Aabb bounds; ///< Bounds of everything under the node
+    uint32_t offset; ///< Index of first child if interior, or of first entry in the index array if a leaf
+    uint32_t count; ///< Number of primitives if a leaf, or zero if interior
+    uint32_t parent; ///< Index of parent node, or zero for the root
+    uint32_t reserved; ///< Padding to fill a cache line
+    bool isLeaf() const;
+};
+
+
+/**
+ * Callback for testing a ray against a primitive, used when finding the closest hit.
+ */
+class Bvh::Intersector {
+public:
+    virtual ~Intersector();
+    /**
+     * Tests a ray against a primitive.
+     *
+     * @param primitive Index of the primitive's box in the array the hierarchy was built from
+     * @param ray Ray to test
+     * @param tMax Largest distance along the ray to accept
+     * @param t Distance to the hit, to be set only if there is one
+     * @return `true` if the ray hits the primitive in [0 .. tMax]
+     */
+    virtual bool intersect(size_t primitive, const Ray& ray, double tMax, double& t) = 0;
+};
+
+} /* namespace M3d */
+#endif
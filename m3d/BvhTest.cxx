@@ -0,0 +1,472 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <stdint.h>
+#include <vector>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/Bvh.h"
+#include "m3d/Parallel.h"
+using namespace std;
+
+
+/**
+ * Intersector that treats each primitive as its box.
+ */
+class BoxIntersector : public M3d::Bvh::Intersector {
+public:
+    explicit BoxIntersector(const vector<M3d::Aabb>& boxes) : boxes(boxes) { }
+    virtual bool intersect(size_t primitive, const M3d::Ray& ray, double tMax, double& t) {
+        return ray.intersects(boxes[primitive], tMax, t);
+    }
+private:
+    const vector<M3d::Aabb>& boxes;
+};
+
+
+/**
+ * Unit test for Bvh.
+ */
+class BvhTest : public CppUnit::TestFixture {
+private:
+    vector<M3d::Aabb> boxes;
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + (upper - lower) * (rand() / (double) RAND_MAX);
+    }
+
+    /**
+     * Returns a random ray starting outside the boxes and aimed near their middle.
+     */
+    static M3d::Ray randomRay() {
+        const M3d::Vec3 origin(random(-20, 20), random(-20, 20), 20);
+        const M3d::Vec3 target(random(-5, 5), random(-5, 5), random(-5, 5));
+        return M3d::Ray(origin, target - origin);
+    }
+
+    /**
+     * Makes random small boxes in a cube.
+     */
+    void makeBoxes(size_t n) {
+        boxes.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            const M3d::Vec3 center(random(-10, 10), random(-10, 10), random(-10, 10));
+            const M3d::Vec3 size(random(0, 0.5), random(0, 0.5), random(0, 0.5));
+            boxes[i] = M3d::Aabb(center - size, center + size);
+        }
+    }
+
+    /**
+     * Checks that every primitive is referenced once and every node has the exact bounds of its children.
+     */
+    void assertValid(const M3d::Bvh& bvh) const {
+        const M3d::Bvh::Node* nodes = bvh.getNodes();
+        vector<int> seen(bvh.getSize(), 0);
+        for (size_t i = 0; i < bvh.getNodeCount(); ++i) {
+            M3d::Aabb bounds;
+            if (nodes[i].isLeaf()) {
+                for (uint32_t j = nodes[i].offset; j < nodes[i].offset + nodes[i].count; ++j) {
+                    ++seen[bvh.getIndices()[j]];
+                    bounds.merge(boxes[bvh.getIndices()[j]]);
+                }
+            } else {
+                CPPUNIT_ASSERT(nodes[i].offset + 1 < bvh.getNodeCount());
+                CPPUNIT_ASSERT_EQUAL((uint32_t) i, nodes[nodes[i].offset].parent);
+                CPPUNIT_ASSERT_EQUAL((uint32_t) i, nodes[nodes[i].offset + 1].parent);
+                bounds = M3d::merge(nodes[nodes[i].offset].bounds, nodes[nodes[i].offset + 1].bounds);
+            }
+            CPPUNIT_ASSERT(nodes[i].bounds == bounds);
+        }
+        CPPUNIT_ASSERT(count(seen.begin(), seen.end(), 1) == (ptrdiff_t) seen.size());
+    }
+
+    /**
+     * Moves each box by a random amount.
+     */
+    void moveBoxes(double distance) {
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            const M3d::Vec3 offset(random(-distance, distance), random(-distance, distance), random(-distance, distance));
+            boxes[i] = M3d::Aabb(boxes[i].lower + offset, boxes[i].upper + offset);
+        }
+    }
+
+    /**
+     * Checks that a list of indices includes every index in another list.
+     */
+    static void assertIncludes(vector<size_t> actual, const vector<size_t>& expected) {
+        sort(actual.begin(), actual.end());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            CPPUNIT_ASSERT(binary_search(actual.begin(), actual.end(), expected[i]));
+        }
+    }
+
+public:
+
+    /**
+     * Restores the default concurrency after each test case.
+     */
+    void tearDown() {
+        M3d::Parallel::setConcurrency(0);
+    }
+
+    /**
+     * Ensures nodes fill one cache line and are aligned to it.
+     */
+    void testNodeLayout() {
+        CPPUNIT_ASSERT_EQUAL((size_t) 64, sizeof(M3d::Bvh::Node));
+        makeBoxes(100);
+        M3d::Bvh bvh;
+        bvh.build(&boxes[0], boxes.size());
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, ((size_t) bvh.getNodes()) % 64);
+    }
+
+    /**
+     * Ensures building gives a valid tree with small leaves.
+     */
+    void testBuild() {
+
+        makeBoxes(1000);
+        M3d::Bvh bvh;
+        bvh.build(&boxes[0], boxes.size(), 2);
+        assertValid(bvh);
+        CPPUNIT_ASSERT_EQUAL((size_t) 1000, bvh.getSize());
+        CPPUNIT_ASSERT(bvh.getNodeCount() > 1);
+
+        M3d::Aabb bounds;
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            bounds.merge(boxes[i]);
+        }
+        CPPUNIT_ASSERT(bvh.getBounds() == bounds);
+
+        for (size_t i = 0; i < bvh.getNodeCount(); ++i) {
+            CPPUNIT_ASSERT(bvh.getNodes()[i].count <= 2);
+            if (!bvh.getNodes()[i].isLeaf()) {
+                CPPUNIT_ASSERT(bvh.getNodes()[i].offset > i);
+            }
+        }
+    }
+
+    /**
+     * Ensures building with nothing or with identical boxes works.
+     */
+    void testBuildDegenerate() {
+
+        M3d::Bvh bvh;
+        bvh.build(NULL, 0);
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, bvh.getNodeCount());
+        CPPUNIT_ASSERT(bvh.getBounds().isEmpty());
+
+        vector<size_t> result(1);
+        bvh.findOverlaps(M3d::Aabb(M3d::Vec3(0, 0, 0)), result);
+        CPPUNIT_ASSERT(result.empty());
+
+        boxes.assign(10, M3d::Aabb(M3d::Vec3(0, 0, 0), M3d::Vec3(1, 1, 1)));
+        bvh.build(&boxes[0], boxes.size(), 1);
+        CPPUNIT_ASSERT_EQUAL((size_t) 1, bvh.getNodeCount());
+        assertValid(bvh);
+    }
+
+    /**
+     * Ensures building with several threads gives exactly the same tree as with one.
+     */
+    void testBuildParallel() {
+
+        makeBoxes(20000);
+        M3d::Bvh serial, parallel;
+        M3d::Parallel::setConcurrency(1);
+        serial.build(&boxes[0], boxes.size());
+        M3d::Parallel::setConcurrency(4);
+        parallel.build(&boxes[0], boxes.size());
+
+        assertValid(parallel);
+        CPPUNIT_ASSERT_EQUAL(serial.getNodeCount(), parallel.getNodeCount());
+        for (size_t i = 0; i < serial.getNodeCount(); ++i) {
+            const M3d::Bvh::Node& a = serial.getNodes()[i];
+            const M3d::Bvh::Node& b = parallel.getNodes()[i];
+            CPPUNIT_ASSERT(a.bounds == b.bounds);
+            CPPUNIT_ASSERT_EQUAL(a.offset, b.offset);
+            CPPUNIT_ASSERT_EQUAL(a.count, b.count);
+        }
+        CPPUNIT_ASSERT(equal(serial.getIndices(), serial.getIndices() + serial.getSize(), parallel.getIndices()));
+    }
+
+    /**
+     * Ensures findOverlaps reports every box overlapping a query box.
+     */
+    void testFindOverlaps() {
+
+        makeBoxes(2000);
+        M3d::Bvh bvh;
+        bvh.build(&boxes[0], boxes.size());
+
+        vector<size_t> expected, actual;
+        for (int i = 0; i < 50; ++i) {
+            const M3d::Vec3 center(random(-10, 10), random(-10, 10), random(-10, 10));
+            const M3d::Aabb query(center - M3d::Vec3(1, 1, 1), center + M3d::Vec3(1, 1, 1));
+            expected.clear();
+            for (size_t j = 0; j < boxes.size(); ++j) {
+                if (query.intersects(boxes[j])) {
+                    expected.push_back(j);
+                }
+            }
+            bvh.findOverlaps(query, actual);
+            assertIncludes(actual, expected);
+        }
+    }
+
+    /**
+     * Ensures findIntersections reports every box hit by a ray.
+     */
+    void testFindIntersections() {
+
+        makeBoxes(2000);
+        M3d::Bvh bvh;
+        bvh.build(&boxes[0], boxes.size());
+
+        vector<size_t> expected, actual;
+        for (int i = 0; i < 50; ++i) {
+            const M3d::Ray ray = randomRay();
+            double t;
+            expected.clear();
+            for (size_t j = 0; j < boxes.size(); ++j) {
+                if (ray.intersects(boxes[j], HUGE_VAL, t)) {
+                    expected.push_back(j);
+                }
+            }
+            bvh.findIntersections(ray, HUGE_VAL, actual);
+            assertIncludes(actual, expected);
+            CPPUNIT_ASSERT(actual.size() < boxes.size());
+        }
+    }
+
+    /**
+     * Ensures findClosest finds the same distance as testing every box.
+     */
+    void testFindClosest() {
+
+        makeBoxes(2000);
+        M3d::Bvh bvh;
+        bvh.build(&boxes[0], boxes.size());
+        BoxIntersector intersector(boxes);
+
+        int hits = 0;
+        for (int i = 0; i < 100; ++i) {
+            const M3d::Ray ray = randomRay();
+            double expected = HUGE_VAL;
+            for (size_t j = 0; j < boxes.size(); ++j) {
+                double t;
+                if (ray.intersects(boxes[j], HUGE_VAL, t)) {
+                    expected = min(expected, t);
+                }
+            }
+
+            size_t primitive;
+            double t;
+            const bool found = bvh.findClosest(ray, HUGE_VAL, intersector, primitive, t);
+            CPPUNIT_ASSERT_EQUAL(expected < HUGE_VAL, found);
+            if (found) {
+                CPPUNIT_ASSERT_EQUAL(expected, t);
+                CPPUNIT_ASSERT(ray.intersects(boxes[primitive], HUGE_VAL, t));
+                ++hits;
+            }
+        }
+        CPPUNIT_ASSERT(hits > 0);
+    }
+
+    /**
+     * Ensures refitting after every box moves gives exact bounds, with one thread or several.
+     */
+    void testRefit() {
+
+        makeBoxes(20000);
+        M3d::Bvh serial, parallel;
+        serial.build(&boxes[0], boxes.size());
+        parallel.build(&boxes[0], boxes.size());
+        const double cost = serial.getCost();
+        moveBoxes(2);
+
+        M3d::Parallel::setConcurrency(1);
+        serial.refit(&boxes[0]);
+        assertValid(serial);
+        M3d::Parallel::setConcurrency(4);
+        parallel.refit(&boxes[0]);
+        assertValid(parallel);
+        CPPUNIT_ASSERT(serial.getCost() > cost);
+    }
+
+    /**
+     * Ensures refitting only the boxes that moved gives exact bounds.
+     */
+    void testRefitChanged() {
+
+        makeBoxes(2000);
+        M3d::Bvh bvh;
+        bvh.build(&boxes[0], boxes.size());
+
+        vector<size_t> changed;
+        for (size_t i = 0; i < boxes.size(); i += 37) {
+            const M3d::Vec3 offset(random(-3, 3), random(-3, 3), random(-3, 3));
+            boxes[i] = M3d::Aabb(boxes[i].lower + offset, boxes[i].upper + offset);
+            changed.push_back(i);
+        }
+        bvh.refit(&boxes[0], &changed[0], changed.size());
+        assertValid(bvh);
+
+        const size_t bad = boxes.size();
+        CPPUNIT_ASSERT_THROW(bvh.refit(&boxes[0], &bad, 1), std::out_of_range);
+    }
+
+    /**
+     * Ensures rotating a refit tree lowers its cost and keeps queries correct.
+     */
+    void testRotate() {
+
+        makeBoxes(2000);
+        M3d::Bvh bvh;
+        bvh.build(&boxes[0], boxes.size());
+        moveBoxes(5);
+        bvh.refit(&boxes[0]);
+        const double cost = bvh.getCost();
+
+        CPPUNIT_ASSERT(bvh.rotate() > 0);
+        assertValid(bvh);
+        CPPUNIT_ASSERT(bvh.getCost() < cost);
+
+        vector<size_t> expected, actual;
+        for (int i = 0; i < 50; ++i) {
+            const M3d::Vec3 center(random(-10, 10), random(-10, 10), random(-10, 10));
+            const M3d::Aabb query(center - M3d::Vec3(1, 1, 1), center + M3d::Vec3(1, 1, 1));
+            expected.clear();
+            for (size_t j = 0; j < boxes.size(); ++j) {
+                if (query.intersects(boxes[j])) {
+                    expected.push_back(j);
+                }
+            }
+            bvh.findOverlaps(query, actual);
+            assertIncludes(actual, expected);
+        }
+
+        // Moving a box after rotating still updates the right leaf
+        boxes[7] = M3d::Aabb(M3d::Vec3(30, 30, 30), M3d::Vec3(31, 31, 31));
+        const size_t changed = 7;
+        bvh.refit(&boxes[0], &changed, 1);
+        assertValid(bvh);
+    }
+
+    /**
+     * Ensures building from Morton codes gives a valid tree that finds the same closest hits.
+     */
+    void testBuildLinear() {
+
+        makeBoxes(20000);
+        M3d::Bvh bvh;
+        M3d::Parallel::setConcurrency(4);
+        bvh.buildLinear(&boxes[0], boxes.size());
+        assertValid(bvh);
+        for (size_t i = 0; i < bvh.getNodeCount(); ++i) {
+            CPPUNIT_ASSERT(bvh.getNodes()[i].count <= M3d::Bvh::DEFAULT_LEAF_SIZE);
+        }
+
+        BoxIntersector intersector(boxes);
+        for (int i = 0; i < 20; ++i) {
+            const M3d::Ray ray = randomRay();
+            double expected = HUGE_VAL;
+            for (size_t j = 0; j < boxes.size(); ++j) {
+                double t;
+                if (ray.intersects(boxes[j], HUGE_VAL, t)) {
+                    expected = min(expected, t);
+                }
+            }
+            size_t primitive;
+            double t = HUGE_VAL;
+            bvh.findClosest(ray, HUGE_VAL, intersector, primitive, t);
+            CPPUNIT_ASSERT_EQUAL(expected, t);
+        }
+
+        // Same tree with one thread
+        M3d::Bvh serial;
+        M3d::Parallel::setConcurrency(1);
+        serial.buildLinear(&boxes[0], boxes.size());
+        CPPUNIT_ASSERT_EQUAL(serial.getNodeCount(), bvh.getNodeCount());
+        CPPUNIT_ASSERT(equal(serial.getIndices(), serial.getIndices() + serial.getSize(), bvh.getIndices()));
+    }
+
+    /**
+     * Ensures building from Morton codes works with few boxes, identical boxes and long codes.
+     */
+    void testBuildLinearDegenerate() {
+
+        M3d::Bvh bvh;
+        bvh.buildLinear(NULL, 0);
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, bvh.getNodeCount());
+
+        boxes.assign(1, M3d::Aabb(M3d::Vec3(0, 0, 0), M3d::Vec3(1, 1, 1)));
+        bvh.buildLinear(&boxes[0], 1, 1);
+        CPPUNIT_ASSERT_EQUAL((size_t) 1, bvh.getNodeCount());
+        assertValid(bvh);
+
+        boxes.assign(1000, M3d::Aabb(M3d::Vec3(0, 0, 0), M3d::Vec3(1, 1, 1)));
+        bvh.buildLinear(&boxes[0], boxes.size(), 1);
+        CPPUNIT_ASSERT_EQUAL((size_t) 1999, bvh.getNodeCount());
+        assertValid(bvh);
+
+        makeBoxes(1100000);
+        M3d::Parallel::setConcurrency(4);
+        bvh.buildLinear(&boxes[0], boxes.size());
+        assertValid(bvh);
+    }
+
+    CPPUNIT_TEST_SUITE(BvhTest);
+    CPPUNIT_TEST(testNodeLayout);
+    CPPUNIT_TEST(testBuild);
+    CPPUNIT_TEST(testBuildDegenerate);
+    CPPUNIT_TEST(testBuildParallel);
+    CPPUNIT_TEST(testBuildLinear);
+    CPPUNIT_TEST(testBuildLinearDegenerate);
+    CPPUNIT_TEST(testFindOverlaps);
+    CPPUNIT_TEST(testFindIntersections);
+    CPPUNIT_TEST(testFindClosest);
+    CPPUNIT_TEST(testRefit);
+    CPPUNIT_TEST(testRefitChanged);
+    CPPUNIT_TEST(testRotate);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(BvhTest::suite());
+    runner.run();
+    return 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <cmath>
+#include "m3d/ConvexShape.h"
+using namespace std;
+namespace M3d {
+
+/**
+ * Destroys the shape.
+ */
+ConvexShape::~ConvexShape() {
+    // pass
+}
+
+// SPHERE
+
+/**
+ * Constructs a unit sphere at the origin.
+ */
+SphereShape::SphereShape() : center(0, 0, 0), radius(1) {
+    // pass
+}
+
+/**
+ * Constructs a sphere.
+ *
+ * @param center Center of the sphere
+ * @param radius Radius of the sphere
+ */
+SphereShape::SphereShape(const Vec3& center, double radius) : center(center), radius(radius) {
+    // pass
+}
+
+/**
+ * Returns the center of the sphere.
+ */
+Vec3 SphereShape::getCenter() const {
+    return center;
+}
+
+/**
+ * Finds the point of the sphere farthest along a direction.
+ */
+Vec3 SphereShape::getSupport(const Vec3& direction) const {
+    const double len = length(direction);
+    if (len == 0) {
+        return center + Vec3(radius, 0, 0);
+    }
+    return center + (direction * (radius / len));
+}
+
+// BOX
+
+/**
+ * Constructs a box two units wide at the origin.
+ */
+BoxShape::BoxShape() : center(0, 0, 0), halfExtents(1, 1, 1), rotation(1.0) {
+    // pass
+}
+
+/**
+ * Constructs a box aligned with the world axes.
+ *
+ * @param center Center of the box
+ * @param halfExtents Half the size of the box along each axis
+ */
+BoxShape::BoxShape(const Vec3& center, const Vec3& halfExtents) :
+        center(center), halfExtents(halfExtents), rotation(1.0) {
+    // pass
+}
+
+/**
+ * Constructs a rotated box.
+ *
+ * @param center Center of the box
+ * @param halfExtents Half the size of the box along each of its own axes
+ * @param rotation Rotation from the box's axes to world space
+ */
+BoxShape::BoxShape(const Vec3& center, const Vec3& halfExtents, const Mat3& rotation) :
+        center(center), halfExtents(halfExtents), rotation(rotation) {
+    // pass
+}
+
+/**
+ * Returns the center of the box.
+ */
+Vec3 BoxShape::getCenter() const {
+    return center;
+}
+
+/**
+ * Finds the corner of the box farthest along a direction.
+ */
+Vec3 BoxShape::getSupport(const Vec3& direction) const {
+    const Vec3 local = transpose(rotation) * direction;
+    const Vec3 corner((local.x >= 0) ? halfExtents.x : -halfExtents.x,
+                      (local.y >= 0) ? halfExtents.y : -halfExtents.y,
+                      (local.z >= 0) ? halfExtents.z : -halfExtents.z);
+    return center + (rotation * corner);
+}
+
+// CAPSULE
+
+/**
+ * Constructs a capsule of radius one around a segment from -Y to +Y.
+ */
+CapsuleShape::CapsuleShape() : start(0, -1, 0), end(0, 1, 0), radius(1) {
+    // pass
+}
+
+/**
+ * Constructs a capsule.
+ *
+ * @param start First end of the segment
+ * @param end Second end of the segment
+ * @param radius Distance from the segment to the surface
+ */
+CapsuleShape::CapsuleShape(const Vec3& start, const Vec3& end, double radius) :
+        start(start), end(end), radius(radius) {
+    // pass
+}
+
+/**
+ * Returns the middle of the segment.
+ */
+Vec3 CapsuleShape::getCenter() const {
+    return (start + end) * 0.5;
+}
+
+/**
+ * Finds the point of the capsule farthest along a direction.
+ */
+Vec3 CapsuleShape::getSupport(const Vec3& direction) const {
+    const Vec3& p = (dot(end - start, direction) >= 0) ? end : start;
+    const double len = length(direction);
+    if (len == 0) {
+        return p + Vec3(radius, 0, 0);
+    }
+    return p + (direction * (radius / len));
+}
+
+// HULL
+
+/**
+ * Constructs a hull of a single point at the origin.
+ */
+HullShape::HullShape() : points(1) {
+    // pass
+}
+
+/**
+ * Constructs the hull of a set of points.
+ *
+ * @param points Points to wrap, at least one
+ */
+HullShape::HullShape(const Vec3Array& points) : points(points) {
+    // pass
+}
+
+/**
+ * Returns the average of the points.
+ */
+Vec3 HullShape::getCenter() const {
+    const size_t size = points.size();
+    double x = 0, y = 0, z = 0;
+    for (size_t i = 0; i < size; ++i) {
+        x += points.x[i];
+        y += points.y[i];
+        z += points.z[i];
+    }
+    return Vec3(x, y, z) / (double) size;
+}
+
+/**
+ * Finds the point of the hull farthest along a direction.
+ */
+Vec3 HullShape::getSupport(const Vec3& direction) const {
+
+    const size_t size = points.size();
+    const double* const x = &points.x[0];
+    const double* const y = &points.y[0];
+    const double* const z = &points.z[0];
+    double best = -HUGE_VAL;
+    size_t index = 0;
+
+    for (size_t i = 0; i < size; ++i) {
+        const double d = (x[i] * direction.x) + (y[i] * direction.y) + (z[i] * direction.z);
+        if (d > best) {
+            best = d;
+            index = i;
+        }
+    }
+    return points.get(index);
+}
+
+} /* namespace M3d */
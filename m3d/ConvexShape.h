@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_CONVEXSHAPE_H
+#define M3D_CONVEXSHAPE_H
+#include "m3d/common.h"
+#include "m3d/Mat3.h"
+#include "m3d/Vec3.h"
+#include "m3d/Vec3Array.h"
+namespace M3d {
+
+
+/**
+ * Convex shape described by its support function, for use with `Gjk`.
+ *
+ * The support function returns the point of the shape farthest along a direction, which is all collision detection
+ * needs to know about the shape.  Shapes are given in world space.
+ */
+class ConvexShape {
+public:
+    virtual ~ConvexShape();
+    /**
+     * Returns a point inside the shape, used to pick a first search direction.
+     */
+    virtual Vec3 getCenter() const = 0;
+    /**
+     * Finds the point of the shape farthest along a direction.
+     *
+     * @param direction Direction to search along, which may not be unit length
+     * @return Point of the shape with the largest dot product with the direction
+     */
+    virtual Vec3 getSupport(const Vec3& direction) const = 0;
+};
+
+
+/**
+ * Sphere as a convex shape.
+ */
+class SphereShape : public ConvexShape {
+public:
+// Attributes
+    Vec3 center; ///< Center of the sphere
+    double radius; ///< Radius of the sphere
+// Methods
+    explicit SphereShape();
+    explicit SphereShape(const Vec3& center, double radius);
+    virtual Vec3 getCenter() const;
+    virtual Vec3 getSupport(const Vec3& direction) const;
+};
+
+
+/**
+ * Oriented box as a convex shape.
+ */
+class BoxShape : public ConvexShape {
+public:
+// Attributes
+    Vec3 center; ///< Center of the box
+    Vec3 halfExtents; ///< Half the size of the box along each of its own axes
+    Mat3 rotation; ///< Rotation from the box's axes to world space
+// Methods
+    explicit BoxShape();
+    explicit BoxShape(const Vec3& center, const Vec3& halfExtents);
+    explicit BoxShape(const Vec3& center, const Vec3& halfExtents, const Mat3& rotation);
+    virtual Vec3 getCenter() const;
+    virtual Vec3 getSupport(const Vec3& direction) const;
+};
+
+
+/**
+ * Capsule, the set of points within a radius of a segment, as a convex shape.
+ */
+class CapsuleShape : public ConvexShape {
+public:
+// Attributes
+    Vec3 start; ///< First end of the segment
+    Vec3 end; ///< Second end of the segment
+    double radius; ///< Distance from the segment to the surface
+// Methods
+    explicit CapsuleShape();
+    explicit CapsuleShape(const Vec3& start, const Vec3& end, double radius);
+    virtual Vec3 getCenter() const;
+    virtual Vec3 getSupport(const Vec3& direction) const;
+};
+
+
+/**
+ * Convex hull of a set of points as a convex shape.
+ *
+ * Points inside the hull may be included, they are just never returned.  The points are stored as separate arrays of
+ * components, so the support function scans them in one loop the compiler can vectorize.
+ */
+class HullShape : public ConvexShape {
+public:
+// Attributes
+    Vec3Array points; ///< Points the hull wraps, at least one
+// Methods
+    explicit HullShape();
+    explicit HullShape(const Vec3Array& points);
+    virtual Vec3 getCenter() const;
+    virtual Vec3 getSupport(const Vec3& direction) const;
+};
+
+} /* namespace M3d */
+#endif
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cstdlib>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/ConvexShape.h"
+using namespace std;
+
+/*
+ * Constants
+ */
+const double TOLERANCE = 1e-9;
+
+
+/**
+ * Unit test for ConvexShape.
+ */
+class ConvexShapeTest : public CppUnit::TestFixture {
+public:
+
+    /**
+     * Ensures the sphere's support point is on its surface along the direction.
+     */
+    void testSphere() {
+        const M3d::SphereShape sphere(M3d::Vec3(1, 2, 3), 2);
+        const M3d::Vec3 p = sphere.getSupport(M3d::Vec3(0, 0, -5));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, p.x, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(2.0, p.y, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, p.z, TOLERANCE);
+    }
+
+    /**
+     * Ensures the box's support point is the corner farthest along the direction, after turning the box 90 degrees.
+     */
+    void testBox() {
+        const M3d::Mat3 rotation = M3d::Mat3::fromRows(M3d::Vec3(0, -1, 0), M3d::Vec3(1, 0, 0), M3d::Vec3(0, 0, 1));
+        const M3d::BoxShape box(M3d::Vec3(10, 0, 0), M3d::Vec3(3, 1, 2), rotation);
+        const M3d::Vec3 p = box.getSupport(M3d::Vec3(1, 1, -1));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(11.0, p.x, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, p.y, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(-2.0, p.z, TOLERANCE);
+    }
+
+    /**
+     * Ensures the capsule's support point is on the cap at the end farthest along the direction.
+     */
+    void testCapsule() {
+        const M3d::CapsuleShape capsule(M3d::Vec3(0, -1, 0), M3d::Vec3(0, 1, 0), 0.5);
+        const M3d::Vec3 p = capsule.getSupport(M3d::Vec3(0, -1, 0));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(-1.5, p.y, TOLERANCE);
+        const M3d::Vec3 q = capsule.getSupport(M3d::Vec3(1, 0.001, 0));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, q.x, 1e-6);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, q.y, 1e-3);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, capsule.getCenter().y, TOLERANCE);
+    }
+
+    /**
+     * Ensures the hull's support point is the input point farthest along the direction.
+     */
+    void testHull() {
+        M3d::Vec3Array points;
+        points.append(M3d::Vec3(0, 0, 0));
+        points.append(M3d::Vec3(1, 0, 0));
+        points.append(M3d::Vec3(0, 1, 0));
+        points.append(M3d::Vec3(0, 0, 1));
+        points.append(M3d::Vec3(0.2, 0.2, 0.2));
+        const M3d::HullShape hull(points);
+        const M3d::Vec3 p = hull.getSupport(M3d::Vec3(-1, 2, 1));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, p.y, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.24, hull.getCenter().x, TOLERANCE);
+    }
+
+    CPPUNIT_TEST_SUITE(ConvexShapeTest);
+    CPPUNIT_TEST(testSphere);
+    CPPUNIT_TEST(testBox);
+    CPPUNIT_TEST(testCapsule);
+    CPPUNIT_TEST(testHull);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(ConvexShapeTest::suite());
+    runner.run();
+    return 0;
+}
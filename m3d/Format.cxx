@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <cctype>
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+#include <string>
+#include "m3d/Format.h"
+using namespace std;
+namespace M3d {
+
+/* Powers of ten that doubles hold exactly */
+static const double POWERS_OF_TEN[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Checks if there is a character left, where a null end means the text ends with a null character */
+static inline bool hasMore(const char* p, const char* end) {
+    return (end == NULL) || (p < end);
+}
+
+/* Checks if the next character is a digit */
+static inline bool hasDigit(const char* p, const char* end) {
+    return hasMore(p, end) && (*p >= '0') && (*p <= '9');
+}
+
+/**
+ * Copies text into a buffer the way `snprintf` would, cutting it short if needed and always ending it with a null
+ * character if there is room for one.
+ *
+ * @param text Text to copy
+ * @param length Number of characters in text
+ * @param buf Buffer to copy into
+ * @param size Number of characters the buffer can hold
+ * @return Length of the text, which is more than was copied if the buffer was too small
+ */
+size_t Format::copy(const char* text, size_t length, char* buf, size_t size) {
+    if (size > 0) {
+        const size_t n = (length < size) ? length : (size - 1);
+        memcpy(buf, text, n);
+        buf[n] = '\0';
+    }
+    return length;
+}
+
+/**
+ * Writes the shortest text for a number that reads back as the same number.
+ *
+ * @param buf Buffer to write into, which must hold at least `DOUBLE_SIZE` characters
+ * @param value Number to write
+ * @return Number of characters written, without a null character
+ */
+size_t Format::formatDouble(char* buf, double value) {
+
+    char text[32];
+    for (int digits = 15; digits <= 17; ++digits) {
+        sprintf(text, "%.*g", digits, value);
+        if ((digits == 17) || (strtod(text, NULL) == value)) {
+            break;
+        }
+    }
+
+    // Always use a period, whatever the locale uses
+    const char* const point = localeconv()->decimal_point;
+    char* const found = (strcmp(point, ".") != 0) ? strstr(text, point) : NULL;
+    size_t length = 0;
+    for (const char* p = text; *p != '\0'; ++p) {
+        if (p == found) {
+            buf[length++] = '.';
+            p += strlen(point) - 1;
+        } else {
+            buf[length++] = *p;
+        }
+    }
+    return length;
+}
+
+/**
+ * Writes a list of numbers in square brackets.
+ *
+ * @param buf Buffer to write into, which must hold at least `count * (DOUBLE_SIZE + 2) + 2` characters
+ * @param values Numbers to write
+ * @param count Number of numbers
+ * @return Number of characters written, without a null character
+ */
+size_t Format::formatList(char* buf, const double* values, size_t count) {
+    size_t length = 0;
+    buf[length++] = '[';
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) {
+            buf[length++] = ',';
+            buf[length++] = ' ';
+        }
+        length += formatDouble(buf + length, values[i]);
+    }
+    buf[length++] = ']';
+    return length;
+}
+
+/**
+ * Checks if a stream has its default precision, width and notation for numbers.
+ */
+bool Format::isDefault(const ios_base& stream) {
+    return (stream.precision() == 6) && (stream.width() == 0) && ((stream.flags() & ios_base::floatfield) == 0);
+}
+
+/**
+ * Reads a character, skipping any whitespace before it.
+ *
+ * @param text Text to read from
+ * @param c Character expected
+ * @return Position after the character, or `NULL` if the next character is different
+ */
+const char* Format::parseChar(const char* text, char c) {
+    while (isspace((unsigned char) *text)) {
+        ++text;
+    }
+    return (*text == c) ? (text + 1) : NULL;
+}
+
+/**
+ * Reads a number, skipping any whitespace before it.
+ *
+ * @param text Text to read from
+ * @param value Number to store the result in, unchanged if there is no number
+ * @return Position after the number, or `NULL` if there is no number
+ */
+const char* Format::parseDouble(const char* text, double& value) {
+
+    while (isspace((unsigned char) *text)) {
+        ++text;
+    }
+    const char* const stop = parseDecimal(text, NULL, value);
+    if (stop != NULL) {
+        return stop;
+    }
+
+    return parseOther(text, NULL, value);
+}
+
+/**
+ * Reads a number from a block of text that does not have to end with a null character, such as part of a file.
+ *
+ * Unlike the other form, whitespace before the number is not skipped.
+ *
+ * @param begin Start of the number
+ * @param end End of the text, which is never read past
+ * @param value Number to store the result in, unchanged if there is no number
+ * @return Position after the number, or `NULL` if there is no number
+ */
+const char* Format::parseDouble(const char* begin, const char* end, double& value) {
+
+    const char* const stop = parseDecimal(begin, end, value);
+    if (stop != NULL) {
+        return stop;
+    }
+
+    return parseOther(begin, end, value);
+}
+
+/**
+ * Reads a list of numbers in square brackets, skipping any whitespace before or inside it.
+ *
+ * @param text Text to read from
+ * @param values Array to store the numbers in, which may be partly filled if the list is malformed
+ * @param count Number of numbers expected
+ * @return Position after the list, or `NULL` if the text does not start with a list of exactly that many numbers
+ */
+const char* Format::parseList(const char* text, double* values, size_t count) {
+    text = parseChar(text, '[');
+    for (size_t i = 0; (text != NULL) && (i < count); ++i) {
+        if (i > 0) {
+            text = parseChar(text, ',');
+        }
+        if (text != NULL) {
+            text = parseDouble(text, values[i]);
+        }
+    }
+    return (text != NULL) ? parseChar(text, ']') : NULL;
+}
+
+// HELPERS
+
+/*
+ * Reads a plain decimal number small enough to convert exactly, returning `NULL` for anything else.
+ *
+ * A mantissa of at most 2^53 and a power of ten of at most 22 are both exact as doubles, so one multiplication or
+ * division rounds the same way `strtod` does.
+ */
+const char* Format::parseDecimal(const char* text, const char* end, double& value) {
+
+    const char* p = text;
+    bool negative = false;
+    if (hasMore(p, end) && ((*p == '-') || (*p == '+'))) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    // Collect significant digits
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool found = false;
+    for (bool fraction = false; ; ++p) {
+        if (hasDigit(p, end)) {
+            if (digits == 19) {
+                return NULL;
+            }
+            mantissa = (mantissa * 10) + (*p - '0');
+            digits += (mantissa != 0) ? 1 : 0;
+            exponent -= fraction ? 1 : 0;
+            found = true;
+        } else if (!fraction && hasMore(p, end) && (*p == '.')) {
+            fraction = true;
+        } else {
+            break;
+        }
+    }
+    if (!found || (hasMore(p, end) && ((*p == 'x') || (*p == 'X')))) {
+        return NULL;
+    }
+
+    // Add exponent, if there is one
+    if (hasMore(p, end) && ((*p == 'e') || (*p == 'E'))) {
+        const char* q = p + 1;
+        bool negativeExponent = false;
+        if (hasMore(q, end) && ((*q == '-') || (*q == '+'))) {
+            negativeExponent = (*q == '-');
+            ++q;
+        }
+        if (hasDigit(q, end)) {
+            int e = 0;
+            for (; hasDigit(q, end); ++q) {
+                e = (e < 10000) ? ((e * 10) + (*q - '0')) : e;
+            }
+            exponent += negativeExponent ? -e : e;
+            p = q;
+        }
+    }
+
+    // Convert
+    double result = (double) mantissa;
+    if (mantissa == 0) {
+        result = 0;
+    } else if ((mantissa > (((uint64_t) 1) << 53)) || (exponent < -22) || (exponent > 22)) {
+        return NULL;
+    } else if (exponent < 0) {
+        result /= POWERS_OF_TEN[-exponent];
+    } else {
+        result *= POWERS_OF_TEN[exponent];
+    }
+    value = negative ? -result : result;
+    return p;
+}
+
+/*
+ * Reads anything `parseDecimal` cannot with `strtod`, returning `NULL` if there is no number.
+ *
+ * The number is copied first, so `strtod` never reads past the end, and its period is swapped for the decimal point of
+ * the current locale, so it reads the same whatever the locale.
+ */
+const char* Format::parseOther(const char* text, const char* end, double& value) {
+
+    // Copy up to the next separator
+    const string point = localeconv()->decimal_point;
+    string token;
+    size_t dot = string::npos;
+    for (const char* p = text; hasMore(p, end) && (*p != '\0'); ++p) {
+        if (isspace((unsigned char) *p) || (*p == ',') || (*p == ']')) {
+            break;
+        } else if ((*p == '.') && (dot == string::npos)) {
+            dot = token.size();
+            token += point;
+        } else {
+            token += *p;
+        }
+    }
+
+    // Convert, and map the characters read back onto the original text
+    char* tokenEnd;
+    const double result = strtod(token.c_str(), &tokenEnd);
+    size_t used = tokenEnd - token.c_str();
+    if (used == 0) {
+        return NULL;
+    } else if ((dot != string::npos) && (used > dot)) {
+        used -= point.size() - 1;
+    }
+    value = result;
+    return text + used;
+}
+
+} /* namespace M3d */
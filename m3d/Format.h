@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_FORMAT_H
+#define M3D_FORMAT_H
+#include "m3d/common.h"
+#include <ios>
+namespace M3d {
+
+
+/**
+ * Utility for writing numbers as text and reading them back, without streams or allocation.
+ *
+ * Numbers are written with the fewest significant digits that read back as exactly the same number, trying fifteen,
+ * sixteen and then seventeen digits.  Lists are written as comma-separated numbers in square brackets, like
+ * `[1, 0.5, -2]`.  Numbers always use a period as the decimal point, whatever the locale.  Reading converts plain
+ * decimal numbers of up to nineteen digits directly, which gives the same result as `strtod` without its overhead, and
+ * leaves anything else to `strtod`.
+ *
+ * Types printed to streams use these exact numbers only when the stream has its default precision, width and
+ * notation, so streams set up with manipulators such as `setprecision` or `setw` still print as they did before.
+ */
+class Format {
+public:
+// Constants
+    static const size_t DOUBLE_SIZE = 24; ///< Most characters written for one number
+// Methods
+    static size_t copy(const char* text, size_t length, char* buf, size_t size);
+    static size_t formatDouble(char* buf, double value);
+    static size_t formatList(char* buf, const double* values, size_t count);
+    static bool isDefault(const std::ios_base& stream);
+    static const char* parseChar(const char* text, char c);
+    static const char* parseDouble(const char* text, double& value);
+    static const char* parseDouble(const char* begin, const char* end, double& value);
+    static const char* parseList(const char* text, double* values, size_t count);
+private:
+// Helpers
+    static const char* parseDecimal(const char* text, const char* end, double& value);
+    static const char* parseOther(const char* text, const char* end, double& value);
+};
+
+} /* namespace M3d */
+#endif
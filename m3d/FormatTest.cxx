@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cfloat>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/Format.h"
+using namespace std;
+
+
+/**
+ * Unit test for Format.
+ */
+class FormatTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Formats a number into a string.
+     */
+    static string format(double value) {
+        char buf[M3d::Format::DOUBLE_SIZE];
+        return string(buf, M3d::Format::formatDouble(buf, value));
+    }
+
+public:
+
+    /**
+     * Ensures copying cuts text short to fit and always adds a null character.
+     */
+    void testCopy() {
+        char buf[4] = { 'x', 'x', 'x', 'x' };
+        CPPUNIT_ASSERT_EQUAL((size_t) 6, M3d::Format::copy("abcdef", 6, buf, 4));
+        CPPUNIT_ASSERT_EQUAL(string("abc"), string(buf));
+        CPPUNIT_ASSERT_EQUAL((size_t) 2, M3d::Format::copy("gh", 2, buf, 4));
+        CPPUNIT_ASSERT_EQUAL(string("gh"), string(buf));
+        CPPUNIT_ASSERT_EQUAL((size_t) 2, M3d::Format::copy("ij", 2, buf, 0));
+        CPPUNIT_ASSERT_EQUAL(string("gh"), string(buf));
+    }
+
+    /**
+     * Ensures numbers are written with the fewest digits needed.
+     */
+    void testFormatDouble() {
+        CPPUNIT_ASSERT_EQUAL(string("1"), format(1));
+        CPPUNIT_ASSERT_EQUAL(string("-2.5"), format(-2.5));
+        CPPUNIT_ASSERT_EQUAL(string("0.1"), format(0.1));
+        CPPUNIT_ASSERT_EQUAL(string("0.30000000000000004"), format(0.1 + 0.2));
+        CPPUNIT_ASSERT_EQUAL(string("1e+100"), format(1e100));
+        CPPUNIT_ASSERT_EQUAL(string("inf"), format(HUGE_VAL));
+        CPPUNIT_ASSERT(format(-DBL_MIN * DBL_EPSILON).size() <= M3d::Format::DOUBLE_SIZE);
+        CPPUNIT_ASSERT(format(-DBL_MAX).size() <= M3d::Format::DOUBLE_SIZE);
+    }
+
+    /**
+     * Ensures random numbers read back exactly as they were written.
+     */
+    void testFormatDoubleRoundTrip() {
+        for (int i = 0; i < 10000; ++i) {
+            const double value = (rand() - (RAND_MAX / 2.0)) / (rand() + 1.0) * pow(10.0, (rand() % 40) - 20);
+            const string text = format(value);
+            CPPUNIT_ASSERT(text.size() <= M3d::Format::DOUBLE_SIZE);
+            CPPUNIT_ASSERT_EQUAL(value, strtod(text.c_str(), NULL));
+        }
+    }
+
+    /**
+     * Ensures lists are written in square brackets, separated by commas.
+     */
+    void testFormatList() {
+        const double values[3] = { 1, -0.5, 3 };
+        char buf[3 * (M3d::Format::DOUBLE_SIZE + 2) + 2];
+        CPPUNIT_ASSERT_EQUAL(string("[1, -0.5, 3]"), string(buf, M3d::Format::formatList(buf, values, 3)));
+        CPPUNIT_ASSERT_EQUAL(string("[]"), string(buf, M3d::Format::formatList(buf, values, 0)));
+    }
+
+    /**
+     * Ensures numbers are read exactly as strtod reads them.
+     */
+    void testParseDouble() {
+        const char* const formats[4] = { "%.17g", "%.6f", "%.3e", "%.25f" };
+        char text[64];
+        for (int i = 0; i < 10000; ++i) {
+            const double number = (rand() - (RAND_MAX / 2.0)) / (rand() + 1.0) * pow(10.0, (rand() % 40) - 20);
+            sprintf(text, formats[i % 4], number);
+            double value = 0;
+            const char* end = M3d::Format::parseDouble(text, value);
+            CPPUNIT_ASSERT(end == text + strlen(text));
+            CPPUNIT_ASSERT_EQUAL(strtod(text, NULL), value);
+        }
+
+        double value = 0;
+        CPPUNIT_ASSERT(M3d::Format::parseDouble("  -inf", value) != NULL);
+        CPPUNIT_ASSERT_EQUAL(-HUGE_VAL, value);
+        CPPUNIT_ASSERT(M3d::Format::parseDouble("0x10", value) != NULL);
+        CPPUNIT_ASSERT_EQUAL(16.0, value);
+        CPPUNIT_ASSERT(M3d::Format::parseDouble("12345678901234567890123", value) != NULL);
+        CPPUNIT_ASSERT_EQUAL(12345678901234567890123.0, value);
+        CPPUNIT_ASSERT(M3d::Format::parseDouble("abc", value) == NULL);
+        CPPUNIT_ASSERT(M3d::Format::parseDouble(".", value) == NULL);
+    }
+
+    /**
+     * Ensures reading a number from part of some text stops at the end.
+     */
+    void testParseDoubleBounded() {
+        const char* const text = "12345e3";
+        double value = 0;
+        CPPUNIT_ASSERT(M3d::Format::parseDouble(text, text + 3, value) == text + 3);
+        CPPUNIT_ASSERT_EQUAL(123.0, value);
+        CPPUNIT_ASSERT(M3d::Format::parseDouble(text, text + 6, value) == text + 5);
+        CPPUNIT_ASSERT_EQUAL(12345.0, value);
+        CPPUNIT_ASSERT(M3d::Format::parseDouble(text, text + 7, value) == text + 7);
+        CPPUNIT_ASSERT_EQUAL(12345000.0, value);
+
+        const char* const special = "nan1 -1e400";
+        CPPUNIT_ASSERT(M3d::Format::parseDouble(special, special + 3, value) == special + 3);
+        CPPUNIT_ASSERT(value != value);
+        CPPUNIT_ASSERT(M3d::Format::parseDouble(special + 5, special + 11, value) == special + 11);
+        CPPUNIT_ASSERT_EQUAL(-HUGE_VAL, value);
+        CPPUNIT_ASSERT(M3d::Format::parseDouble(special, special, value) == NULL);
+    }
+
+    /**
+     * Ensures numbers are written and read with a period in a locale that uses a comma, if one is installed.
+     */
+    void testLocale() {
+        const char* const names[4] = { "de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8", "fr_FR.utf8" };
+        for (int i = 0; (i < 4) && (setlocale(LC_NUMERIC, names[i]) == NULL); ++i) {
+            ;
+        }
+
+        const double values[3] = { 0.5, 1.5e-300, 3 };
+        char buf[3 * (M3d::Format::DOUBLE_SIZE + 2) + 2];
+        const string text(buf, M3d::Format::formatList(buf, values, 3));
+        double parsed[3] = { 0, 0, 0 };
+        const char* const end = M3d::Format::parseList(text.c_str(), parsed, 3);
+        const char* const bounded = "2.5e-300,";
+        double value = 0;
+        const char* const stop = M3d::Format::parseDouble(bounded, bounded + 9, value);
+        setlocale(LC_NUMERIC, "C");
+
+        CPPUNIT_ASSERT_EQUAL(string("[0.5, 1.5e-300, 3]"), text);
+        CPPUNIT_ASSERT(end == text.c_str() + text.size());
+        CPPUNIT_ASSERT_EQUAL(values[1], parsed[1]);
+        CPPUNIT_ASSERT(stop == bounded + 8);
+        CPPUNIT_ASSERT_EQUAL(2.5e-300, value);
+    }
+
+    /**
+     * Ensures lists can be read with or without extra whitespace.
+     */
+    void testParseList() {
+        double values[3] = { 0, 0, 0 };
+        const char* text = " [ 1,-0.5 ,\t3e2 ] tail";
+        const char* end = M3d::Format::parseList(text, values, 3);
+        CPPUNIT_ASSERT(end != NULL);
+        CPPUNIT_ASSERT_EQUAL(string(" tail"), string(end));
+        CPPUNIT_ASSERT_EQUAL(1.0, values[0]);
+        CPPUNIT_ASSERT_EQUAL(-0.5, values[1]);
+        CPPUNIT_ASSERT_EQUAL(300.0, values[2]);
+    }
+
+    /**
+     * Ensures malformed lists are rejected.
+     */
+    void testParseListInvalid() {
+        double values[3];
+        CPPUNIT_ASSERT(M3d::Format::parseList("1, 2, 3]", values, 3) == NULL);
+        CPPUNIT_ASSERT(M3d::Format::parseList("[1, 2]", values, 3) == NULL);
+        CPPUNIT_ASSERT(M3d::Format::parseList("[1, 2, 3, 4]", values, 3) == NULL);
+        CPPUNIT_ASSERT(M3d::Format::parseList("[1 2 3]", values, 3) == NULL);
+        CPPUNIT_ASSERT(M3d::Format::parseList("[1, x, 3]", values, 3) == NULL);
+        CPPUNIT_ASSERT(M3d::Format::parseList("[1, 2, 3", values, 3) == NULL);
+        CPPUNIT_ASSERT(M3d::Format::parseList("", values, 3) == NULL);
+    }
+
+    CPPUNIT_TEST_SUITE(FormatTest);
+    CPPUNIT_TEST(testCopy);
+    CPPUNIT_TEST(testFormatDouble);
+    CPPUNIT_TEST(testFormatDoubleRoundTrip);
+    CPPUNIT_TEST(testFormatList);
+    CPPUNIT_TEST(testLocale);
+    CPPUNIT_TEST(testParseDouble);
+    CPPUNIT_TEST(testParseDoubleBounded);
+    CPPUNIT_TEST(testParseList);
+    CPPUNIT_TEST(testParseListInvalid);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(FormatTest::suite());
+    runner.run();
+    return 0;
+}
@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "m3d/Frustum.h"
+using namespace std;
+namespace M3d {
+
+// HELPERS
+
+/*
+ * Scales a plane so its normal is unit length, leaving degenerate planes alone.
+ */
+static Vec4 normalizePlane(const Vec4& plane) {
+    const double len = length(plane.toVec3());
+    return (len > 0) ? (plane / len) : plane;
+}
+
+/*
+ * Appends the indices of objects in a block with a non-negative margin to a list.
+ */
+static size_t appendIndices(const double* margin, size_t begin, size_t end, size_t* visible) {
+    size_t count = 0;
+    for (size_t i = begin; i < end; ++i) {
+        visible[count] = i;
+        count += (margin[i - begin] >= 0);
+    }
+    return count;
+}
+
+// METHODS
+
+/**
+ * Constructs a frustum with all planes zero, which contains everything.
+ */
+Frustum::Frustum() {
+    // pass
+}
+
+/**
+ * Extracts the planes of a view volume from a projection or view-projection matrix.
+ *
+ * Uses the method of Gribb and Hartmann, where each plane is a sum or difference of the last row of the matrix and
+ * one of the other rows.  If the matrix is a view-projection matrix the planes are in world space, and if it is just a
+ * projection matrix the planes are in eye space.
+ *
+ * @param mat Matrix transforming points into clip space
+ * @param depthRange Range of depth in clip space, where reversed depth puts the near plane at `w` and the far plane at
+ *        zero
+ * @return Frustum bounded by the planes of the matrix
+ */
+Frustum Frustum::fromMat4(const Mat4& mat, DepthRange depthRange) {
+
+    const Vec4 r0 = mat.getRow(0);
+    const Vec4 r1 = mat.getRow(1);
+    const Vec4 r2 = mat.getRow(2);
+    const Vec4 r3 = mat.getRow(3);
+
+    Frustum frustum;
+    frustum.planes[LEFT_PLANE] = normalizePlane(r3 + r0);
+    frustum.planes[RIGHT_PLANE] = normalizePlane(r3 - r0);
+    frustum.planes[BOTTOM_PLANE] = normalizePlane(r3 + r1);
+    frustum.planes[TOP_PLANE] = normalizePlane(r3 - r1);
+    switch (depthRange) {
+    case ZERO_TO_ONE:
+        frustum.planes[NEAR_PLANE] = normalizePlane(r2);
+        frustum.planes[FAR_PLANE] = normalizePlane(r3 - r2);
+        break;
+    case ONE_TO_ZERO:
+        frustum.planes[NEAR_PLANE] = normalizePlane(r3 - r2);
+        frustum.planes[FAR_PLANE] = normalizePlane(r2);
+        break;
+    default:
+        frustum.planes[NEAR_PLANE] = normalizePlane(r3 + r2);
+        frustum.planes[FAR_PLANE] = normalizePlane(r3 - r2);
+        break;
+    }
+    return frustum;
+}
+
+/**
+ * Returns one of the planes bounding the frustum.
+ *
+ * @param i Index of plane, in the range [0 .. 5]
+ * @return Reference to the plane
+ * @throws std::out_of_range if index is out of bounds
+ */
+const Vec4& Frustum::getPlane(int i) const {
+    if (((unsigned int) i) >= PLANE_COUNT) {
+        throw out_of_range("[Frustum] Index out of bounds!");
+    } else {
+        return planes[i];
+    }
+}
+
+/**
+ * Checks if a point is inside the frustum.
+ *
+ * @param p Point to check
+ * @return `true` if the point is inside or on all planes
+ */
+bool Frustum::containsPoint(const Vec3& p) const {
+    for (int i = 0; i < PLANE_COUNT; ++i) {
+        if (dot(planes[i], Vec4(p, 1)) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks if an axis-aligned box may be visible.
+ *
+ * The test is conservative, so a large box just outside a corner of the frustum may be reported as visible.
+ *
+ * @param lower Minimum corner of box
+ * @param upper Maximum corner of box
+ * @return `false` if the box is definitely outside the frustum
+ */
+bool Frustum::intersectsBox(const Vec3& lower, const Vec3& upper) const {
+    for (int i = 0; i < PLANE_COUNT; ++i) {
+        const Vec4& plane = planes[i];
+        const double x = (plane.x >= 0) ? upper.x : lower.x;
+        const double y = (plane.y >= 0) ? upper.y : lower.y;
+        const double z = (plane.z >= 0) ? upper.z : lower.z;
+        if ((plane.x * x) + (plane.y * y) + (plane.z * z) + plane.w < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks if a sphere may be visible.
+ *
+ * The test is conservative, so a large sphere just outside a corner of the frustum may be reported as visible.
+ *
+ * @param center Center of sphere
+ * @param radius Radius of sphere
+ * @return `false` if the sphere is definitely outside the frustum
+ */
+bool Frustum::intersectsSphere(const Vec3& center, double radius) const {
+    for (int i = 0; i < PLANE_COUNT; ++i) {
+        if (dot(planes[i], Vec4(center, 1)) < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Finds the axis-aligned boxes that may be visible.
+ *
+ * @param lower Minimum corners of boxes
+ * @param upper Maximum corners of boxes, the same size as `lower`
+ * @param visible List to store indices of visible boxes in, which is resized to the number found
+ * @return Number of visible boxes
+ */
+size_t Frustum::findVisibleBoxes(const Vec3Array& lower, const Vec3Array& upper, vector<size_t>& visible) const {
+
+    const size_t n = lower.size();
+    double margin[BLOCK_SIZE];
+    size_t count = 0;
+
+    visible.resize(n);
+    for (size_t begin = 0; begin < n; begin += BLOCK_SIZE) {
+        const size_t end = std::min(begin + BLOCK_SIZE, n);
+        testBoxes(lower, upper, begin, end, margin);
+        count += appendIndices(margin, begin, end, &visible[count]);
+    }
+    visible.resize(count);
+    return count;
+}
+
+/**
+ * Finds the spheres that may be visible.
+ *
+ * @param centers Centers of spheres
+ * @param radii Radii of spheres, the same size as `centers`
+ * @param visible List to store indices of visible spheres in, which is resized to the number found
+ * @return Number of visible spheres
+ */
+size_t Frustum::findVisibleSpheres(const Vec3Array& centers,
+                                   const vector<double>& radii,
+                                   vector<size_t>& visible) const {
+
+    const size_t n = centers.size();
+    double margin[BLOCK_SIZE];
+    size_t count = 0;
+
+    visible.resize(n);
+    for (size_t begin = 0; begin < n; begin += BLOCK_SIZE) {
+        const size_t end = std::min(begin + BLOCK_SIZE, n);
+        testSpheres(centers, radii, begin, end, margin);
+        count += appendIndices(margin, begin, end, &visible[count]);
+    }
+    visible.resize(count);
+    return count;
+}
+
+/**
+ * Marks the axis-aligned boxes that may be visible in a bitmask.
+ *
+ * @param lower Minimum corners of boxes
+ * @param upper Maximum corners of boxes, the same size as `lower`
+ * @param mask Bitmask to store results in, which is resized to hold one bit per box
+ * @return Number of visible boxes
+ */
+size_t Frustum::markVisibleBoxes(const Vec3Array& lower, const Vec3Array& upper, vector<uint32_t>& mask) const {
+
+    const size_t n = lower.size();
+    double margin[BLOCK_SIZE];
+    size_t count = 0;
+
+    mask.resize((n + 31) / 32);
+    for (size_t begin = 0; begin < n; begin += BLOCK_SIZE) {
+        const size_t end = std::min(begin + BLOCK_SIZE, n);
+        testBoxes(lower, upper, begin, end, margin);
+        count += Bitmask::setFromMargins(margin, begin, end, &mask[0]);
+    }
+    return count;
+}
+
+/**
+ * Marks the spheres that may be visible in a bitmask.
+ *
+ * @param centers Centers of spheres
+ * @param radii Radii of spheres, the same size as `centers`
+ * @param mask Bitmask to store results in, which is resized to hold one bit per sphere
+ * @return Number of visible spheres
+ */
+size_t Frustum::markVisibleSpheres(const Vec3Array& centers,
+                                   const vector<double>& radii,
+                                   vector<uint32_t>& mask) const {
+
+    const size_t n = centers.size();
+    double margin[BLOCK_SIZE];
+    size_t count = 0;
+
+    mask.resize((n + 31) / 32);
+    for (size_t begin = 0; begin < n; begin += BLOCK_SIZE) {
+        const size_t end = std::min(begin + BLOCK_SIZE, n);
+        testSpheres(centers, radii, begin, end, margin);
+        count += Bitmask::setFromMargins(margin, begin, end, &mask[0]);
+    }
+    return count;
+}
+
+// HELPERS
+
+/*
+ * Finds how far inside all planes each box in a block is, where a negative margin means the box is outside.
+ *
+ * For each plane only the corner furthest along the plane's normal needs to be tested, and since the normal is the
+ * same for the whole block, the component arrays for that corner can be chosen once per plane.  The inner loop is then
+ * a straight run of multiplies and minimums over contiguous arrays, which the compiler can vectorize.
+ */
+void Frustum::testBoxes(const Vec3Array& lower,
+                        const Vec3Array& upper,
+                        size_t begin,
+                        size_t end,
+                        double* margin) const {
+
+    const size_t n = end - begin;
+
+    for (size_t i = 0; i < n; ++i) {
+        margin[i] = HUGE_VAL;
+    }
+    for (int p = 0; p < PLANE_COUNT; ++p) {
+        const double a = planes[p].x;
+        const double b = planes[p].y;
+        const double c = planes[p].z;
+        const double d = planes[p].w;
+        const double* x = &((a >= 0) ? upper.x : lower.x)[begin];
+        const double* y = &((b >= 0) ? upper.y : lower.y)[begin];
+        const double* z = &((c >= 0) ? upper.z : lower.z)[begin];
+        for (size_t i = 0; i < n; ++i) {
+            const double distance = (a * x[i]) + (b * y[i]) + (c * z[i]) + d;
+            margin[i] = (distance < margin[i]) ? distance : margin[i];
+        }
+    }
+}
+
+/*
+ * Finds how far inside all planes each sphere in a block is, where a negative margin means the sphere is outside.
+ */
+void Frustum::testSpheres(const Vec3Array& centers,
+                          const vector<double>& radii,
+                          size_t begin,
+                          size_t end,
+                          double* margin) const {
+
+    const size_t n = end - begin;
+    const double* x = &centers.x[begin];
+    const double* y = &centers.y[begin];
+    const double* z = &centers.z[begin];
+    const double* r = &radii[begin];
+
+    for (size_t i = 0; i < n; ++i) {
+        margin[i] = HUGE_VAL;
+    }
+    for (int p = 0; p < PLANE_COUNT; ++p) {
+        const double a = planes[p].x;
+        const double b = planes[p].y;
+        const double c = planes[p].z;
+        const double d = planes[p].w;
+        for (size_t i = 0; i < n; ++i) {
+            const double distance = (a * x[i]) + (b * y[i]) + (c * z[i]) + d + r[i];
+            margin[i] = (distance < margin[i]) ? distance : margin[i];
+        }
+    }
+}
+
+} /* namespace M3d */
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_FRUSTUM_H
+#define M3D_FRUSTUM_H
+#include "m3d/common.h"
+#include <stdint.h>
+#include <vector>
+#include "m3d/Bitmask.h"
+#include "m3d/Mat4.h"
+#include "m3d/Vec3.h"
+#include "m3d/Vec3Array.h"
+#include "m3d/Vec4.h"
+namespace M3d {
+
+
+/**
+ * View volume bounded by six planes, for culling objects that cannot be seen.
+ *
+ * Each plane is stored as a vector `(a, b, c, d)` whose normal `(a, b, c)` is unit length and points into the volume,
+ * so a point `p` is on the inside of the plane when `a * p.x + b * p.y + c * p.z + d >= 0`.
+ *
+ * The batch methods take bounds as separate arrays of components so each plane can be tested against many objects at
+ * once with SIMD instructions.  Results are written either as a compact list of visible indices or as a bitmask with
+ * one bit per object, where bit `i % 32` of word `i / 32` is set if object `i` is visible.
+ */
+class Frustum {
+public:
+// Types
+    /** Range of depth in clip space */
+    enum DepthRange {
+        MINUS_ONE_TO_ONE, ///< Near at -w and far at w, as in OpenGL
+        ZERO_TO_ONE, ///< Near at 0 and far at w, as in Direct3D and Vulkan
+        ONE_TO_ZERO ///< Near at w and far at 0, for reversed depth
+    };
+// Constants
+    static const int PLANE_COUNT = 6; ///< Number of planes bounding the volume
+    static const int LEFT_PLANE = 0; ///< Index of left plane
+    static const int RIGHT_PLANE = 1; ///< Index of right plane
+    static const int BOTTOM_PLANE = 2; ///< Index of bottom plane
+    static const int TOP_PLANE = 3; ///< Index of top plane
+    static const int NEAR_PLANE = 4; ///< Index of near plane
+    static const int FAR_PLANE = 5; ///< Index of far plane
+// Methods
+    explicit Frustum();
+    static Frustum fromMat4(const Mat4& mat, DepthRange depthRange = MINUS_ONE_TO_ONE);
+    const Vec4& getPlane(int i) const;
+    bool containsPoint(const Vec3& p) const;
+    bool intersectsBox(const Vec3& lower, const Vec3& upper) const;
+    bool intersectsSphere(const Vec3& center, double radius) const;
+    size_t findVisibleBoxes(const Vec3Array& lower, const Vec3Array& upper, std::vector<size_t>& visible) const;
+    size_t findVisibleSpheres(const Vec3Array& centers, const std::vector<double>& radii,
+                              std::vector<size_t>& visible) const;
+    size_t markVisibleBoxes(const Vec3Array& lower, const Vec3Array& upper, std::vector<uint32_t>& mask) const;
+    size_t markVisibleSpheres(const Vec3Array& centers, const std::vector<double>& radii,
+                              std::vector<uint32_t>& mask) const;
+private:
+// Constants
+    static const size_t BLOCK_SIZE = 256;
+// Attributes
+    Vec4 planes[PLANE_COUNT];
+// Helpers
+    void testBoxes(const Vec3Array& lower, const Vec3Array& upper, size_t begin, size_t end,
+                   double* margin) const;
+    void testSpheres(const Vec3Array& centers, const std::vector<double>& radii, size_t begin, size_t end,
+                     double* margin) const;
+};
+
+} /* namespace M3d */
+#endif
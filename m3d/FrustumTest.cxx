@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cstdlib>
+#include <stdexcept>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/Frustum.h"
+#include "m3d/Math.h"
+#include "m3d/Projection.h"
+using namespace std;
+
+/*
+ * Constants
+ */
+const double TOLERANCE = 1e-9;
+
+
+/**
+ * Unit test for Frustum.
+ */
+class FrustumTest : public CppUnit::TestFixture {
+private:
+    M3d::Frustum frustum;
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + (upper - lower) * (rand() / (double) RAND_MAX);
+    }
+
+public:
+
+    /**
+     * Prepares the fixture before running each test case.
+     *
+     * The camera sits at (0, 0, 10) looking down the negative Z axis with a 90 degree field of view, so the view
+     * volume spans from Z = 9 to Z = -90.
+     */
+    void setUp() {
+        M3d::Mat4 projection, view, inv;
+        M3d::perspective(M3d::toRadians(90), 1.0, 1.0, 100.0, projection, inv);
+        M3d::lookAt(M3d::Vec3(0, 0, 10), M3d::Vec3(0, 0, 0), M3d::Vec3(0, 1, 0), view, inv);
+        frustum = M3d::Frustum::fromMat4(projection * view);
+    }
+
+    /**
+     * Ensures the extracted planes are normalized and point inwards.
+     */
+    void testFromMat4() {
+        const M3d::Vec4& nearPlane = frustum.getPlane(M3d::Frustum::NEAR_PLANE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, nearPlane.x, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, nearPlane.y, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(-1.0, nearPlane.z, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(9.0, nearPlane.w, TOLERANCE);
+        const M3d::Vec4& left = frustum.getPlane(M3d::Frustum::LEFT_PLANE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, M3d::length(left.toVec3()), TOLERANCE);
+        CPPUNIT_ASSERT(left.x > 0);
+    }
+
+    /**
+     * Checks that a frustum from a projection spanning Z = -1 to Z = -100 has its near and far planes labeled.
+     */
+    static void checkNearAndFar(const M3d::Frustum& f) {
+        const M3d::Vec4& nearPlane = f.getPlane(M3d::Frustum::NEAR_PLANE);
+        const M3d::Vec4& farPlane = f.getPlane(M3d::Frustum::FAR_PLANE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(-1.0, nearPlane.z, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(-1.0, nearPlane.w, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, farPlane.z, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(100.0, farPlane.w, TOLERANCE);
+        CPPUNIT_ASSERT(f.containsPoint(M3d::Vec3(0, 0, -1.5)));
+        CPPUNIT_ASSERT(f.containsPoint(M3d::Vec3(0, 0, -99)));
+        CPPUNIT_ASSERT(!f.containsPoint(M3d::Vec3(0, 0, -0.5)));
+        CPPUNIT_ASSERT(!f.containsPoint(M3d::Vec3(0, 0, -101)));
+    }
+
+    /**
+     * Ensures projections with depth in [0 .. 1], standard or reversed, give the right near and far planes.
+     */
+    void testFromMat4ZeroToOne() {
+
+        // Standard depth, made by remapping depth of an OpenGL projection from [-1 .. 1] to [0 .. 1]
+        M3d::Mat4 projection, inv;
+        M3d::perspective(M3d::toRadians(90), 1.0, 1.0, 100.0, projection, inv);
+        M3d::Mat4 remap(1);
+        remap[2][2] = 0.5;
+        remap[3][2] = 0.5;
+        checkNearAndFar(M3d::Frustum::fromMat4(remap * projection, M3d::Frustum::ZERO_TO_ONE));
+
+        // Reversed depth
+        M3d::perspectiveReversed(M3d::toRadians(90), 1.0, 1.0, 100.0, projection, inv);
+        checkNearAndFar(M3d::Frustum::fromMat4(projection, M3d::Frustum::ONE_TO_ZERO));
+    }
+
+    /**
+     * Ensures getPlane rejects indices out of bounds.
+     */
+    void testGetPlaneOutOfBounds() {
+        CPPUNIT_ASSERT_THROW(frustum.getPlane(6), out_of_range);
+    }
+
+    /**
+     * Ensures containsPoint works correctly.
+     */
+    void testContainsPoint() {
+        CPPUNIT_ASSERT(frustum.containsPoint(M3d::Vec3(0, 0, 0)));
+        CPPUNIT_ASSERT(frustum.containsPoint(M3d::Vec3(9, 0, 0)));
+        CPPUNIT_ASSERT(!frustum.containsPoint(M3d::Vec3(11, 0, 0)));
+        CPPUNIT_ASSERT(!frustum.containsPoint(M3d::Vec3(0, 0, 9.5)));
+        CPPUNIT_ASSERT(!frustum.containsPoint(M3d::Vec3(0, 0, -91)));
+    }
+
+    /**
+     * Ensures intersectsSphere works correctly.
+     */
+    void testIntersectsSphere() {
+        CPPUNIT_ASSERT(frustum.intersectsSphere(M3d::Vec3(0, 0, 0), 1));
+        CPPUNIT_ASSERT(frustum.intersectsSphere(M3d::Vec3(0, 0, 9.5), 1));
+        CPPUNIT_ASSERT(!frustum.intersectsSphere(M3d::Vec3(0, 0, 11), 1));
+        CPPUNIT_ASSERT(!frustum.intersectsSphere(M3d::Vec3(20, 0, 0), 5));
+    }
+
+    /**
+     * Ensures intersectsBox works correctly.
+     */
+    void testIntersectsBox() {
+        CPPUNIT_ASSERT(frustum.intersectsBox(M3d::Vec3(-1, -1, -1), M3d::Vec3(1, 1, 1)));
+        CPPUNIT_ASSERT(frustum.intersectsBox(M3d::Vec3(9, -1, -1), M3d::Vec3(30, 1, 1)));
+        CPPUNIT_ASSERT(!frustum.intersectsBox(M3d::Vec3(12, -1, -1), M3d::Vec3(30, 1, 1)));
+        CPPUNIT_ASSERT(!frustum.intersectsBox(M3d::Vec3(-1, -1, 9.5), M3d::Vec3(1, 1, 20)));
+    }
+
+    /**
+     * Ensures the batch sphere tests agree with the single sphere test.
+     */
+    void testFindAndMarkVisibleSpheres() {
+
+        const size_t n = 1000;
+        M3d::Vec3Array centers(n);
+        vector<double> radii(n);
+        for (size_t i = 0; i < n; ++i) {
+            centers.set(i, M3d::Vec3(random(-100, 100), random(-100, 100), random(-100, 20)));
+            radii[i] = random(0, 10);
+        }
+
+        vector<size_t> visible;
+        vector<uint32_t> mask;
+        const size_t found = frustum.findVisibleSpheres(centers, radii, visible);
+        const size_t marked = frustum.markVisibleSpheres(centers, radii, mask);
+
+        CPPUNIT_ASSERT_EQUAL(found, marked);
+        CPPUNIT_ASSERT_EQUAL(found, visible.size());
+        CPPUNIT_ASSERT_EQUAL((n + 31) / 32, mask.size());
+        size_t k = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const bool expected = frustum.intersectsSphere(centers.get(i), radii[i]);
+            CPPUNIT_ASSERT_EQUAL(expected, ((mask[i / 32] >> (i % 32)) & 1) != 0);
+            if (expected) {
+                CPPUNIT_ASSERT_EQUAL(i, visible[k++]);
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL(found, k);
+        CPPUNIT_ASSERT(found > 0 && found < n);
+    }
+
+    /**
+     * Ensures the batch box tests agree with the single box test.
+     */
+    void testFindAndMarkVisibleBoxes() {
+
+        const size_t n = 1000;
+        M3d::Vec3Array lower(n), upper(n);
+        for (size_t i = 0; i < n; ++i) {
+            const M3d::Vec3 p(random(-100, 100), random(-100, 100), random(-100, 20));
+            lower.set(i, p);
+            upper.set(i, p + M3d::Vec3(random(0, 10), random(0, 10), random(0, 10)));
+        }
+
+        vector<size_t> visible;
+        vector<uint32_t> mask;
+        const size_t found = frustum.findVisibleBoxes(lower, upper, visible);
+        const size_t marked = frustum.markVisibleBoxes(lower, upper, mask);
+
+        CPPUNIT_ASSERT_EQUAL(found, marked);
+        size_t k = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const bool expected = frustum.intersectsBox(lower.get(i), upper.get(i));
+            CPPUNIT_ASSERT_EQUAL(expected, ((mask[i / 32] >> (i % 32)) & 1) != 0);
+            if (expected) {
+                CPPUNIT_ASSERT_EQUAL(i, visible[k++]);
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL(found, k);
+        CPPUNIT_ASSERT(found > 0 && found < n);
+    }
+
+    CPPUNIT_TEST_SUITE(FrustumTest);
+    CPPUNIT_TEST(testFromMat4);
+    CPPUNIT_TEST(testFromMat4ZeroToOne);
+    CPPUNIT_TEST(testGetPlaneOutOfBounds);
+    CPPUNIT_TEST(testContainsPoint);
+    CPPUNIT_TEST(testIntersectsSphere);
+    CPPUNIT_TEST(testIntersectsBox);
+    CPPUNIT_TEST(testFindAndMarkVisibleSpheres);
+    CPPUNIT_TEST(testFindAndMarkVisibleBoxes);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(FrustumTest::suite());
+    runner.run();
+    return 0;
+}
@@ -0,0 +1,659 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "m3d/Gjk.h"
+using namespace std;
+namespace M3d {
+
+/*
+ * Constants
+ */
+static const double TOLERANCE = 1e-10;
+static const double EPSILON = 1e-20;
+
+
+/*
+ * Face of the polytope grown by the Expanding Polytope Algorithm, wound counter-clockwise seen from outside.
+ */
+struct Gjk::Face {
+    int v[3];
+    Vec3 normal;
+    double distance;
+};
+
+
+/*
+ * Task testing a range of pairs of shapes.
+ */
+class Gjk::PairTask : public ParallelTask {
+public:
+    PairTask(const vector<const ConvexShape*>& shapes, const vector<Pair>& pairs, vector<Result>& results,
+             vector<Simplex>* simplices) :
+            shapes(shapes), pairs(pairs), results(results), simplices(simplices) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const ConvexShape& a = *shapes[pairs[i].first];
+            const ConvexShape& b = *shapes[pairs[i].second];
+            if (simplices == NULL) {
+                results[i] = evaluate(a, b);
+            } else {
+                results[i] = evaluate(a, b, (*simplices)[i]);
+            }
+        }
+    }
+private:
+    const vector<const ConvexShape*>& shapes;
+    const vector<Pair>& pairs;
+    vector<Result>& results;
+    vector<Simplex>* simplices;
+};
+
+
+/*
+ * Keeps some points of a simplex, in the order given.
+ */
+static void keep(Gjk::Simplex& simplex, int count, int i, int j = 0, int k = 0) {
+    const int indices[3] = { i, j, k };
+    Gjk::Simplex kept;
+    for (int n = 0; n < count; ++n) {
+        kept.directions[n] = simplex.directions[indices[n]];
+        kept.a[n] = simplex.a[indices[n]];
+        kept.b[n] = simplex.b[indices[n]];
+    }
+    kept.size = count;
+    simplex = kept;
+}
+
+// RESULT
+
+/**
+ * Constructs a result for shapes that are apart with nothing computed yet.
+ */
+Gjk::Result::Result() : intersecting(false), distance(0), depth(0), iterations(0) {
+    // pass
+}
+
+// SIMPLEX
+
+/**
+ * Constructs an empty simplex, which starts the search from scratch.
+ */
+Gjk::Simplex::Simplex() : size(0) {
+    // pass
+}
+
+/**
+ * Removes every point, so the next search starts from scratch.
+ */
+void Gjk::Simplex::clear() {
+    size = 0;
+}
+
+/**
+ * Returns one point of the Minkowski difference.
+ *
+ * @param i Index of the point, less than the size
+ * @return Difference of the support points on A and B
+ * @throws out_of_range if index is out of bounds
+ */
+Vec3 Gjk::Simplex::getPoint(int i) const {
+    if ((i < 0) || (i >= size)) {
+        throw out_of_range("[Gjk] Index out of bounds!");
+    }
+    return a[i] - b[i];
+}
+
+// METHODS
+
+/**
+ * Tests two shapes from scratch.
+ *
+ * @param a First shape
+ * @param b Second shape
+ * @return Distance and closest points if apart, or depth and deepest points if overlapping
+ */
+Gjk::Result Gjk::evaluate(const ConvexShape& a, const ConvexShape& b) {
+    Simplex simplex;
+    return evaluate(a, b, simplex);
+}
+
+/**
+ * Tests two shapes, starting from a simplex kept from an earlier test of the same shapes.
+ *
+ * @param a First shape
+ * @param b Second shape
+ * @param simplex Simplex to start from, which is replaced with the final simplex
+ * @return Distance and closest points if apart, or depth and deepest points if overlapping
+ */
+Gjk::Result Gjk::evaluate(const ConvexShape& a, const ConvexShape& b, Simplex& simplex) {
+    Result result;
+    if (search(a, b, simplex, result)) {
+        Simplex polytope = simplex;
+        findPenetration(a, b, polytope, result);
+    }
+    return result;
+}
+
+/**
+ * Tests many pairs of shapes from scratch on several threads.
+ *
+ * @param shapes Shapes referred to by the pairs
+ * @param pairs Indices of shapes to test, e.g. from a broadphase
+ * @param results List to store one result per pair in
+ */
+void Gjk::evaluate(const vector<const ConvexShape*>& shapes, const vector<Pair>& pairs, vector<Result>& results) {
+    results.resize(pairs.size());
+    PairTask task(shapes, pairs, results, NULL);
+    Parallel::run(task, pairs.size(), GRAIN_SIZE);
+}
+
+/**
+ * Tests many pairs of shapes on several threads, starting from simplices kept from earlier tests.
+ *
+ * @param shapes Shapes referred to by the pairs
+ * @param pairs Indices of shapes to test, in the same order as last time
+ * @param results List to store one result per pair in
+ * @param simplices Simplex to start from for each pair, which is resized to match the pairs and then replaced with the
+ *                  final simplices
+ */
+void Gjk::evaluate(const vector<const ConvexShape*>& shapes, const vector<Pair>& pairs, vector<Result>& results,
+                   vector<Simplex>& simplices) {
+    results.resize(pairs.size());
+    simplices.resize(pairs.size());
+    PairTask task(shapes, pairs, results, &simplices);
+    Parallel::run(task, pairs.size(), GRAIN_SIZE);
+}
+
+/**
+ * Checks if two shapes overlap or touch, without finding how deep.
+ *
+ * @param a First shape
+ * @param b Second shape
+ * @return `true` if the shapes overlap or touch
+ */
+bool Gjk::intersects(const ConvexShape& a, const ConvexShape& b) {
+    Simplex simplex;
+    Result result;
+    return search(a, b, simplex, result);
+}
+
+// HELPERS
+
+/*
+ * Adds the point of the Minkowski difference farthest along a direction to a simplex.
+ */
+void Gjk::addVertex(const ConvexShape& a, const ConvexShape& b, const Vec3& direction, Simplex& simplex) {
+    const int n = simplex.size++;
+    simplex.directions[n] = direction;
+    simplex.a[n] = a.getSupport(direction);
+    simplex.b[n] = b.getSupport(-direction);
+}
+
+/*
+ * Adds points to a simplex until it is a tetrahedron with some volume, or returns false if the difference is flat.
+ */
+bool Gjk::expand(const ConvexShape& a, const ConvexShape& b, Simplex& simplex) {
+
+    static const Vec3 AXES[6] = { Vec3(1, 0, 0), Vec3(-1, 0, 0), Vec3(0, 1, 0),
+                                  Vec3(0, -1, 0), Vec3(0, 0, 1), Vec3(0, 0, -1) };
+
+    // Add a point off the first
+    if (simplex.size == 1) {
+        for (int i = 0; (i < 6) && (simplex.size == 1); ++i) {
+            addVertex(a, b, AXES[i], simplex);
+            const Vec3 e = simplex.getPoint(1) - simplex.getPoint(0);
+            if (!(dot(e, e) > TOLERANCE)) {
+                --simplex.size;
+            }
+        }
+    }
+
+    // Add a point off the line
+    if (simplex.size == 2) {
+        const Vec3 e = simplex.getPoint(1) - simplex.getPoint(0);
+        const Vec3 u = fabs(e.x) < fabs(e.y) ? ((fabs(e.x) < fabs(e.z)) ? AXES[0] : AXES[4])
+                                             : ((fabs(e.y) < fabs(e.z)) ? AXES[2] : AXES[4]);
+        const Vec3 d1 = normalize(cross(e, u));
+        const Vec3 d2 = normalize(cross(e, d1));
+        const Vec3 directions[4] = { d1, -d1, d2, -d2 };
+        for (int i = 0; (i < 4) && (simplex.size == 2); ++i) {
+            addVertex(a, b, directions[i], simplex);
+            const Vec3 off = cross(simplex.getPoint(2) - simplex.getPoint(0), e);
+            if (!(dot(off, off) > TOLERANCE * dot(e, e))) {
+                --simplex.size;
+            }
+        }
+    }
+
+    // Add a point off the plane
+    if (simplex.size == 3) {
+        const Vec3 p = simplex.getPoint(0);
+        const Vec3 n = normalize(cross(simplex.getPoint(1) - p, simplex.getPoint(2) - p));
+        for (int i = 0; (i < 2) && (simplex.size == 3); ++i) {
+            addVertex(a, b, (i == 0) ? n : -n, simplex);
+            if (!(fabs(dot(n, simplex.getPoint(3) - p)) > sqrt(TOLERANCE))) {
+                --simplex.size;
+            }
+        }
+    }
+    return simplex.size == 4;
+}
+
+/*
+ * Finds how deep two overlapping shapes go into each other, using the Expanding Polytope Algorithm.
+ *
+ * The polytope starts as the final simplex of the search and grows toward the face of the Minkowski difference
+ * closest to the origin, which gives the smallest move that separates the shapes.
+ */
+void Gjk::findPenetration(const ConvexShape& a, const ConvexShape& b, Simplex& simplex, Result& result) {
+
+    result.intersecting = true;
+    result.distance = 0;
+
+    // Fall back to the centers if the difference is flat
+    if (!expand(a, b, simplex)) {
+        const Vec3 d = b.getCenter() - a.getCenter();
+        result.normal = (dot(d, d) > 0) ? normalize(d) : Vec3(1, 0, 0);
+        result.pointA = a.getSupport(result.normal);
+        result.pointB = b.getSupport(-result.normal);
+        result.depth = std::max(dot(result.pointA - result.pointB, result.normal), 0.0);
+        return;
+    }
+
+    // Make the tetrahedron with faces pointing out
+    vector<Vec3> vertices, supportsA, supportsB;
+    for (int i = 0; i < 4; ++i) {
+        vertices.push_back(simplex.getPoint(i));
+        supportsA.push_back(simplex.a[i]);
+        supportsB.push_back(simplex.b[i]);
+    }
+    const Vec3 centroid = (vertices[0] + vertices[1] + vertices[2] + vertices[3]) * 0.25;
+    const int corners[4][3] = { { 0, 1, 2 }, { 0, 3, 1 }, { 0, 2, 3 }, { 1, 3, 2 } };
+    vector<Face> faces;
+    for (int i = 0; i < 4; ++i) {
+        Face face;
+        if (makeFace(vertices, corners[i][0], corners[i][1], corners[i][2], face)) {
+            if (dot(face.normal, vertices[face.v[0]] - centroid) < 0) {
+                makeFace(vertices, corners[i][0], corners[i][2], corners[i][1], face);
+            }
+            faces.push_back(face);
+        }
+    }
+
+    // Grow toward the closest face until it stops moving
+    Face closest = faces[0];
+    for (int iteration = 0; !faces.empty(); ++iteration) {
+        closest = faces[0];
+        for (size_t i = 1; i < faces.size(); ++i) {
+            if (faces[i].distance < closest.distance) {
+                closest = faces[i];
+            }
+        }
+        if (iteration >= MAX_ITERATIONS) {
+            break;
+        }
+        const Vec3 pointA = a.getSupport(closest.normal);
+        const Vec3 pointB = b.getSupport(-closest.normal);
+        const Vec3 w = pointA - pointB;
+        if ((dot(w, closest.normal) - closest.distance) <= TOLERANCE * std::max(1.0, fabs(closest.distance))) {
+            break;
+        }
+
+        // Remove faces the new point can see, keeping the edges around them
+        const int m = (int) vertices.size();
+        vertices.push_back(w);
+        supportsA.push_back(pointA);
+        supportsB.push_back(pointB);
+        vector< pair<int,int> > horizon;
+        for (size_t i = 0; i < faces.size(); ) {
+            if (dot(faces[i].normal, w - vertices[faces[i].v[0]]) > 0) {
+                for (int e = 0; e < 3; ++e) {
+                    const pair<int,int> edge(faces[i].v[e], faces[i].v[(e + 1) % 3]);
+                    const pair<int,int> reversed(edge.second, edge.first);
+                    const vector< pair<int,int> >::iterator it = find(horizon.begin(), horizon.end(), reversed);
+                    if (it != horizon.end()) {
+                        horizon.erase(it);
+                    } else {
+                        horizon.push_back(edge);
+                    }
+                }
+                faces[i] = faces.back();
+                faces.pop_back();
+            } else {
+                ++i;
+            }
+        }
+        if (horizon.empty()) {
+            break;
+        }
+
+        // Connect the edges to the new point
+        for (size_t i = 0; i < horizon.size(); ++i) {
+            Face face;
+            if (makeFace(vertices, horizon[i].first, horizon[i].second, m, face)) {
+                faces.push_back(face);
+            }
+        }
+    }
+
+    // Find where the origin projects onto the closest face
+    const Vec3 p = closest.normal * closest.distance;
+    const Vec3& v0 = vertices[closest.v[0]];
+    const Vec3 e1 = vertices[closest.v[1]] - v0;
+    const Vec3 e2 = vertices[closest.v[2]] - v0;
+    const Vec3 e3 = p - v0;
+    const double d11 = dot(e1, e1), d12 = dot(e1, e2), d22 = dot(e2, e2);
+    const double d31 = dot(e3, e1), d32 = dot(e3, e2);
+    const double denominator = (d11 * d22) - (d12 * d12);
+    const double v = (denominator != 0) ? (((d22 * d31) - (d12 * d32)) / denominator) : 0;
+    const double u = (denominator != 0) ? (((d11 * d32) - (d12 * d31)) / denominator) : 0;
+    const double t = 1 - v - u;
+
+    result.depth = std::max(closest.distance, 0.0);
+    result.normal = closest.normal;
+    result.pointA = (supportsA[closest.v[0]] * t) + (supportsA[closest.v[1]] * v) + (supportsA[closest.v[2]] * u);
+    result.pointB = (supportsB[closest.v[0]] * t) + (supportsB[closest.v[1]] * v) + (supportsB[closest.v[2]] * u);
+}
+
+/*
+ * Makes a face of a polytope from three of its vertices.
+ */
+bool Gjk::makeFace(const vector<Vec3>& vertices, int i, int j, int k, Face& face) {
+    const Vec3 n = cross(vertices[j] - vertices[i], vertices[k] - vertices[i]);
+    const double len = length(n);
+    if (!(len > 0)) {
+        return false;
+    }
+    face.v[0] = i;
+    face.v[1] = j;
+    face.v[2] = k;
+    face.normal = n / len;
+    face.distance = dot(face.normal, vertices[i]);
+    return true;
+}
+
+/*
+ * Searches for the point of the Minkowski difference closest to the origin, using the Gilbert-Johnson-Keerthi
+ * algorithm, and returns true if the difference contains the origin.
+ *
+ * If the shapes are apart, the distance, normal and closest points are stored in the result.
+ */
+bool Gjk::search(const ConvexShape& a, const ConvexShape& b, Simplex& simplex, Result& result) {
+
+    // Refresh cached points, dropping any that are now the same
+    const int cached = simplex.size;
+    simplex.size = 0;
+    for (int i = 0; i < cached; ++i) {
+        addVertex(a, b, simplex.directions[i], simplex);
+        for (int j = 0; j < simplex.size - 1; ++j) {
+            if (simplex.getPoint(j) == simplex.getPoint(simplex.size - 1)) {
+                --simplex.size;
+                break;
+            }
+        }
+    }
+    if (simplex.size == 0) {
+        const Vec3 d = b.getCenter() - a.getCenter();
+        addVertex(a, b, (dot(d, d) > 0) ? d : Vec3(1, 0, 0), simplex);
+    }
+
+    // Move the simplex toward the origin
+    double weights[4];
+    Vec3 v;
+    result.iterations = 0;
+    for (;;) {
+        if (solve(simplex, weights, v)) {
+            return true;
+        }
+        const double vv = dot(v, v);
+        if (vv <= EPSILON) {
+            return true;
+        } else if (result.iterations >= MAX_ITERATIONS) {
+            break;
+        }
+        const Vec3 w = a.getSupport(-v) - b.getSupport(v);
+        if ((vv - dot(v, w)) <= TOLERANCE * vv) {
+            break;
+        }
+        bool repeated = false;
+        for (int i = 0; i < simplex.size; ++i) {
+            repeated |= (simplex.getPoint(i) == w);
+        }
+        if (repeated) {
+            break;
+        }
+        addVertex(a, b, -v, simplex);
+        ++result.iterations;
+    }
+
+    // Combine support points with the weights of the closest point
+    result.intersecting = false;
+    result.pointA = Vec3(0, 0, 0);
+    result.pointB = Vec3(0, 0, 0);
+    for (int i = 0; i < simplex.size; ++i) {
+        result.pointA = result.pointA + (simplex.a[i] * weights[i]);
+        result.pointB = result.pointB + (simplex.b[i] * weights[i]);
+    }
+    result.distance = sqrt(dot(v, v));
+    result.normal = v / -result.distance;
+    return false;
+}
+
+/*
+ * Finds the point of a simplex closest to the origin, reducing the simplex to the points needed to describe it.
+ *
+ * Returns true if the simplex is a tetrahedron containing the origin, in which case it is left alone.
+ */
+bool Gjk::solve(Simplex& simplex, double weights[4], Vec3& closest) {
+    bool inside = false;
+    switch (simplex.size) {
+    case 1:
+        weights[0] = 1;
+        closest = simplex.getPoint(0);
+        break;
+    case 2:
+        solveSegment(simplex, weights, closest);
+        break;
+    case 3:
+        solveTriangle(simplex, weights, closest);
+        break;
+    default:
+        solveTetrahedron(simplex, weights, closest, inside);
+        break;
+    }
+    return inside;
+}
+
+/*
+ * Finds the point of a segment closest to the origin.
+ */
+void Gjk::solveSegment(Simplex& simplex, double weights[4], Vec3& closest) {
+
+    const Vec3 p0 = simplex.getPoint(0);
+    const Vec3 e = simplex.getPoint(1) - p0;
+    const double ee = dot(e, e);
+    const double t = (ee > 0) ? (-dot(p0, e) / ee) : 0;
+
+    if (t <= 0) {
+        keep(simplex, 1, 0);
+        weights[0] = 1;
+        closest = p0;
+    } else if (t >= 1) {
+        keep(simplex, 1, 1);
+        weights[0] = 1;
+        closest = simplex.getPoint(0);
+    } else {
+        weights[0] = 1 - t;
+        weights[1] = t;
+        closest = p0 + (e * t);
+    }
+}
+
+/*
+ * Finds the point of a tetrahedron closest to the origin, checking each face the origin is outside of.
+ */
+void Gjk::solveTetrahedron(Simplex& simplex, double weights[4], Vec3& closest, bool& inside) {
+
+    static const int FACES[4][4] = { { 0, 1, 2, 3 }, { 0, 1, 3, 2 }, { 0, 2, 3, 1 }, { 1, 2, 3, 0 } };
+
+    Vec3 p[4];
+    for (int i = 0; i < 4; ++i) {
+        p[i] = simplex.getPoint(i);
+    }
+
+    // Treat every face as outside if the tetrahedron is flat
+    const double volume = dot(p[1] - p[0], cross(p[2] - p[0], p[3] - p[0]));
+    double scale = 0;
+    for (int i = 1; i < 4; ++i) {
+        scale = std::max(scale, dot(p[i] - p[0], p[i] - p[0]));
+    }
+    const bool flat = fabs(volume) <= TOLERANCE * scale * sqrt(scale);
+
+    // Find closest point on faces facing the origin
+    double best = HUGE_VAL;
+    Simplex result = simplex;
+    inside = true;
+    for (int f = 0; f < 4; ++f) {
+        const Vec3& a = p[FACES[f][0]];
+        const Vec3 n = cross(p[FACES[f][1]] - a, p[FACES[f][2]] - a);
+        if (!flat && ((dot(n, -a) * dot(n, p[FACES[f][3]] - a)) >= 0)) {
+            continue;
+        }
+        inside = false;
+        Simplex face = simplex;
+        keep(face, 3, FACES[f][0], FACES[f][1], FACES[f][2]);
+        double w[4];
+        Vec3 v;
+        solveTriangle(face, w, v);
+        if (dot(v, v) < best) {
+            best = dot(v, v);
+            result = face;
+            copy(w, w + 4, weights);
+            closest = v;
+        }
+    }
+    if (!inside) {
+        simplex = result;
+    }
+}
+
+/*
+ * Finds the point of a triangle closest to the origin, following Ericson.
+ */
+void Gjk::solveTriangle(Simplex& simplex, double weights[4], Vec3& closest) {
+
+    const Vec3 a = simplex.getPoint(0);
+    const Vec3 b = simplex.getPoint(1);
+    const Vec3 c = simplex.getPoint(2);
+    const Vec3 ab = b - a;
+    const Vec3 ac = c - a;
+
+    // Check vertex regions and edge regions
+    const double d1 = -dot(ab, a), d2 = -dot(ac, a);
+    if ((d1 <= 0) && (d2 <= 0)) {
+        keep(simplex, 1, 0);
+        weights[0] = 1;
+        closest = a;
+        return;
+    }
+    const double d3 = -dot(ab, b), d4 = -dot(ac, b);
+    if ((d3 >= 0) && (d4 <= d3)) {
+        keep(simplex, 1, 1);
+        weights[0] = 1;
+        closest = b;
+        return;
+    }
+    const double vc = (d1 * d4) - (d3 * d2);
+    if ((vc <= 0) && (d1 >= 0) && (d3 <= 0)) {
+        const double t = d1 / (d1 - d3);
+        keep(simplex, 2, 0, 1);
+        weights[0] = 1 - t;
+        weights[1] = t;
+        closest = a + (ab * t);
+        return;
+    }
+    const double d5 = -dot(ab, c), d6 = -dot(ac, c);
+    if ((d6 >= 0) && (d5 <= d6)) {
+        keep(simplex, 1, 2);
+        weights[0] = 1;
+        closest = c;
+        return;
+    }
+    const double vb = (d5 * d2) - (d1 * d6);
+    if ((vb <= 0) && (d2 >= 0) && (d6 <= 0)) {
+        const double t = d2 / (d2 - d6);
+        keep(simplex, 2, 0, 2);
+        weights[0] = 1 - t;
+        weights[1] = t;
+        closest = a + (ac * t);
+        return;
+    }
+    const double va = (d3 * d6) - (d5 * d4);
+    if ((va <= 0) && ((d4 - d3) >= 0) && ((d5 - d6) >= 0)) {
+        const double t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        keep(simplex, 2, 1, 2);
+        weights[0] = 1 - t;
+        weights[1] = t;
+        closest = b + ((c - b) * t);
+        return;
+    }
+
+    // Use the longest edge if the triangle is flat
+    const double sum = va + vb + vc;
+    if (!(sum > 0)) {
+        const int edges[3][2] = { { 0, 1 }, { 0, 2 }, { 1, 2 } };
+        double best = HUGE_VAL;
+        Simplex result = simplex;
+        for (int e = 0; e < 3; ++e) {
+            Simplex edge = simplex;
+            keep(edge, 2, edges[e][0], edges[e][1]);
+            double w[4];
+            Vec3 v;
+            solveSegment(edge, w, v);
+            if (dot(v, v) < best) {
+                best = dot(v, v);
+                result = edge;
+                copy(w, w + 4, weights);
+                closest = v;
+            }
+        }
+        simplex = result;
+        return;
+    }
+
+    // Inside the face
+    const double v = vb / sum;
+    const double w = vc / sum;
+    weights[0] = 1 - v - w;
+    weights[1] = v;
+    weights[2] = w;
+    closest = a + (ab * v) + (ac * w);
+}
+
+} /* namespace M3d */
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_GJK_H
+#define M3D_GJK_H
+#include "m3d/common.h"
+#include <stdint.h>
+#include <utility>
+#include <vector>
+#include "m3d/ConvexShape.h"
+#include "m3d/Parallel.h"
+#include "m3d/Vec3.h"
+namespace M3d {
+
+
+/**
+ * Narrowphase collision detection between convex shapes.
+ *
+ * The Gilbert-Johnson-Keerthi algorithm searches the Minkowski difference of two shapes, `A - B`, for the point
+ * closest to the origin, using only their support functions.  If the shapes are apart, that point gives their distance
+ * and the closest point on each.  If the origin is inside the difference, the shapes overlap, and the Expanding
+ * Polytope Algorithm grows the final simplex out to the surface of the difference to find how deep they overlap and
+ * which way to push them apart.
+ *
+ * Shapes that move a little between frames usually end up with a similar simplex.  Passing the simplex from the
+ * previous frame starts the search from there, which often finishes in one or two steps.
+ */
+class Gjk {
+public:
+// Types
+    struct Result;
+    struct Simplex;
+    typedef std::pair<uint32_t,uint32_t> Pair; ///< Indices of two shapes to test
+// Constants
+    static const int MAX_ITERATIONS = 64; ///< Most steps taken by either algorithm
+// Methods
+    static Result evaluate(const ConvexShape& a, const ConvexShape& b);
+    static Result evaluate(const ConvexShape& a, const ConvexShape& b, Simplex& simplex);
+    static void evaluate(const std::vector<const ConvexShape*>& shapes, const std::vector<Pair>& pairs,
+                         std::vector<Result>& results);
+    static void evaluate(const std::vector<const ConvexShape*>& shapes, const std::vector<Pair>& pairs,
+                         std::vector<Result>& results, std::vector<Simplex>& simplices);
+    static bool intersects(const ConvexShape& a, const ConvexShape& b);
+private:
+// Types
+    struct Face;
+    class PairTask;
+// Constants
+    static const size_t GRAIN_SIZE = 256;
+// Helpers
+    static void addVertex(const ConvexShape& a, const ConvexShape& b, const Vec3& direction, Simplex& simplex);
+    static bool expand(const ConvexShape& a, const ConvexShape& b, Simplex& simplex);
+    static void findPenetration(const ConvexShape& a, const ConvexShape& b, Simplex& simplex, Result& result);
+    static bool makeFace(const std::vector<Vec3>& vertices, int i, int j, int k, Face& face);
+    static bool search(const ConvexShape& a, const ConvexShape& b, Simplex& simplex, Result& result);
+    static bool solve(Simplex& simplex, double weights[4], Vec3& closest);
+    static void solveSegment(Simplex& simplex, double weights[4], Vec3& closest);
+    static void solveTetrahedron(Simplex& simplex, double weights[4], Vec3& closest, bool& inside);
+    static void solveTriangle(Simplex& simplex, double weights[4], Vec3& closest);
+};
+
+
+/**
+ * Outcome of testing two shapes.
+ */
+struct Gjk::Result {
+    bool intersecting; ///< `true` if the shapes overlap or touch
+    double distance; ///< Distance between the shapes, or zero if they overlap
+    double depth; ///< How far the shapes overlap, or zero if they are apart
+    Vec3 normal; ///< Unit direction from A toward B, along which B moves to separate if they overlap
+    Vec3 pointA; ///< Closest or deepest point on A
+    Vec3 pointB; ///< Closest or deepest point on B
+    int iterations; ///< Number of steps taken, for profiling warm starts
+    explicit Result();
+};
+
+
+/**
+ * Up to four points of the Minkowski difference, kept between calls to warm start the search.
+ *
+ * Each point stores the direction that found it, so the support functions can be asked again after the shapes move.
+ */
+struct Gjk::Simplex {
+    Vec3 directions[4]; ///< Direction each point was found along
+    Vec3 a[4]; ///< Support point on A for each direction
+    Vec3 b[4]; ///< Support point on B for the opposite of each direction
+    int size; ///< Number of points, where zero starts from scratch
+    explicit Simplex();
+    void clear();
+    Vec3 getPoint(int i) const;
+};
+
+} /* namespace M3d */
+#endif
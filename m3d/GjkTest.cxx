@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/Gjk.h"
+using namespace std;
+
+/*
+ * Constants
+ */
+const double TOLERANCE = 1e-6;
+
+
+/**
+ * Unit test for Gjk.
+ */
+class GjkTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + (upper - lower) * (rand() / (double) RAND_MAX);
+    }
+
+    /**
+     * Makes a hull from the corners of a box.
+     */
+    static M3d::HullShape makeCube(const M3d::Vec3& center, double half) {
+        M3d::Vec3Array points;
+        for (int i = 0; i < 8; ++i) {
+            points.append(center + M3d::Vec3((i & 1) ? half : -half, (i & 2) ? half : -half, (i & 4) ? half : -half));
+        }
+        return M3d::HullShape(points);
+    }
+
+public:
+
+    /**
+     * Restores the default number of threads after each test case.
+     */
+    void tearDown() {
+        M3d::Parallel::setConcurrency(0);
+    }
+
+    /**
+     * Ensures separated spheres give their distance, closest points and a normal from A to B.
+     */
+    void testSeparatedSpheres() {
+
+        const M3d::SphereShape a(M3d::Vec3(0, 0, 0), 1);
+        const M3d::SphereShape b(M3d::Vec3(3, 4, 0), 2);
+        const M3d::Gjk::Result result = M3d::Gjk::evaluate(a, b);
+
+        CPPUNIT_ASSERT(!result.intersecting);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(2.0, result.distance, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.6, result.normal.x, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.8, result.normal.y, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.6, result.pointA.x, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.8, result.pointB.x, TOLERANCE);
+        CPPUNIT_ASSERT(!M3d::Gjk::intersects(a, b));
+    }
+
+    /**
+     * Ensures separated boxes, capsules and hulls give exact distances.
+     */
+    void testSeparatedShapes() {
+
+        const M3d::BoxShape box(M3d::Vec3(0, 0, 0), M3d::Vec3(1, 1, 1));
+        const M3d::CapsuleShape capsule(M3d::Vec3(4, -1, 0), M3d::Vec3(4, 1, 0), 0.5);
+        const M3d::HullShape hull = makeCube(M3d::Vec3(0.5, 0.3, 5), 1);
+
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(2.5, M3d::Gjk::evaluate(box, capsule).distance, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, M3d::Gjk::evaluate(box, hull).distance, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(-1.0, M3d::Gjk::evaluate(capsule, box).normal.x, TOLERANCE);
+    }
+
+    /**
+     * Ensures overlapping boxes give the depth along the axis of least overlap.
+     */
+    void testOverlappingBoxes() {
+
+        const M3d::BoxShape a(M3d::Vec3(0, 0, 0), M3d::Vec3(1, 1, 1));
+        const M3d::BoxShape b(M3d::Vec3(1.5, 0.2, 0.1), M3d::Vec3(1, 1, 1));
+        const M3d::Gjk::Result result = M3d::Gjk::evaluate(a, b);
+
+        CPPUNIT_ASSERT(result.intersecting);
+        CPPUNIT_ASSERT(M3d::Gjk::intersects(a, b));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, result.distance, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, result.depth, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, result.normal.x, TOLERANCE);
+        const M3d::Vec3 d = result.pointA - result.pointB;
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, d.x, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, result.pointA.x, TOLERANCE);
+    }
+
+    /**
+     * Ensures random pairs of spheres agree with the distances between their centers.
+     */
+    void testRandomSpheres() {
+        for (int i = 0; i < 500; ++i) {
+            const M3d::SphereShape a(M3d::Vec3(random(-5, 5), random(-5, 5), random(-5, 5)), random(0.5, 3));
+            const M3d::SphereShape b(M3d::Vec3(random(-5, 5), random(-5, 5), random(-5, 5)), random(0.5, 3));
+            const double gap = M3d::length(b.center - a.center) - a.radius - b.radius;
+            const M3d::Gjk::Result result = M3d::Gjk::evaluate(a, b);
+            CPPUNIT_ASSERT_EQUAL(gap <= 0, result.intersecting);
+            if (gap > 0) {
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(gap, result.distance, 1e-4);
+            } else {
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(-gap, result.depth, 1e-2);
+                CPPUNIT_ASSERT(M3d::dot(result.normal, b.center - a.center) >= 0);
+            }
+        }
+    }
+
+    /**
+     * Ensures starting from the simplex of an earlier test gives the same answer in fewer steps.
+     */
+    void testWarmStart() {
+
+        const M3d::HullShape a = makeCube(M3d::Vec3(0, 0, 0), 1);
+        M3d::HullShape b = makeCube(M3d::Vec3(3, 0.5, 0.25), 1);
+        M3d::Gjk::Simplex simplex;
+        M3d::Gjk::evaluate(a, b, simplex);
+        CPPUNIT_ASSERT(simplex.size > 0);
+
+        for (size_t i = 0; i < b.points.size(); ++i) {
+            b.points.x[i] += 0.01;
+        }
+        const M3d::Gjk::Result cold = M3d::Gjk::evaluate(a, b);
+        const M3d::Gjk::Result warm = M3d::Gjk::evaluate(a, b, simplex);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.01, cold.distance, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(cold.distance, warm.distance, TOLERANCE);
+        CPPUNIT_ASSERT(warm.iterations < cold.iterations);
+        CPPUNIT_ASSERT_THROW(simplex.getPoint(4), out_of_range);
+    }
+
+    /**
+     * Ensures testing pairs on several threads gives the same results as testing them one at a time.
+     */
+    void testEvaluatePairs() {
+
+        vector<M3d::SphereShape> spheres;
+        vector<M3d::BoxShape> boxes;
+        for (int i = 0; i < 200; ++i) {
+            spheres.push_back(M3d::SphereShape(M3d::Vec3(random(-5, 5), random(-5, 5), random(-5, 5)), 1));
+            boxes.push_back(M3d::BoxShape(M3d::Vec3(random(-5, 5), random(-5, 5), random(-5, 5)),
+                                          M3d::Vec3(random(0.5, 1), random(0.5, 1), random(0.5, 1))));
+        }
+        vector<const M3d::ConvexShape*> shapes;
+        vector<M3d::Gjk::Pair> pairs;
+        for (int i = 0; i < 200; ++i) {
+            shapes.push_back(&spheres[i]);
+            shapes.push_back(&boxes[i]);
+        }
+        for (int i = 0; i < 2000; ++i) {
+            pairs.push_back(M3d::Gjk::Pair(rand() % 400, rand() % 400));
+        }
+
+        M3d::Parallel::setConcurrency(4);
+        vector<M3d::Gjk::Result> results, warm;
+        vector<M3d::Gjk::Simplex> simplices;
+        M3d::Gjk::evaluate(shapes, pairs, results);
+        M3d::Gjk::evaluate(shapes, pairs, warm, simplices);
+        M3d::Gjk::evaluate(shapes, pairs, warm, simplices);
+
+        CPPUNIT_ASSERT_EQUAL(pairs.size(), results.size());
+        CPPUNIT_ASSERT_EQUAL(pairs.size(), simplices.size());
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            const M3d::Gjk::Result expected = M3d::Gjk::evaluate(*shapes[pairs[i].first], *shapes[pairs[i].second]);
+            CPPUNIT_ASSERT_EQUAL(expected.intersecting, results[i].intersecting);
+            CPPUNIT_ASSERT_EQUAL(expected.distance, results[i].distance);
+            CPPUNIT_ASSERT_EQUAL(expected.intersecting, warm[i].intersecting);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.distance, warm[i].distance, 1e-4);
+        }
+    }
+
+    CPPUNIT_TEST_SUITE(GjkTest);
+    CPPUNIT_TEST(testSeparatedSpheres);
+    CPPUNIT_TEST(testSeparatedShapes);
+    CPPUNIT_TEST(testOverlappingBoxes);
+    CPPUNIT_TEST(testRandomSpheres);
+    CPPUNIT_TEST(testWarmStart);
+    CPPUNIT_TEST(testEvaluatePairs);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(GjkTest::suite());
+    runner.run();
+    return 0;
+}
@@ -0,0 +1,398 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+#include "m3d/Half.h"
+using namespace std;
+namespace M3d {
+
+/* Storage types must be contiguous components to be converted as runs */
+typedef char Vec3SizeCheck[(sizeof(Vec3) == 3 * sizeof(double)) ? 1 : -1];
+typedef char Vec4SizeCheck[(sizeof(Vec4) == 4 * sizeof(double)) ? 1 : -1];
+typedef char QuatSizeCheck[(sizeof(Quat) == 4 * sizeof(double)) ? 1 : -1];
+typedef char HalfVec3SizeCheck[(sizeof(HalfVec3) == 3 * sizeof(uint16_t)) ? 1 : -1];
+typedef char HalfVec4SizeCheck[(sizeof(HalfVec4) == 4 * sizeof(uint16_t)) ? 1 : -1];
+typedef char HalfQuatSizeCheck[(sizeof(HalfQuat) == 4 * sizeof(uint16_t)) ? 1 : -1];
+
+
+/*
+ * Task converting a range of a batch.
+ */
+class Half::ConvertTask : public ParallelTask {
+public:
+    ConvertTask(Converter converter, const void* in, void* out) : converter(converter), in(in), out(out) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        converter(in, out, begin, end);
+    }
+private:
+    Converter converter;
+    const void* in;
+    void* out;
+};
+
+// METHODS
+
+/**
+ * Rounds a double to the nearest half.
+ */
+uint16_t Half::fromDouble(double value) {
+
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(double));
+    const uint16_t sign = (uint16_t) ((bits >> 48) & 0x8000);
+    const int exponent = (int) ((bits >> 52) & 0x7FF);
+    const uint64_t mantissa = bits & ((((uint64_t) 1) << 52) - 1);
+
+    // Infinity and not a number, keeping not a number quiet
+    if (exponent == 0x7FF) {
+        return sign | 0x7C00 | ((mantissa != 0) ? (0x200 | (uint16_t) (mantissa >> 42)) : 0);
+    }
+
+    // Too large, or normal
+    const int biased = exponent - 1023 + 15;
+    if (biased >= 31) {
+        return sign | 0x7C00;
+    } else if (biased > 0) {
+        const uint64_t rest = mantissa & ((((uint64_t) 1) << 42) - 1);
+        const uint64_t halfway = ((uint64_t) 1) << 41;
+        uint16_t half = (uint16_t) ((biased << 10) | (int) (mantissa >> 42));
+        if ((rest > halfway) || ((rest == halfway) && (half & 1))) {
+            ++half;
+        }
+        return sign | half;
+    }
+
+    // Subnormal, or too small, where carrying out of the mantissa gives the smallest normal
+    const int shift = 43 - biased;
+    if ((exponent == 0) || (shift >= 64)) {
+        return sign;
+    }
+    const uint64_t full = mantissa | (((uint64_t) 1) << 52);
+    const uint64_t rest = full & ((((uint64_t) 1) << shift) - 1);
+    const uint64_t halfway = ((uint64_t) 1) << (shift - 1);
+    uint16_t half = (uint16_t) (full >> shift);
+    if ((rest > halfway) || ((rest == halfway) && (half & 1))) {
+        ++half;
+    }
+    return sign | half;
+}
+
+/**
+ * Rounds doubles to the nearest halves, on several threads.
+ *
+ * @param values Doubles to convert
+ * @param count Number of doubles
+ * @param halves Array with room for the halves
+ */
+void Half::fromDoubles(const double* values, size_t count, uint16_t* halves) {
+    convert(&convertDoubles, values, halves, count);
+}
+
+/**
+ * Rounds a float to the nearest half.
+ */
+uint16_t Half::fromFloat(float value) {
+    return fromDouble(value);
+}
+
+/**
+ * Rounds floats to the nearest halves, on several threads.
+ *
+ * @param values Floats to convert
+ * @param count Number of floats
+ * @param halves Array with room for the halves
+ */
+void Half::fromFloats(const float* values, size_t count, uint16_t* halves) {
+    convert(&convertFloats, values, halves, count);
+}
+
+/**
+ * Converts a half to a double.
+ */
+double Half::toDouble(uint16_t half) {
+    const int exponent = (half >> 10) & 0x1F;
+    const int mantissa = half & 0x3FF;
+    double value;
+    if (exponent == 0) {
+        value = ldexp((double) mantissa, -24);
+    } else if (exponent < 31) {
+        value = ldexp((double) (mantissa | 0x400), exponent - 25);
+    } else if (mantissa == 0) {
+        value = numeric_limits<double>::infinity();
+    } else {
+        value = numeric_limits<double>::quiet_NaN();
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+/**
+ * Converts halves to doubles, on several threads.
+ *
+ * @param halves Halves to convert
+ * @param count Number of halves
+ * @param values Array with room for the doubles
+ */
+void Half::toDoubles(const uint16_t* halves, size_t count, double* values) {
+    convert(&convertHalvesToDoubles, halves, values, count);
+}
+
+/**
+ * Converts a half to a float.
+ */
+float Half::toFloat(uint16_t half) {
+    return (float) toDouble(half);
+}
+
+/**
+ * Converts halves to floats, on several threads.
+ *
+ * @param halves Halves to convert
+ * @param count Number of halves
+ * @param values Array with room for the floats
+ */
+void Half::toFloats(const uint16_t* halves, size_t count, float* values) {
+    convert(&convertHalvesToFloats, halves, values, count);
+}
+
+// HELPERS
+
+/*
+ * Runs a conversion over a batch on several threads.
+ */
+void Half::convert(Converter converter, const void* in, void* out, size_t count) {
+    ConvertTask task(converter, in, out);
+    Parallel::run(task, count, GRAIN_SIZE);
+}
+
+/*
+ * Rounds a range of doubles to halves.
+ */
+void Half::convertDoubles(const void* in, void* out, size_t begin, size_t end) {
+    const double* const values = static_cast<const double*>(in);
+    uint16_t* const halves = static_cast<uint16_t*>(out);
+    for (size_t i = begin; i < end; ++i) {
+        halves[i] = fromDouble(values[i]);
+    }
+}
+
+/*
+ * Rounds a range of floats to halves.
+ */
+void Half::convertFloats(const void* in, void* out, size_t begin, size_t end) {
+    const float* const values = static_cast<const float*>(in);
+    uint16_t* const halves = static_cast<uint16_t*>(out);
+    size_t i = begin;
+#ifdef __F16C__
+    for (; (i + 8) <= end; i += 8) {
+        const __m128i converted = _mm256_cvtps_ph(_mm256_loadu_ps(values + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(halves + i), converted);
+    }
+#endif
+    for (; i < end; ++i) {
+        halves[i] = fromFloat(values[i]);
+    }
+}
+
+/*
+ * Converts a range of halves to doubles.
+ */
+void Half::convertHalvesToDoubles(const void* in, void* out, size_t begin, size_t end) {
+    const uint16_t* const halves = static_cast<const uint16_t*>(in);
+    double* const values = static_cast<double*>(out);
+    size_t i = begin;
+#ifdef __F16C__
+    for (; (i + 4) <= end; i += 4) {
+        const __m128 floats = _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(halves + i)));
+        _mm256_storeu_pd(values + i, _mm256_cvtps_pd(floats));
+    }
+#endif
+    for (; i < end; ++i) {
+        values[i] = toDouble(halves[i]);
+    }
+}
+
+/*
+ * Converts a range of halves to floats.
+ */
+void Half::convertHalvesToFloats(const void* in, void* out, size_t begin, size_t end) {
+    const uint16_t* const halves = static_cast<const uint16_t*>(in);
+    float* const values = static_cast<float*>(out);
+    size_t i = begin;
+#ifdef __F16C__
+    for (; (i + 8) <= end; i += 8) {
+        const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(halves + i));
+        _mm256_storeu_ps(values + i, _mm256_cvtph_ps(packed));
+    }
+#endif
+    for (; i < end; ++i) {
+        values[i] = toFloat(halves[i]);
+    }
+}
+
+// HALFVEC3 METHODS
+
+/**
+ * Constructs a zero vector.
+ */
+HalfVec3::HalfVec3() : x(0), y(0), z(0) {
+    // pass
+}
+
+/**
+ * Constructs a vector by rounding the components of another.
+ */
+HalfVec3::HalfVec3(const Vec3& vec) : x(Half::fromDouble(vec.x)), y(Half::fromDouble(vec.y)),
+        z(Half::fromDouble(vec.z)) {
+    // pass
+}
+
+/**
+ * Rounds vectors to halves, on several threads.
+ *
+ * @param vecs Vectors to convert
+ * @param count Number of vectors
+ * @param halves Array with room for the converted vectors
+ */
+void HalfVec3::fromVec3s(const Vec3* vecs, size_t count, HalfVec3* halves) {
+    Half::fromDoubles(reinterpret_cast<const double*>(vecs), 3 * count, reinterpret_cast<uint16_t*>(halves));
+}
+
+/**
+ * Converts the vector to doubles.
+ */
+Vec3 HalfVec3::toVec3() const {
+    return Vec3(Half::toDouble(x), Half::toDouble(y), Half::toDouble(z));
+}
+
+/**
+ * Converts vectors of halves to doubles, on several threads.
+ *
+ * @param halves Vectors to convert
+ * @param count Number of vectors
+ * @param vecs Array with room for the converted vectors
+ */
+void HalfVec3::toVec3s(const HalfVec3* halves, size_t count, Vec3* vecs) {
+    Half::toDoubles(reinterpret_cast<const uint16_t*>(halves), 3 * count, reinterpret_cast<double*>(vecs));
+}
+
+// HALFVEC4 METHODS
+
+/**
+ * Constructs a zero vector.
+ */
+HalfVec4::HalfVec4() : x(0), y(0), z(0), w(0) {
+    // pass
+}
+
+/**
+ * Constructs a vector by rounding the components of another.
+ */
+HalfVec4::HalfVec4(const Vec4& vec) : x(Half::fromDouble(vec.x)), y(Half::fromDouble(vec.y)),
+        z(Half::fromDouble(vec.z)), w(Half::fromDouble(vec.w)) {
+    // pass
+}
+
+/**
+ * Rounds vectors to halves, on several threads.
+ *
+ * @param vecs Vectors to convert
+ * @param count Number of vectors
+ * @param halves Array with room for the converted vectors
+ */
+void HalfVec4::fromVec4s(const Vec4* vecs, size_t count, HalfVec4* halves) {
+    Half::fromDoubles(reinterpret_cast<const double*>(vecs), 4 * count, reinterpret_cast<uint16_t*>(halves));
+}
+
+/**
+ * Converts the vector to doubles.
+ */
+Vec4 HalfVec4::toVec4() const {
+    return Vec4(Half::toDouble(x), Half::toDouble(y), Half::toDouble(z), Half::toDouble(w));
+}
+
+/**
+ * Converts vectors of halves to doubles, on several threads.
+ *
+ * @param halves Vectors to convert
+ * @param count Number of vectors
+ * @param vecs Array with room for the converted vectors
+ */
+void HalfVec4::toVec4s(const HalfVec4* halves, size_t count, Vec4* vecs) {
+    Half::toDoubles(reinterpret_cast<const uint16_t*>(halves), 4 * count, reinterpret_cast<double*>(vecs));
+}
+
+// HALFQUAT METHODS
+
+/**
+ * Constructs a quaternion of zeroes.
+ */
+HalfQuat::HalfQuat() : x(0), y(0), z(0), w(0) {
+    // pass
+}
+
+/**
+ * Constructs a quaternion by rounding the components of another.
+ */
+HalfQuat::HalfQuat(const Quat& quat) : x(Half::fromDouble(quat.x)), y(Half::fromDouble(quat.y)),
+        z(Half::fromDouble(quat.z)), w(Half::fromDouble(quat.w)) {
+    // pass
+}
+
+/**
+ * Rounds quaternions to halves, on several threads.
+ *
+ * @param quats Quaternions to convert
+ * @param count Number of quaternions
+ * @param halves Array with room for the converted quaternions
+ */
+void HalfQuat::fromQuats(const Quat* quats, size_t count, HalfQuat* halves) {
+    Half::fromDoubles(reinterpret_cast<const double*>(quats), 4 * count, reinterpret_cast<uint16_t*>(halves));
+}
+
+/**
+ * Converts the quaternion to doubles.
+ */
+Quat HalfQuat::toQuat() const {
+    return Quat(Half::toDouble(x), Half::toDouble(y), Half::toDouble(z), Half::toDouble(w));
+}
+
+/**
+ * Converts quaternions of halves to doubles, on several threads.
+ *
+ * @param halves Quaternions to convert
+ * @param count Number of quaternions
+ * @param quats Array with room for the converted quaternions
+ */
+void HalfQuat::toQuats(const HalfQuat* halves, size_t count, Quat* quats) {
+    Half::toDoubles(reinterpret_cast<const uint16_t*>(halves), 4 * count, reinterpret_cast<double*>(quats));
+}
+
+} /* namespace M3d */
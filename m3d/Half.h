@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_HALF_H
+#define M3D_HALF_H
+#include "m3d/common.h"
+#include <stdint.h>
+#include "m3d/Parallel.h"
+#include "m3d/Quat.h"
+#include "m3d/Vec3.h"
+#include "m3d/Vec4.h"
+namespace M3d {
+
+
+/**
+ * Utility for converting between IEEE half-precision floats, stored as 16-bit integers, and floats or doubles.
+ *
+ * Conversions round to the nearest half, with ties to even.  Values too large for a half become infinity, and not a
+ * number stays not a number.  Converting a half back is always exact.
+ *
+ * Batches are split across several threads.  When compiled for processors with F16C instructions, batches of floats
+ * use them eight at a time, and batches of halves converted to doubles go through floats with them too.  Doubles are
+ * always rounded to halves directly, since going through floats could round twice.
+ */
+class Half {
+public:
+// Methods
+    static uint16_t fromDouble(double value);
+    static void fromDoubles(const double* values, size_t count, uint16_t* halves);
+    static uint16_t fromFloat(float value);
+    static void fromFloats(const float* values, size_t count, uint16_t* halves);
+    static double toDouble(uint16_t half);
+    static void toDoubles(const uint16_t* halves, size_t count, double* values);
+    static float toFloat(uint16_t half);
+    static void toFloats(const uint16_t* halves, size_t count, float* values);
+private:
+// Types
+    typedef void (*Converter)(const void* in, void* out, size_t begin, size_t end);
+    class ConvertTask;
+// Constants
+    static const size_t GRAIN_SIZE = 65536;
+// Helpers
+    static void convert(Converter converter, const void* in, void* out, size_t count);
+    static void convertDoubles(const void* in, void* out, size_t begin, size_t end);
+    static void convertFloats(const void* in, void* out, size_t begin, size_t end);
+    static void convertHalvesToDoubles(const void* in, void* out, size_t begin, size_t end);
+    static void convertHalvesToFloats(const void* in, void* out, size_t begin, size_t end);
+};
+
+
+/**
+ * Three-component vector stored as half-precision floats, taking six bytes instead of twenty-four.
+ */
+class HalfVec3 {
+public:
+// Attributes
+    uint16_t x; ///< X coordinate
+    uint16_t y; ///< Y coordinate
+    uint16_t z; ///< Z coordinate
+// Methods
+    explicit HalfVec3();
+    explicit HalfVec3(const Vec3& vec);
+    static void fromVec3s(const Vec3* vecs, size_t count, HalfVec3* halves);
+    Vec3 toVec3() const;
+    static void toVec3s(const HalfVec3* halves, size_t count, Vec3* vecs);
+};
+
+
+/**
+ * Four-component vector stored as half-precision floats, taking eight bytes instead of thirty-two.
+ */
+class HalfVec4 {
+public:
+// Attributes
+    uint16_t x; ///< X coordinate
+    uint16_t y; ///< Y coordinate
+    uint16_t z; ///< Z coordinate
+    uint16_t w; ///< Homogeneous coordinate
+// Methods
+    explicit HalfVec4();
+    explicit HalfVec4(const Vec4& vec);
+    static void fromVec4s(const Vec4* vecs, size_t count, HalfVec4* halves);
+    Vec4 toVec4() const;
+    static void toVec4s(const HalfVec4* halves, size_t count, Vec4* vecs);
+};
+
+
+/**
+ * Quaternion stored as half-precision floats, taking eight bytes instead of thirty-two.
+ *
+ * Components of a unit quaternion keep about three decimal digits, so rotations decoded from halves are usually
+ * within a few hundredths of a degree.  Use `normalize` after decoding if a unit quaternion is needed.
+ */
+class HalfQuat {
+public:
+// Attributes
+    uint16_t x; ///< First component of vector part
+    uint16_t y; ///< Second component of vector part
+    uint16_t z; ///< Third component of vector part
+    uint16_t w; ///< Scalar part
+// Methods
+    explicit HalfQuat();
+    explicit HalfQuat(const Quat& quat);
+    static void fromQuats(const Quat* quats, size_t count, HalfQuat* halves);
+    Quat toQuat() const;
+    static void toQuats(const HalfQuat* halves, size_t count, Quat* quats);
+};
+
+} /* namespace M3d */
+#endif
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/Half.h"
+#include "m3d/Math.h"
+using namespace std;
+
+
+/**
+ * Unit test for Half.
+ */
+class HalfTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + ((upper - lower) * rand() / RAND_MAX);
+    }
+
+    /**
+     * Checks if a half is not a number.
+     */
+    static bool isNan(uint16_t half) {
+        return ((half & 0x7C00) == 0x7C00) && ((half & 0x3FF) != 0);
+    }
+
+public:
+
+    /**
+     * Resets the number of threads.
+     */
+    void tearDown() {
+        M3d::Parallel::setConcurrency(0);
+    }
+
+    /**
+     * Ensures doubles round to the nearest half, with ties to even.
+     */
+    void testFromDouble() {
+        CPPUNIT_ASSERT_EQUAL((uint16_t) 0x3C00, M3d::Half::fromDouble(1));
+        CPPUNIT_ASSERT_EQUAL((uint16_t) 0xC000, M3d::Half::fromDouble(-2));
+        CPPUNIT_ASSERT_EQUAL((uint16_t) 0x2E66, M3d::Half::fromDouble(0.1));
+        CPPUNIT_ASSERT_EQUAL((uint16_t) 0x7BFF, M3d::Half::fromDouble(65504));
+        CPPUNIT_ASSERT_EQUAL((uint16_t) 0x7BFF, M3d::Half::fromDouble(65519.99));
+        CPPUNIT_ASSERT_EQUAL((uint16_t) 0x7C00, M3d::Half::fromDouble(65520));
+        CPPUNIT_ASSERT_EQUAL((uint16_t) 0xFC00, M3d::Half::fromDouble(-1e300));
+        CPPUNIT_ASSERT_EQUAL((uint16_t) 0x0001, M3d::Half::fromDouble(ldexp(1.0, -24)));
+        CPPUNIT_ASSERT_EQUAL((uint16_t) 0x0000, M3d::Half::fromDouble(ldexp(1.0, -25)));
+        CPPUNIT_ASSERT_EQUAL((uint16_t) 0x0001, M3d::Half::fromDouble(ldexp(1.0, -25) * 1.000001));
+        CPPUNIT_ASSERT_EQUAL((uint16_t) 0x0002, M3d::Half::fromDouble(ldexp(3.0, -25)));
+        CPPUNIT_ASSERT_EQUAL((uint16_t) 0x0400, M3d::Half::fromDouble(ldexp(1.0, -14) * 0.99999));
+        CPPUNIT_ASSERT_EQUAL((uint16_t) 0x3C00, M3d::Half::fromDouble(1 + ldexp(1.0, -11)));
+        CPPUNIT_ASSERT_EQUAL((uint16_t) 0x3C02, M3d::Half::fromDouble(1 + ldexp(3.0, -11)));
+        CPPUNIT_ASSERT_EQUAL((uint16_t) 0x8000, M3d::Half::fromDouble(-0.0));
+        CPPUNIT_ASSERT_EQUAL((uint16_t) 0x0000, M3d::Half::fromDouble(1e-300));
+        CPPUNIT_ASSERT_EQUAL((uint16_t) 0x7C00, M3d::Half::fromDouble(numeric_limits<double>::infinity()));
+        CPPUNIT_ASSERT(isNan(M3d::Half::fromDouble(numeric_limits<double>::quiet_NaN())));
+        CPPUNIT_ASSERT_EQUAL((uint16_t) 0x3555, M3d::Half::fromFloat(1.0f / 3));
+    }
+
+    /**
+     * Ensures every half converts to a value that rounds back to itself.
+     */
+    void testToDouble() {
+        for (uint32_t i = 0; i < 65536; ++i) {
+            const uint16_t half = (uint16_t) i;
+            const double value = M3d::Half::toDouble(half);
+            if (isNan(half)) {
+                CPPUNIT_ASSERT(value != value);
+                CPPUNIT_ASSERT(M3d::Half::toFloat(half) != M3d::Half::toFloat(half));
+            } else {
+                CPPUNIT_ASSERT_EQUAL(half, M3d::Half::fromDouble(value));
+                CPPUNIT_ASSERT_EQUAL(half, M3d::Half::fromFloat(M3d::Half::toFloat(half)));
+                CPPUNIT_ASSERT_EQUAL(value, (double) M3d::Half::toFloat(half));
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL(65504.0, M3d::Half::toDouble(0x7BFF));
+        CPPUNIT_ASSERT_EQUAL(ldexp(1.0, -24), M3d::Half::toDouble(0x0001));
+        CPPUNIT_ASSERT_EQUAL(-numeric_limits<double>::infinity(), M3d::Half::toDouble(0xFC00));
+    }
+
+    /**
+     * Ensures batches match single conversions.
+     */
+    void testBatch() {
+        M3d::Parallel::setConcurrency(4);
+        const size_t count = 200003;
+        vector<double> doubles(count);
+        vector<float> floats(count);
+        for (size_t i = 0; i < count; ++i) {
+            doubles[i] = random(-70000, 70000) * pow(10.0, -(double) (i % 10));
+            floats[i] = (float) doubles[i];
+        }
+
+        vector<uint16_t> halves(count);
+        M3d::Half::fromDoubles(&doubles[0], count, &halves[0]);
+        for (size_t i = 0; i < count; ++i) {
+            CPPUNIT_ASSERT_EQUAL(M3d::Half::fromDouble(doubles[i]), halves[i]);
+        }
+        M3d::Half::fromFloats(&floats[0], count, &halves[0]);
+        for (size_t i = 0; i < count; ++i) {
+            CPPUNIT_ASSERT_EQUAL(M3d::Half::fromFloat(floats[i]), halves[i]);
+        }
+
+        M3d::Half::toDoubles(&halves[0], count, &doubles[0]);
+        M3d::Half::toFloats(&halves[0], count, &floats[0]);
+        for (size_t i = 0; i < count; ++i) {
+            CPPUNIT_ASSERT_EQUAL(M3d::Half::toDouble(halves[i]), doubles[i]);
+            CPPUNIT_ASSERT_EQUAL(M3d::Half::toFloat(halves[i]), floats[i]);
+        }
+    }
+
+    /**
+     * Ensures vectors and quaternions convert component by component.
+     */
+    void testVectors() {
+        const size_t count = 50001;
+        vector<M3d::Vec3> vec3s(count);
+        vector<M3d::Vec4> vec4s(count);
+        vector<M3d::Quat> quats(count);
+        for (size_t i = 0; i < count; ++i) {
+            vec3s[i] = M3d::Vec3(random(-100, 100), random(-1, 1), random(-0.01, 0.01));
+            vec4s[i] = M3d::Vec4(random(-100, 100), random(-1, 1), random(-0.01, 0.01), 1);
+            const M3d::Vec3 axis(random(-1, 1), random(-1, 1), random(-1, 1));
+            quats[i] = M3d::Quat::fromAxisAngle(normalize(axis), random(-M3d::PI, M3d::PI));
+        }
+
+        vector<M3d::HalfVec3> halfVec3s(count);
+        vector<M3d::HalfVec4> halfVec4s(count);
+        vector<M3d::HalfQuat> halfQuats(count);
+        M3d::HalfVec3::fromVec3s(&vec3s[0], count, &halfVec3s[0]);
+        M3d::HalfVec4::fromVec4s(&vec4s[0], count, &halfVec4s[0]);
+        M3d::HalfQuat::fromQuats(&quats[0], count, &halfQuats[0]);
+
+        vector<M3d::Vec3> decodedVec3s(count);
+        vector<M3d::Vec4> decodedVec4s(count);
+        vector<M3d::Quat> decodedQuats(count);
+        M3d::HalfVec3::toVec3s(&halfVec3s[0], count, &decodedVec3s[0]);
+        M3d::HalfVec4::toVec4s(&halfVec4s[0], count, &decodedVec4s[0]);
+        M3d::HalfQuat::toQuats(&halfQuats[0], count, &decodedQuats[0]);
+
+        double maxAngle = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const M3d::HalfVec3 halfVec3(vec3s[i]);
+            CPPUNIT_ASSERT_EQUAL(halfVec3.x, halfVec3s[i].x);
+            CPPUNIT_ASSERT_EQUAL(halfVec3.y, halfVec3s[i].y);
+            CPPUNIT_ASSERT_EQUAL(halfVec3.z, halfVec3s[i].z);
+            CPPUNIT_ASSERT(halfVec3.toVec3() == decodedVec3s[i]);
+            CPPUNIT_ASSERT(fabs(decodedVec3s[i].x - vec3s[i].x) <= 0.0313);
+
+            const M3d::HalfVec4 halfVec4(vec4s[i]);
+            CPPUNIT_ASSERT_EQUAL(halfVec4.w, halfVec4s[i].w);
+            CPPUNIT_ASSERT(halfVec4.toVec4() == decodedVec4s[i]);
+            CPPUNIT_ASSERT_EQUAL(1.0, decodedVec4s[i].w);
+
+            const M3d::HalfQuat halfQuat(quats[i]);
+            CPPUNIT_ASSERT_EQUAL(halfQuat.x, halfQuats[i].x);
+            CPPUNIT_ASSERT_EQUAL(halfQuat.w, halfQuats[i].w);
+            CPPUNIT_ASSERT(halfQuat.toQuat() == decodedQuats[i]);
+            const M3d::Quat q = normalize(decodedQuats[i]);
+            const double cosine = fabs((q.x * quats[i].x) + (q.y * quats[i].y) + (q.z * quats[i].z)
+                                       + (q.w * quats[i].w));
+            maxAngle = std::max(maxAngle, M3d::toDegrees(2 * acos(std::min(cosine, 1.0))));
+        }
+        CPPUNIT_ASSERT(maxAngle < 0.05);
+
+        const M3d::HalfVec3 zero;
+        CPPUNIT_ASSERT(M3d::Vec3(0, 0, 0) == zero.toVec3());
+    }
+
+    CPPUNIT_TEST_SUITE(HalfTest);
+    CPPUNIT_TEST(testBatch);
+    CPPUNIT_TEST(testFromDouble);
+    CPPUNIT_TEST(testToDouble);
+    CPPUNIT_TEST(testVectors);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(HalfTest::suite());
+    runner.run();
+    return 0;
+}
@@ -0,0 +1,499 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include <stdexcept>
+#include "m3d/KdTree.h"
+using namespace std;
+namespace M3d {
+
+
+/*
+ * Entry on the stack of a query, holding a node, its range of points, and a lower bound on the squared distance to it.
+ */
+struct KdTree::Entry {
+    size_t node;
+    size_t begin;
+    size_t end;
+    double bound;
+};
+
+
+/*
+ * Compares points along one axis.
+ */
+class KdTree::AxisLess {
+public:
+    AxisLess(const Vec3Array& points, int axis) :
+            coords((axis == 0) ? points.x : ((axis == 1) ? points.y : points.z)) { }
+    bool operator()(uint32_t a, uint32_t b) const {
+        return coords[a] < coords[b];
+    }
+private:
+    const vector<double>& coords;
+};
+
+
+/*
+ * Task building separate subtrees on separate threads.
+ */
+class KdTree::BuildTask : public ParallelTask {
+public:
+    BuildTask(KdTree& tree, const Vec3Array& points, size_t first, const vector<size_t>& bounds) :
+            tree(tree), points(points), first(first), bounds(bounds) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            tree.buildSubtree(points, first + i, bounds[i], bounds[i + 1]);
+        }
+    }
+private:
+    KdTree& tree;
+    const Vec3Array& points;
+    size_t first;
+    const vector<size_t>& bounds;
+};
+
+
+/*
+ * Task copying a range of points into the order of the tree.
+ */
+class KdTree::GatherTask : public ParallelTask {
+public:
+    GatherTask(KdTree& tree, const Vec3Array& points) : tree(tree), points(points) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const uint32_t j = tree.indices[i];
+            tree.points.x[i] = points.x[j];
+            tree.points.y[i] = points.y[j];
+            tree.points.z[i] = points.z[j];
+        }
+    }
+private:
+    KdTree& tree;
+    const Vec3Array& points;
+};
+
+
+/*
+ * Task finding points within a radius of a range of queries.
+ *
+ * Each chunk collects its results separately, along with how many each query found, so they can be joined in order
+ * afterwards.
+ */
+class KdTree::RadiusTask : public ParallelTask {
+public:
+    RadiusTask(const KdTree& tree, const Vec3Array& queries, double radius, vector<size_t>& offsets,
+               vector< vector<uint32_t> >& results) :
+            tree(tree), queries(queries), radius(radius), offsets(offsets), results(results) { }
+    virtual void run(size_t chunk, size_t begin, size_t end) {
+        vector<uint32_t>& result = results[chunk];
+        for (size_t i = begin; i < end; ++i) {
+            const size_t first = result.size();
+            tree.searchRadius(queries.get(i), radius, result);
+            for (size_t j = first; j < result.size(); ++j) {
+                result[j] = tree.indices[result[j]];
+            }
+            offsets[i + 1] = result.size() - first;
+        }
+    }
+private:
+    const KdTree& tree;
+    const Vec3Array& queries;
+    double radius;
+    vector<size_t>& offsets;
+    vector< vector<uint32_t> >& results;
+};
+
+
+/*
+ * Task finding the nearest points to a range of queries.
+ */
+class KdTree::NearestTask : public ParallelTask {
+public:
+    NearestTask(const KdTree& tree, const Vec3Array& queries, size_t k, double epsilon, uint32_t* result) :
+            tree(tree), queries(queries), k(k), epsilon(epsilon), result(result) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        vector<Candidate> heap;
+        heap.reserve(k);
+        for (size_t i = begin; i < end; ++i) {
+            tree.searchNearest(queries.get(i), k, epsilon, heap);
+            uint32_t* const r = result + (i * k);
+            for (size_t j = 0; j < k; ++j) {
+                r[j] = (j < heap.size()) ? tree.indices[heap[j].second] : (uint32_t) NO_POINT;
+            }
+        }
+    }
+private:
+    const KdTree& tree;
+    const Vec3Array& queries;
+    size_t k;
+    double epsilon;
+    uint32_t* result;
+};
+
+// METHODS
+
+/**
+ * Constructs an empty tree.
+ */
+KdTree::KdTree() : depth(0) {
+    // pass
+}
+
+/**
+ * Builds the tree over a set of points, replacing anything already in it.
+ *
+ * The upper levels are split on the calling thread, then the subtrees below them are built on separate threads.
+ *
+ * @param points Points to put in the tree, which are copied
+ * @param leafSize Largest number of points in a leaf, in [1 .. MAX_LEAF_SIZE]
+ * @throws invalid_argument if leaf size is out of range
+ */
+void KdTree::build(const Vec3Array& points, size_t leafSize) {
+
+    if ((leafSize < 1) || (leafSize > MAX_LEAF_SIZE)) {
+        throw invalid_argument("[KdTree] Leaf size out of range!");
+    }
+
+    const size_t size = points.size();
+
+    // Find depth where every leaf fits in a bucket
+    depth = 0;
+    while (((size + ((size_t) 1 << depth) - 1) >> depth) > leafSize) {
+        ++depth;
+    }
+    splits.assign(((size_t) 1 << depth) - 1, 0);
+    axes.assign(splits.size(), 0);
+    indices.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+        indices[i] = (uint32_t) i;
+    }
+
+    // Split upper levels until there is enough work for every thread
+    int parallelDepth = 0;
+    if (Parallel::getConcurrency() > 1) {
+        while ((parallelDepth < depth) && (((size_t) 1 << parallelDepth) < (Parallel::getConcurrency() * 4))) {
+            ++parallelDepth;
+        }
+    }
+    vector<size_t> bounds(2);
+    bounds[1] = size;
+    for (int level = 0; level < parallelDepth; ++level) {
+        const size_t first = ((size_t) 1 << level) - 1;
+        vector<size_t> next(1, 0);
+        for (size_t i = 0; i + 1 < bounds.size(); ++i) {
+            splitNode(points, first + i, bounds[i], bounds[i + 1]);
+            next.push_back(bounds[i] + ((bounds[i + 1] - bounds[i]) / 2));
+            next.push_back(bounds[i + 1]);
+        }
+        bounds.swap(next);
+    }
+
+    // Build subtrees below them on separate threads
+    BuildTask buildTask(*this, points, ((size_t) 1 << parallelDepth) - 1, bounds);
+    Parallel::run(buildTask, bounds.size() - 1, 1);
+
+    // Store points in order
+    this->points.resize(size);
+    GatherTask gatherTask(*this, points);
+    Parallel::run(gatherTask, size, GRAIN_SIZE);
+}
+
+/**
+ * Finds every point within a distance of another point.
+ *
+ * @param point Point to search around
+ * @param radius Largest distance to include, including points exactly that far away
+ * @param result List to store indices of points in, which is cleared first
+ */
+void KdTree::findInRadius(const Vec3& point, double radius, vector<size_t>& result) const {
+
+    vector<uint32_t> slots;
+
+    searchRadius(point, radius, slots);
+    result.resize(slots.size());
+    for (size_t i = 0; i < slots.size(); ++i) {
+        result[i] = indices[slots[i]];
+    }
+}
+
+/**
+ * Finds every point within a distance of each of many points, on several threads.
+ *
+ * @param queries Points to search around
+ * @param radius Largest distance to include, including points exactly that far away
+ * @param offsets List to store where the results of each query start in, followed by the total number of results
+ * @param result List to store indices of points in, with the results of each query in order
+ */
+void KdTree::findInRadius(const Vec3Array& queries, double radius, vector<size_t>& offsets,
+                          vector<uint32_t>& result) const {
+
+    const size_t size = queries.size();
+    vector< vector<uint32_t> > results(Parallel::countChunks(size, QUERY_GRAIN_SIZE));
+
+    // Search on separate threads
+    offsets.assign(size + 1, 0);
+    RadiusTask task(*this, queries, radius, offsets, results);
+    Parallel::run(task, size, QUERY_GRAIN_SIZE);
+
+    // Join results
+    for (size_t i = 0; i < size; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+    result.resize(offsets[size]);
+    size_t position = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        copy(results[i].begin(), results[i].end(), result.begin() + position);
+        position += results[i].size();
+    }
+}
+
+/**
+ * Finds the points closest to another point.
+ *
+ * @param point Point to search around
+ * @param k Number of points to find
+ * @param result List to store indices of points in, nearest first, which has fewer than `k` only if the tree does
+ * @param epsilon Allowed relative error in distance, where zero finds the exact nearest points
+ */
+void KdTree::findNearest(const Vec3& point, size_t k, vector<size_t>& result, double epsilon) const {
+
+    vector<Candidate> heap;
+
+    searchNearest(point, k, epsilon, heap);
+    result.resize(heap.size());
+    for (size_t i = 0; i < heap.size(); ++i) {
+        result[i] = indices[heap[i].second];
+    }
+}
+
+/**
+ * Finds the points closest to each of many points, on several threads.
+ *
+ * @param queries Points to search around
+ * @param k Number of points to find for each query
+ * @param result List to store indices of points in, `k` per query nearest first, padded with `NO_POINT` if the tree
+ *               has fewer than `k` points
+ * @param epsilon Allowed relative error in distance, where zero finds the exact nearest points
+ */
+void KdTree::findNearest(const Vec3Array& queries, size_t k, vector<uint32_t>& result, double epsilon) const {
+
+    const size_t size = queries.size();
+
+    result.resize(size * k);
+    if (k > 0) {
+        NearestTask task(*this, queries, k, epsilon, &result[0]);
+        Parallel::run(task, size, QUERY_GRAIN_SIZE);
+    }
+}
+
+/**
+ * Returns the number of levels of interior nodes.
+ */
+int KdTree::getDepth() const {
+    return depth;
+}
+
+/**
+ * Returns the index each point had when given to `build`, in the order the points are stored.
+ */
+const uint32_t* KdTree::getIndices() const {
+    return indices.empty() ? NULL : &indices[0];
+}
+
+/**
+ * Returns the points in the order they are stored, with points in the same leaf next to each other.
+ */
+const Vec3Array& KdTree::getPoints() const {
+    return points;
+}
+
+/**
+ * Returns the number of points in the tree.
+ */
+size_t KdTree::getSize() const {
+    return indices.size();
+}
+
+// HELPERS
+
+/*
+ * Splits a node and everything under it.
+ */
+void KdTree::buildSubtree(const Vec3Array& points, size_t node, size_t begin, size_t end) {
+    if (node < splits.size()) {
+        const size_t mid = begin + ((end - begin) / 2);
+        splitNode(points, node, begin, end);
+        buildSubtree(points, (2 * node) + 1, begin, mid);
+        buildSubtree(points, (2 * node) + 2, mid, end);
+    }
+}
+
+/*
+ * Finds the stored points closest to a point, leaving them sorted nearest first.
+ *
+ * Nodes are visited nearest child first, and a node is skipped once the squared distance to its splitting plane,
+ * scaled by the allowed error, is no closer than the `k`th closest point found so far.
+ */
+void KdTree::searchNearest(const Vec3& point, size_t k, double epsilon, vector<Candidate>& heap) const {
+
+    heap.clear();
+    if ((k == 0) || indices.empty()) {
+        return;
+    }
+
+    const double factor = (1 + epsilon) * (1 + epsilon);
+    const size_t interior = splits.size();
+    Entry stack[MAX_DEPTH + 1];
+    double distances[MAX_LEAF_SIZE];
+    int top = 0;
+
+    const Entry root = { 0, 0, indices.size(), 0 };
+    stack[top++] = root;
+    while (top > 0) {
+        const Entry e = stack[--top];
+        if ((heap.size() == k) && !((e.bound * factor) < heap.front().first)) {
+            continue;
+        }
+
+        // Scan leaf
+        if (e.node >= interior) {
+            const size_t count = e.end - e.begin;
+            const double* const x = &points.x[e.begin];
+            const double* const y = &points.y[e.begin];
+            const double* const z = &points.z[e.begin];
+            for (size_t j = 0; j < count; ++j) {
+                const double dx = x[j] - point.x;
+                const double dy = y[j] - point.y;
+                const double dz = z[j] - point.z;
+                distances[j] = (dx * dx) + (dy * dy) + (dz * dz);
+            }
+            for (size_t j = 0; j < count; ++j) {
+                if (heap.size() < k) {
+                    heap.push_back(Candidate(distances[j], (uint32_t) (e.begin + j)));
+                    push_heap(heap.begin(), heap.end());
+                } else if (distances[j] < heap.front().first) {
+                    pop_heap(heap.begin(), heap.end());
+                    heap.back() = Candidate(distances[j], (uint32_t) (e.begin + j));
+                    push_heap(heap.begin(), heap.end());
+                }
+            }
+            continue;
+        }
+
+        // Push far child, then near child so it is visited first
+        const double d = point[axes[e.node]] - splits[e.node];
+        const size_t mid = e.begin + ((e.end - e.begin) / 2);
+        const Entry left = { (2 * e.node) + 1, e.begin, mid, e.bound };
+        const Entry right = { (2 * e.node) + 2, mid, e.end, e.bound };
+        stack[top] = (d < 0) ? right : left;
+        stack[top].bound = std::max(e.bound, d * d);
+        ++top;
+        stack[top++] = (d < 0) ? left : right;
+    }
+    sort_heap(heap.begin(), heap.end());
+}
+
+/*
+ * Appends the positions of stored points within a distance of a point.
+ */
+void KdTree::searchRadius(const Vec3& point, double radius, vector<uint32_t>& slots) const {
+
+    if (indices.empty()) {
+        return;
+    }
+
+    const double r2 = radius * radius;
+    const size_t interior = splits.size();
+    Entry stack[MAX_DEPTH + 1];
+    double distances[MAX_LEAF_SIZE];
+    int top = 0;
+
+    const Entry root = { 0, 0, indices.size(), 0 };
+    stack[top++] = root;
+    while (top > 0) {
+        const Entry e = stack[--top];
+        if (e.bound > r2) {
+            continue;
+        }
+
+        // Scan leaf
+        if (e.node >= interior) {
+            const size_t count = e.end - e.begin;
+            const double* const x = &points.x[e.begin];
+            const double* const y = &points.y[e.begin];
+            const double* const z = &points.z[e.begin];
+            for (size_t j = 0; j < count; ++j) {
+                const double dx = x[j] - point.x;
+                const double dy = y[j] - point.y;
+                const double dz = z[j] - point.z;
+                distances[j] = (dx * dx) + (dy * dy) + (dz * dz);
+            }
+            for (size_t j = 0; j < count; ++j) {
+                if (distances[j] <= r2) {
+                    slots.push_back((uint32_t) (e.begin + j));
+                }
+            }
+            continue;
+        }
+
+        // Push both children, with the far one bounded by the splitting plane
+        const double d = point[axes[e.node]] - splits[e.node];
+        const size_t mid = e.begin + ((e.end - e.begin) / 2);
+        const Entry left = { (2 * e.node) + 1, e.begin, mid, e.bound };
+        const Entry right = { (2 * e.node) + 2, mid, e.end, e.bound };
+        stack[top] = (d < 0) ? right : left;
+        stack[top].bound = std::max(e.bound, d * d);
+        ++top;
+        stack[top++] = (d < 0) ? left : right;
+    }
+}
+
+/*
+ * Splits the points of a node at the median along the axis where they spread the most.
+ */
+void KdTree::splitNode(const Vec3Array& points, size_t node, size_t begin, size_t end) {
+
+    // Find axis with largest extent
+    Vec3 lower = points.get(indices[begin]);
+    Vec3 upper = lower;
+    for (size_t i = begin + 1; i < end; ++i) {
+        const Vec3 p = points.get(indices[i]);
+        lower = min(lower, p);
+        upper = max(upper, p);
+    }
+    const Vec3 extent = upper - lower;
+    const int axis = (extent.x >= extent.y) ? ((extent.x >= extent.z) ? 0 : 2) : ((extent.y >= extent.z) ? 1 : 2);
+
+    // Partition at the median
+    const size_t mid = begin + ((end - begin) / 2);
+    uint32_t* const order = &indices[0];
+    nth_element(order + begin, order + mid, order + end, AxisLess(points, axis));
+    splits[node] = points.get(order[mid])[axis];
+    axes[node] = (uint8_t) axis;
+}
+
+} /* namespace M3d */
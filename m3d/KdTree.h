@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_KDTREE_H
+#define M3D_KDTREE_H
+#include "m3d/common.h"
+#include <stdint.h>
+#include <utility>
+#include <vector>
+#include "m3d/Parallel.h"
+#include "m3d/Vec3.h"
+#include "m3d/Vec3Array.h"
+namespace M3d {
+
+
+/**
+ * K-d tree over a static set of points.
+ *
+ * The tree is a complete binary tree stored without pointers.  The children of node `i` are `2i + 1` and `2i + 2`,
+ * and every node splits its range of points in half at the median along the axis where they spread the most, so the
+ * range of each node follows from its position alone.  Interior nodes only store a split value and an axis.  Splits
+ * stop once each leaf holds at most a bucket of points, which are stored next to each other as separate arrays of
+ * components, so a leaf is scanned in one loop the compiler can vectorize.
+ *
+ * Nearest queries can be approximate.  With an epsilon greater than zero, branches are skipped unless they could hold
+ * a point closer than the current `k`th closest divided by `1 + epsilon`, so every point reported is within that
+ * factor of the true distance, and queries visit far fewer leaves.
+ *
+ * Results are indices into the array of points given to `build`.
+ */
+class KdTree {
+public:
+// Constants
+    static const size_t DEFAULT_LEAF_SIZE = 16; ///< Default largest number of points in a leaf
+    static const size_t MAX_LEAF_SIZE = 64; ///< Largest number of points allowed in a leaf
+    static const uint32_t NO_POINT = 0xFFFFFFFF; ///< Index padding batch nearest results when there are too few points
+// Methods
+    explicit KdTree();
+    void build(const Vec3Array& points, size_t leafSize = DEFAULT_LEAF_SIZE);
+    void findInRadius(const Vec3& point, double radius, std::vector<size_t>& result) const;
+    void findInRadius(const Vec3Array& queries, double radius, std::vector<size_t>& offsets,
+                      std::vector<uint32_t>& result) const;
+    void findNearest(const Vec3& point, size_t k, std::vector<size_t>& result, double epsilon = 0) const;
+    void findNearest(const Vec3Array& queries, size_t k, std::vector<uint32_t>& result, double epsilon = 0) const;
+    int getDepth() const;
+    const uint32_t* getIndices() const;
+    const Vec3Array& getPoints() const;
+    size_t getSize() const;
+private:
+// Types
+    class AxisLess;
+    class BuildTask;
+    class GatherTask;
+    class NearestTask;
+    class RadiusTask;
+    struct Entry;
+    typedef std::pair<double,uint32_t> Candidate;
+// Constants
+    static const size_t GRAIN_SIZE = 65536;
+    static const size_t QUERY_GRAIN_SIZE = 1024;
+    static const int MAX_DEPTH = 32;
+// Attributes
+    Vec3Array points;
+    std::vector<uint32_t> indices;
+    std::vector<double> splits;
+    std::vector<uint8_t> axes;
+    int depth;
+// Helpers
+    void buildSubtree(const Vec3Array& points, size_t node, size_t begin, size_t end);
+    void searchNearest(const Vec3& point, size_t k, double epsilon, std::vector<Candidate>& heap) const;
+    void searchRadius(const Vec3& point, double radius, std::vector<uint32_t>& slots) const;
+    void splitNode(const Vec3Array& points, size_t node, size_t begin, size_t end);
+};
+
+} /* namespace M3d */
+#endif
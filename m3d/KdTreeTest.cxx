@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/KdTree.h"
+using namespace std;
+
+/*
+ * Constants
+ */
+const double TOLERANCE = 1e-9;
+
+
+/**
+ * Unit test for KdTree.
+ */
+class KdTreeTest : public CppUnit::TestFixture {
+private:
+    M3d::Vec3Array points;
+    M3d::Vec3Array queries;
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + (upper - lower) * (rand() / (double) RAND_MAX);
+    }
+
+    /**
+     * Makes an array of random points in a cube.
+     */
+    static M3d::Vec3Array randomPoints(size_t size, double extent) {
+        M3d::Vec3Array arr(size);
+        for (size_t i = 0; i < size; ++i) {
+            arr.set(i, M3d::Vec3(random(-extent, extent), random(-extent, extent), random(-extent, extent)));
+        }
+        return arr;
+    }
+
+    /**
+     * Finds every point within a distance of another point by checking them all.
+     */
+    vector<size_t> findInRadius(const M3d::Vec3& point, double radius) const {
+        vector<size_t> result;
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (M3d::length(points.get(i) - point) <= radius) {
+                result.push_back(i);
+            }
+        }
+        return result;
+    }
+
+    /**
+     * Finds the distances to the points closest to another point by checking them all.
+     */
+    vector<double> findNearestDistances(const M3d::Vec3& point, size_t k) const {
+        vector<double> distances;
+        for (size_t i = 0; i < points.size(); ++i) {
+            distances.push_back(M3d::length(points.get(i) - point));
+        }
+        sort(distances.begin(), distances.end());
+        distances.resize(min(k, distances.size()));
+        return distances;
+    }
+
+public:
+
+    /**
+     * Prepares the fixture before running each test case.
+     */
+    void setUp() {
+        points = randomPoints(2000, 10);
+        queries = randomPoints(2500, 12);
+    }
+
+    /**
+     * Restores the default number of threads after each test case.
+     */
+    void tearDown() {
+        M3d::Parallel::setConcurrency(0);
+    }
+
+    /**
+     * Ensures build splits until leaves fit and stores the points along with their original indices.
+     */
+    void testBuild() {
+
+        M3d::KdTree tree;
+        tree.build(points);
+
+        CPPUNIT_ASSERT_EQUAL(7, tree.getDepth());
+        CPPUNIT_ASSERT_EQUAL(points.size(), tree.getSize());
+        const uint32_t* indices = tree.getIndices();
+        vector<bool> seen(points.size(), false);
+        for (size_t i = 0; i < tree.getSize(); ++i) {
+            CPPUNIT_ASSERT(!seen[indices[i]]);
+            seen[indices[i]] = true;
+            CPPUNIT_ASSERT_EQUAL(points.x[indices[i]], tree.getPoints().x[i]);
+            CPPUNIT_ASSERT_EQUAL(points.z[indices[i]], tree.getPoints().z[i]);
+        }
+    }
+
+    /**
+     * Ensures build rejects leaf sizes out of range.
+     */
+    void testBuildInvalid() {
+        M3d::KdTree tree;
+        CPPUNIT_ASSERT_THROW(tree.build(points, 0), invalid_argument);
+        CPPUNIT_ASSERT_THROW(tree.build(points, M3d::KdTree::MAX_LEAF_SIZE + 1), invalid_argument);
+    }
+
+    /**
+     * Ensures building on several threads gives the same tree as building on one.
+     */
+    void testBuildParallel() {
+
+        const M3d::Vec3Array many = randomPoints(200000, 50);
+        M3d::KdTree serial, parallel;
+
+        M3d::Parallel::setConcurrency(1);
+        serial.build(many, 8);
+        M3d::Parallel::setConcurrency(4);
+        parallel.build(many, 8);
+
+        for (size_t i = 0; i < many.size(); ++i) {
+            CPPUNIT_ASSERT_EQUAL(serial.getIndices()[i], parallel.getIndices()[i]);
+        }
+    }
+
+    /**
+     * Ensures findInRadius finds the same points as checking every point.
+     */
+    void testFindInRadius() {
+
+        M3d::KdTree tree;
+        tree.build(points);
+
+        for (size_t i = 0; i < 200; ++i) {
+            const M3d::Vec3 query = queries.get(i);
+            vector<size_t> result;
+            tree.findInRadius(query, 1.5, result);
+            sort(result.begin(), result.end());
+            CPPUNIT_ASSERT(result == findInRadius(query, 1.5));
+        }
+    }
+
+    /**
+     * Ensures the batch findInRadius gives the same results as the single one on several threads.
+     */
+    void testFindInRadiusBatch() {
+
+        M3d::KdTree tree;
+        tree.build(points);
+
+        M3d::Parallel::setConcurrency(4);
+        vector<size_t> offsets;
+        vector<uint32_t> result;
+        tree.findInRadius(queries, 1, offsets, result);
+
+        CPPUNIT_ASSERT_EQUAL(queries.size() + 1, offsets.size());
+        CPPUNIT_ASSERT_EQUAL(result.size(), offsets.back());
+        for (size_t i = 0; i < queries.size(); ++i) {
+            vector<size_t> expected;
+            tree.findInRadius(queries.get(i), 1, expected);
+            CPPUNIT_ASSERT_EQUAL(expected.size(), offsets[i + 1] - offsets[i]);
+            for (size_t j = 0; j < expected.size(); ++j) {
+                CPPUNIT_ASSERT_EQUAL(expected[j], (size_t) result[offsets[i] + j]);
+            }
+        }
+    }
+
+    /**
+     * Ensures findNearest finds the exact nearest points when epsilon is zero.
+     */
+    void testFindNearest() {
+
+        M3d::KdTree tree;
+        tree.build(points, 4);
+
+        for (size_t i = 0; i < 200; ++i) {
+            const M3d::Vec3 query = (i % 10 == 0) ? (queries.get(i) * 3.0) : queries.get(i);
+            vector<size_t> result;
+            tree.findNearest(query, 8, result);
+            const vector<double> expected = findNearestDistances(query, 8);
+            CPPUNIT_ASSERT_EQUAL(expected.size(), result.size());
+            for (size_t j = 0; j < result.size(); ++j) {
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[j], M3d::length(points.get(result[j]) - query), TOLERANCE);
+            }
+        }
+    }
+
+    /**
+     * Ensures findNearest stays within the allowed error when epsilon is positive.
+     */
+    void testFindNearestApproximate() {
+
+        M3d::KdTree tree;
+        tree.build(points);
+
+        for (size_t i = 0; i < 200; ++i) {
+            const M3d::Vec3 query = queries.get(i);
+            vector<size_t> result;
+            tree.findNearest(query, 8, result, 0.5);
+            const vector<double> expected = findNearestDistances(query, 8);
+            CPPUNIT_ASSERT_EQUAL(expected.size(), result.size());
+            for (size_t j = 0; j < result.size(); ++j) {
+                CPPUNIT_ASSERT(M3d::length(points.get(result[j]) - query) <= (expected[j] * 1.5) + TOLERANCE);
+            }
+        }
+    }
+
+    /**
+     * Ensures the batch findNearest gives the same results as the single one, padding when there are too few points.
+     */
+    void testFindNearestBatch() {
+
+        M3d::KdTree tree;
+        tree.build(points);
+
+        M3d::Parallel::setConcurrency(4);
+        vector<uint32_t> result;
+        tree.findNearest(queries, 5, result, 0.1);
+
+        CPPUNIT_ASSERT_EQUAL(queries.size() * 5, result.size());
+        for (size_t i = 0; i < queries.size(); ++i) {
+            vector<size_t> expected;
+            tree.findNearest(queries.get(i), 5, expected, 0.1);
+            for (size_t j = 0; j < 5; ++j) {
+                CPPUNIT_ASSERT_EQUAL(expected[j], (size_t) result[(i * 5) + j]);
+            }
+        }
+
+        M3d::Vec3Array few(3);
+        M3d::KdTree small;
+        small.build(few);
+        small.findNearest(queries, 5, result);
+        const uint32_t none = M3d::KdTree::NO_POINT;
+        CPPUNIT_ASSERT(result[2] != none);
+        CPPUNIT_ASSERT_EQUAL(none, result[3]);
+        CPPUNIT_ASSERT_EQUAL(none, result[4]);
+    }
+
+    CPPUNIT_TEST_SUITE(KdTreeTest);
+    CPPUNIT_TEST(testBuild);
+    CPPUNIT_TEST(testBuildInvalid);
+    CPPUNIT_TEST(testBuildParallel);
+    CPPUNIT_TEST(testFindInRadius);
+    CPPUNIT_TEST(testFindInRadiusBatch);
+    CPPUNIT_TEST(testFindNearest);
+    CPPUNIT_TEST(testFindNearestApproximate);
+    CPPUNIT_TEST(testFindNearestBatch);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(KdTreeTest::suite());
+    runner.run();
+    return 0;
+}
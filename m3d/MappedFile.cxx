@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <fstream>
+#include <stdexcept>
+#ifdef HAVE_SYS_MMAN_H
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "m3d/MappedFile.h"
+using namespace std;
+namespace M3d {
+
+/* Start of an empty file */
+static const double EMPTY = 0;
+
+/**
+ * Constructs a closed file.
+ */
+MappedFile::MappedFile() : mapping(NULL), size(0), data(NULL) {
+    // pass
+}
+
+/**
+ * Closes the file.
+ */
+MappedFile::~MappedFile() {
+    close();
+}
+
+/**
+ * Releases the file's memory, making any pointers into it invalid.
+ */
+void MappedFile::close() {
+#ifdef HAVE_SYS_MMAN_H
+    if (mapping != NULL) {
+        munmap(mapping, size);
+    }
+#endif
+    mapping = NULL;
+    size = 0;
+    vector<double>().swap(buffer);
+    data = NULL;
+}
+
+/**
+ * Returns the first byte of the file.
+ *
+ * @throws logic_error if the file is not open
+ */
+const char* MappedFile::getData() const {
+    if (data == NULL) {
+        throw logic_error("[MappedFile] File is not open!");
+    }
+    return data;
+}
+
+/**
+ * Returns the number of bytes in the file.
+ */
+size_t MappedFile::getSize() const {
+    return size;
+}
+
+/**
+ * Checks if a file has been opened.
+ */
+bool MappedFile::isOpen() const {
+    return data != NULL;
+}
+
+/**
+ * Opens a file, closing any file opened before.
+ *
+ * @param filename Path to the file
+ * @throws runtime_error if the file cannot be opened or read
+ */
+void MappedFile::open(const string& filename) {
+
+    close();
+
+#ifdef HAVE_SYS_MMAN_H
+    const int descriptor = ::open(filename.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw runtime_error("[MappedFile] Could not open file!");
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0) {
+        ::close(descriptor);
+        throw runtime_error("[MappedFile] Could not read file!");
+    } else if (status.st_size == 0) {
+        ::close(descriptor);
+        data = reinterpret_cast<const char*>(&EMPTY);
+        return;
+    }
+    const size_t length = (size_t) status.st_size;
+    void* const address = mmap(NULL, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    ::close(descriptor);
+    if (address == MAP_FAILED) {
+        throw runtime_error("[MappedFile] Could not map file!");
+    }
+    mapping = address;
+    size = length;
+    data = static_cast<const char*>(address);
+#else
+    ifstream file(filename.c_str(), ios::in | ios::binary);
+    if (!file) {
+        throw runtime_error("[MappedFile] Could not open file!");
+    }
+    file.seekg(0, ios::end);
+    const size_t length = (size_t) file.tellg();
+    file.seekg(0, ios::beg);
+    buffer.resize((length / sizeof(double)) + 1);
+    if (!file.read(reinterpret_cast<char*>(&buffer[0]), length)) {
+        vector<double>().swap(buffer);
+        throw runtime_error("[MappedFile] Could not read file!");
+    }
+    size = length;
+    data = reinterpret_cast<const char*>(&buffer[0]);
+#endif
+}
+
+} /* namespace M3d */
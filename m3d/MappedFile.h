@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_MAPPEDFILE_H
+#define M3D_MAPPEDFILE_H
+#include "m3d/common.h"
+#include <string>
+#include <vector>
+namespace M3d {
+
+
+/**
+ * Read-only view of a whole file in memory.
+ *
+ * Where the system supports it the file is mapped into memory, so opening it reads nothing and pages are loaded as they
+ * are touched.  Otherwise the file is read into a buffer when opened.  Either way the bytes are aligned for any scalar
+ * type and are not followed by a null character.
+ */
+class MappedFile {
+public:
+// Methods
+    explicit MappedFile();
+    ~MappedFile();
+    void close();
+    const char* getData() const;
+    size_t getSize() const;
+    bool isOpen() const;
+    void open(const std::string& filename);
+private:
+// Attributes
+    void* mapping;
+    size_t size;
+    std::vector<double> buffer;
+    const char* data;
+// Helpers
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
+
+} /* namespace M3d */
+#endif
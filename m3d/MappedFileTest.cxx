@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/MappedFile.h"
+using namespace std;
+
+/*
+ * Constants
+ */
+const char* FILENAME = "MappedFileTest.tmp";
+
+
+/**
+ * Unit test for MappedFile.
+ */
+class MappedFileTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Replaces the test file with some bytes.
+     */
+    static void save(const string& contents) {
+        ofstream file(FILENAME, ios::out | ios::binary | ios::trunc);
+        file.write(contents.data(), contents.size());
+    }
+
+public:
+
+    /**
+     * Removes the test file.
+     */
+    void tearDown() {
+        remove(FILENAME);
+    }
+
+    /**
+     * Ensures an empty file can be opened.
+     */
+    void testOpenEmpty() {
+        save("");
+        M3d::MappedFile file;
+        file.open(FILENAME);
+        CPPUNIT_ASSERT(file.isOpen());
+        CPPUNIT_ASSERT(file.getData() != NULL);
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, file.getSize());
+    }
+
+    /**
+     * Ensures opening a missing file throws and leaves the file closed.
+     */
+    void testOpenMissing() {
+        M3d::MappedFile file;
+        CPPUNIT_ASSERT_THROW(file.open("MappedFileTest.missing"), runtime_error);
+        CPPUNIT_ASSERT(!file.isOpen());
+        CPPUNIT_ASSERT_THROW(file.getData(), logic_error);
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, file.getSize());
+    }
+
+    /**
+     * Ensures the bytes of a file are visible until it is closed, and that it can be opened again.
+     */
+    void testOpenAndClose() {
+        const string contents("line one\n\0line two\n", 19);
+        save(contents);
+        M3d::MappedFile file;
+        file.open(FILENAME);
+        CPPUNIT_ASSERT_EQUAL(contents.size(), file.getSize());
+        CPPUNIT_ASSERT_EQUAL(0, memcmp(contents.data(), file.getData(), contents.size()));
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, ((size_t) file.getData()) % sizeof(double));
+
+        file.close();
+        CPPUNIT_ASSERT(!file.isOpen());
+        CPPUNIT_ASSERT_THROW(file.getData(), logic_error);
+        file.close();
+
+        save("other");
+        file.open(FILENAME);
+        file.open(FILENAME);
+        CPPUNIT_ASSERT_EQUAL((size_t) 5, file.getSize());
+        CPPUNIT_ASSERT_EQUAL(0, memcmp("other", file.getData(), 5));
+    }
+
+    CPPUNIT_TEST_SUITE(MappedFileTest);
+    CPPUNIT_TEST(testOpenEmpty);
+    CPPUNIT_TEST(testOpenMissing);
+    CPPUNIT_TEST(testOpenAndClose);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(MappedFileTest::suite());
+    runner.run();
+    return 0;
+}
@@ -39,6 +39,7 @@ public:
 // Constants
     static const int ORDER = 3; ///< Number of rows and columns
     static const int ORDER_SQUARED = 9; ///< Number of elements in matrix
+    static const size_t FORMAT_SIZE = 249; ///< Characters needed to format any matrix, including the null character
 // Methods
     explicit Mat3();
     explicit Mat3(const double value);
@@ -52,6 +53,8 @@ public:
     static Mat3 fromArrayInRowMajor(const double arr[3][3]);
     static Mat3 fromColumns(const Vec3& c1, const Vec3& c2, const Vec3& c3);
     static Mat3 fromRows(const Vec3& r1, const Vec3& r2, const Vec3& r3);
+    static const char* parse(const char* text, Mat3& mat);
+    size_t formatTo(char* buf, size_t size) const;
     Vec3 getColumn(const int j) const;
     Vec3 getRow(const int i) const;
     void toArrayInColumnMajor(double arr[3][3]) const;
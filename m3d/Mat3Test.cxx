@@ -817,6 +817,25 @@ public:
         CPPUNIT_ASSERT_EQUAL(expect, result);
     }
 
+    /**
+     * Ensures parse reads back exactly what toString writes, column by column.
+     */
+    void testParse() {
+
+        // Make a matrix with numbers that need every digit
+        Mat3 mat;
+        for (int j = 0; j < Mat3::ORDER; ++j) {
+            for (int i = 0; i < Mat3::ORDER; ++i) {
+                mat[j][i] = (i + 1.0) / (j + 7.0);
+            }
+        }
+
+        // Read it back and compare
+        Mat3 result;
+        CPPUNIT_ASSERT(Mat3::parse(mat.toString().c_str(), result) != NULL);
+        CPPUNIT_ASSERT(mat == result);
+    }
+
     /**
      * Ensures transposing a matrix works correctly.
      */
@@ -904,6 +923,7 @@ public:
     CPPUNIT_TEST(testToArrayInRowMajorFloatArray);
     CPPUNIT_TEST(testToArrayInRowMajorDoubleArrayArray);
     CPPUNIT_TEST(testToArrayInRowMajorFloatArrayArray);
+    CPPUNIT_TEST(testParse);
     CPPUNIT_TEST(testToString);
     CPPUNIT_TEST(testTranspose);
     CPPUNIT_TEST(testMultiplyVector);
@@ -26,7 +26,6 @@
 #include "config.h"
 #include <cmath>
 #include <iomanip>
-#include <sstream>
 #include <stdexcept>
 #include "m3d/Mat4.h"
 using namespace std;
@@ -253,6 +252,61 @@ Mat4 Mat4::fromArrayInRowMajor(const float arr[4][4]) {
     return mat;
 }
 
+/**
+ * Writes the matrix as text, the same way as `toString`, without allocating memory.
+ *
+ * Each element is written with the fewest digits that read back as exactly the same number.
+ *
+ * @param buf Buffer to write into, ended with a null character and cut short if too small
+ * @param size Number of characters the buffer can hold, where `FORMAT_SIZE` is always enough
+ * @return Length of the text, which is more than was written if the buffer was too small
+ */
+size_t Mat4::formatTo(char* buf, size_t size) const {
+    char text[FORMAT_SIZE];
+    size_t length = 0;
+    text[length++] = '[';
+    for (int j = 0; j < ORDER; ++j) {
+        if (j > 0) {
+            text[length++] = ',';
+            text[length++] = ' ';
+        }
+        double values[ORDER];
+        for (int i = 0; i < ORDER; ++i) {
+            values[i] = columns[j][i];
+        }
+        length += Format::formatList(text + length, values, ORDER);
+    }
+    text[length++] = ']';
+    return Format::copy(text, length, buf, size);
+}
+
+/**
+ * Reads a matrix from text written by `formatTo` or `toString`, as a list of columns.
+ *
+ * @param text Text to read from, where whitespace is allowed before and between tokens
+ * @param mat Matrix to store the result in, unchanged if the text is malformed
+ * @return Position after the matrix, or `NULL` if the text does not start with one
+ */
+const char* Mat4::parse(const char* text, Mat4& mat) {
+    double values[ORDER][ORDER];
+    text = Format::parseChar(text, '[');
+    for (int j = 0; (text != NULL) && (j < ORDER); ++j) {
+        if (j > 0) {
+            text = Format::parseChar(text, ',');
+        }
+        if (text != NULL) {
+            text = Format::parseList(text, values[j], ORDER);
+        }
+    }
+    if (text != NULL) {
+        text = Format::parseChar(text, ']');
+    }
+    if (text != NULL) {
+        mat = fromArrayInColumnMajor(values);
+    }
+    return text;
+}
+
 /**
  * Returns a column in the matrix.
  *
@@ -418,9 +472,8 @@ Mat3 Mat4::toMat3() const {
  * Returns a string representation of the matrix.
  */
 string Mat4::toString() const {
-    stringstream stream;
-    stream << (*this);
-    return stream.str();
+    char text[FORMAT_SIZE];
+    return string(text, formatTo(text, FORMAT_SIZE));
 }
 
 // OPERATORS
@@ -728,11 +781,17 @@ int Mat4::SignChart::operator()(const int i, const int j) const {
 } /* namespace M3d */
 
 ostream& operator<<(ostream &stream, const M3d::Mat4& mat) {
-    stream << '[';
-    stream << mat[0];
-    for (int j = 1; j < M3d::Mat4::ORDER; ++j) {
-        stream << ", " << mat[j];
+    if (!M3d::Format::isDefault(stream)) {
+        stream << '[';
+        for (int j = 0; j < M3d::Mat4::ORDER; ++j) {
+            stream << ((j == 0) ? "[" : ", [") << mat[j][0];
+            for (int i = 1; i < M3d::Mat4::ORDER; ++i) {
+                stream << ", " << mat[j][i];
+            }
+            stream << ']';
+        }
+        return stream << ']';
     }
-    stream << ']';
-    return stream;
+    char text[M3d::Mat4::FORMAT_SIZE];
+    return stream.write(text, mat.formatTo(text, sizeof(text)));
 }
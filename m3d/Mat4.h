@@ -39,6 +39,7 @@ public:
 // Constants
     static const int ORDER = 4; ///< Number of rows and columns
     static const int ORDER_SQUARED = 16; ///< Number of elements in matrix
+    static const size_t FORMAT_SIZE = 435; ///< Characters needed to format any matrix, including the null character
 // Methods
     explicit Mat4();
     explicit Mat4(const double value);
@@ -53,6 +54,8 @@ public:
     static Mat4 fromArrayInRowMajor(const float[4][4]);
     static Mat4 fromColumns(const Vec4& c1, const Vec4& c2, const Vec4& c3, const Vec4& c4);
     static Mat4 fromRows(const Vec4& r1, const Vec4& r2, const Vec4& r3, const Vec4& r4);
+    static const char* parse(const char* text, Mat4& mat);
+    size_t formatTo(char* buf, size_t size) const;
     Vec4 getColumn(const int j) const;
     Vec4 getRow(const int i) const;
     void toArrayInColumnMajor(double arr[4][4]) const;
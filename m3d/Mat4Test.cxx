@@ -25,6 +25,8 @@
  */
 #include "config.h"
 #include "m3d/common.h"
+#include <iomanip>
+#include <sstream>
 #include <cppunit/TestFixture.h>
 #include <cppunit/extensions/HelperMacros.h>
 #include <cppunit/ui/text/TestRunner.h>
@@ -1202,6 +1204,44 @@ public:
         CPPUNIT_ASSERT_EQUAL(expect, result);
     }
 
+    /**
+     * Ensures streams print exact values by default, and follow precision when it is set.
+     */
+    void testOperatorInsert() {
+
+        Mat4 mat(1);
+        mat[3][0] = 1.0 / 3.0;
+        ostringstream exact, precise;
+
+        exact << mat;
+        CPPUNIT_ASSERT_EQUAL(mat.toString(), exact.str());
+        precise << setprecision(3) << mat;
+        CPPUNIT_ASSERT_EQUAL(string("[[1, 0, 0, 0], [0, 1, 0, 0], [0, 0, 1, 0], [0.333, 0, 0, 1]]"), precise.str());
+    }
+
+    /**
+     * Ensures parse reads back exactly what toString writes, column by column.
+     */
+    void testParse() {
+
+        // Make a matrix with numbers that need every digit
+        Mat4 mat;
+        for (int j = 0; j < Mat4::ORDER; ++j) {
+            for (int i = 0; i < Mat4::ORDER; ++i) {
+                mat[j][i] = (i + 1.0) / (j + 7.0);
+            }
+        }
+
+        // Read it back and compare
+        Mat4 result;
+        char buf[Mat4::FORMAT_SIZE];
+        mat.formatTo(buf, sizeof(buf));
+        CPPUNIT_ASSERT(Mat4::parse(buf, result) != NULL);
+        CPPUNIT_ASSERT(mat == result);
+        CPPUNIT_ASSERT(Mat4::parse("[[1, 2, 3, 4], [5, 6, 7, 8]]", result) == NULL);
+        CPPUNIT_ASSERT(mat == result);
+    }
+
     /**
      * Ensures transposing a matrix works correctly.
      */
@@ -1287,6 +1327,8 @@ public:
     CPPUNIT_TEST(testToArrayInRowMajorDoubleArrayArray);
     CPPUNIT_TEST(testToArrayInRowMajorFloatArrayArray);
     CPPUNIT_TEST(testToMat3);
+    CPPUNIT_TEST(testOperatorInsert);
+    CPPUNIT_TEST(testParse);
     CPPUNIT_TEST(testToString);
     CPPUNIT_TEST(testTranspose);
     CPPUNIT_TEST(testMultiplyVector);
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <stdexcept>
+#include "m3d/MatrixStack.h"
+using namespace std;
+namespace M3d {
+
+/**
+ * Constructs a stack holding a single identity matrix.
+ *
+ * @param capacity Maximum number of entries, which must be at least one
+ * @throws std::invalid_argument if capacity is zero
+ */
+MatrixStack::MatrixStack(size_t capacity) : capacity(capacity) {
+    if (capacity == 0) {
+        throw invalid_argument("[MatrixStack] Capacity must be at least one!");
+    }
+    entries = new Entry[capacity];
+    top = entries;
+    loadIdentity();
+}
+
+/**
+ * Destroys the stack.
+ */
+MatrixStack::~MatrixStack() {
+    delete[] entries;
+}
+
+/**
+ * Returns the maximum number of entries the stack can hold.
+ */
+size_t MatrixStack::getCapacity() const {
+    return capacity;
+}
+
+/**
+ * Returns the inverse of the top matrix, computing it only if it is not already known.
+ *
+ * @return Reference to inverse, valid until the top of the stack changes
+ */
+const Mat4& MatrixStack::getInverse() const {
+    if (!top->inverseValid) {
+        top->inverse = inverse(top->matrix);
+        top->inverseValid = true;
+    }
+    return top->inverse;
+}
+
+/**
+ * Returns the matrix for transforming normals by the top matrix, computing it only if it is not already known.
+ *
+ * The normal matrix is the inverse transpose of the upper-left 3x3 part of the top matrix.
+ *
+ * @return Reference to normal matrix, valid until the top of the stack changes
+ */
+const Mat3& MatrixStack::getNormalMatrix() const {
+    if (!top->normalValid) {
+        top->normal = transpose(inverse(top->matrix.toMat3()));
+        top->normalValid = true;
+    }
+    return top->normal;
+}
+
+/**
+ * Returns the number of entries currently on the stack, which is always at least one.
+ */
+size_t MatrixStack::getSize() const {
+    return (top - entries) + 1;
+}
+
+/**
+ * Returns the matrix on top of the stack.
+ *
+ * @return Reference to top matrix, valid until the top of the stack changes
+ */
+const Mat4& MatrixStack::getTop() const {
+    return top->matrix;
+}
+
+/**
+ * Replaces the top matrix.
+ *
+ * @param mat Matrix to copy to the top of the stack
+ */
+void MatrixStack::load(const Mat4& mat) {
+    top->matrix = mat;
+    top->inverseValid = false;
+    top->normalValid = false;
+}
+
+/**
+ * Replaces the top matrix with a matrix whose inverse is already known.
+ *
+ * @param mat Matrix to copy to the top of the stack
+ * @param inv Inverse of the matrix
+ */
+void MatrixStack::load(const Mat4& mat, const Mat4& inv) {
+    top->matrix = mat;
+    top->inverse = inv;
+    top->inverseValid = true;
+    top->normalValid = false;
+}
+
+/**
+ * Replaces the top matrix with the identity matrix.
+ */
+void MatrixStack::loadIdentity() {
+    top->matrix = Mat4(1);
+    top->inverse = Mat4(1);
+    top->normal = Mat3(1);
+    top->inverseValid = true;
+    top->normalValid = true;
+}
+
+/**
+ * Multiplies the top matrix by another matrix on the right.
+ *
+ * @param mat Matrix to multiply by
+ */
+void MatrixStack::multiply(const Mat4& mat) {
+    top->matrix = top->matrix * mat;
+    top->inverseValid = false;
+    top->normalValid = false;
+}
+
+/**
+ * Multiplies the top matrix by another matrix on the right, updating the inverse using the matrix's known inverse.
+ *
+ * If the inverse of the top matrix has been computed, the new inverse is found with a single multiplication, since the
+ * inverse of `M * T` is `T^-1 * M^-1`.
+ *
+ * @param mat Matrix to multiply by
+ * @param inv Inverse of the matrix to multiply by
+ */
+void MatrixStack::multiply(const Mat4& mat, const Mat4& inv) {
+    top->matrix = top->matrix * mat;
+    if (top->inverseValid) {
+        top->inverse = inv * top->inverse;
+    }
+    top->normalValid = false;
+}
+
+/**
+ * Removes the top entry, restoring the entry below it.
+ *
+ * @throws std::underflow_error if only one entry is on the stack
+ */
+void MatrixStack::pop() {
+    if (top == entries) {
+        throw underflow_error("[MatrixStack] Cannot pop last entry!");
+    }
+    --top;
+}
+
+/**
+ * Duplicates the top entry, including any inverse or normal matrix already computed for it.
+ *
+ * @throws std::overflow_error if the stack is full
+ */
+void MatrixStack::push() {
+    if (getSize() == capacity) {
+        throw overflow_error("[MatrixStack] Stack is full!");
+    }
+    Entry* const next = top + 1;
+    next->matrix = top->matrix;
+    next->inverseValid = top->inverseValid;
+    next->normalValid = top->normalValid;
+    if (top->inverseValid) {
+        next->inverse = top->inverse;
+    }
+    if (top->normalValid) {
+        next->normal = top->normal;
+    }
+    top = next;
+}
+
+} /* namespace M3d */
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_MATRIXSTACK_H
+#define M3D_MATRIXSTACK_H
+#include "m3d/common.h"
+#include "m3d/Mat3.h"
+#include "m3d/Mat4.h"
+namespace M3d {
+
+
+/**
+ * Stack of 4x4 matrices for nesting transformations.
+ *
+ * All entries are allocated up front when the stack is constructed, so pushing and popping never touch the heap.
+ * The inverse and normal matrix of the top entry are only computed when requested, and are then remembered with the
+ * entry, so popping back to a parent restores its inverse without recomputing it.
+ *
+ * Like the OpenGL matrix stack, a new stack holds a single identity matrix and can never be popped empty.
+ */
+class MatrixStack {
+public:
+// Constants
+    static const size_t DEFAULT_CAPACITY = 32; ///< Number of entries reserved by default
+// Methods
+    explicit MatrixStack(size_t capacity = DEFAULT_CAPACITY);
+    ~MatrixStack();
+    size_t getCapacity() const;
+    const Mat4& getInverse() const;
+    const Mat3& getNormalMatrix() const;
+    size_t getSize() const;
+    const Mat4& getTop() const;
+    void load(const Mat4& mat);
+    void load(const Mat4& mat, const Mat4& inv);
+    void loadIdentity();
+    void multiply(const Mat4& mat);
+    void multiply(const Mat4& mat, const Mat4& inv);
+    void pop();
+    void push();
+private:
+// Types
+    struct Entry;
+// Attributes
+    Entry* entries;
+    Entry* top;
+    size_t capacity;
+// Helpers
+    MatrixStack(const MatrixStack&);
+    MatrixStack& operator=(const MatrixStack&);
+};
+
+
+/*
+ * Matrix on the stack with its cached inverse and normal matrix.
+ */
+struct MatrixStack::Entry {
+    Mat4 matrix;
+    mutable Mat4 inverse;
+    mutable Mat3 normal;
+    mutable bool inverseValid;
+    mutable bool normalValid;
+};
+
+} /* namespace M3d */
+#endif
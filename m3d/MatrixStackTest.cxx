@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <stdexcept>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/MatrixStack.h"
+using namespace std;
+
+/*
+ * Constants
+ */
+const double TOLERANCE = 1e-9;
+
+
+/**
+ * Unit test for MatrixStack.
+ */
+class MatrixStackTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Makes a matrix that translates by an offset.
+     */
+    static M3d::Mat4 createTranslation(double x, double y, double z) {
+        M3d::Mat4 mat(1);
+        mat[3] = M3d::Vec4(x, y, z, 1);
+        return mat;
+    }
+
+    /**
+     * Makes a matrix that scales by a factor along each axis.
+     */
+    static M3d::Mat4 createScale(double x, double y, double z) {
+        M3d::Mat4 mat(1);
+        mat[0][0] = x;
+        mat[1][1] = y;
+        mat[2][2] = z;
+        return mat;
+    }
+
+    /**
+     * Checks that two matrices are equal within tolerance.
+     */
+    static void assertMatricesEqual(const M3d::Mat4& expected, const M3d::Mat4& actual) {
+        for (int j = 0; j < 4; ++j) {
+            for (int i = 0; i < 4; ++i) {
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[j][i], actual[j][i], TOLERANCE);
+            }
+        }
+    }
+
+public:
+
+    /**
+     * Ensures a new stack holds a single identity matrix.
+     */
+    void testConstructor() {
+        M3d::MatrixStack stack(4);
+        CPPUNIT_ASSERT_EQUAL((size_t) 1, stack.getSize());
+        CPPUNIT_ASSERT_EQUAL((size_t) 4, stack.getCapacity());
+        CPPUNIT_ASSERT(stack.getTop() == M3d::Mat4(1));
+        CPPUNIT_ASSERT(stack.getInverse() == M3d::Mat4(1));
+    }
+
+    /**
+     * Ensures the constructor rejects a capacity of zero.
+     */
+    void testConstructorWithZeroCapacity() {
+        CPPUNIT_ASSERT_THROW(M3d::MatrixStack(0), invalid_argument);
+    }
+
+    /**
+     * Ensures push duplicates the top matrix and pop restores the previous one.
+     */
+    void testPushPop() {
+        M3d::MatrixStack stack;
+        const M3d::Mat4 t = createTranslation(1, 2, 3);
+        stack.load(t);
+        stack.push();
+        CPPUNIT_ASSERT_EQUAL((size_t) 2, stack.getSize());
+        CPPUNIT_ASSERT(stack.getTop() == t);
+        stack.multiply(createScale(2, 2, 2));
+        CPPUNIT_ASSERT(stack.getTop() != t);
+        stack.pop();
+        CPPUNIT_ASSERT_EQUAL((size_t) 1, stack.getSize());
+        CPPUNIT_ASSERT(stack.getTop() == t);
+    }
+
+    /**
+     * Ensures pushing onto a full stack throws.
+     */
+    void testPushWhenFull() {
+        M3d::MatrixStack stack(2);
+        stack.push();
+        CPPUNIT_ASSERT_THROW(stack.push(), overflow_error);
+    }
+
+    /**
+     * Ensures popping the last entry throws.
+     */
+    void testPopLast() {
+        M3d::MatrixStack stack;
+        CPPUNIT_ASSERT_THROW(stack.pop(), underflow_error);
+    }
+
+    /**
+     * Ensures multiply post-multiplies the top matrix.
+     */
+    void testMultiply() {
+        M3d::MatrixStack stack;
+        const M3d::Mat4 t = createTranslation(1, 2, 3);
+        const M3d::Mat4 s = createScale(2, 3, 4);
+        stack.multiply(t);
+        stack.multiply(s);
+        assertMatricesEqual(t * s, stack.getTop());
+    }
+
+    /**
+     * Ensures the inverse is recomputed after the top changes.
+     */
+    void testGetInverse() {
+        M3d::MatrixStack stack;
+        const M3d::Mat4 t = createTranslation(1, 2, 3);
+        const M3d::Mat4 s = createScale(2, 4, 8);
+        stack.multiply(t);
+        assertMatricesEqual(createTranslation(-1, -2, -3), stack.getInverse());
+        stack.multiply(s);
+        assertMatricesEqual(M3d::inverse(t * s), stack.getInverse());
+    }
+
+    /**
+     * Ensures multiplying with a known inverse keeps the inverse correct.
+     */
+    void testMultiplyWithInverse() {
+        M3d::MatrixStack stack;
+        stack.multiply(createTranslation(4, 5, 6));
+        stack.getInverse();
+        stack.multiply(createScale(2, 4, 8), createScale(0.5, 0.25, 0.125));
+        assertMatricesEqual(M3d::inverse(stack.getTop()), stack.getInverse());
+    }
+
+    /**
+     * Ensures popping restores the inverse of the previous entry.
+     */
+    void testPopRestoresInverse() {
+        M3d::MatrixStack stack;
+        stack.load(createScale(2, 2, 2));
+        stack.push();
+        stack.multiply(createTranslation(1, 1, 1));
+        stack.getInverse();
+        stack.pop();
+        assertMatricesEqual(createScale(0.5, 0.5, 0.5), stack.getInverse());
+    }
+
+    /**
+     * Ensures pushing copies an inverse already computed, and never reuses one left in the entry by earlier pushes.
+     */
+    void testPushCopiesInverse() {
+        M3d::MatrixStack stack;
+        stack.push();
+        stack.load(createTranslation(1, 1, 1));
+        stack.getInverse();
+        stack.getNormalMatrix();
+        stack.pop();
+
+        stack.load(createScale(2, 2, 2));
+        stack.push();
+        assertMatricesEqual(createScale(0.5, 0.5, 0.5), stack.getInverse());
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, stack.getNormalMatrix()[0][0], TOLERANCE);
+        stack.push();
+        assertMatricesEqual(createScale(0.5, 0.5, 0.5), stack.getInverse());
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, stack.getNormalMatrix()[1][1], TOLERANCE);
+    }
+
+    /**
+     * Ensures the normal matrix is the inverse transpose of the upper-left 3x3 part.
+     */
+    void testGetNormalMatrix() {
+        M3d::MatrixStack stack;
+        stack.multiply(createTranslation(7, 8, 9));
+        stack.multiply(createScale(2, 4, 8));
+        const M3d::Mat3 normal = stack.getNormalMatrix();
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, normal[0][0], TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.25, normal[1][1], TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.125, normal[2][2], TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, normal[0][1], TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, normal[2][0], TOLERANCE);
+    }
+
+    CPPUNIT_TEST_SUITE(MatrixStackTest);
+    CPPUNIT_TEST(testConstructor);
+    CPPUNIT_TEST(testConstructorWithZeroCapacity);
+    CPPUNIT_TEST(testPushPop);
+    CPPUNIT_TEST(testPushWhenFull);
+    CPPUNIT_TEST(testPopLast);
+    CPPUNIT_TEST(testMultiply);
+    CPPUNIT_TEST(testGetInverse);
+    CPPUNIT_TEST(testMultiplyWithInverse);
+    CPPUNIT_TEST(testPopRestoresInverse);
+    CPPUNIT_TEST(testPushCopiesInverse);
+    CPPUNIT_TEST(testGetNormalMatrix);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(MatrixStackTest::suite());
+    runner.run();
+    return 0;
+}
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <stdexcept>
+#include "m3d/MatrixWriter.h"
+using namespace std;
+namespace M3d {
+
+/* Matrices must be sixteen contiguous doubles to be converted as one run */
+typedef char Mat4SizeCheck[(sizeof(Mat4) == 16 * sizeof(double)) ? 1 : -1];
+
+
+/*
+ * Task converting a range of matrices.
+ */
+class MatrixWriter::MatrixTask : public ParallelTask {
+public:
+    MatrixTask(const Mat4* mats, Layout layout, float* out, size_t stride)
+            : in(reinterpret_cast<const double*>(mats)), layout(layout), out(out), stride(stride) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        if ((layout == COLUMNS_4X4) && (stride == 16)) {
+
+            // Convert as one run, which compilers can vectorize
+            const double* const first = in + (begin * 16);
+            float* const result = out + (begin * 16);
+            const size_t size = (end - begin) * 16;
+            for (size_t k = 0; k < size; ++k) {
+                result[k] = (float) first[k];
+            }
+        } else if (layout == COLUMNS_4X4) {
+            for (size_t i = begin; i < end; ++i) {
+                const double* const mat = in + (i * 16);
+                float* const result = out + (i * stride);
+                for (int k = 0; k < 16; ++k) {
+                    result[k] = (float) mat[k];
+                }
+            }
+        } else {
+            for (size_t i = begin; i < end; ++i) {
+                const double* const mat = in + (i * 16);
+                float* const result = out + (i * stride);
+                for (int r = 0; r < 3; ++r) {
+                    for (int c = 0; c < 4; ++c) {
+                        result[(r * 4) + c] = (float) mat[(c * 4) + r];
+                    }
+                }
+            }
+        }
+    }
+private:
+    const double* in;
+    Layout layout;
+    float* out;
+    size_t stride;
+};
+
+
+/*
+ * Task composing and converting a range of translations, rotations and scales.
+ */
+class MatrixWriter::TrsTask : public ParallelTask {
+public:
+    TrsTask(const Vec3* translations, const Quat* rotations, const Vec3* scales, Layout layout, float* out,
+            size_t stride)
+            : translations(translations), rotations(rotations), scales(scales), layout(layout), out(out),
+              stride(stride) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+
+            // Find rotation, normalizing the quaternion
+            double m[3][4] = { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 } };
+            if (rotations != NULL) {
+                const Quat& q = rotations[i];
+                const double norm = (q.x * q.x) + (q.y * q.y) + (q.z * q.z) + (q.w * q.w);
+                const double s = (norm > 0) ? (2 / norm) : 0;
+                const double xx = q.x * q.x * s;
+                const double yy = q.y * q.y * s;
+                const double zz = q.z * q.z * s;
+                const double xy = q.x * q.y * s;
+                const double xz = q.x * q.z * s;
+                const double yz = q.y * q.z * s;
+                const double wx = q.w * q.x * s;
+                const double wy = q.w * q.y * s;
+                const double wz = q.w * q.z * s;
+                m[0][0] = 1 - yy - zz;
+                m[0][1] = xy - wz;
+                m[0][2] = xz + wy;
+                m[1][0] = xy + wz;
+                m[1][1] = 1 - xx - zz;
+                m[1][2] = yz - wx;
+                m[2][0] = xz - wy;
+                m[2][1] = yz + wx;
+                m[2][2] = 1 - xx - yy;
+            }
+
+            // Scale columns and add translation
+            if (scales != NULL) {
+                const Vec3& scale = scales[i];
+                for (int r = 0; r < 3; ++r) {
+                    m[r][0] *= scale.x;
+                    m[r][1] *= scale.y;
+                    m[r][2] *= scale.z;
+                }
+            }
+            if (translations != NULL) {
+                m[0][3] = translations[i].x;
+                m[1][3] = translations[i].y;
+                m[2][3] = translations[i].z;
+            }
+
+            // Store
+            float* const result = out + (i * stride);
+            if (layout == COLUMNS_4X4) {
+                for (int c = 0; c < 4; ++c) {
+                    result[c * 4] = (float) m[0][c];
+                    result[(c * 4) + 1] = (float) m[1][c];
+                    result[(c * 4) + 2] = (float) m[2][c];
+                    result[(c * 4) + 3] = (c == 3) ? 1.0f : 0.0f;
+                }
+            } else {
+                for (int r = 0; r < 3; ++r) {
+                    for (int c = 0; c < 4; ++c) {
+                        result[(r * 4) + c] = (float) m[r][c];
+                    }
+                }
+            }
+        }
+    }
+private:
+    const Vec3* translations;
+    const Quat* rotations;
+    const Vec3* scales;
+    Layout layout;
+    float* out;
+    size_t stride;
+};
+
+// METHODS
+
+/**
+ * Returns the number of floats written for each transform in a layout.
+ *
+ * @throws invalid_argument if the layout is unknown
+ */
+size_t MatrixWriter::countFloats(Layout layout) {
+    switch (layout) {
+    case COLUMNS_4X4:
+        return 16;
+    case ROWS_3X4:
+        return 12;
+    default:
+        throw invalid_argument("[MatrixWriter] Unknown layout!");
+    }
+}
+
+/**
+ * Writes matrices as floats.
+ *
+ * @param mats Matrices to write
+ * @param count Number of matrices
+ * @param layout Arrangement of each matrix's floats, where rows of three by four drop the last row
+ * @param out Buffer with room for every matrix at its stride
+ * @param stride Number of floats from the start of one matrix to the next, or zero to pack them together
+ * @throws invalid_argument if the layout is unknown or the stride is smaller than a matrix
+ */
+void MatrixWriter::write(const Mat4* mats, size_t count, Layout layout, float* out, size_t stride) {
+    MatrixTask task(mats, layout, out, findStride(layout, stride));
+    Parallel::run(task, count, GRAIN_SIZE);
+}
+
+/**
+ * Writes transforms that scale, then rotate, then translate, as floats.
+ *
+ * @param translations Offsets of each transform, or `NULL` for none
+ * @param rotations Rotations of each transform, which are normalized first, or `NULL` for none
+ * @param scales Scale factors along each axis of each transform, or `NULL` for none
+ * @param count Number of transforms
+ * @param layout Arrangement of each transform's floats
+ * @param out Buffer with room for every transform at its stride
+ * @param stride Number of floats from the start of one transform to the next, or zero to pack them together
+ * @throws invalid_argument if the layout is unknown or the stride is smaller than a transform
+ */
+void MatrixWriter::write(const Vec3* translations, const Quat* rotations, const Vec3* scales, size_t count,
+                         Layout layout, float* out, size_t stride) {
+    TrsTask task(translations, rotations, scales, layout, out, findStride(layout, stride));
+    Parallel::run(task, count, GRAIN_SIZE);
+}
+
+// HELPERS
+
+/*
+ * Checks a stride, replacing zero with the size of a transform.
+ */
+size_t MatrixWriter::findStride(Layout layout, size_t stride) {
+    const size_t size = countFloats(layout);
+    if (stride == 0) {
+        return size;
+    } else if (stride < size) {
+        throw invalid_argument("[MatrixWriter] Stride is smaller than a transform!");
+    }
+    return stride;
+}
+
+} /* namespace M3d */
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_MATRIXWRITER_H
+#define M3D_MATRIXWRITER_H
+#include "m3d/common.h"
+#include "m3d/Mat4.h"
+#include "m3d/Parallel.h"
+#include "m3d/Quat.h"
+#include "m3d/Vec3.h"
+namespace M3d {
+
+
+/**
+ * Utility for converting many transforms at once into a buffer of floats, such as per-instance data for a GPU.
+ *
+ * Transforms are written either as whole matrices in column-major order, or as the top three rows of each matrix in
+ * row-major order, which holds an affine transform in three four-component vectors.  Each transform starts a fixed
+ * number of floats after the one before it, so they can be placed inside larger per-instance blocks; any floats in
+ * between are left as they were.  Large batches are split across several threads.
+ */
+class MatrixWriter {
+public:
+// Types
+    /** Arrangement of each transform's floats */
+    enum Layout { COLUMNS_4X4, ROWS_3X4 };
+// Methods
+    static size_t countFloats(Layout layout);
+    static void write(const Mat4* mats, size_t count, Layout layout, float* out, size_t stride = 0);
+    static void write(const Vec3* translations, const Quat* rotations, const Vec3* scales, size_t count, Layout layout,
+                      float* out, size_t stride = 0);
+private:
+// Types
+    class MatrixTask;
+    class TrsTask;
+// Constants
+    static const size_t GRAIN_SIZE = 16384;
+// Helpers
+    static size_t findStride(Layout layout, size_t stride);
+};
+
+} /* namespace M3d */
+#endif
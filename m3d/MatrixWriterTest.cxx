@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/MatrixWriter.h"
+using namespace std;
+
+
+/**
+ * Unit test for MatrixWriter.
+ */
+class MatrixWriterTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + ((upper - lower) * rand() / RAND_MAX);
+    }
+
+    /**
+     * Makes random matrices.
+     */
+    static vector<M3d::Mat4> makeMatrices(size_t size) {
+        vector<M3d::Mat4> mats(size);
+        for (size_t i = 0; i < size; ++i) {
+            for (int j = 0; j < 4; ++j) {
+                mats[i][j] = M3d::Vec4(random(-10, 10), random(-10, 10), random(-10, 10), random(-10, 10));
+            }
+        }
+        return mats;
+    }
+
+public:
+
+    /**
+     * Resets the number of threads.
+     */
+    void tearDown() {
+        M3d::Parallel::setConcurrency(0);
+    }
+
+    /**
+     * Ensures each layout has the right number of floats.
+     */
+    void testCountFloats() {
+        CPPUNIT_ASSERT_EQUAL((size_t) 16, M3d::MatrixWriter::countFloats(M3d::MatrixWriter::COLUMNS_4X4));
+        CPPUNIT_ASSERT_EQUAL((size_t) 12, M3d::MatrixWriter::countFloats(M3d::MatrixWriter::ROWS_3X4));
+        CPPUNIT_ASSERT_THROW(M3d::MatrixWriter::countFloats((M3d::MatrixWriter::Layout) 7), invalid_argument);
+    }
+
+    /**
+     * Ensures matrices are written exactly as converting them one at a time would, with or without gaps.
+     */
+    void testWriteMatrices() {
+        const size_t size = 50001;
+        const vector<M3d::Mat4> mats = makeMatrices(size);
+        M3d::Parallel::setConcurrency(4);
+
+        // Packed columns
+        vector<float> out(16 * size);
+        M3d::MatrixWriter::write(&mats[0], size, M3d::MatrixWriter::COLUMNS_4X4, &out[0]);
+        for (size_t i = 0; i < size; ++i) {
+            float expected[16];
+            mats[i].toArrayInColumnMajor(expected);
+            CPPUNIT_ASSERT(equal(expected, expected + 16, &out[16 * i]));
+        }
+
+        // Rows with gaps, which should be left alone
+        vector<float> padded(20 * size, -1.0f);
+        M3d::MatrixWriter::write(&mats[0], size, M3d::MatrixWriter::ROWS_3X4, &padded[0], 20);
+        for (size_t i = 0; i < size; ++i) {
+            float expected[16];
+            mats[i].toArrayInRowMajor(expected);
+            CPPUNIT_ASSERT(equal(expected, expected + 12, &padded[20 * i]));
+            CPPUNIT_ASSERT(vector<float>(8, -1.0f) == vector<float>(&padded[(20 * i) + 12], &padded[20 * (i + 1)]));
+        }
+
+        CPPUNIT_ASSERT_THROW(M3d::MatrixWriter::write(&mats[0], size, M3d::MatrixWriter::COLUMNS_4X4, &out[0], 12),
+                             invalid_argument);
+    }
+
+    /**
+     * Ensures translations, rotations and scales are composed in the right order.
+     */
+    void testWriteTransforms() {
+        const size_t size = 1000;
+        vector<M3d::Vec3> translations(size);
+        vector<M3d::Quat> rotations(size);
+        vector<M3d::Vec3> scales(size);
+        for (size_t i = 0; i < size; ++i) {
+            translations[i] = M3d::Vec3(random(-10, 10), random(-10, 10), random(-10, 10));
+            rotations[i] = M3d::Quat(random(-1, 1), random(-1, 1), random(-1, 1), random(-1, 1));
+            scales[i] = M3d::Vec3(random(0.1, 2), random(0.1, 2), random(0.1, 2));
+        }
+
+        vector<float> columns(16 * size);
+        vector<float> rows(12 * size);
+        M3d::MatrixWriter::write(&translations[0], &rotations[0], &scales[0], size, M3d::MatrixWriter::COLUMNS_4X4,
+                                 &columns[0]);
+        M3d::MatrixWriter::write(&translations[0], &rotations[0], &scales[0], size, M3d::MatrixWriter::ROWS_3X4,
+                                 &rows[0]);
+        for (size_t i = 0; i < size; ++i) {
+            M3d::Mat4 scale(1);
+            scale[0][0] = scales[i].x;
+            scale[1][1] = scales[i].y;
+            scale[2][2] = scales[i].z;
+            M3d::Mat4 mat = normalize(rotations[i]).toMat4() * scale;
+            mat[3] = M3d::Vec4(translations[i], 1);
+            float expected[16];
+            mat.toArrayInColumnMajor(expected);
+            for (int k = 0; k < 16; ++k) {
+                CPPUNIT_ASSERT(fabs(expected[k] - columns[(16 * i) + k]) < 1e-5);
+            }
+            mat.toArrayInRowMajor(expected);
+            for (int k = 0; k < 12; ++k) {
+                CPPUNIT_ASSERT(fabs(expected[k] - rows[(12 * i) + k]) < 1e-5);
+            }
+        }
+
+        // Missing parts are left out
+        float out[12];
+        M3d::MatrixWriter::write(&translations[0], NULL, NULL, 1, M3d::MatrixWriter::ROWS_3X4, out);
+        const float expected[12] = { 1, 0, 0, (float) translations[0].x, 0, 1, 0, (float) translations[0].y,
+                                     0, 0, 1, (float) translations[0].z };
+        CPPUNIT_ASSERT(equal(expected, expected + 12, out));
+    }
+
+    CPPUNIT_TEST_SUITE(MatrixWriterTest);
+    CPPUNIT_TEST(testCountFloats);
+    CPPUNIT_TEST(testWriteMatrices);
+    CPPUNIT_TEST(testWriteTransforms);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(MatrixWriterTest::suite());
+    runner.run();
+    return 0;
+}
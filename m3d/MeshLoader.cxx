@@ -0,0 +1,760 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include "m3d/MeshLoader.h"
+using namespace std;
+namespace M3d {
+
+/* Outcomes of parsing a line */
+enum { PARSED = 0, BAD_NUMBER = 1, BAD_INDEX = 2 };
+
+/* Formats of PLY files */
+enum { ASCII = 0, LITTLE_ENDIAN_BINARY = 1, BIG_ENDIAN_BINARY = 2 };
+
+/* Names, sizes and signedness of PLY scalar types */
+static const int SCALAR_TYPE_COUNT = 16;
+static const char* const SCALAR_NAMES[SCALAR_TYPE_COUNT] = {
+    "char", "uchar", "short", "ushort", "int", "uint", "float", "double",
+    "int8", "uint8", "int16", "uint16", "int32", "uint32", "float32", "float64"
+};
+static const size_t SCALAR_SIZES[SCALAR_TYPE_COUNT] = { 1, 1, 2, 2, 4, 4, 4, 8, 1, 1, 2, 2, 4, 4, 4, 8 };
+
+/* Checks if a character separates tokens on a line */
+static inline bool isBlank(char c) {
+    return (c == ' ') || (c == '\t') || (c == '\r');
+}
+
+/* Skips spaces and tabs */
+static inline const char* skipBlanks(const char* p, const char* end) {
+    while ((p < end) && isBlank(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+/* Finds the end of a token */
+static inline const char* skipToken(const char* p, const char* end) {
+    while ((p < end) && !isBlank(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+/* Finds the newline ending a line, or the end of the text */
+static inline const char* findLineEnd(const char* p, const char* end) {
+    const void* const newline = memchr(p, '\n', end - p);
+    return (newline != NULL) ? static_cast<const char*>(newline) : end;
+}
+
+/* Reads a number after any blanks, returning NULL if there is none */
+static inline const char* readNumber(const char* p, const char* end, double& value) {
+    p = skipBlanks(p, end);
+    return (p < end) ? Format::parseDouble(p, end, value) : NULL;
+}
+
+/* Reads an integer after any blanks, returning NULL if there is none */
+static inline const char* readInteger(const char* p, const char* end, long& value) {
+    p = skipBlanks(p, end);
+    const bool negative = (p < end) && (*p == '-');
+    p += negative ? 1 : 0;
+    if ((p >= end) || (*p < '0') || (*p > '9')) {
+        return NULL;
+    }
+    long result = 0;
+    for (; (p < end) && (*p >= '0') && (*p <= '9'); ++p) {
+        result = (result * 10) + (*p - '0');
+    }
+    value = negative ? -result : result;
+    return p;
+}
+
+/* Reads a PLY scalar from binary data */
+static double readScalar(const char* p, int type, bool swap) {
+    char bytes[8];
+    const size_t size = SCALAR_SIZES[type];
+    for (size_t i = 0; i < size; ++i) {
+        bytes[i] = p[swap ? (size - 1 - i) : i];
+    }
+    switch (type % 8) {
+    case 0: { int8_t v; memcpy(&v, bytes, 1); return v; }
+    case 1: { uint8_t v; memcpy(&v, bytes, 1); return v; }
+    case 2: { int16_t v; memcpy(&v, bytes, 2); return v; }
+    case 3: { uint16_t v; memcpy(&v, bytes, 2); return v; }
+    case 4: { int32_t v; memcpy(&v, bytes, 4); return v; }
+    case 5: { uint32_t v; memcpy(&v, bytes, 4); return v; }
+    case 6: { float v; memcpy(&v, bytes, 4); return v; }
+    default: { double v; memcpy(&v, bytes, 8); return v; }
+    }
+}
+
+
+/*
+ * Number of each kind of item in a chunk, and then the offsets where the chunk's items go.
+ */
+struct MeshLoader::Counts {
+    size_t positions;
+    size_t normals;
+    size_t triangles;
+    int error;
+};
+
+
+/*
+ * Property of an element in a PLY file.
+ */
+struct MeshLoader::Property {
+    string name;
+    int type;
+    int countType;
+    bool isList() const {
+        return countType >= 0;
+    }
+};
+
+
+/*
+ * Element in a PLY file, such as its vertices or faces.
+ */
+struct MeshLoader::Element {
+    string name;
+    size_t count;
+    vector<Property> properties;
+    int find(const string& name) const {
+        for (size_t i = 0; i < properties.size(); ++i) {
+            if (properties[i].name == name) {
+                return (int) i;
+            }
+        }
+        return -1;
+    }
+    size_t getStride() const {
+        size_t stride = 0;
+        for (size_t i = 0; i < properties.size(); ++i) {
+            if (properties[i].isList()) {
+                return 0;
+            }
+            stride += SCALAR_SIZES[properties[i].type];
+        }
+        return stride;
+    }
+};
+
+
+/*
+ * Task decoding a range of fixed-size binary PLY vertices.
+ */
+class MeshLoader::BinaryTask : public ParallelTask {
+public:
+    BinaryTask(const char* data, const Element& vertex, bool swap, Vec3Array& positions, Vec3Array& normals) :
+            data(data), stride(vertex.getStride()), swap(swap), positions(positions), normals(normals) {
+        const char* const names[6] = { "x", "y", "z", "nx", "ny", "nz" };
+        for (int k = 0; k < 6; ++k) {
+            const int index = vertex.find(names[k]);
+            offsets[k] = 0;
+            types[k] = (index >= 0) ? vertex.properties[index].type : -1;
+            for (int i = 0; i < index; ++i) {
+                offsets[k] += SCALAR_SIZES[vertex.properties[i].type];
+            }
+        }
+    }
+    virtual void run(size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const char* const v = data + (i * stride);
+            positions.x[i] = readScalar(v + offsets[0], types[0], swap);
+            positions.y[i] = readScalar(v + offsets[1], types[1], swap);
+            positions.z[i] = readScalar(v + offsets[2], types[2], swap);
+        }
+        if (normals.size() > 0) {
+            for (size_t i = begin; i < end; ++i) {
+                const char* const v = data + (i * stride);
+                normals.x[i] = readScalar(v + offsets[3], types[3], swap);
+                normals.y[i] = readScalar(v + offsets[4], types[4], swap);
+                normals.z[i] = readScalar(v + offsets[5], types[5], swap);
+            }
+        }
+    }
+private:
+    const char* data;
+    size_t stride;
+    bool swap;
+    size_t offsets[6];
+    int types[6];
+    Vec3Array& positions;
+    Vec3Array& normals;
+};
+
+
+/*
+ * Task counting or parsing the lines starting in a range of text.
+ *
+ * A line belongs to the chunk its first character is in, so each chunk skips the end of a line started in the chunk
+ * before it.  When counting, the chunk's counts are stored; when parsing, the counts are offsets into the arrays.
+ */
+class MeshLoader::TextTask : public ParallelTask {
+public:
+    TextTask(const char* begin, const char* end, FileType type, const Element* vertex, vector<Counts>& counts) :
+            begin(begin), end(end), type(type), vertex(vertex), counts(counts), positions(NULL), normals(NULL),
+            indices(NULL) {
+        if (vertex != NULL) {
+            const char* const names[6] = { "x", "y", "z", "nx", "ny", "nz" };
+            for (int k = 0; k < 6; ++k) {
+                columns[k] = vertex->find(names[k]);
+            }
+        }
+    }
+    void setOutputs(Vec3Array* positions, Vec3Array* normals, vector<uint32_t>* indices) {
+        this->positions = positions;
+        this->normals = normals;
+        this->indices = indices;
+    }
+    virtual void run(size_t chunk, size_t first, size_t last) {
+
+        // Start at the first whole line
+        const char* p = begin + first;
+        if ((first > 0) && (p[-1] != '\n')) {
+            p = findLineEnd(p, end);
+            p = (p < end) ? (p + 1) : end;
+        }
+
+        Counts& c = counts[chunk];
+        Counts n = { 0, 0, 0, PARSED };
+        while ((p < begin + last) && (n.error == PARSED)) {
+            const char* const lineEnd = findLineEnd(p, end);
+            const char* const q = skipBlanks(p, lineEnd);
+            if (type == OBJ) {
+                n.error = readObjLine(q, lineEnd, c, n);
+            } else if (q < lineEnd) {
+                n.error = (type == XYZ) ? readXyzLine(q, lineEnd, c, n) : readVertexLine(q, lineEnd, c, n);
+            }
+            p = (lineEnd < end) ? (lineEnd + 1) : end;
+        }
+
+        if (positions == NULL) {
+            c = n;
+        } else {
+            c.error = n.error;
+        }
+    }
+private:
+    const char* begin;
+    const char* end;
+    FileType type;
+    const Element* vertex;
+    int columns[6];
+    vector<Counts>& counts;
+    Vec3Array* positions;
+    Vec3Array* normals;
+    vector<uint32_t>* indices;
+
+    /* Reads numbers into an array, or just checks there are enough when counting */
+    int readVec3(const char* p, const char* lineEnd, Vec3Array* arr, size_t i) {
+        if (arr == NULL) {
+            return PARSED;
+        }
+        double v[3];
+        for (int k = 0; k < 3; ++k) {
+            p = readNumber(p, lineEnd, v[k]);
+            if (p == NULL) {
+                return BAD_NUMBER;
+            }
+        }
+        arr->x[i] = v[0];
+        arr->y[i] = v[1];
+        arr->z[i] = v[2];
+        return PARSED;
+    }
+
+    /* Reads a vertex, normal or face from an OBJ line */
+    int readObjLine(const char* p, const char* lineEnd, const Counts& offsets, Counts& n) {
+        if (((lineEnd - p) > 1) && (p[0] == 'v') && isBlank(p[1])) {
+            return readVec3(p + 2, lineEnd, positions, offsets.positions + n.positions++);
+        } else if (((lineEnd - p) > 2) && (p[0] == 'v') && (p[1] == 'n') && isBlank(p[2])) {
+            return readVec3(p + 3, lineEnd, normals, offsets.normals + n.normals++);
+        } else if (((lineEnd - p) > 1) && (p[0] == 'f') && isBlank(p[1])) {
+            return readObjFace(p + 2, lineEnd, offsets, n);
+        }
+        return PARSED;
+    }
+
+    /* Reads the corners of an OBJ face, splitting it into a fan of triangles */
+    int readObjFace(const char* p, const char* lineEnd, const Counts& offsets, Counts& n) {
+        size_t corners = 0;
+        uint32_t fan[3] = { 0, 0, 0 };
+        const long defined = (long) (offsets.positions + n.positions);
+        const long total = (long) ((positions == NULL) ? 0 : positions->size());
+        for (p = skipBlanks(p, lineEnd); p < lineEnd; p = skipBlanks(skipToken(p, lineEnd), lineEnd)) {
+            if (indices != NULL) {
+                long index;
+                if (readInteger(p, lineEnd, index) == NULL) {
+                    return BAD_NUMBER;
+                }
+                index = (index < 0) ? (defined + index) : (index - 1);
+                if ((index < 0) || (index >= total)) {
+                    return BAD_INDEX;
+                }
+                fan[(corners < 2) ? corners : 2] = (uint32_t) index;
+                if (corners >= 2) {
+                    uint32_t* const triangle = &(*indices)[3 * (offsets.triangles + n.triangles)];
+                    triangle[0] = fan[0];
+                    triangle[1] = fan[1];
+                    triangle[2] = fan[2];
+                    fan[1] = fan[2];
+                }
+            }
+            n.triangles += (corners >= 2) ? 1 : 0;
+            ++corners;
+        }
+        return PARSED;
+    }
+
+    /* Reads a point and possibly its normal from an XYZ line */
+    int readXyzLine(const char* p, const char* lineEnd, const Counts& offsets, Counts& n) {
+        if (*p == '#') {
+            return PARSED;
+        } else if (positions == NULL) {
+            size_t tokens = 0;
+            for (; p < lineEnd; p = skipBlanks(skipToken(p, lineEnd), lineEnd)) {
+                ++tokens;
+            }
+            n.normals += (tokens >= 6) ? 1 : 0;
+            ++n.positions;
+            return (tokens >= 3) ? PARSED : BAD_NUMBER;
+        }
+        const size_t i = offsets.positions + n.positions++;
+        double v[6];
+        const int count = (normals->size() > 0) ? 6 : 3;
+        for (int k = 0; k < count; ++k) {
+            p = readNumber(p, lineEnd, v[k]);
+            if (p == NULL) {
+                return BAD_NUMBER;
+            }
+        }
+        positions->x[i] = v[0];
+        positions->y[i] = v[1];
+        positions->z[i] = v[2];
+        if (count == 6) {
+            normals->x[i] = v[3];
+            normals->y[i] = v[4];
+            normals->z[i] = v[5];
+        }
+        return PARSED;
+    }
+
+    /* Reads a vertex from a line of an ASCII PLY file */
+    int readVertexLine(const char* p, const char* lineEnd, const Counts& offsets, Counts& n) {
+        const size_t i = offsets.positions + n.positions++;
+        if (positions == NULL) {
+            return PARSED;
+        }
+        double v[6] = { 0, 0, 0, 0, 0, 0 };
+        for (int j = 0; j < (int) vertex->properties.size(); ++j) {
+            double value;
+            p = readNumber(p, lineEnd, value);
+            if (p == NULL) {
+                return BAD_NUMBER;
+            }
+            for (int k = 0; k < 6; ++k) {
+                v[k] = (columns[k] == j) ? value : v[k];
+            }
+        }
+        positions->x[i] = v[0];
+        positions->y[i] = v[1];
+        positions->z[i] = v[2];
+        if (normals->size() > 0) {
+            normals->x[i] = v[3];
+            normals->y[i] = v[4];
+            normals->z[i] = v[5];
+        }
+        return PARSED;
+    }
+};
+
+// METHODS
+
+/**
+ * Constructs an empty loader.
+ */
+MeshLoader::MeshLoader() {
+    // pass
+}
+
+/**
+ * Removes everything loaded.
+ */
+void MeshLoader::clear() {
+    positions.clear();
+    normals.clear();
+    indices.clear();
+}
+
+/**
+ * Determines the kind of a file from its extension, ignoring case.
+ *
+ * @param filename Path to the file
+ * @return Kind of file
+ * @throws invalid_argument if the extension is not `.obj`, `.ply` or `.xyz`
+ */
+MeshLoader::FileType MeshLoader::findType(const string& filename) {
+    const size_t dot = filename.rfind('.');
+    string extension = (dot == string::npos) ? "" : filename.substr(dot + 1);
+    for (size_t i = 0; i < extension.size(); ++i) {
+        extension[i] = (char) tolower((unsigned char) extension[i]);
+    }
+    if (extension == "obj") {
+        return OBJ;
+    } else if (extension == "ply") {
+        return PLY;
+    } else if (extension == "xyz") {
+        return XYZ;
+    }
+    throw invalid_argument("[MeshLoader] Unknown file type!");
+}
+
+/**
+ * Returns the corners of each triangle, three per triangle, as indices into the positions.
+ */
+const vector<uint32_t>& MeshLoader::getIndices() const {
+    return indices;
+}
+
+/**
+ * Returns the normals in the file, which is empty if it has none.
+ */
+const Vec3Array& MeshLoader::getNormals() const {
+    return normals;
+}
+
+/**
+ * Returns the positions of the vertices or points in the file.
+ */
+const Vec3Array& MeshLoader::getPositions() const {
+    return positions;
+}
+
+/**
+ * Loads a file, choosing how to read it from its extension.
+ *
+ * @param filename Path to the file
+ * @throws invalid_argument if the extension is not known
+ * @throws runtime_error if the file cannot be read or is malformed
+ */
+void MeshLoader::load(const string& filename) {
+    load(filename, findType(filename));
+}
+
+/**
+ * Loads a file, replacing anything loaded before.
+ *
+ * @param filename Path to the file
+ * @param type Kind of file
+ * @throws runtime_error if the file cannot be read or is malformed, in which case the loader is left empty
+ */
+void MeshLoader::load(const string& filename, FileType type) {
+
+    clear();
+    MappedFile file;
+    file.open(filename);
+
+    try {
+        const char* const data = file.getData();
+        if (type == PLY) {
+            loadPly(data, file.getSize());
+        } else {
+            loadText(data, data + file.getSize(), type, NULL);
+        }
+        for (size_t i = 0; i < indices.size(); ++i) {
+            if (indices[i] >= positions.size()) {
+                throw runtime_error("[MeshLoader] Index out of bounds!");
+            }
+        }
+    } catch (...) {
+        clear();
+        throw;
+    }
+}
+
+// HELPERS
+
+/*
+ * Loads the elements of a PLY file after reading its header.
+ */
+void MeshLoader::loadPly(const char* data, size_t size) {
+
+    const char* const last = data + size;
+    vector<Element> elements;
+    int format;
+    const char* p = readHeader(data, last, elements, format);
+
+    const uint16_t probe = 1;
+    const bool little = (*reinterpret_cast<const char*>(&probe) == 1);
+    const bool swap = (format == LITTLE_ENDIAN_BINARY) ? !little : little;
+
+    for (size_t i = 0; i < elements.size(); ++i) {
+        const Element& element = elements[i];
+        vector<uint32_t>* const faces = (element.name == "face") ? &indices : NULL;
+        if (element.name != "vertex") {
+            p = (format == ASCII) ? readTextElement(p, last, element, faces)
+                                  : readBinaryElement(p, last, element, swap, faces);
+            continue;
+        }
+
+        // Check vertices have positions, and maybe normals
+        const Property* columns[6];
+        const char* const names[6] = { "x", "y", "z", "nx", "ny", "nz" };
+        for (int k = 0; k < 6; ++k) {
+            const int index = element.find(names[k]);
+            columns[k] = (index >= 0) ? &element.properties[index] : NULL;
+        }
+        if ((columns[0] == NULL) || (columns[1] == NULL) || (columns[2] == NULL) || (element.getStride() == 0)) {
+            throw runtime_error("[MeshLoader] Vertices need scalar x, y and z properties!");
+        }
+        const bool hasNormals = (columns[3] != NULL) && (columns[4] != NULL) && (columns[5] != NULL);
+
+        if (format == ASCII) {
+            const char* end = p;
+            for (size_t j = 0; (j < element.count) && (end < last); ++j) {
+                end = findLineEnd(end, last);
+                end = (end < last) ? (end + 1) : last;
+            }
+            loadText(p, end, PLY, &element);
+            if (positions.size() != element.count) {
+                throw runtime_error("[MeshLoader] File is too short!");
+            }
+            p = end;
+        } else {
+            const size_t stride = element.getStride();
+            if (element.count > (size_t) (last - p) / stride) {
+                throw runtime_error("[MeshLoader] File is too short!");
+            }
+            positions.resize(element.count);
+            normals.resize(hasNormals ? element.count : 0);
+            BinaryTask task(p, element, swap, positions, normals);
+            Parallel::run(task, element.count, VERTEX_GRAIN_SIZE);
+            p += element.count * stride;
+        }
+    }
+}
+
+/*
+ * Counts and then parses the lines of some text on several threads.
+ */
+void MeshLoader::loadText(const char* begin, const char* end, FileType type, const Element* vertex) {
+
+    const size_t size = end - begin;
+    const size_t chunks = Parallel::countChunks(size, TEXT_GRAIN_SIZE);
+
+    // Count items in each chunk
+    vector<Counts> counts(chunks);
+    TextTask task(begin, end, type, vertex, counts);
+    Parallel::run(task, size, TEXT_GRAIN_SIZE);
+
+    // Turn counts into offsets
+    Counts total = { 0, 0, 0, PARSED };
+    for (size_t i = 0; i < chunks; ++i) {
+        if (counts[i].error != PARSED) {
+            throw runtime_error("[MeshLoader] Malformed line!");
+        }
+        const Counts count = counts[i];
+        counts[i] = total;
+        total.positions += count.positions;
+        total.normals += count.normals;
+        total.triangles += count.triangles;
+    }
+    bool hasNormals = (total.normals > 0);
+    if (type == XYZ) {
+        hasNormals = (total.normals == total.positions);
+    } else if (type == PLY) {
+        hasNormals = (vertex->find("nx") >= 0) && (vertex->find("ny") >= 0) && (vertex->find("nz") >= 0);
+    }
+
+    // Parse them into place
+    positions.resize(total.positions);
+    normals.resize(hasNormals ? ((type == OBJ) ? total.normals : total.positions) : 0);
+    if (type == OBJ) {
+        indices.resize(3 * total.triangles);
+    }
+    task.setOutputs(&positions, &normals, &indices);
+    Parallel::run(task, size, TEXT_GRAIN_SIZE);
+    for (size_t i = 0; i < chunks; ++i) {
+        if (counts[i].error == BAD_INDEX) {
+            throw runtime_error("[MeshLoader] Index out of bounds!");
+        } else if (counts[i].error != PARSED) {
+            throw runtime_error("[MeshLoader] Malformed line!");
+        }
+    }
+}
+
+/*
+ * Reads the items of an element in a binary PLY file, splitting faces into triangles if asked.
+ */
+const char* MeshLoader::readBinaryElement(const char* p, const char* last, const Element& element, bool swap,
+                                          vector<uint32_t>* indices) {
+
+    // Skip fixed-size elements in one step
+    const size_t stride = element.getStride();
+    if ((stride > 0) && (indices == NULL)) {
+        if (element.count > (size_t) (last - p) / stride) {
+            throw runtime_error("[MeshLoader] File is too short!");
+        }
+        return p + (element.count * stride);
+    }
+
+    const int corners = element.find("vertex_indices");
+    const int list = (corners >= 0) ? corners : element.find("vertex_index");
+    for (size_t i = 0; i < element.count; ++i) {
+        for (int j = 0; j < (int) element.properties.size(); ++j) {
+            const Property& property = element.properties[j];
+            size_t n = 1;
+            int type = property.type;
+            if (property.isList()) {
+                if ((size_t) (last - p) < SCALAR_SIZES[property.countType]) {
+                    throw runtime_error("[MeshLoader] File is too short!");
+                }
+                n = (size_t) readScalar(p, property.countType, swap);
+                p += SCALAR_SIZES[property.countType];
+            }
+            if (n > (size_t) (last - p) / SCALAR_SIZES[type]) {
+                throw runtime_error("[MeshLoader] File is too short!");
+            }
+            if ((indices != NULL) && (j == list)) {
+                uint32_t fan[3] = { 0, 0, 0 };
+                for (size_t k = 0; k < n; ++k) {
+                    fan[(k < 2) ? k : 2] = (uint32_t) readScalar(p + (k * SCALAR_SIZES[type]), type, swap);
+                    if (k >= 2) {
+                        indices->insert(indices->end(), fan, fan + 3);
+                        fan[1] = fan[2];
+                    }
+                }
+            }
+            p += n * SCALAR_SIZES[type];
+        }
+    }
+    return p;
+}
+
+/*
+ * Reads the header of a PLY file, returning the position just after it.
+ */
+const char* MeshLoader::readHeader(const char* p, const char* last, vector<Element>& elements, int& format) {
+
+    format = -1;
+    for (bool first = true; ; first = false) {
+        if (p >= last) {
+            throw runtime_error("[MeshLoader] Missing end of PLY header!");
+        }
+        const char* const lineEnd = findLineEnd(p, last);
+        istringstream line(string(p, lineEnd));
+        p = (lineEnd < last) ? (lineEnd + 1) : last;
+
+        string keyword;
+        line >> keyword;
+        if (first && (keyword != "ply")) {
+            throw runtime_error("[MeshLoader] Not a PLY file!");
+        } else if (keyword == "format") {
+            string name;
+            line >> name;
+            format = (name == "ascii") ? ASCII
+                   : (name == "binary_little_endian") ? LITTLE_ENDIAN_BINARY
+                   : (name == "binary_big_endian") ? BIG_ENDIAN_BINARY : -1;
+        } else if (keyword == "element") {
+            Element element;
+            if (!(line >> element.name >> element.count)) {
+                throw runtime_error("[MeshLoader] Malformed PLY element!");
+            }
+            elements.push_back(element);
+        } else if (keyword == "property") {
+            string type, countType, name;
+            line >> type;
+            if (type == "list") {
+                line >> countType >> type;
+            }
+            line >> name;
+            Property property;
+            property.name = name;
+            property.type = (int) (find(SCALAR_NAMES, SCALAR_NAMES + SCALAR_TYPE_COUNT, type) - SCALAR_NAMES);
+            property.countType = countType.empty() ? -1
+                    : (int) (find(SCALAR_NAMES, SCALAR_NAMES + SCALAR_TYPE_COUNT, countType) - SCALAR_NAMES);
+            if (elements.empty() || name.empty() || (property.type == SCALAR_TYPE_COUNT)
+                    || (property.countType == SCALAR_TYPE_COUNT)) {
+                throw runtime_error("[MeshLoader] Malformed PLY property!");
+            }
+            elements.back().properties.push_back(property);
+        } else if (keyword == "end_header") {
+            break;
+        }
+    }
+
+    if (format < 0) {
+        throw runtime_error("[MeshLoader] Unknown PLY format!");
+    }
+    return p;
+}
+
+/*
+ * Reads the lines of an element in an ASCII PLY file, splitting faces into triangles if asked.
+ */
+const char* MeshLoader::readTextElement(const char* p, const char* last, const Element& element,
+                                        vector<uint32_t>* indices) {
+
+    const int corners = element.find("vertex_indices");
+    const int list = (corners >= 0) ? corners : element.find("vertex_index");
+    for (size_t i = 0; i < element.count; ++i) {
+        if (p >= last) {
+            throw runtime_error("[MeshLoader] File is too short!");
+        }
+        const char* const lineEnd = findLineEnd(p, last);
+        const char* q = p;
+        for (int j = 0; j < (int) element.properties.size(); ++j) {
+            long n = 1;
+            if (element.properties[j].isList() && ((q = readInteger(q, lineEnd, n)) == NULL)) {
+                throw runtime_error("[MeshLoader] Malformed line!");
+            }
+            uint32_t fan[3] = { 0, 0, 0 };
+            for (long k = 0; k < n; ++k) {
+                double value;
+                if ((q = readNumber(q, lineEnd, value)) == NULL) {
+                    throw runtime_error("[MeshLoader] Malformed line!");
+                }
+                if ((indices != NULL) && (j == list)) {
+                    fan[(k < 2) ? k : 2] = (uint32_t) value;
+                    if (k >= 2) {
+                        indices->insert(indices->end(), fan, fan + 3);
+                        fan[1] = fan[2];
+                    }
+                }
+            }
+        }
+        p = (lineEnd < last) ? (lineEnd + 1) : last;
+    }
+    return p;
+}
+
+} /* namespace M3d */
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_MESHLOADER_H
+#define M3D_MESHLOADER_H
+#include "m3d/common.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "m3d/Format.h"
+#include "m3d/MappedFile.h"
+#include "m3d/Parallel.h"
+#include "m3d/Vec3Array.h"
+namespace M3d {
+
+
+/**
+ * Loader for meshes and point clouds in OBJ, PLY and XYZ files.
+ *
+ * Files are mapped into memory and split into chunks of whole lines that are parsed on several threads, first to count
+ * what each chunk holds and then to write it straight into the arrays at the right offsets.  Binary PLY vertices are
+ * decoded directly from the mapping, also on several threads.  Numbers are read with `Format`, which converts plain
+ * decimals without going through `strtod`.
+ *
+ * Positions and normals are kept as separate arrays of components.  Faces are split into triangles as fans, and their
+ * corners are stored as indices into the positions, counting from zero.  In OBJ files normals are kept in the order
+ * they are listed, since faces refer to them separately.  In PLY files normals are read from `nx`, `ny` and `nz`
+ * vertex properties.  XYZ files hold one point per line, optionally followed by its normal, with `#` starting a
+ * comment; normals are only kept if every point has one.
+ */
+class MeshLoader {
+public:
+// Types
+    /** Kind of file */
+    enum FileType { OBJ, PLY, XYZ };
+// Methods
+    explicit MeshLoader();
+    void clear();
+    static FileType findType(const std::string& filename);
+    const std::vector<uint32_t>& getIndices() const;
+    const Vec3Array& getNormals() const;
+    const Vec3Array& getPositions() const;
+    void load(const std::string& filename);
+    void load(const std::string& filename, FileType type);
+private:
+// Types
+    struct Counts;
+    struct Element;
+    struct Property;
+    class BinaryTask;
+    class TextTask;
+// Constants
+    static const size_t TEXT_GRAIN_SIZE = 1048576;
+    static const size_t VERTEX_GRAIN_SIZE = 65536;
+// Attributes
+    Vec3Array positions;
+    Vec3Array normals;
+    std::vector<uint32_t> indices;
+// Helpers
+    void loadPly(const char* data, size_t size);
+    void loadText(const char* begin, const char* end, FileType type, const Element* vertex);
+    static const char* readBinaryElement(const char* p, const char* last, const Element& element, bool swap,
+                                         std::vector<uint32_t>* indices);
+    static const char* readHeader(const char* p, const char* last, std::vector<Element>& elements, int& format);
+    static const char* readTextElement(const char* p, const char* last, const Element& element,
+                                       std::vector<uint32_t>* indices);
+};
+
+} /* namespace M3d */
+#endif
@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/MeshLoader.h"
+using namespace std;
+
+/*
+ * Constants
+ */
+const char* FILENAME = "MeshLoaderTest.tmp";
+
+
+/**
+ * Unit test for MeshLoader.
+ */
+class MeshLoaderTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Replaces the test file with some bytes.
+     */
+    static void save(const string& contents) {
+        ofstream file(FILENAME, ios::out | ios::binary | ios::trunc);
+        file.write(contents.data(), contents.size());
+    }
+
+    /**
+     * Appends the bytes of a scalar, optionally reversing them.
+     */
+    template <typename T>
+    static void append(string& contents, T value, bool swap) {
+        char bytes[sizeof(T)];
+        memcpy(bytes, &value, sizeof(T));
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            contents += bytes[swap ? (sizeof(T) - 1 - i) : i];
+        }
+    }
+
+    /**
+     * Checks a vector in an array.
+     */
+    static void checkVec3(const M3d::Vec3Array& arr, size_t i, double x, double y, double z) {
+        CPPUNIT_ASSERT_EQUAL(x, arr.x[i]);
+        CPPUNIT_ASSERT_EQUAL(y, arr.y[i]);
+        CPPUNIT_ASSERT_EQUAL(z, arr.z[i]);
+    }
+
+    /**
+     * Checks the triangles of a unit square split into two.
+     */
+    static void checkSquare(const M3d::MeshLoader& loader) {
+        const uint32_t expected[6] = { 0, 1, 2, 0, 2, 3 };
+        CPPUNIT_ASSERT_EQUAL((size_t) 4, loader.getPositions().size());
+        CPPUNIT_ASSERT(loader.getIndices() == vector<uint32_t>(expected, expected + 6));
+        checkVec3(loader.getPositions(), 0, 0, 0, 0);
+        checkVec3(loader.getPositions(), 2, 1, 1, 0.5);
+    }
+
+    /**
+     * Makes a binary PLY file of a unit square with normals.
+     */
+    static string makeBinaryPly(bool bigEndian) {
+        const uint16_t probe = 1;
+        const bool swap = (*reinterpret_cast<const char*>(&probe) == 1) == bigEndian;
+        string contents = string("ply\nformat ") + (bigEndian ? "binary_big_endian" : "binary_little_endian")
+                + " 1.0\ncomment test\nelement vertex 4\nproperty float x\nproperty float y\nproperty double z\n"
+                + "property uchar red\nproperty float nx\nproperty float ny\nproperty float nz\n"
+                + "element face 1\nproperty list uchar int vertex_indices\nproperty ushort flags\nend_header\n";
+        const float xy[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+        const double z[4] = { 0, 0, 0.5, 0 };
+        for (int i = 0; i < 4; ++i) {
+            append(contents, xy[i][0], swap);
+            append(contents, xy[i][1], swap);
+            append(contents, z[i], swap);
+            append(contents, (uint8_t) 255, swap);
+            append(contents, 0.0f, swap);
+            append(contents, 0.0f, swap);
+            append(contents, 1.0f, swap);
+        }
+        append(contents, (uint8_t) 4, swap);
+        for (int32_t i = 0; i < 4; ++i) {
+            append(contents, i, swap);
+        }
+        append(contents, (uint16_t) 7, swap);
+        return contents;
+    }
+
+public:
+
+    /**
+     * Removes the test file and resets the number of threads.
+     */
+    void tearDown() {
+        remove(FILENAME);
+        M3d::Parallel::setConcurrency(0);
+    }
+
+    /**
+     * Ensures file types are found from extensions.
+     */
+    void testFindType() {
+        CPPUNIT_ASSERT_EQUAL(M3d::MeshLoader::OBJ, M3d::MeshLoader::findType("scan/mesh.obj"));
+        CPPUNIT_ASSERT_EQUAL(M3d::MeshLoader::PLY, M3d::MeshLoader::findType("mesh.PLY"));
+        CPPUNIT_ASSERT_EQUAL(M3d::MeshLoader::XYZ, M3d::MeshLoader::findType("points.v2.Xyz"));
+        CPPUNIT_ASSERT_THROW(M3d::MeshLoader::findType("mesh.stl"), invalid_argument);
+        CPPUNIT_ASSERT_THROW(M3d::MeshLoader::findType("mesh"), invalid_argument);
+    }
+
+    /**
+     * Ensures malformed files are caught and leave the loader empty.
+     */
+    void testLoadInvalid() {
+        M3d::MeshLoader loader;
+        CPPUNIT_ASSERT_THROW(loader.load("MeshLoaderTest.missing", M3d::MeshLoader::OBJ), runtime_error);
+
+        save("v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 4\n");
+        CPPUNIT_ASSERT_THROW(loader.load(FILENAME, M3d::MeshLoader::OBJ), runtime_error);
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, loader.getPositions().size());
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, loader.getIndices().size());
+
+        save("v 0 0\n");
+        CPPUNIT_ASSERT_THROW(loader.load(FILENAME, M3d::MeshLoader::OBJ), runtime_error);
+        save("1 2 3\n4 5\n");
+        CPPUNIT_ASSERT_THROW(loader.load(FILENAME, M3d::MeshLoader::XYZ), runtime_error);
+        save("ply\nformat ascii 1.0\nelement vertex 2\nproperty float x\nproperty float y\nproperty float z\n"
+             "end_header\n0 0 0\n");
+        CPPUNIT_ASSERT_THROW(loader.load(FILENAME, M3d::MeshLoader::PLY), runtime_error);
+        string binary = makeBinaryPly(false);
+        save(binary.substr(0, binary.size() - 10));
+        CPPUNIT_ASSERT_THROW(loader.load(FILENAME, M3d::MeshLoader::PLY), runtime_error);
+        save("solid cube\n");
+        CPPUNIT_ASSERT_THROW(loader.load(FILENAME, M3d::MeshLoader::PLY), runtime_error);
+    }
+
+    /**
+     * Ensures OBJ vertices, normals and faces are read, with polygons split into triangles.
+     */
+    void testLoadObj() {
+        save("# square\r\nv 0 0 0\r\nv 1 0 0 1\r\nvt 0.5 0.5\r\nvn 0 0 1\r\n\r\n"
+             "v 1 1 0.5\r\n  v\t0 1 0\r\no square\r\nf 1/1/1 2/1/1 -2/1/1 -1//1\r\n");
+        M3d::MeshLoader loader;
+        loader.load(FILENAME, M3d::MeshLoader::OBJ);
+        checkSquare(loader);
+        CPPUNIT_ASSERT_EQUAL((size_t) 1, loader.getNormals().size());
+        checkVec3(loader.getNormals(), 0, 0, 0, 1);
+    }
+
+    /**
+     * Ensures a large OBJ file is read the same on any number of threads.
+     */
+    void testLoadObjParallel() {
+        ostringstream stream;
+        const size_t size = 200000;
+        stream.precision(17);
+        for (size_t i = 0; i < size; ++i) {
+            stream << "v " << (rand() / (double) RAND_MAX) << ' ' << (i * 0.25) << " -" << i << '\n';
+            if (i >= 2) {
+                stream << "f " << (i - 1) << ' ' << i << " -1\n";
+            }
+        }
+        save(stream.str());
+
+        M3d::MeshLoader serial, parallel;
+        M3d::Parallel::setConcurrency(1);
+        serial.load(FILENAME, M3d::MeshLoader::OBJ);
+        M3d::Parallel::setConcurrency(4);
+        parallel.load(FILENAME, M3d::MeshLoader::OBJ);
+        CPPUNIT_ASSERT_EQUAL(size, parallel.getPositions().size());
+        CPPUNIT_ASSERT_EQUAL(3 * (size - 2), parallel.getIndices().size());
+        CPPUNIT_ASSERT(serial.getPositions().x == parallel.getPositions().x);
+        CPPUNIT_ASSERT(serial.getPositions().y == parallel.getPositions().y);
+        CPPUNIT_ASSERT(serial.getPositions().z == parallel.getPositions().z);
+        CPPUNIT_ASSERT(serial.getIndices() == parallel.getIndices());
+        checkVec3(parallel.getPositions(), size - 1, parallel.getPositions().x[size - 1], (size - 1) * 0.25,
+                  -(double) (size - 1));
+        CPPUNIT_ASSERT_EQUAL((uint32_t) (size - 1), parallel.getIndices().back());
+    }
+
+    /**
+     * Ensures ASCII PLY vertices, normals and faces are read.
+     */
+    void testLoadPlyAscii() {
+        save("ply\nformat ascii 1.0\ncomment square\nelement vertex 4\nproperty float x\nproperty float y\n"
+             "property float z\nproperty uchar red\nproperty float nx\nproperty float ny\nproperty float nz\n"
+             "element face 1\nproperty list uchar int vertex_indices\nelement edge 1\nproperty int vertex1\n"
+             "property int vertex2\nend_header\n0 0 0 255 0 0 1\n1 0 0 255 0 0 1\n1 1 0.5 255 0 0 1\n"
+             "0 1 0 255 0 0 1\n4 0 1 2 3\n0 1\n");
+        M3d::MeshLoader loader;
+        CPPUNIT_ASSERT_THROW(loader.load(FILENAME), invalid_argument);
+        loader.load(FILENAME, M3d::MeshLoader::PLY);
+        checkSquare(loader);
+        CPPUNIT_ASSERT_EQUAL((size_t) 4, loader.getNormals().size());
+        checkVec3(loader.getNormals(), 3, 0, 0, 1);
+    }
+
+    /**
+     * Ensures binary PLY files are read in either byte order.
+     */
+    void testLoadPlyBinary() {
+        for (int i = 0; i < 2; ++i) {
+            save(makeBinaryPly(i == 1));
+            M3d::MeshLoader loader;
+            loader.load(FILENAME, M3d::MeshLoader::PLY);
+            checkSquare(loader);
+            CPPUNIT_ASSERT_EQUAL((size_t) 4, loader.getNormals().size());
+            checkVec3(loader.getNormals(), 1, 0, 0, 1);
+        }
+    }
+
+    /**
+     * Ensures XYZ points are read, with normals only if every point has one.
+     */
+    void testLoadXyz() {
+        M3d::MeshLoader loader;
+        save("# points\n1 2 3 0 0 1\n\n4.5 -5e2 6 0 1 0 # with normal\n");
+        loader.load(FILENAME, M3d::MeshLoader::XYZ);
+        CPPUNIT_ASSERT_EQUAL((size_t) 2, loader.getPositions().size());
+        CPPUNIT_ASSERT_EQUAL((size_t) 2, loader.getNormals().size());
+        checkVec3(loader.getPositions(), 1, 4.5, -500, 6);
+        checkVec3(loader.getNormals(), 1, 0, 1, 0);
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, loader.getIndices().size());
+
+        save("1 2 3 0 0 1\n4 5 6");
+        loader.load(FILENAME, M3d::MeshLoader::XYZ);
+        CPPUNIT_ASSERT_EQUAL((size_t) 2, loader.getPositions().size());
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, loader.getNormals().size());
+        checkVec3(loader.getPositions(), 1, 4, 5, 6);
+    }
+
+    CPPUNIT_TEST_SUITE(MeshLoaderTest);
+    CPPUNIT_TEST(testFindType);
+    CPPUNIT_TEST(testLoadInvalid);
+    CPPUNIT_TEST(testLoadObj);
+    CPPUNIT_TEST(testLoadObjParallel);
+    CPPUNIT_TEST(testLoadPlyAscii);
+    CPPUNIT_TEST(testLoadPlyBinary);
+    CPPUNIT_TEST(testLoadXyz);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(MeshLoaderTest::suite());
+    runner.run();
+    return 0;
+}
@@ -0,0 +1,397 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include <vector>
+#include "m3d/Morton.h"
+using namespace std;
+namespace M3d {
+
+/*
+ * Constants
+ */
+static const size_t GRAIN_SIZE = 65536;
+static const int RADIX_BITS = 8;
+static const size_t RADIX_SIZE = 256;
+static const double CELLS_30 = 1024;
+static const double CELLS_63 = 2097152;
+
+/*
+ * Spreads the low 10 bits of a number out so there are two zero bits between each.
+ */
+static uint32_t spread30(uint32_t x) {
+    x &= 0x000003ff;
+    x = (x | (x << 16)) & 0x030000ff;
+    x = (x | (x << 8)) & 0x0300f00f;
+    x = (x | (x << 4)) & 0x030c30c3;
+    x = (x | (x << 2)) & 0x09249249;
+    return x;
+}
+
+/*
+ * Gathers every third bit of a number back together, undoing `spread30`.
+ */
+static uint32_t compact30(uint32_t x) {
+    x &= 0x09249249;
+    x = (x ^ (x >> 2)) & 0x030c30c3;
+    x = (x ^ (x >> 4)) & 0x0300f00f;
+    x = (x ^ (x >> 8)) & 0xff0000ff;
+    x = (x ^ (x >> 16)) & 0x000003ff;
+    return x;
+}
+
+/*
+ * Spreads the low 21 bits of a number out so there are two zero bits between each.
+ */
+static uint64_t spread63(uint64_t x) {
+    x &= UINT64_C(0x00000000001fffff);
+    x = (x | (x << 32)) & UINT64_C(0x001f00000000ffff);
+    x = (x | (x << 16)) & UINT64_C(0x001f0000ff0000ff);
+    x = (x | (x << 8)) & UINT64_C(0x100f00f00f00f00f);
+    x = (x | (x << 4)) & UINT64_C(0x10c30c30c30c30c3);
+    x = (x | (x << 2)) & UINT64_C(0x1249249249249249);
+    return x;
+}
+
+/*
+ * Gathers every third bit of a number back together, undoing `spread63`.
+ */
+static uint32_t compact63(uint64_t x) {
+    x &= UINT64_C(0x1249249249249249);
+    x = (x ^ (x >> 2)) & UINT64_C(0x10c30c30c30c30c3);
+    x = (x ^ (x >> 4)) & UINT64_C(0x100f00f00f00f00f);
+    x = (x ^ (x >> 8)) & UINT64_C(0x001f0000ff0000ff);
+    x = (x ^ (x >> 16)) & UINT64_C(0x001f00000000ffff);
+    x = (x ^ (x >> 32)) & UINT64_C(0x00000000001fffff);
+    return (uint32_t) x;
+}
+
+/*
+ * Finds the number of cells per unit length along each axis of a box.
+ */
+static Vec3 findScale(const Aabb& bounds, double cells) {
+    const Vec3 extent = bounds.getExtent();
+    return Vec3((extent.x > 0) ? (cells / extent.x) : 0,
+                (extent.y > 0) ? (cells / extent.y) : 0,
+                (extent.z > 0) ? (cells / extent.z) : 0);
+}
+
+/*
+ * Converts a distance from the lower corner of a box to a cell index, clamping to the box.
+ */
+static uint32_t quantize(double distance, double scale, double cells) {
+    const double cell = distance * scale;
+    if (!(cell > 0)) {
+        return 0;
+    } else if (cell >= cells - 1) {
+        return (uint32_t) (cells - 1);
+    } else {
+        return (uint32_t) cell;
+    }
+}
+
+/*
+ * Computes the 30-bit code of a point.
+ */
+static void findCode(const Vec3& point, const Vec3& lower, const Vec3& scale, uint32_t& code) {
+    code = encodeMorton30(quantize(point.x - lower.x, scale.x, CELLS_30),
+                          quantize(point.y - lower.y, scale.y, CELLS_30),
+                          quantize(point.z - lower.z, scale.z, CELLS_30));
+}
+
+/*
+ * Computes the 63-bit code of a point.
+ */
+static void findCode(const Vec3& point, const Vec3& lower, const Vec3& scale, uint64_t& code) {
+    code = encodeMorton63(quantize(point.x - lower.x, scale.x, CELLS_63),
+                          quantize(point.y - lower.y, scale.y, CELLS_63),
+                          quantize(point.z - lower.z, scale.z, CELLS_63));
+}
+
+
+/*
+ * Task computing codes for a range of points.
+ */
+template <typename K>
+class MortonTask : public ParallelTask {
+public:
+    MortonTask(const Vec3* points, const Vec3& lower, const Vec3& scale, K* codes) :
+            points(points), lower(lower), scale(scale), codes(codes) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            findCode(points[i], lower, scale, codes[i]);
+        }
+    }
+private:
+    const Vec3* points;
+    Vec3 lower;
+    Vec3 scale;
+    K* codes;
+};
+
+
+/*
+ * Task counting the digits of a range of keys for one pass of a radix sort.
+ */
+template <typename K>
+class HistogramTask : public ParallelTask {
+public:
+    HistogramTask(const K* keys, int shift, vector<size_t>& counts) : keys(keys), shift(shift), counts(counts) { }
+    virtual void run(size_t chunk, size_t begin, size_t end) {
+        size_t* const c = &counts[chunk * RADIX_SIZE];
+        fill(c, c + RADIX_SIZE, 0);
+        for (size_t i = begin; i < end; ++i) {
+            ++c[(keys[i] >> shift) & (RADIX_SIZE - 1)];
+        }
+    }
+private:
+    const K* keys;
+    int shift;
+    vector<size_t>& counts;
+};
+
+
+/*
+ * Task moving a range of keys and values to their places for one pass of a radix sort.
+ */
+template <typename K>
+class ScatterTask : public ParallelTask {
+public:
+    ScatterTask(const K* keys, const uint32_t* values, int shift, vector<size_t>& offsets, K* outKeys,
+                uint32_t* outValues) :
+            keys(keys), values(values), shift(shift), offsets(offsets), outKeys(outKeys), outValues(outValues) { }
+    virtual void run(size_t chunk, size_t begin, size_t end) {
+        size_t* const o = &offsets[chunk * RADIX_SIZE];
+        for (size_t i = begin; i < end; ++i) {
+            const size_t j = o[(keys[i] >> shift) & (RADIX_SIZE - 1)]++;
+            outKeys[j] = keys[i];
+            outValues[j] = values[i];
+        }
+    }
+private:
+    const K* keys;
+    const uint32_t* values;
+    int shift;
+    vector<size_t>& offsets;
+    K* outKeys;
+    uint32_t* outValues;
+};
+
+/*
+ * Computes codes for an array of points on several threads.
+ */
+template <typename K>
+static void findCodes(const Vec3* points, size_t size, const Aabb& bounds, double cells, K* codes) {
+    MortonTask<K> task(points, bounds.lower, findScale(bounds, cells), codes);
+    Parallel::run(task, size, GRAIN_SIZE);
+}
+
+/*
+ * Sorts keys and values together with a stable radix sort, eight bits at a time on several threads.
+ *
+ * Each chunk counts its digits, the counts are turned into starting offsets for each chunk and digit, and then each
+ * chunk moves its items independently.  Passes where every key has the same digit are skipped.
+ */
+template <typename K>
+static void sortByKey(K* keys, uint32_t* values, size_t size) {
+
+    if (size < 2) {
+        return;
+    }
+
+    vector<K> keyBuffer(size);
+    vector<uint32_t> valueBuffer(size);
+    K* fromKeys = keys;
+    K* toKeys = &keyBuffer[0];
+    uint32_t* fromValues = values;
+    uint32_t* toValues = &valueBuffer[0];
+    vector<size_t> counts(Parallel::countChunks(size, GRAIN_SIZE) * RADIX_SIZE);
+    const size_t chunks = counts.size() / RADIX_SIZE;
+
+    for (int shift = 0; shift < (int) (sizeof(K) * 8); shift += RADIX_BITS) {
+
+        // Count digits in each chunk
+        HistogramTask<K> histogram(fromKeys, shift, counts);
+        Parallel::run(histogram, size, GRAIN_SIZE);
+
+        // Turn counts into offsets, with earlier chunks first so the sort is stable
+        size_t offset = 0;
+        bool same = false;
+        for (size_t d = 0; d < RADIX_SIZE && !same; ++d) {
+            const size_t start = offset;
+            for (size_t c = 0; c < chunks; ++c) {
+                const size_t count = counts[(c * RADIX_SIZE) + d];
+                counts[(c * RADIX_SIZE) + d] = offset;
+                offset += count;
+            }
+            same = ((offset - start) == size);
+        }
+        if (same) {
+            continue;
+        }
+
+        // Move items
+        ScatterTask<K> scatter(fromKeys, fromValues, shift, counts, toKeys, toValues);
+        Parallel::run(scatter, size, GRAIN_SIZE);
+        swap(fromKeys, toKeys);
+        swap(fromValues, toValues);
+    }
+
+    if (fromKeys != keys) {
+        copy(fromKeys, fromKeys + size, keys);
+        copy(fromValues, fromValues + size, values);
+    }
+}
+
+/**
+ * Interleaves three 10-bit coordinates into a 30-bit code.
+ *
+ * @param x Coordinate along X, of which only the low 10 bits are used
+ * @param y Coordinate along Y, of which only the low 10 bits are used
+ * @param z Coordinate along Z, of which only the low 10 bits are used
+ * @return Code with bits of X, Y and Z interleaved
+ */
+uint32_t encodeMorton30(uint32_t x, uint32_t y, uint32_t z) {
+    return (spread30(x) << 2) | (spread30(y) << 1) | spread30(z);
+}
+
+/**
+ * Interleaves three 21-bit coordinates into a 63-bit code.
+ *
+ * @param x Coordinate along X, of which only the low 21 bits are used
+ * @param y Coordinate along Y, of which only the low 21 bits are used
+ * @param z Coordinate along Z, of which only the low 21 bits are used
+ * @return Code with bits of X, Y and Z interleaved
+ */
+uint64_t encodeMorton63(uint32_t x, uint32_t y, uint32_t z) {
+    return (spread63(x) << 2) | (spread63(y) << 1) | spread63(z);
+}
+
+/**
+ * Separates a 30-bit code back into its coordinates.
+ *
+ * @param code Code to separate
+ * @param x Coordinate along X
+ * @param y Coordinate along Y
+ * @param z Coordinate along Z
+ */
+void decodeMorton30(uint32_t code, uint32_t& x, uint32_t& y, uint32_t& z) {
+    x = compact30(code >> 2);
+    y = compact30(code >> 1);
+    z = compact30(code);
+}
+
+/**
+ * Separates a 63-bit code back into its coordinates.
+ *
+ * @param code Code to separate
+ * @param x Coordinate along X
+ * @param y Coordinate along Y
+ * @param z Coordinate along Z
+ */
+void decodeMorton63(uint64_t code, uint32_t& x, uint32_t& y, uint32_t& z) {
+    x = compact63(code >> 2);
+    y = compact63(code >> 1);
+    z = compact63(code);
+}
+
+/**
+ * Computes the 30-bit code of a point, dividing a box into 1024 cells along each axis.
+ *
+ * @param point Point to compute code of
+ * @param bounds Box to quantize against
+ * @return Code of the cell holding the point
+ */
+uint32_t findMorton30(const Vec3& point, const Aabb& bounds) {
+    uint32_t code;
+    findCode(point, bounds.lower, findScale(bounds, CELLS_30), code);
+    return code;
+}
+
+/**
+ * Computes the 63-bit code of a point, dividing a box into 2097152 cells along each axis.
+ *
+ * @param point Point to compute code of
+ * @param bounds Box to quantize against
+ * @return Code of the cell holding the point
+ */
+uint64_t findMorton63(const Vec3& point, const Aabb& bounds) {
+    uint64_t code;
+    findCode(point, bounds.lower, findScale(bounds, CELLS_63), code);
+    return code;
+}
+
+/**
+ * Computes the 30-bit codes of an array of points on several threads.
+ *
+ * @param points Array of points
+ * @param size Number of points
+ * @param bounds Box to quantize against
+ * @param codes Array to store codes in, with room for all the points
+ */
+void findMortonCodes(const Vec3* points, size_t size, const Aabb& bounds, uint32_t* codes) {
+    findCodes(points, size, bounds, CELLS_30, codes);
+}
+
+/**
+ * Computes the 63-bit codes of an array of points on several threads.
+ *
+ * @param points Array of points
+ * @param size Number of points
+ * @param bounds Box to quantize against
+ * @param codes Array to store codes in, with room for all the points
+ */
+void findMortonCodes(const Vec3* points, size_t size, const Aabb& bounds, uint64_t* codes) {
+    findCodes(points, size, bounds, CELLS_63, codes);
+}
+
+/**
+ * Sorts 30-bit codes in increasing order, moving values along with them, on several threads.
+ *
+ * The sort is stable, so values with equal codes stay in the same order.
+ *
+ * @param codes Array of codes to sort
+ * @param values Array of values to move with the codes, e.g. indices of points
+ * @param size Number of codes
+ */
+void sortMortonCodes(uint32_t* codes, uint32_t* values, size_t size) {
+    sortByKey(codes, values, size);
+}
+
+/**
+ * Sorts 63-bit codes in increasing order, moving values along with them, on several threads.
+ *
+ * The sort is stable, so values with equal codes stay in the same order.
+ *
+ * @param codes Array of codes to sort
+ * @param values Array of values to move with the codes, e.g. indices of points
+ * @param size Number of codes
+ */
+void sortMortonCodes(uint64_t* codes, uint32_t* values, size_t size) {
+    sortByKey(codes, values, size);
+}
+
+} /* namespace M3d */
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_MORTON_H
+#define M3D_MORTON_H
+#include "m3d/common.h"
+#include <stdint.h>
+#include "m3d/Aabb.h"
+#include "m3d/Parallel.h"
+#include "m3d/Vec3.h"
+namespace M3d {
+
+/*
+ * Morton codes.
+ *
+ * A Morton code interleaves the bits of three integer coordinates, so sorting points by their codes puts them in
+ * order along a Z-shaped space-filling curve, and points close together in the order are usually close together in
+ * space.  Codes are 30 bits, with 10 bits per axis, or 63 bits, with 21 bits per axis.  Bits of X are the most
+ * significant in each group of three.
+ *
+ * Points are quantized against a bounding box, so every point should be inside the box.  Points outside are clamped.
+ */
+uint32_t encodeMorton30(uint32_t x, uint32_t y, uint32_t z);
+uint64_t encodeMorton63(uint32_t x, uint32_t y, uint32_t z);
+void decodeMorton30(uint32_t code, uint32_t& x, uint32_t& y, uint32_t& z);
+void decodeMorton63(uint64_t code, uint32_t& x, uint32_t& y, uint32_t& z);
+uint32_t findMorton30(const Vec3& point, const Aabb& bounds);
+uint64_t findMorton63(const Vec3& point, const Aabb& bounds);
+void findMortonCodes(const Vec3* points, size_t size, const Aabb& bounds, uint32_t* codes);
+void findMortonCodes(const Vec3* points, size_t size, const Aabb& bounds, uint64_t* codes);
+void sortMortonCodes(uint32_t* codes, uint32_t* values, size_t size);
+void sortMortonCodes(uint64_t* codes, uint32_t* values, size_t size);
+
+} /* namespace M3d */
+#endif
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/Morton.h"
+#include "m3d/Parallel.h"
+using namespace std;
+
+
+/**
+ * Unit test for Morton.
+ */
+class MortonTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + (upper - lower) * (rand() / (double) RAND_MAX);
+    }
+
+    /**
+     * Checks that codes were sorted stably by comparing with a sort of code and index pairs.
+     */
+    template <typename K>
+    static void assertSorted(size_t size, int bits) {
+
+        vector<K> codes(size);
+        vector<uint32_t> values(size);
+        vector< pair<K, uint32_t> > expected(size);
+        for (size_t i = 0; i < size; ++i) {
+            codes[i] = ((K) rand() * (K) rand()) & ((((K) 1) << bits) - 1);
+            values[i] = (uint32_t) i;
+            expected[i] = make_pair(codes[i], values[i]);
+        }
+        sort(expected.begin(), expected.end());
+
+        M3d::sortMortonCodes(&codes[0], &values[0], size);
+        for (size_t i = 0; i < size; ++i) {
+            CPPUNIT_ASSERT(codes[i] == expected[i].first);
+            CPPUNIT_ASSERT_EQUAL(expected[i].second, values[i]);
+        }
+    }
+
+public:
+
+    /**
+     * Restores the default concurrency after each test case.
+     */
+    void tearDown() {
+        M3d::Parallel::setConcurrency(0);
+    }
+
+    /**
+     * Ensures coordinates are interleaved with X most significant.
+     */
+    void testEncode() {
+        CPPUNIT_ASSERT_EQUAL((uint32_t) 4, M3d::encodeMorton30(1, 0, 0));
+        CPPUNIT_ASSERT_EQUAL((uint32_t) 2, M3d::encodeMorton30(0, 1, 0));
+        CPPUNIT_ASSERT_EQUAL((uint32_t) 1, M3d::encodeMorton30(0, 0, 1));
+        CPPUNIT_ASSERT_EQUAL((uint32_t) 0x38, M3d::encodeMorton30(2, 2, 2));
+        CPPUNIT_ASSERT_EQUAL((uint32_t) 0x3fffffff, M3d::encodeMorton30(1023, 1023, 1023));
+        CPPUNIT_ASSERT_EQUAL((uint32_t) 0x24924924, M3d::encodeMorton30(1023, 0, 0));
+        CPPUNIT_ASSERT(M3d::encodeMorton63(1, 0, 0) == 4);
+        CPPUNIT_ASSERT(M3d::encodeMorton63(2097151, 2097151, 2097151) == UINT64_C(0x7fffffffffffffff));
+        CPPUNIT_ASSERT(M3d::encodeMorton63(0, 0, 2097151) == UINT64_C(0x1249249249249249));
+    }
+
+    /**
+     * Ensures decoding gives back the coordinates that were encoded.
+     */
+    void testDecode() {
+        for (int i = 0; i < 1000; ++i) {
+            const uint32_t x = rand() % 2097152, y = rand() % 2097152, z = rand() % 2097152;
+            uint32_t a, b, c;
+            M3d::decodeMorton63(M3d::encodeMorton63(x, y, z), a, b, c);
+            CPPUNIT_ASSERT_EQUAL(x, a);
+            CPPUNIT_ASSERT_EQUAL(y, b);
+            CPPUNIT_ASSERT_EQUAL(z, c);
+            M3d::decodeMorton30(M3d::encodeMorton30(x, y, z), a, b, c);
+            CPPUNIT_ASSERT_EQUAL(x % 1024, a);
+            CPPUNIT_ASSERT_EQUAL(y % 1024, b);
+            CPPUNIT_ASSERT_EQUAL(z % 1024, c);
+        }
+    }
+
+    /**
+     * Ensures points are quantized against a box and clamped to it.
+     */
+    void testFindMorton() {
+        const M3d::Aabb bounds(M3d::Vec3(0, 0, 0), M3d::Vec3(1024, 2048, 0));
+        CPPUNIT_ASSERT_EQUAL(M3d::encodeMorton30(3, 1, 0), M3d::findMorton30(M3d::Vec3(3.5, 2.5, 0), bounds));
+        CPPUNIT_ASSERT_EQUAL(M3d::encodeMorton30(0, 1023, 0), M3d::findMorton30(M3d::Vec3(-5, 2048, 7), bounds));
+        CPPUNIT_ASSERT(M3d::findMorton63(M3d::Vec3(1024, 0, 0), bounds) == M3d::encodeMorton63(2097151, 0, 0));
+        CPPUNIT_ASSERT(M3d::findMorton63(M3d::Vec3(0.5, 1, 0), bounds) == M3d::encodeMorton63(1024, 1024, 0));
+    }
+
+    /**
+     * Ensures codes for an array are the same as for each point, with several threads.
+     */
+    void testFindMortonCodes() {
+
+        const size_t n = 200003;
+        vector<M3d::Vec3> points(n);
+        for (size_t i = 0; i < n; ++i) {
+            points[i] = M3d::Vec3(random(-1, 1), random(0, 5), random(2, 3));
+        }
+        const M3d::Aabb bounds = M3d::Aabb::fromPoints(&points[0], n);
+
+        M3d::Parallel::setConcurrency(4);
+        vector<uint32_t> shortCodes(n);
+        vector<uint64_t> longCodes(n);
+        M3d::findMortonCodes(&points[0], n, bounds, &shortCodes[0]);
+        M3d::findMortonCodes(&points[0], n, bounds, &longCodes[0]);
+        for (size_t i = 0; i < n; ++i) {
+            CPPUNIT_ASSERT_EQUAL(M3d::findMorton30(points[i], bounds), shortCodes[i]);
+            CPPUNIT_ASSERT(M3d::findMorton63(points[i], bounds) == longCodes[i]);
+        }
+    }
+
+    /**
+     * Ensures sorting orders codes stably, with one thread or several.
+     */
+    void testSortMortonCodes() {
+        M3d::Parallel::setConcurrency(1);
+        assertSorted<uint32_t>(1000, 30);
+        assertSorted<uint64_t>(1000, 63);
+        M3d::Parallel::setConcurrency(4);
+        assertSorted<uint32_t>(300007, 12);
+        assertSorted<uint32_t>(300007, 30);
+        assertSorted<uint64_t>(300007, 63);
+        assertSorted<uint64_t>(1, 63);
+    }
+
+    CPPUNIT_TEST_SUITE(MortonTest);
+    CPPUNIT_TEST(testEncode);
+    CPPUNIT_TEST(testDecode);
+    CPPUNIT_TEST(testFindMorton);
+    CPPUNIT_TEST(testFindMortonCodes);
+    CPPUNIT_TEST(testSortMortonCodes);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(MortonTest::suite());
+    runner.run();
+    return 0;
+}
@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "m3d/NormalCodec.h"
+using namespace std;
+namespace M3d {
+
+
+/*
+ * Task decoding a range of codes stored as bytes.
+ */
+class NormalCodec::DecodeTask : public ParallelTask {
+public:
+    DecodeTask(const unsigned char* codes, Format format, Vec3Array& vecs)
+            : codes(codes), format(format), bytes(countBytes(format)), vecs(vecs) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const unsigned char* const code = codes + (i * bytes);
+            uint32_t value = 0;
+            for (size_t b = 0; b < bytes; ++b) {
+                value |= ((uint32_t) code[b]) << (8 * b);
+            }
+            const Vec3 vec = decode(value, format);
+            vecs.x[i] = vec.x;
+            vecs.y[i] = vec.y;
+            vecs.z[i] = vec.z;
+        }
+    }
+private:
+    const unsigned char* codes;
+    Format format;
+    size_t bytes;
+    Vec3Array& vecs;
+};
+
+
+/*
+ * Task encoding a range of vectors as bytes.
+ */
+class NormalCodec::EncodeTask : public ParallelTask {
+public:
+    EncodeTask(const Vec3Array& vecs, Format format, unsigned char* codes)
+            : vecs(vecs), format(format), bytes(countBytes(format)), codes(codes) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const uint32_t value = encode(Vec3(vecs.x[i], vecs.y[i], vecs.z[i]), format);
+            unsigned char* const code = codes + (i * bytes);
+            for (size_t b = 0; b < bytes; ++b) {
+                code[b] = (unsigned char) (value >> (8 * b));
+            }
+        }
+    }
+private:
+    const Vec3Array& vecs;
+    Format format;
+    size_t bytes;
+    unsigned char* codes;
+};
+
+// METHODS
+
+/**
+ * Returns the number of bytes each code takes in a batch.
+ *
+ * @throws invalid_argument if the format is unknown
+ */
+size_t NormalCodec::countBytes(Format format) {
+    switch (format) {
+    case OCT16:
+        return 2;
+    case OCT24:
+    case SNORM24:
+        return 3;
+    case OCT32:
+    case SNORM32:
+        return 4;
+    default:
+        throw invalid_argument("[NormalCodec] Unknown format!");
+    }
+}
+
+/**
+ * Decodes a unit vector.
+ *
+ * @param code Code from `encode`
+ * @param format Layout of the code
+ * @return Unit vector closest to the code
+ * @throws invalid_argument if the format is unknown
+ */
+Vec3 NormalCodec::decode(uint32_t code, Format format) {
+
+    const int bits = countBits(format);
+    const uint32_t mask = (((uint32_t) 1) << bits) - 1;
+    double x, y, z;
+    if ((format == SNORM24) || (format == SNORM32)) {
+        x = fromSnorm(code & mask, bits);
+        y = fromSnorm((code >> bits) & mask, bits);
+        z = fromSnorm((code >> (2 * bits)) & mask, bits);
+    } else {
+        decodeOctahedral(fromSnorm(code & mask, bits), fromSnorm((code >> bits) & mask, bits), x, y, z);
+    }
+
+    const double length = sqrt((x * x) + (y * y) + (z * z));
+    if (length == 0) {
+        return Vec3(0, 0, 1);
+    }
+    return Vec3(x / length, y / length, z / length);
+}
+
+/**
+ * Decodes a batch of unit vectors on several threads.
+ *
+ * @param codes Codes from `encode`, each `countBytes(format)` bytes in little-endian order
+ * @param count Number of codes
+ * @param format Layout of the codes
+ * @param vecs Array to store the vectors in, replacing its contents
+ * @throws invalid_argument if the format is unknown
+ */
+void NormalCodec::decode(const void* codes, size_t count, Format format, Vec3Array& vecs) {
+    countBytes(format);
+    vecs.resize(count);
+    DecodeTask task(static_cast<const unsigned char*>(codes), format, vecs);
+    Parallel::run(task, count, GRAIN_SIZE);
+}
+
+/**
+ * Encodes a vector.
+ *
+ * Octahedral codes are chosen from the four nearest points of the grid as the one that decodes closest to the vector,
+ * rather than just the nearest point, which cuts the largest error by about a third.
+ *
+ * @param vec Vector to encode, which is normalized first, and which is taken as positive Z if it is zero or not finite
+ * @param format Layout of the code
+ * @return Code for the vector
+ * @throws invalid_argument if the format is unknown
+ */
+uint32_t NormalCodec::encode(const Vec3& vec, Format format) {
+
+    const int bits = countBits(format);
+    const double sum = fabs(vec.x) + fabs(vec.y) + fabs(vec.z);
+    if ((sum == 0) || !(sum < HUGE_VAL)) {
+        return encode(Vec3(0, 0, 1), format);
+    }
+
+    // Store each component
+    if ((format == SNORM24) || (format == SNORM32)) {
+        const double length = sqrt((vec.x * vec.x) + (vec.y * vec.y) + (vec.z * vec.z));
+        return toSnorm(vec.x / length, bits) | (toSnorm(vec.y / length, bits) << bits)
+                | (toSnorm(vec.z / length, bits) << (2 * bits));
+    }
+
+    // Project onto octahedron and fold lower half over upper half
+    double u = vec.x / sum;
+    double v = vec.y / sum;
+    if (vec.z < 0) {
+        const double foldedU = (1 - fabs(v)) * ((u >= 0) ? 1 : -1);
+        const double foldedV = (1 - fabs(u)) * ((v >= 0) ? 1 : -1);
+        u = foldedU;
+        v = foldedV;
+    }
+
+    // Pick the neighbouring grid point that decodes closest to the vector
+    const double scale = (double) ((1 << (bits - 1)) - 1);
+    const double lowerU = floor(std::min(std::max(u, -1.0), 1.0) * scale);
+    const double lowerV = floor(std::min(std::max(v, -1.0), 1.0) * scale);
+    double bestU = lowerU;
+    double bestV = lowerV;
+    double bestCosine = -HUGE_VAL;
+    for (int i = 0; i < 4; ++i) {
+        const double gridU = std::min(lowerU + (i & 1), scale);
+        const double gridV = std::min(lowerV + (i >> 1), scale);
+        double x, y, z;
+        decodeOctahedral(gridU / scale, gridV / scale, x, y, z);
+        const double cosine = ((x * vec.x) + (y * vec.y) + (z * vec.z)) / sqrt((x * x) + (y * y) + (z * z));
+        if (cosine > bestCosine) {
+            bestCosine = cosine;
+            bestU = gridU;
+            bestV = gridV;
+        }
+    }
+    return toSnorm(bestU / scale, bits) | (toSnorm(bestV / scale, bits) << bits);
+}
+
+/**
+ * Encodes a batch of vectors on several threads.
+ *
+ * @param vecs Vectors to encode, which are normalized first
+ * @param format Layout of the codes
+ * @param codes Buffer with room for `countBytes(format)` bytes per vector, stored in little-endian order
+ * @throws invalid_argument if the format is unknown
+ */
+void NormalCodec::encode(const Vec3Array& vecs, Format format, void* codes) {
+    countBytes(format);
+    EncodeTask task(vecs, format, static_cast<unsigned char*>(codes));
+    Parallel::run(task, vecs.size(), GRAIN_SIZE);
+}
+
+// HELPERS
+
+/*
+ * Returns the number of bits in each value of a code.
+ */
+int NormalCodec::countBits(Format format) {
+    switch (format) {
+    case OCT16:
+    case SNORM24:
+        return 8;
+    case OCT24:
+        return 12;
+    case OCT32:
+        return 16;
+    case SNORM32:
+        return 10;
+    default:
+        throw invalid_argument("[NormalCodec] Unknown format!");
+    }
+}
+
+/*
+ * Unfolds a point in the square onto the octahedron, without normalizing it.
+ */
+void NormalCodec::decodeOctahedral(double u, double v, double& x, double& y, double& z) {
+    z = 1 - fabs(u) - fabs(v);
+    if (z < 0) {
+        x = (1 - fabs(v)) * ((u >= 0) ? 1 : -1);
+        y = (1 - fabs(u)) * ((v >= 0) ? 1 : -1);
+    } else {
+        x = u;
+        y = v;
+    }
+}
+
+/*
+ * Converts a signed normalized integer of some bits to a value in [-1 .. 1].
+ */
+double NormalCodec::fromSnorm(uint32_t code, int bits) {
+    const uint32_t sign = ((uint32_t) 1) << (bits - 1);
+    const int32_t value = ((int32_t) (code ^ sign)) - ((int32_t) sign);
+    return std::max(value / (double) ((1 << (bits - 1)) - 1), -1.0);
+}
+
+/*
+ * Converts a value in [-1 .. 1] to the nearest signed normalized integer of some bits.
+ */
+uint32_t NormalCodec::toSnorm(double value, int bits) {
+    const int32_t scale = (1 << (bits - 1)) - 1;
+    const int32_t code = (int32_t) floor((std::min(std::max(value, -1.0), 1.0) * scale) + 0.5);
+    return ((uint32_t) code) & ((((uint32_t) 1) << bits) - 1);
+}
+
+} /* namespace M3d */
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_NORMALCODEC_H
+#define M3D_NORMALCODEC_H
+#include "m3d/common.h"
+#include <stdint.h>
+#include "m3d/Parallel.h"
+#include "m3d/Vec3.h"
+#include "m3d/Vec3Array.h"
+namespace M3d {
+
+
+/**
+ * Utility for compressing unit vectors, such as normals and directions, into a few bytes.
+ *
+ * Octahedral formats project a vector onto an octahedron that is unfolded into a square, and store the two coordinates
+ * in the square as signed normalized integers of equal width.  They spread precision evenly over the sphere, and a
+ * vector in 32 bits is within about 0.0025 degrees of the original.  Snorm formats store each of the three components
+ * as a signed normalized integer, which is simpler but less precise for the same size.  Codes keep the first value in
+ * their lowest bits.
+ *
+ * Vectors are normalized before they are encoded, and decoded vectors are normalized.  The zero vector is encoded as
+ * positive Z.  Batches are stored as two, three or four bytes per vector in little-endian order, so files of codes can
+ * be shared between machines.
+ */
+class NormalCodec {
+public:
+// Types
+    /** Layout of a code */
+    enum Format {
+        OCT16, ///< Octahedral with 8 bits per coordinate
+        OCT24, ///< Octahedral with 12 bits per coordinate
+        OCT32, ///< Octahedral with 16 bits per coordinate
+        SNORM24, ///< Three components of 8 bits
+        SNORM32 ///< Three components of 10 bits, with the top two bits zero
+    };
+// Methods
+    static size_t countBytes(Format format);
+    static Vec3 decode(uint32_t code, Format format);
+    static void decode(const void* codes, size_t count, Format format, Vec3Array& vecs);
+    static uint32_t encode(const Vec3& vec, Format format);
+    static void encode(const Vec3Array& vecs, Format format, void* codes);
+private:
+// Types
+    class DecodeTask;
+    class EncodeTask;
+// Constants
+    static const size_t GRAIN_SIZE = 16384;
+// Helpers
+    static int countBits(Format format);
+    static void decodeOctahedral(double u, double v, double& x, double& y, double& z);
+    static double fromSnorm(uint32_t code, int bits);
+    static uint32_t toSnorm(double value, int bits);
+};
+
+} /* namespace M3d */
+#endif
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/NormalCodec.h"
+using namespace std;
+
+
+/**
+ * Unit test for NormalCodec.
+ */
+class NormalCodecTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + ((upper - lower) * rand() / RAND_MAX);
+    }
+
+    /**
+     * Makes random vectors of various lengths.
+     */
+    static M3d::Vec3Array makeVectors(size_t size) {
+        M3d::Vec3Array vecs(size);
+        for (size_t i = 0; i < size; ++i) {
+            M3d::Vec3 vec;
+            do {
+                vec = M3d::Vec3(random(-1, 1), random(-1, 1), random(-1, 1));
+            } while ((dot(vec, vec) > 1) || (dot(vec, vec) < 1e-6));
+            vecs.set(i, vec * random(0.5, 4));
+        }
+        return vecs;
+    }
+
+    /**
+     * Finds the largest angle in degrees between vectors and their decoded codes.
+     */
+    static double findMaxError(const M3d::Vec3Array& vecs, M3d::NormalCodec::Format format) {
+        double maxError = 0;
+        for (size_t i = 0; i < vecs.size(); ++i) {
+            const M3d::Vec3 expected = normalize(vecs.get(i));
+            const M3d::Vec3 actual = M3d::NormalCodec::decode(M3d::NormalCodec::encode(expected, format), format);
+            CPPUNIT_ASSERT(fabs(dot(actual, actual) - 1) < 1e-12);
+            const double cosine = std::min(dot(expected, actual), 1.0);
+            maxError = std::max(maxError, acos(cosine) * 180 / M_PI);
+        }
+        return maxError;
+    }
+
+public:
+
+    /**
+     * Resets the number of threads.
+     */
+    void tearDown() {
+        M3d::Parallel::setConcurrency(0);
+    }
+
+    /**
+     * Ensures axes and degenerate vectors are encoded exactly.
+     */
+    void testAxes() {
+        const M3d::NormalCodec::Format formats[5] = { M3d::NormalCodec::OCT16, M3d::NormalCodec::OCT24,
+                                                      M3d::NormalCodec::OCT32, M3d::NormalCodec::SNORM24,
+                                                      M3d::NormalCodec::SNORM32 };
+        for (int f = 0; f < 5; ++f) {
+            for (int axis = 0; axis < 3; ++axis) {
+                for (int sign = -1; sign <= 1; sign += 2) {
+                    M3d::Vec3 vec(0, 0, 0);
+                    vec[axis] = sign * 3;
+                    const uint32_t code = M3d::NormalCodec::encode(vec, formats[f]);
+                    CPPUNIT_ASSERT(normalize(vec) == M3d::NormalCodec::decode(code, formats[f]));
+                    CPPUNIT_ASSERT(code < (((uint64_t) 1) << (8 * M3d::NormalCodec::countBytes(formats[f]))));
+                }
+            }
+            const M3d::Vec3 up(0, 0, 1);
+            const uint32_t zero = M3d::NormalCodec::encode(M3d::Vec3(0, 0, 0), formats[f]);
+            const uint32_t nan = M3d::NormalCodec::encode(M3d::Vec3(NAN, 0, 0), formats[f]);
+            CPPUNIT_ASSERT(up == M3d::NormalCodec::decode(zero, formats[f]));
+            CPPUNIT_ASSERT(up == M3d::NormalCodec::decode(nan, formats[f]));
+        }
+        CPPUNIT_ASSERT_THROW(M3d::NormalCodec::encode(M3d::Vec3(1, 0, 0), (M3d::NormalCodec::Format) 9),
+                             invalid_argument);
+    }
+
+    /**
+     * Ensures codes decode close to the vectors they came from, with octahedral codes the most precise.
+     */
+    void testPrecision() {
+        const M3d::Vec3Array vecs = makeVectors(200000);
+        const double oct16 = findMaxError(vecs, M3d::NormalCodec::OCT16);
+        const double oct24 = findMaxError(vecs, M3d::NormalCodec::OCT24);
+        const double oct32 = findMaxError(vecs, M3d::NormalCodec::OCT32);
+        const double snorm24 = findMaxError(vecs, M3d::NormalCodec::SNORM24);
+        const double snorm32 = findMaxError(vecs, M3d::NormalCodec::SNORM32);
+        CPPUNIT_ASSERT(oct16 < 0.7);
+        CPPUNIT_ASSERT(oct24 < 0.05);
+        CPPUNIT_ASSERT(oct32 < 0.003);
+        CPPUNIT_ASSERT(snorm24 < 0.5);
+        CPPUNIT_ASSERT(snorm32 < 0.12);
+        CPPUNIT_ASSERT(oct24 < snorm24);
+        CPPUNIT_ASSERT(oct32 < snorm32);
+    }
+
+    /**
+     * Ensures batches match single vectors, stored in little-endian order.
+     */
+    void testBatch() {
+        const M3d::Vec3Array vecs = makeVectors(50001);
+        M3d::Parallel::setConcurrency(4);
+        vector<unsigned char> codes(3 * vecs.size());
+        M3d::NormalCodec::encode(vecs, M3d::NormalCodec::OCT24, &codes[0]);
+        for (size_t i = 0; i < vecs.size(); ++i) {
+            const uint32_t code = M3d::NormalCodec::encode(vecs.get(i), M3d::NormalCodec::OCT24);
+            const uint32_t stored = codes[3 * i] | (codes[(3 * i) + 1] << 8) | (codes[(3 * i) + 2] << 16);
+            CPPUNIT_ASSERT_EQUAL(code, stored);
+        }
+
+        M3d::Vec3Array decoded;
+        M3d::NormalCodec::decode(&codes[0], vecs.size(), M3d::NormalCodec::OCT24, decoded);
+        CPPUNIT_ASSERT_EQUAL(vecs.size(), decoded.size());
+        for (size_t i = 0; i < vecs.size(); ++i) {
+            const uint32_t code = M3d::NormalCodec::encode(vecs.get(i), M3d::NormalCodec::OCT24);
+            CPPUNIT_ASSERT(M3d::NormalCodec::decode(code, M3d::NormalCodec::OCT24) == decoded.get(i));
+        }
+    }
+
+    CPPUNIT_TEST_SUITE(NormalCodecTest);
+    CPPUNIT_TEST(testAxes);
+    CPPUNIT_TEST(testBatch);
+    CPPUNIT_TEST(testPrecision);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(NormalCodecTest::suite());
+    runner.run();
+    return 0;
+}
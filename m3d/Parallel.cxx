@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <pthread.h>
+#include <unistd.h>
+#include <vector>
+#include "m3d/Parallel.h"
+using namespace std;
+namespace M3d {
+
+/*
+ * Range of work handed to a thread.
+ */
+struct Parallel::Chunk {
+    ParallelTask* task;
+    size_t index;
+    size_t begin;
+    size_t end;
+};
+
+// ATTRIBUTES
+size_t Parallel::concurrency = Parallel::findDefaultConcurrency();
+
+// METHODS
+
+/**
+ * Destroys the task.
+ */
+ParallelTask::~ParallelTask() {
+    // pass
+}
+
+/**
+ * Determines how many chunks work will be split into.
+ *
+ * @param size Number of items in the work
+ * @param grain Smallest number of items worth running on a separate thread
+ * @return Number of chunks, which is zero only if there are no items
+ */
+size_t Parallel::countChunks(size_t size, size_t grain) {
+    if (grain == 0) {
+        grain = 1;
+    }
+    const size_t chunks = (size + grain - 1) / grain;
+    return (chunks < concurrency) ? chunks : concurrency;
+}
+
+/**
+ * Returns the maximum number of threads used to run a task.
+ */
+size_t Parallel::getConcurrency() {
+    return concurrency;
+}
+
+/**
+ * Runs a task, splitting its work into chunks that are run at the same time.
+ *
+ * If only one chunk is needed, the task is run directly on the calling thread without starting any threads.  If a
+ * thread cannot be started, its chunk is run on the calling thread instead.
+ *
+ * @param task Task to run
+ * @param size Number of items in the work
+ * @param grain Smallest number of items worth running on a separate thread
+ */
+void Parallel::run(ParallelTask& task, size_t size, size_t grain) {
+
+    const size_t count = countChunks(size, grain);
+    if (count == 0) {
+        return;
+    } else if (count == 1) {
+        task.run(0, 0, size);
+        return;
+    }
+
+    // Split work into even chunks
+    vector<Chunk> chunks(count);
+    for (size_t i = 0; i < count; ++i) {
+        chunks[i].task = &task;
+        chunks[i].index = i;
+        chunks[i].begin = (size * i) / count;
+        chunks[i].end = (size * (i + 1)) / count;
+    }
+
+    // Start threads for all but the first chunk
+    vector<pthread_t> threads(count);
+    vector<bool> started(count, false);
+    for (size_t i = 1; i < count; ++i) {
+        started[i] = (pthread_create(&threads[i], NULL, &runChunk, &chunks[i]) == 0);
+    }
+
+    // Run first chunk and any that could not be started here
+    runChunk(&chunks[0]);
+    for (size_t i = 1; i < count; ++i) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        } else {
+            runChunk(&chunks[i]);
+        }
+    }
+}
+
+/**
+ * Changes the maximum number of threads used to run a task.
+ *
+ * @param concurrency Maximum number of threads, where zero restores the number of processors
+ */
+void Parallel::setConcurrency(size_t concurrency) {
+    Parallel::concurrency = (concurrency > 0) ? concurrency : findDefaultConcurrency();
+}
+
+// HELPERS
+
+/*
+ * Runs a chunk of a task, as the entry point of a thread.
+ */
+void* Parallel::runChunk(void* arg) {
+    Chunk* chunk = (Chunk*) arg;
+    chunk->task->run(chunk->index, chunk->begin, chunk->end);
+    return NULL;
+}
+
+/*
+ * Finds the number of processors available.
+ */
+size_t Parallel::findDefaultConcurrency() {
+    const long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    return (processors > 0) ? ((size_t) processors) : 1;
+}
+
+} /* namespace M3d */
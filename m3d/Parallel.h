@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_PARALLEL_H
+#define M3D_PARALLEL_H
+#include "m3d/common.h"
+namespace M3d {
+
+
+/**
+ * Work that can be split into independent ranges and run on several threads.
+ */
+class ParallelTask {
+public:
+    virtual ~ParallelTask();
+    /**
+     * Processes one range of the work.
+     *
+     * Called once per chunk, possibly at the same time from different threads, so implementations should only write to
+     * state owned by the chunk.  Must not throw.
+     *
+     * @param chunk Index of the chunk, in [0 .. number of chunks)
+     * @param begin Index of first item in the chunk
+     * @param end Index one past the last item in the chunk
+     */
+    virtual void run(size_t chunk, size_t begin, size_t end) = 0;
+};
+
+
+/**
+ * Utility for running tasks on several threads.
+ *
+ * Work is split into at most one contiguous chunk per thread.  The first chunk is run on the calling thread, and the
+ * call returns once every chunk has finished.
+ */
+class Parallel {
+public:
+// Methods
+    static size_t countChunks(size_t size, size_t grain);
+    static size_t getConcurrency();
+    static void run(ParallelTask& task, size_t size, size_t grain);
+    static void setConcurrency(size_t concurrency);
+private:
+// Types
+    struct Chunk;
+// Attributes
+    static size_t concurrency;
+// Helpers
+    static void* runChunk(void* arg);
+    static size_t findDefaultConcurrency();
+};
+
+} /* namespace M3d */
+#endif
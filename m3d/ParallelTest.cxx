@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <vector>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/Parallel.h"
+using namespace std;
+
+
+/**
+ * Task that records which chunk visited each item.
+ */
+class MarkTask : public M3d::ParallelTask {
+public:
+    vector<int> marks;
+    explicit MarkTask(size_t size) : marks(size, -1) { }
+    virtual void run(size_t chunk, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            marks[i] = (int) chunk;
+        }
+    }
+};
+
+
+/**
+ * Unit test for Parallel.
+ */
+class ParallelTest : public CppUnit::TestFixture {
+public:
+
+    /**
+     * Restores the default concurrency after each test case.
+     */
+    void tearDown() {
+        M3d::Parallel::setConcurrency(0);
+    }
+
+    /**
+     * Ensures countChunks is limited by both the grain size and the concurrency.
+     */
+    void testCountChunks() {
+        M3d::Parallel::setConcurrency(4);
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, M3d::Parallel::countChunks(0, 10));
+        CPPUNIT_ASSERT_EQUAL((size_t) 1, M3d::Parallel::countChunks(10, 10));
+        CPPUNIT_ASSERT_EQUAL((size_t) 2, M3d::Parallel::countChunks(11, 10));
+        CPPUNIT_ASSERT_EQUAL((size_t) 4, M3d::Parallel::countChunks(1000, 10));
+        CPPUNIT_ASSERT_EQUAL((size_t) 4, M3d::Parallel::countChunks(1000, 0));
+    }
+
+    /**
+     * Ensures setConcurrency with zero restores a positive default.
+     */
+    void testSetConcurrency() {
+        M3d::Parallel::setConcurrency(3);
+        CPPUNIT_ASSERT_EQUAL((size_t) 3, M3d::Parallel::getConcurrency());
+        M3d::Parallel::setConcurrency(0);
+        CPPUNIT_ASSERT(M3d::Parallel::getConcurrency() > 0);
+    }
+
+    /**
+     * Ensures run visits every item exactly once in contiguous, ordered chunks.
+     */
+    void testRun() {
+        M3d::Parallel::setConcurrency(4);
+        MarkTask task(1001);
+        M3d::Parallel::run(task, task.marks.size(), 100);
+        CPPUNIT_ASSERT_EQUAL(0, task.marks.front());
+        CPPUNIT_ASSERT_EQUAL(3, task.marks.back());
+        for (size_t i = 1; i < task.marks.size(); ++i) {
+            CPPUNIT_ASSERT(task.marks[i] == task.marks[i - 1] || task.marks[i] == task.marks[i - 1] + 1);
+        }
+    }
+
+    /**
+     * Ensures run does nothing when there is no work.
+     */
+    void testRunEmpty() {
+        MarkTask task(0);
+        M3d::Parallel::run(task, 0, 100);
+        CPPUNIT_ASSERT(task.marks.empty());
+    }
+
+    CPPUNIT_TEST_SUITE(ParallelTest);
+    CPPUNIT_TEST(testCountChunks);
+    CPPUNIT_TEST(testSetConcurrency);
+    CPPUNIT_TEST(testRun);
+    CPPUNIT_TEST(testRunEmpty);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(ParallelTest::suite());
+    runner.run();
+    return 0;
+}
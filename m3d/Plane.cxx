@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include "m3d/Plane.h"
+using namespace std;
+namespace M3d {
+
+/**
+ * Constructs the XY plane, facing positive Z.
+ */
+Plane::Plane() : normal(0, 0, 1), offset(0) {
+    // pass
+}
+
+/**
+ * Constructs a plane from a normal and an offset.
+ *
+ * @param normal Unit normal
+ * @param offset Negative of the distance from the origin along the normal
+ */
+Plane::Plane(const Vec3& normal, double offset) : normal(normal), offset(offset) {
+    // pass
+}
+
+/**
+ * Makes a plane through a point.
+ *
+ * @param point Point on the plane
+ * @param normal Direction the plane faces, which is normalized
+ * @return Plane through the point
+ */
+Plane Plane::fromPointNormal(const Vec3& point, const Vec3& normal) {
+    const Vec3 n = normalize(normal);
+    return Plane(n, -dot(n, point));
+}
+
+/**
+ * Makes a plane through three points, facing the side they wind counter-clockwise around.
+ *
+ * @param a First point
+ * @param b Second point
+ * @param c Third point
+ * @return Plane through the points
+ */
+Plane Plane::fromPoints(const Vec3& a, const Vec3& b, const Vec3& c) {
+    return fromPointNormal(a, cross(b - a, c - a));
+}
+
+/**
+ * Makes a plane from its equation `(a, b, c, d)`, scaling it so the normal is unit length.
+ *
+ * @param v Coefficients of the equation, e.g. from `Frustum::getPlane`
+ * @return Plane with the same equation
+ */
+Plane Plane::fromVec4(const Vec4& v) {
+    const double len = length(v.toVec3());
+    return Plane(v.toVec3() / len, v.w / len);
+}
+
+/**
+ * Computes the signed distance from the plane to a point.
+ *
+ * @param point Point to compute distance to
+ * @return Distance, positive on the side the normal points to
+ */
+double Plane::getDistance(const Vec3& point) const {
+    return dot(normal, point) + offset;
+}
+
+/**
+ * Checks if a ray hits the plane from either side.
+ *
+ * @param ray Ray to check
+ * @param tMax Largest distance along the ray to accept
+ * @param t Distance to the hit, set only if there is one
+ * @return `true` if the ray hits the plane in [0 .. tMax]
+ */
+bool Plane::intersects(const Ray& ray, double tMax, double& t) const {
+
+    const double denominator = dot(normal, ray.direction);
+    if (denominator == 0) {
+        return false;
+    }
+
+    const double tHit = -getDistance(ray.origin) / denominator;
+    if ((tHit < 0) || (tHit > tMax)) {
+        return false;
+    }
+    t = tHit;
+    return true;
+}
+
+/**
+ * Tests a ray against many planes.
+ *
+ * @param ray Ray to test
+ * @param normals Unit normals of planes
+ * @param offsets Offsets of planes, the same size as `normals`
+ * @param tMax Largest distance along the ray to accept
+ * @param t Array to store the distance to each plane in, or `HUGE_VAL` if missed, with room for every plane
+ * @param mask Bitmask to store results in, which is resized to hold one bit per plane
+ * @return Number of planes hit
+ */
+size_t Plane::markHits(const Ray& ray, const Vec3Array& normals, const vector<double>& offsets, double tMax, double* t,
+                       vector<uint32_t>& mask) {
+
+    const size_t n = normals.size();
+    double margin[BLOCK_SIZE];
+    size_t count = 0;
+
+    mask.resize((n + 31) / 32);
+    for (size_t begin = 0; begin < n; begin += BLOCK_SIZE) {
+        const size_t end = std::min(begin + BLOCK_SIZE, n);
+        for (size_t i = begin; i < end; ++i) {
+            const double denominator = (normals.x[i] * ray.direction.x)
+                    + (normals.y[i] * ray.direction.y)
+                    + (normals.z[i] * ray.direction.z);
+            const double distance = (normals.x[i] * ray.origin.x)
+                    + (normals.y[i] * ray.origin.y)
+                    + (normals.z[i] * ray.origin.z)
+                    + offsets[i];
+            const double tHit = -distance / denominator;
+            const bool hit = (denominator != 0) & (tHit >= 0) & (tHit <= tMax);
+            t[i] = hit ? tHit : HUGE_VAL;
+            margin[i - begin] = hit ? 0 : -1;
+        }
+        count += Bitmask::setFromMargins(margin, begin, end, &mask[0]);
+    }
+    return count;
+}
+
+/**
+ * Finds the point on the plane closest to another point.
+ *
+ * @param point Point to project onto the plane
+ * @return Closest point on the plane
+ */
+Vec3 Plane::project(const Vec3& point) const {
+    return point - (normal * getDistance(point));
+}
+
+/**
+ * Returns the equation of the plane as `(a, b, c, d)`.
+ */
+Vec4 Plane::toVec4() const {
+    return Vec4(normal, offset);
+}
+
+/**
+ * Returns a string representation of the plane.
+ */
+string Plane::toString() const {
+    stringstream stream;
+    stream << (*this);
+    return stream.str();
+}
+
+} /* namespace M3d */
+
+/**
+ * Appends a plane to a stream.
+ *
+ * @param stream Stream to append to
+ * @param plane Plane to append
+ * @return Reference to the stream
+ */
+ostream& operator<<(ostream& stream, const M3d::Plane& plane) {
+    stream << '[' << plane.normal << ", " << plane.offset << ']';
+    return stream;
+}
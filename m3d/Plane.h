@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_PLANE_H
+#define M3D_PLANE_H
+#include "m3d/common.h"
+#include <iostream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "m3d/Bitmask.h"
+#include "m3d/Ray.h"
+#include "m3d/Vec3.h"
+#include "m3d/Vec3Array.h"
+#include "m3d/Vec4.h"
+namespace M3d {
+
+
+/**
+ * Infinite plane with a unit normal.
+ *
+ * A point `p` is on the plane when `dot(normal, p) + offset` is zero, and that expression is the signed distance from
+ * the plane, positive on the side the normal points to.  This matches the planes of `Frustum`.
+ *
+ * The batch test takes planes as separate arrays of components so one ray can be tested against many planes at once
+ * with SIMD instructions.  Results are written as a distance for each plane and a bitmask with one bit per plane.
+ */
+class Plane {
+public:
+// Attributes
+    Vec3 normal; ///< Unit normal
+    double offset; ///< Negative of the distance from the origin along the normal
+// Methods
+    explicit Plane();
+    explicit Plane(const Vec3& normal, double offset);
+    static Plane fromPointNormal(const Vec3& point, const Vec3& normal);
+    static Plane fromPoints(const Vec3& a, const Vec3& b, const Vec3& c);
+    static Plane fromVec4(const Vec4& v);
+    double getDistance(const Vec3& point) const;
+    bool intersects(const Ray& ray, double tMax, double& t) const;
+    static size_t markHits(const Ray& ray, const Vec3Array& normals, const std::vector<double>& offsets, double tMax,
+                           double* t, std::vector<uint32_t>& mask);
+    Vec3 project(const Vec3& point) const;
+    Vec4 toVec4() const;
+    std::string toString() const;
+private:
+// Constants
+    static const size_t BLOCK_SIZE = 256;
+};
+
+} /* namespace M3d */
+
+std::ostream& operator<<(std::ostream& stream, const M3d::Plane& plane);
+#endif
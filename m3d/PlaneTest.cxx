@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cmath>
+#include <cstdlib>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/Plane.h"
+using namespace std;
+
+/*
+ * Constants
+ */
+const double TOLERANCE = 1e-9;
+
+
+/**
+ * Unit test for Plane.
+ */
+class PlaneTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + (upper - lower) * (rand() / (double) RAND_MAX);
+    }
+
+public:
+
+    /**
+     * Ensures fromPoints faces the side the points wind counter-clockwise around.
+     */
+    void testFromPoints() {
+        const M3d::Plane plane = M3d::Plane::fromPoints(M3d::Vec3(0, 0, 2), M3d::Vec3(1, 0, 2), M3d::Vec3(0, 1, 2));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, plane.normal.z, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(-2.0, plane.offset, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, plane.getDistance(M3d::Vec3(4, 5, 5)), TOLERANCE);
+    }
+
+    /**
+     * Ensures fromVec4 normalizes the equation and toVec4 gives it back.
+     */
+    void testFromVec4() {
+        const M3d::Plane plane = M3d::Plane::fromVec4(M3d::Vec4(0, 2, 0, -4));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, plane.normal.y, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(-2.0, plane.offset, TOLERANCE);
+        const M3d::Vec4 v = plane.toVec4();
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, v.y, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(-2.0, v.w, TOLERANCE);
+    }
+
+    /**
+     * Ensures project moves a point onto the plane.
+     */
+    void testProject() {
+        const M3d::Plane plane = M3d::Plane::fromPointNormal(M3d::Vec3(1, 1, 1), M3d::Vec3(1, 1, 1));
+        const M3d::Vec3 p = plane.project(M3d::Vec3(5, -2, 3));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, plane.getDistance(p), TOLERANCE);
+    }
+
+    /**
+     * Ensures intersects finds hits from either side and rejects parallel rays and hits out of range.
+     */
+    void testIntersects() {
+        const M3d::Plane plane(M3d::Vec3(0, 0, 1), -5);
+        double t = -1;
+        CPPUNIT_ASSERT(plane.intersects(M3d::Ray(M3d::Vec3(0, 0, 0), M3d::Vec3(0, 0, 1)), 10, t));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0, t, TOLERANCE);
+        CPPUNIT_ASSERT(plane.intersects(M3d::Ray(M3d::Vec3(0, 0, 8), M3d::Vec3(0, 0, -1)), 10, t));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, t, TOLERANCE);
+        CPPUNIT_ASSERT(!plane.intersects(M3d::Ray(M3d::Vec3(0, 0, 0), M3d::Vec3(1, 0, 0)), 10, t));
+        CPPUNIT_ASSERT(!plane.intersects(M3d::Ray(M3d::Vec3(0, 0, 0), M3d::Vec3(0, 0, -1)), 10, t));
+        CPPUNIT_ASSERT(!plane.intersects(M3d::Ray(M3d::Vec3(0, 0, 0), M3d::Vec3(0, 0, 1)), 4, t));
+    }
+
+    /**
+     * Ensures the batch ray test agrees with the single ray test.
+     */
+    void testMarkHits() {
+
+        const size_t n = 1000;
+        M3d::Vec3Array normals(n);
+        vector<double> offsets(n);
+        for (size_t i = 0; i < n; ++i) {
+            normals.set(i, M3d::normalize(M3d::Vec3(random(-1, 1), random(-1, 1), random(-1, 1))));
+            offsets[i] = random(-20, 20);
+        }
+        const M3d::Ray ray(M3d::Vec3(1, 2, 3), M3d::normalize(M3d::Vec3(1, -1, 0.5)));
+
+        vector<double> t(n);
+        vector<uint32_t> mask;
+        const size_t count = M3d::Plane::markHits(ray, normals, offsets, 30, &t[0], mask);
+
+        CPPUNIT_ASSERT_EQUAL((n + 31) / 32, mask.size());
+        size_t expected = 0;
+        for (size_t i = 0; i < n; ++i) {
+            double tHit;
+            const bool hit = M3d::Plane(normals.get(i), offsets[i]).intersects(ray, 30, tHit);
+            CPPUNIT_ASSERT_EQUAL(hit, M3d::Bitmask::get(mask, i));
+            if (hit) {
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(tHit, t[i], TOLERANCE);
+                ++expected;
+            } else {
+                CPPUNIT_ASSERT_EQUAL(HUGE_VAL, t[i]);
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL(expected, count);
+        CPPUNIT_ASSERT(count > 0 && count < n);
+    }
+
+    CPPUNIT_TEST_SUITE(PlaneTest);
+    CPPUNIT_TEST(testFromPoints);
+    CPPUNIT_TEST(testFromVec4);
+    CPPUNIT_TEST(testProject);
+    CPPUNIT_TEST(testIntersects);
+    CPPUNIT_TEST(testMarkHits);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(PlaneTest::suite());
+    runner.run();
+    return 0;
+}
@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <pthread.h>
+#include <stdexcept>
+#include "m3d/PointStream.h"
+#include "m3d/Vec4.h"
+using namespace std;
+namespace M3d {
+
+
+/*
+ * Number, mean, sum of squared deviations and bounds of some points.
+ */
+struct PointStream::Moments {
+    size_t count;
+    double mean[3];
+    double squares[3];
+    double lower[3];
+    double upper[3];
+};
+
+
+/*
+ * Disk access done while a chunk is being transformed.
+ */
+struct PointStream::Transfer {
+    ArrayFile::Reader* reader;
+    ArrayFile::Writer* writer;
+    void* buffer;
+    size_t writeCount;
+    size_t readFirst;
+    size_t readCount;
+    string error;
+};
+
+
+/*
+ * Task transforming a chunk of points in place and finding their moments.
+ */
+class PointStream::TransformTask : public ParallelTask {
+public:
+    TransformTask(const double (&rows)[4][4], size_t scalarSize, void* points, vector<Moments>& moments)
+            : rows(rows), scalarSize(scalarSize), points(points), moments(moments) {
+        projective = (rows[3][0] != 0) || (rows[3][1] != 0) || (rows[3][2] != 0) || (rows[3][3] != 1);
+    }
+    virtual void run(size_t chunk, size_t begin, size_t end) {
+        if (scalarSize == sizeof(float)) {
+            transform(static_cast<float*>(points), begin, end, moments[chunk]);
+        } else {
+            transform(static_cast<double*>(points), begin, end, moments[chunk]);
+        }
+    }
+private:
+    const double (&rows)[4][4];
+    size_t scalarSize;
+    void* points;
+    vector<Moments>& moments;
+    bool projective;
+    template <typename T>
+    void transform(T* points, size_t begin, size_t end, Moments& m) const {
+        m.count = 0;
+        for (int c = 0; c < 3; ++c) {
+            m.mean[c] = 0;
+            m.squares[c] = 0;
+            m.lower[c] = HUGE_VAL;
+            m.upper[c] = -HUGE_VAL;
+        }
+        for (size_t i = begin; i < end; ++i) {
+            T* const p = points + (3 * i);
+            const double x = p[0];
+            const double y = p[1];
+            const double z = p[2];
+            double scale = 1;
+            if (projective) {
+                scale = 1 / ((rows[3][0] * x) + (rows[3][1] * y) + (rows[3][2] * z) + rows[3][3]);
+            }
+            ++m.count;
+            for (int c = 0; c < 3; ++c) {
+
+                // Transform component, keeping it as stored
+                p[c] = (T) (((rows[c][0] * x) + (rows[c][1] * y) + (rows[c][2] * z) + rows[c][3]) * scale);
+                const double value = p[c];
+
+                // Update running moments
+                const double delta = value - m.mean[c];
+                m.mean[c] += delta / m.count;
+                m.squares[c] += delta * (value - m.mean[c]);
+                m.lower[c] = std::min(m.lower[c], value);
+                m.upper[c] = std::max(m.upper[c], value);
+            }
+        }
+    }
+};
+
+// METHODS
+
+/**
+ * Constructs a pipeline.
+ *
+ * @param chunkSize Number of points read at a time, which sets how much memory is used
+ * @throws invalid_argument if the chunk size is zero
+ */
+PointStream::PointStream(size_t chunkSize) : chunkSize(chunkSize), count(0) {
+    if (chunkSize == 0) {
+        throw invalid_argument("[PointStream] Chunk size must be positive!");
+    }
+    for (int c = 0; c < 3; ++c) {
+        mean[c] = 0;
+        squares[c] = 0;
+    }
+}
+
+/**
+ * Returns the bounds of the points last processed, which is empty if there were none.
+ */
+const Aabb& PointStream::getBounds() const {
+    return bounds;
+}
+
+/**
+ * Returns the number of points read at a time.
+ */
+size_t PointStream::getChunkSize() const {
+    return chunkSize;
+}
+
+/**
+ * Returns the number of points last processed.
+ */
+size_t PointStream::getCount() const {
+    return count;
+}
+
+/**
+ * Returns the mean of the points last processed, which is zero if there were none.
+ */
+Vec3 PointStream::getMean() const {
+    return Vec3(mean[0], mean[1], mean[2]);
+}
+
+/**
+ * Returns the variance of each component of the points last processed, which is zero if there were none.
+ */
+Vec3 PointStream::getVariance() const {
+    if (count == 0) {
+        return Vec3(0, 0, 0);
+    }
+    return Vec3(squares[0] / count, squares[1] / count, squares[2] / count);
+}
+
+/**
+ * Finds the bounds, mean and variance of the points in a file, without changing them.
+ *
+ * @param input Path to an array file of three-component vectors
+ * @throws runtime_error if the file cannot be read or does not hold three-component vectors
+ */
+void PointStream::measure(const string& input) {
+    process(input, NULL, Mat4(1));
+}
+
+/**
+ * Transforms the points in a file by a matrix, writing them to another file.
+ *
+ * Points are treated as positions with a fourth component of one, and are divided by their transformed fourth
+ * component if the last row of the matrix is not the same as that of an affine transform.
+ *
+ * @param input Path to an array file of three-component vectors
+ * @param output Path to the file to write, which is replaced, and removed again if anything fails
+ * @param mat Transform to apply
+ * @throws runtime_error if either file cannot be read or written, or the input does not hold three-component vectors
+ */
+void PointStream::transform(const string& input, const string& output, const Mat4& mat) {
+    process(input, &output, mat);
+}
+
+/**
+ * Rotates and then translates the points in a file, writing them to another file.
+ *
+ * @param input Path to an array file of three-component vectors
+ * @param output Path to the file to write, which is replaced, and removed again if anything fails
+ * @param rotation Rotation to apply, which is normalized first
+ * @param translation Offset added after rotating
+ * @throws runtime_error if either file cannot be read or written, or the input does not hold three-component vectors
+ */
+void PointStream::transform(const string& input, const string& output, const Quat& rotation,
+                            const Vec3& translation) {
+    Mat4 mat = normalize(rotation).toMat4();
+    mat[3] = Vec4(translation, 1);
+    process(input, &output, mat);
+}
+
+// HELPERS
+
+/*
+ * Merges the moments of a chunk into the totals.
+ */
+void PointStream::addMoments(const Moments& moments) {
+
+    if (moments.count == 0) {
+        return;
+    }
+
+    const double n = (double) (count + moments.count);
+    const double weight = ((double) count) * moments.count / n;
+    for (int c = 0; c < 3; ++c) {
+        const double delta = moments.mean[c] - mean[c];
+        mean[c] += delta * moments.count / n;
+        squares[c] += moments.squares[c] + (delta * delta * weight);
+    }
+    count += moments.count;
+    bounds.merge(Aabb(Vec3(moments.lower[0], moments.lower[1], moments.lower[2]),
+                      Vec3(moments.upper[0], moments.upper[1], moments.upper[2])));
+}
+
+/*
+ * Streams the points in a file through a transform, writing them to another file if one is given.
+ */
+void PointStream::process(const string& input, const string* output, const Mat4& mat) {
+
+    // Reset totals
+    bounds = Aabb();
+    count = 0;
+    for (int c = 0; c < 3; ++c) {
+        mean[c] = 0;
+        squares[c] = 0;
+    }
+
+    // Open files
+    ArrayFile::Reader reader;
+    reader.open(input);
+    if (reader.getType() != ArrayFile::VEC3) {
+        throw runtime_error("[PointStream] File does not hold three-component vectors!");
+    }
+    ArrayFile::Writer writer;
+    if (output != NULL) {
+        writer.open(*output, ArrayFile::VEC3, reader.getScalarSize());
+    }
+
+    // Stream the points, removing a partly written output if anything fails
+    try {
+        // Make buffers, with doubles so either kind of scalar is aligned
+        const size_t total = reader.getCount();
+        const size_t size = std::min(chunkSize, total);
+        vector<double> buffers[2];
+        buffers[0].resize((3 * size) + 1);
+        buffers[1].resize((3 * size) + 1);
+        double rows[4][4];
+        mat.toArrayInRowMajor(rows);
+
+        // Transform each chunk while writing the last one and reading the next one
+        reader.read(0, size, &buffers[0][0]);
+        size_t current = 0;
+        size_t pending = 0;
+        for (size_t first = 0; first < total; first += pending) {
+            const size_t n = std::min(chunkSize, total - first);
+            Transfer transfer;
+            transfer.reader = &reader;
+            transfer.writer = (output != NULL) ? &writer : NULL;
+            transfer.buffer = &buffers[1 - current][0];
+            transfer.writeCount = pending;
+            transfer.readFirst = first + n;
+            transfer.readCount = std::min(chunkSize, total - (first + n));
+            pthread_t thread;
+            const bool started = (pthread_create(&thread, NULL, &runTransfer, &transfer) == 0);
+
+            vector<Moments> moments(Parallel::countChunks(n, GRAIN_SIZE));
+            TransformTask task(rows, reader.getScalarSize(), &buffers[current][0], moments);
+            Parallel::run(task, n, GRAIN_SIZE);
+            for (size_t i = 0; i < moments.size(); ++i) {
+                addMoments(moments[i]);
+            }
+
+            if (started) {
+                pthread_join(thread, NULL);
+            } else {
+                runTransfer(&transfer);
+            }
+            if (!transfer.error.empty()) {
+                throw runtime_error(transfer.error);
+            }
+            current = 1 - current;
+            pending = n;
+        }
+
+        // Write the last chunk
+        if (output != NULL) {
+            writer.write(&buffers[1 - current][0], pending);
+            writer.close();
+        }
+    } catch (...) {
+        if (output != NULL) {
+            writer.abandon();
+            std::remove(output->c_str());
+        }
+        throw;
+    }
+}
+
+/*
+ * Writes and then reads the buffer of a transfer, as the entry point of a thread.
+ */
+void* PointStream::runTransfer(void* arg) {
+    Transfer* transfer = (Transfer*) arg;
+    try {
+        if ((transfer->writer != NULL) && (transfer->writeCount > 0)) {
+            transfer->writer->write(transfer->buffer, transfer->writeCount);
+        }
+        if (transfer->readCount > 0) {
+            transfer->reader->read(transfer->readFirst, transfer->readCount, transfer->buffer);
+        }
+    } catch (exception& e) {
+        transfer->error = e.what();
+    }
+    return NULL;
+}
+
+} /* namespace M3d */
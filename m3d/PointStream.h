@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_POINTSTREAM_H
+#define M3D_POINTSTREAM_H
+#include "m3d/common.h"
+#include <string>
+#include <vector>
+#include "m3d/Aabb.h"
+#include "m3d/ArrayFile.h"
+#include "m3d/Mat4.h"
+#include "m3d/Parallel.h"
+#include "m3d/Quat.h"
+#include "m3d/Vec3.h"
+namespace M3d {
+
+
+/**
+ * Pipeline transforming array files of points that are too large to fit in memory.
+ *
+ * Points are read a fixed number at a time into one of two buffers, transformed in place on several threads, and then
+ * written out from the same buffer.  While one buffer is being transformed, another thread writes the points left in
+ * the other buffer and reads the next chunk into it, so computing overlaps with disk access, and memory use stays at
+ * two chunks however large the file is.  The bounds, mean and variance of the transformed points are kept as they pass.
+ *
+ * Input files may hold floats or doubles in either layout.  Output files are interleaved and keep the input's scalars,
+ * and must not be the input file.
+ */
+class PointStream {
+public:
+// Constants
+    static const size_t DEFAULT_CHUNK_SIZE = 1048576; ///< Number of points read at a time unless given
+// Methods
+    explicit PointStream(size_t chunkSize = DEFAULT_CHUNK_SIZE);
+    const Aabb& getBounds() const;
+    size_t getChunkSize() const;
+    size_t getCount() const;
+    Vec3 getMean() const;
+    Vec3 getVariance() const;
+    void measure(const std::string& input);
+    void transform(const std::string& input, const std::string& output, const Mat4& mat);
+    void transform(const std::string& input, const std::string& output, const Quat& rotation, const Vec3& translation);
+private:
+// Types
+    struct Moments;
+    struct Transfer;
+    class TransformTask;
+// Constants
+    static const size_t GRAIN_SIZE = 65536;
+// Attributes
+    size_t chunkSize;
+    Aabb bounds;
+    size_t count;
+    double mean[3];
+    double squares[3];
+// Helpers
+    void addMoments(const Moments& moments);
+    void process(const std::string& input, const std::string* output, const Mat4& mat);
+    static void* runTransfer(void* arg);
+};
+
+} /* namespace M3d */
+#endif
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/PointStream.h"
+using namespace std;
+
+/*
+ * Constants
+ */
+const char* INPUT = "PointStreamTest.in";
+const char* OUTPUT = "PointStreamTest.out";
+
+
+/**
+ * Unit test for PointStream.
+ */
+class PointStreamTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + ((upper - lower) * rand() / RAND_MAX);
+    }
+
+    /**
+     * Makes an array of random points.
+     */
+    static M3d::Vec3Array makePoints(size_t size) {
+        M3d::Vec3Array arr(size);
+        for (size_t i = 0; i < size; ++i) {
+            arr.set(i, M3d::Vec3(random(-10, 10), random(0, 5), random(-1, 1)));
+        }
+        return arr;
+    }
+
+    /**
+     * Checks that two vectors are about the same.
+     */
+    static void checkNear(const M3d::Vec3& expected, const M3d::Vec3& actual, double tolerance) {
+        CPPUNIT_ASSERT(fabs(expected.x - actual.x) <= tolerance);
+        CPPUNIT_ASSERT(fabs(expected.y - actual.y) <= tolerance);
+        CPPUNIT_ASSERT(fabs(expected.z - actual.z) <= tolerance);
+    }
+
+    /**
+     * Checks the bounds, mean and variance of a stream against those of some points.
+     */
+    static void checkMoments(const M3d::Vec3Array& points, const M3d::PointStream& stream) {
+        const size_t size = points.size();
+        double mean[3] = { 0, 0, 0 };
+        double variance[3] = { 0, 0, 0 };
+        for (size_t i = 0; i < size; ++i) {
+            mean[0] += points.x[i] / size;
+            mean[1] += points.y[i] / size;
+            mean[2] += points.z[i] / size;
+        }
+        for (size_t i = 0; i < size; ++i) {
+            variance[0] += (points.x[i] - mean[0]) * (points.x[i] - mean[0]) / size;
+            variance[1] += (points.y[i] - mean[1]) * (points.y[i] - mean[1]) / size;
+            variance[2] += (points.z[i] - mean[2]) * (points.z[i] - mean[2]) / size;
+        }
+        CPPUNIT_ASSERT_EQUAL(size, stream.getCount());
+        CPPUNIT_ASSERT(M3d::Aabb::fromPoints(points) == stream.getBounds());
+        checkNear(M3d::Vec3(mean), stream.getMean(), 1e-9);
+        checkNear(M3d::Vec3(variance), stream.getVariance(), 1e-9);
+    }
+
+public:
+
+    /**
+     * Removes the test files and resets the number of threads.
+     */
+    void tearDown() {
+        remove(INPUT);
+        remove(OUTPUT);
+        M3d::Parallel::setConcurrency(0);
+    }
+
+    /**
+     * Ensures files that cannot be streamed are rejected.
+     */
+    void testInvalid() {
+        CPPUNIT_ASSERT_THROW(M3d::PointStream(0), invalid_argument);
+        M3d::PointStream stream(10);
+        CPPUNIT_ASSERT_THROW(stream.measure(INPUT), runtime_error);
+        M3d::ArrayFile::write(INPUT, vector<M3d::Quat>(5));
+        CPPUNIT_ASSERT_THROW(stream.transform(INPUT, OUTPUT, M3d::Mat4(1)), runtime_error);
+    }
+
+    /**
+     * Ensures an output that fails partway through is removed rather than left looking like a complete file.
+     */
+    void testTransformFailure() {
+        M3d::ArrayFile::write(INPUT, makePoints(1000));
+        M3d::PointStream stream(100);
+
+        // Writing over the input truncates it, so reading the rest of it fails
+        CPPUNIT_ASSERT_THROW(stream.transform(INPUT, INPUT, M3d::Mat4(1)), runtime_error);
+        M3d::ArrayFile file;
+        CPPUNIT_ASSERT_THROW(file.open(INPUT), runtime_error);
+    }
+
+    /**
+     * Ensures the moments of a file are found without writing anything, in any number of chunks and threads.
+     */
+    void testMeasure() {
+        const M3d::Vec3Array points = makePoints(200000);
+        M3d::ArrayFile::write(INPUT, points);
+        const size_t chunkSizes[] = { 1, 999, 100000, 300000 };
+        for (int i = 0; i < 4; ++i) {
+            M3d::Parallel::setConcurrency((i % 2) ? 4 : 1);
+            M3d::PointStream stream(chunkSizes[i]);
+            stream.measure(INPUT);
+            checkMoments(points, stream);
+        }
+
+        M3d::ArrayFile::write(INPUT, M3d::Vec3Array());
+        M3d::PointStream stream;
+        stream.measure(INPUT);
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, stream.getCount());
+        CPPUNIT_ASSERT(stream.getBounds().isEmpty());
+        CPPUNIT_ASSERT(M3d::Vec3(0, 0, 0) == stream.getVariance());
+    }
+
+    /**
+     * Ensures points are transformed by a matrix, with the same result however they are split up.
+     */
+    void testTransformMat4() {
+        const M3d::Vec3Array points = makePoints(150001);
+        M3d::ArrayFile::write(INPUT, points);
+        M3d::Mat4 mat = M3d::Quat::fromAxisAngle(M3d::Vec3(1, 2, 3), 0.7).toMat4();
+        mat[0] = mat[0] * 2;
+        mat[3] = M3d::Vec4(5, -6, 7, 1);
+
+        M3d::Vec3Array expected(points.size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            expected.set(i, (mat * M3d::Vec4(points.get(i), 1)).toVec3());
+        }
+
+        vector<double> first;
+        for (int i = 0; i < 3; ++i) {
+            M3d::Parallel::setConcurrency((i == 1) ? 1 : 4);
+            M3d::PointStream stream((i == 2) ? 7 : 65536);
+            stream.transform(INPUT, OUTPUT, mat);
+            checkMoments(expected, stream);
+
+            M3d::ArrayFile file;
+            file.open(OUTPUT);
+            CPPUNIT_ASSERT(file.verify());
+            CPPUNIT_ASSERT_EQUAL(M3d::ArrayFile::INTERLEAVED, file.getLayout());
+            CPPUNIT_ASSERT_EQUAL(points.size(), file.getCount());
+            const M3d::Vec3* const vecs = file.getVec3s();
+            for (size_t j = 0; j < points.size(); ++j) {
+                checkNear(expected.get(j), vecs[j], 1e-12);
+            }
+            const vector<double> doubles(file.getDoubles(), file.getDoubles() + (3 * points.size()));
+            if (i == 0) {
+                first = doubles;
+            } else {
+                CPPUNIT_ASSERT(first == doubles);
+            }
+        }
+    }
+
+    /**
+     * Ensures points stored as floats are rotated and translated, and kept as floats.
+     */
+    void testTransformQuat() {
+        const size_t size = 1000;
+        vector<float> floats(3 * size);
+        for (size_t i = 0; i < floats.size(); ++i) {
+            floats[i] = (float) random(-10, 10);
+        }
+        M3d::ArrayFile::write(INPUT, M3d::ArrayFile::VEC3, sizeof(float), M3d::ArrayFile::INTERLEAVED, &floats[0],
+                              size);
+
+        const M3d::Quat rotation(0, 0, 2, 2);
+        const M3d::Vec3 translation(1, 2, 3);
+        M3d::PointStream stream(64);
+        stream.transform(INPUT, OUTPUT, rotation, translation);
+
+        M3d::ArrayFile file;
+        file.open(OUTPUT);
+        CPPUNIT_ASSERT(file.verify());
+        CPPUNIT_ASSERT_EQUAL((size_t) 4, file.getScalarSize());
+        const float* const result = file.getFloats();
+        for (size_t i = 0; i < size; ++i) {
+            const M3d::Vec3 expected(1 - floats[(3 * i) + 1], 2 + floats[3 * i], 3 + floats[(3 * i) + 2]);
+            checkNear(expected, M3d::Vec3(result[3 * i], result[(3 * i) + 1], result[(3 * i) + 2]), 1e-5);
+        }
+
+        M3d::Vec3Array written;
+        file.read(written);
+        checkMoments(written, stream);
+    }
+
+    CPPUNIT_TEST_SUITE(PointStreamTest);
+    CPPUNIT_TEST(testInvalid);
+    CPPUNIT_TEST(testTransformFailure);
+    CPPUNIT_TEST(testMeasure);
+    CPPUNIT_TEST(testTransformMat4);
+    CPPUNIT_TEST(testTransformQuat);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(PointStreamTest::suite());
+    runner.run();
+    return 0;
+}
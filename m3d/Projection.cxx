@@ -0,0 +1,411 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <cmath>
+#include "m3d/Projection.h"
+using namespace std;
+namespace M3d {
+
+// HELPERS
+
+/*
+ * Writes a perspective projection and its inverse, given the nonzero elements of the projection.
+ *
+ * <pre>
+ * | a 0  c 0 |            | 1/a  0   0   c/a |
+ * | 0 b  d 0 |   inverse  |  0  1/b  0   d/b |
+ * | 0 0  e f |   ------>  |  0   0   0   -1  |
+ * | 0 0 -1 0 |            |  0   0  1/f  e/f |
+ * </pre>
+ */
+template <typename T>
+static void writeProjection(T a, T b, T c, T d, T e, T f, T mat[16], T inv[16]) {
+
+    for (int i = 0; i < 16; ++i) {
+        mat[i] = 0;
+        inv[i] = 0;
+    }
+
+    mat[0] = a;
+    mat[5] = b;
+    mat[8] = c;
+    mat[9] = d;
+    mat[10] = e;
+    mat[11] = -1;
+    mat[14] = f;
+
+    inv[0] = 1 / a;
+    inv[5] = 1 / b;
+    inv[11] = 1 / f;
+    inv[12] = c / a;
+    inv[13] = d / b;
+    inv[14] = -1;
+    inv[15] = e / f;
+}
+
+/*
+ * Writes an OpenGL frustum projection and its inverse.
+ */
+template <typename T>
+static void writeFrustum(T l, T r, T b, T t, T n, T f, T mat[16], T inv[16]) {
+    const T rl = r - l;
+    const T tb = t - b;
+    const T fn = f - n;
+    writeProjection<T>((2 * n) / rl, (2 * n) / tb, (r + l) / rl, (t + b) / tb, -(f + n) / fn, -(2 * f * n) / fn, mat, inv);
+}
+
+/*
+ * Writes a view matrix and its inverse.
+ *
+ * The view matrix is a rotation into the camera's basis followed by a translation, so the inverse is the transposed
+ * rotation followed by a translation to the eye.
+ */
+template <typename T>
+static void writeLookAt(const Vec3& eye, const Vec3& center, const Vec3& up, T mat[16], T inv[16]) {
+
+    const Vec3 f = normalize(center - eye);
+    const Vec3 s = normalize(cross(f, up));
+    const Vec3 u = cross(s, f);
+
+    mat[0] = (T) s.x;  mat[4] = (T) s.y;  mat[8] = (T) s.z;   mat[12] = (T) -dot(s, eye);
+    mat[1] = (T) u.x;  mat[5] = (T) u.y;  mat[9] = (T) u.z;   mat[13] = (T) -dot(u, eye);
+    mat[2] = (T) -f.x; mat[6] = (T) -f.y; mat[10] = (T) -f.z; mat[14] = (T) dot(f, eye);
+    mat[3] = 0;        mat[7] = 0;        mat[11] = 0;        mat[15] = 1;
+
+    inv[0] = (T) s.x;  inv[4] = (T) u.x;  inv[8] = (T) -f.x;  inv[12] = (T) eye.x;
+    inv[1] = (T) s.y;  inv[5] = (T) u.y;  inv[9] = (T) -f.y;  inv[13] = (T) eye.y;
+    inv[2] = (T) s.z;  inv[6] = (T) u.z;  inv[10] = (T) -f.z; inv[14] = (T) eye.z;
+    inv[3] = 0;        inv[7] = 0;        inv[11] = 0;        inv[15] = 1;
+}
+
+/*
+ * Writes an OpenGL orthographic projection and its inverse.
+ */
+template <typename T>
+static void writeOrtho(T l, T r, T b, T t, T n, T f, T mat[16], T inv[16]) {
+
+    const T rl = r - l;
+    const T tb = t - b;
+    const T fn = f - n;
+
+    for (int i = 0; i < 16; ++i) {
+        mat[i] = 0;
+        inv[i] = 0;
+    }
+
+    mat[0] = 2 / rl;
+    mat[5] = 2 / tb;
+    mat[10] = -2 / fn;
+    mat[12] = -(r + l) / rl;
+    mat[13] = -(t + b) / tb;
+    mat[14] = -(f + n) / fn;
+    mat[15] = 1;
+
+    inv[0] = rl / 2;
+    inv[5] = tb / 2;
+    inv[10] = -fn / 2;
+    inv[12] = (r + l) / 2;
+    inv[13] = (t + b) / 2;
+    inv[14] = -(f + n) / 2;
+    inv[15] = 1;
+}
+
+/*
+ * Computes the X and Y scale factors of a symmetric perspective projection.
+ */
+template <typename T>
+static void findScale(T fovy, T aspect, T& sx, T& sy) {
+    sy = 1 / tan(fovy / 2);
+    sx = sy / aspect;
+}
+
+/*
+ * Writes a symmetric perspective projection and its inverse.
+ */
+template <typename T>
+static void writePerspective(T fovy, T aspect, T n, T f, T mat[16], T inv[16]) {
+    T sx, sy;
+    findScale(fovy, aspect, sx, sy);
+    writeProjection<T>(sx, sy, 0, 0, -(f + n) / (f - n), -(2 * f * n) / (f - n), mat, inv);
+}
+
+/*
+ * Writes a symmetric perspective projection with the far plane at infinity, and its inverse.
+ */
+template <typename T>
+static void writePerspectiveInfinite(T fovy, T aspect, T n, T mat[16], T inv[16]) {
+    T sx, sy;
+    findScale(fovy, aspect, sx, sy);
+    writeProjection<T>(sx, sy, 0, 0, -1, -2 * n, mat, inv);
+}
+
+/*
+ * Writes a symmetric perspective projection with reversed depth, and its inverse.
+ */
+template <typename T>
+static void writePerspectiveReversed(T fovy, T aspect, T n, T f, T mat[16], T inv[16]) {
+    T sx, sy;
+    findScale(fovy, aspect, sx, sy);
+    writeProjection<T>(sx, sy, 0, 0, n / (f - n), (f * n) / (f - n), mat, inv);
+}
+
+/*
+ * Writes a symmetric perspective projection with reversed depth and the far plane at infinity, and its inverse.
+ */
+template <typename T>
+static void writePerspectiveInfiniteReversed(T fovy, T aspect, T n, T mat[16], T inv[16]) {
+    T sx, sy;
+    findScale(fovy, aspect, sx, sy);
+    writeProjection<T>(sx, sy, 0, 0, 0, n, mat, inv);
+}
+
+/*
+ * Copies column-major arrays into a matrix and its inverse.
+ */
+static void copy(const double arr[16], const double invArr[16], Mat4& mat, Mat4& inv) {
+    mat = Mat4::fromArrayInColumnMajor(arr);
+    inv = Mat4::fromArrayInColumnMajor(invArr);
+}
+
+// FUNCTIONS
+
+/**
+ * Makes a perspective projection from the planes of a view volume, like `glFrustum`.
+ *
+ * @param left Position of left clipping plane at near plane
+ * @param right Position of right clipping plane at near plane
+ * @param bottom Position of bottom clipping plane at near plane
+ * @param top Position of top clipping plane at near plane
+ * @param zNear Distance to near clipping plane, which must be positive
+ * @param zFar Distance to far clipping plane, which must be greater than near
+ * @param mat Matrix to store projection in
+ * @param inv Matrix to store inverse of projection in
+ */
+void frustum(double left, double right, double bottom, double top, double zNear, double zFar, Mat4& mat, Mat4& inv) {
+    double arr[16], invArr[16];
+    writeFrustum(left, right, bottom, top, zNear, zFar, arr, invArr);
+    copy(arr, invArr, mat, inv);
+}
+
+/**
+ * Makes a perspective projection from the planes of a view volume in single precision, like `glFrustum`.
+ *
+ * @param left Position of left clipping plane at near plane
+ * @param right Position of right clipping plane at near plane
+ * @param bottom Position of bottom clipping plane at near plane
+ * @param top Position of top clipping plane at near plane
+ * @param zNear Distance to near clipping plane, which must be positive
+ * @param zFar Distance to far clipping plane, which must be greater than near
+ * @param mat Array to store projection in, in column-major order
+ * @param inv Array to store inverse of projection in, in column-major order
+ */
+void frustum(float left, float right, float bottom, float top, float zNear, float zFar, float mat[16], float inv[16]) {
+    writeFrustum(left, right, bottom, top, zNear, zFar, mat, inv);
+}
+
+/**
+ * Makes a view matrix for a camera looking at a point, like `gluLookAt`.
+ *
+ * @param eye Position of the camera
+ * @param center Point the camera is looking at
+ * @param up Direction that should point up in the view, which must not be parallel to the view direction
+ * @param mat Matrix to store view matrix in
+ * @param inv Matrix to store inverse of view matrix in
+ */
+void lookAt(const Vec3& eye, const Vec3& center, const Vec3& up, Mat4& mat, Mat4& inv) {
+    double arr[16], invArr[16];
+    writeLookAt(eye, center, up, arr, invArr);
+    copy(arr, invArr, mat, inv);
+}
+
+/**
+ * Makes a view matrix for a camera looking at a point in single precision, like `gluLookAt`.
+ *
+ * The camera's basis is computed in double precision before being rounded.
+ *
+ * @param eye Position of the camera
+ * @param center Point the camera is looking at
+ * @param up Direction that should point up in the view, which must not be parallel to the view direction
+ * @param mat Array to store view matrix in, in column-major order
+ * @param inv Array to store inverse of view matrix in, in column-major order
+ */
+void lookAt(const Vec3& eye, const Vec3& center, const Vec3& up, float mat[16], float inv[16]) {
+    writeLookAt(eye, center, up, mat, inv);
+}
+
+/**
+ * Makes an orthographic projection, like `glOrtho`.
+ *
+ * @param left Position of left clipping plane
+ * @param right Position of right clipping plane
+ * @param bottom Position of bottom clipping plane
+ * @param top Position of top clipping plane
+ * @param zNear Distance to near clipping plane
+ * @param zFar Distance to far clipping plane
+ * @param mat Matrix to store projection in
+ * @param inv Matrix to store inverse of projection in
+ */
+void ortho(double left, double right, double bottom, double top, double zNear, double zFar, Mat4& mat, Mat4& inv) {
+    double arr[16], invArr[16];
+    writeOrtho(left, right, bottom, top, zNear, zFar, arr, invArr);
+    copy(arr, invArr, mat, inv);
+}
+
+/**
+ * Makes an orthographic projection in single precision, like `glOrtho`.
+ *
+ * @param left Position of left clipping plane
+ * @param right Position of right clipping plane
+ * @param bottom Position of bottom clipping plane
+ * @param top Position of top clipping plane
+ * @param zNear Distance to near clipping plane
+ * @param zFar Distance to far clipping plane
+ * @param mat Array to store projection in, in column-major order
+ * @param inv Array to store inverse of projection in, in column-major order
+ */
+void ortho(float left, float right, float bottom, float top, float zNear, float zFar, float mat[16], float inv[16]) {
+    writeOrtho(left, right, bottom, top, zNear, zFar, mat, inv);
+}
+
+/**
+ * Makes a symmetric perspective projection, like `gluPerspective`.
+ *
+ * @param fovy Vertical field of view in radians
+ * @param aspect Width of the view divided by its height
+ * @param zNear Distance to near clipping plane, which must be positive
+ * @param zFar Distance to far clipping plane, which must be greater than near
+ * @param mat Matrix to store projection in
+ * @param inv Matrix to store inverse of projection in
+ */
+void perspective(double fovy, double aspect, double zNear, double zFar, Mat4& mat, Mat4& inv) {
+    double arr[16], invArr[16];
+    writePerspective(fovy, aspect, zNear, zFar, arr, invArr);
+    copy(arr, invArr, mat, inv);
+}
+
+/**
+ * Makes a symmetric perspective projection in single precision, like `gluPerspective`.
+ *
+ * @param fovy Vertical field of view in radians
+ * @param aspect Width of the view divided by its height
+ * @param zNear Distance to near clipping plane, which must be positive
+ * @param zFar Distance to far clipping plane, which must be greater than near
+ * @param mat Array to store projection in, in column-major order
+ * @param inv Array to store inverse of projection in, in column-major order
+ */
+void perspective(float fovy, float aspect, float zNear, float zFar, float mat[16], float inv[16]) {
+    writePerspective(fovy, aspect, zNear, zFar, mat, inv);
+}
+
+/**
+ * Makes a symmetric perspective projection with the far plane at infinity.
+ *
+ * @param fovy Vertical field of view in radians
+ * @param aspect Width of the view divided by its height
+ * @param zNear Distance to near clipping plane, which must be positive
+ * @param mat Matrix to store projection in
+ * @param inv Matrix to store inverse of projection in
+ */
+void perspectiveInfinite(double fovy, double aspect, double zNear, Mat4& mat, Mat4& inv) {
+    double arr[16], invArr[16];
+    writePerspectiveInfinite(fovy, aspect, zNear, arr, invArr);
+    copy(arr, invArr, mat, inv);
+}
+
+/**
+ * Makes a symmetric perspective projection with the far plane at infinity in single precision.
+ *
+ * @param fovy Vertical field of view in radians
+ * @param aspect Width of the view divided by its height
+ * @param zNear Distance to near clipping plane, which must be positive
+ * @param mat Array to store projection in, in column-major order
+ * @param inv Array to store inverse of projection in, in column-major order
+ */
+void perspectiveInfinite(float fovy, float aspect, float zNear, float mat[16], float inv[16]) {
+    writePerspectiveInfinite(fovy, aspect, zNear, mat, inv);
+}
+
+/**
+ * Makes a symmetric perspective projection that maps the near plane to a depth of one and the far plane to zero.
+ *
+ * @param fovy Vertical field of view in radians
+ * @param aspect Width of the view divided by its height
+ * @param zNear Distance to near clipping plane, which must be positive
+ * @param zFar Distance to far clipping plane, which must be greater than near
+ * @param mat Matrix to store projection in
+ * @param inv Matrix to store inverse of projection in
+ */
+void perspectiveReversed(double fovy, double aspect, double zNear, double zFar, Mat4& mat, Mat4& inv) {
+    double arr[16], invArr[16];
+    writePerspectiveReversed(fovy, aspect, zNear, zFar, arr, invArr);
+    copy(arr, invArr, mat, inv);
+}
+
+/**
+ * Makes a symmetric perspective projection that maps the near plane to a depth of one and the far plane to zero in
+ * single precision.
+ *
+ * @param fovy Vertical field of view in radians
+ * @param aspect Width of the view divided by its height
+ * @param zNear Distance to near clipping plane, which must be positive
+ * @param zFar Distance to far clipping plane, which must be greater than near
+ * @param mat Array to store projection in, in column-major order
+ * @param inv Array to store inverse of projection in, in column-major order
+ */
+void perspectiveReversed(float fovy, float aspect, float zNear, float zFar, float mat[16], float inv[16]) {
+    writePerspectiveReversed(fovy, aspect, zNear, zFar, mat, inv);
+}
+
+/**
+ * Makes a symmetric perspective projection that maps the near plane to a depth of one and infinity to zero.
+ *
+ * @param fovy Vertical field of view in radians
+ * @param aspect Width of the view divided by its height
+ * @param zNear Distance to near clipping plane, which must be positive
+ * @param mat Matrix to store projection in
+ * @param inv Matrix to store inverse of projection in
+ */
+void perspectiveInfiniteReversed(double fovy, double aspect, double zNear, Mat4& mat, Mat4& inv) {
+    double arr[16], invArr[16];
+    writePerspectiveInfiniteReversed(fovy, aspect, zNear, arr, invArr);
+    copy(arr, invArr, mat, inv);
+}
+
+/**
+ * Makes a symmetric perspective projection that maps the near plane to a depth of one and infinity to zero in single
+ * precision.
+ *
+ * @param fovy Vertical field of view in radians
+ * @param aspect Width of the view divided by its height
+ * @param zNear Distance to near clipping plane, which must be positive
+ * @param mat Array to store projection in, in column-major order
+ * @param inv Array to store inverse of projection in, in column-major order
+ */
+void perspectiveInfiniteReversed(float fovy, float aspect, float zNear, float mat[16], float inv[16]) {
+    writePerspectiveInfiniteReversed(fovy, aspect, zNear, mat, inv);
+}
+
+} /* namespace M3d */
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_PROJECTION_H
+#define M3D_PROJECTION_H
+#include "m3d/common.h"
+#include "m3d/Mat4.h"
+#include "m3d/Vec3.h"
+namespace M3d {
+
+/*
+ * Projection and view builders.
+ *
+ * Each builder writes a matrix and its exact inverse together, using closed forms instead of a general inversion.  The
+ * `Mat4` versions work in double precision, and the array versions work in single precision and write column-major
+ * arrays ready for OpenGL.
+ *
+ * Unless noted otherwise, projections follow the OpenGL conventions of a camera looking down the negative Z axis and
+ * depth in [-1 .. 1].  The reversed variants instead map the near plane to one and the far plane to zero, for use with
+ * a depth range of [0 .. 1] (e.g. `glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE)`).
+ */
+void frustum(double left, double right, double bottom, double top, double zNear, double zFar, Mat4& mat, Mat4& inv);
+void frustum(float left, float right, float bottom, float top, float zNear, float zFar, float mat[16], float inv[16]);
+void lookAt(const Vec3& eye, const Vec3& center, const Vec3& up, Mat4& mat, Mat4& inv);
+void lookAt(const Vec3& eye, const Vec3& center, const Vec3& up, float mat[16], float inv[16]);
+void ortho(double left, double right, double bottom, double top, double zNear, double zFar, Mat4& mat, Mat4& inv);
+void ortho(float left, float right, float bottom, float top, float zNear, float zFar, float mat[16], float inv[16]);
+void perspective(double fovy, double aspect, double zNear, double zFar, Mat4& mat, Mat4& inv);
+void perspective(float fovy, float aspect, float zNear, float zFar, float mat[16], float inv[16]);
+void perspectiveInfinite(double fovy, double aspect, double zNear, Mat4& mat, Mat4& inv);
+void perspectiveInfinite(float fovy, float aspect, float zNear, float mat[16], float inv[16]);
+void perspectiveReversed(double fovy, double aspect, double zNear, double zFar, Mat4& mat, Mat4& inv);
+void perspectiveReversed(float fovy, float aspect, float zNear, float zFar, float mat[16], float inv[16]);
+void perspectiveInfiniteReversed(double fovy, double aspect, double zNear, Mat4& mat, Mat4& inv);
+void perspectiveInfiniteReversed(float fovy, float aspect, float zNear, float mat[16], float inv[16]);
+
+} /* namespace M3d */
+#endif
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/Math.h"
+#include "m3d/Projection.h"
+using namespace std;
+
+/*
+ * Constants
+ */
+const double TOLERANCE = 1e-9;
+const float TOLERANCE_FLOAT = 1e-5;
+
+
+/**
+ * Unit test for Projection.
+ */
+class ProjectionTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Checks that the product of a matrix and its inverse is the identity.
+     */
+    static void assertInverse(const M3d::Mat4& mat, const M3d::Mat4& inv, double tolerance = TOLERANCE) {
+        const M3d::Mat4 product = mat * inv;
+        for (int j = 0; j < 4; ++j) {
+            for (int i = 0; i < 4; ++i) {
+                CPPUNIT_ASSERT_DOUBLES_EQUAL((i == j) ? 1.0 : 0.0, product[j][i], tolerance);
+            }
+        }
+    }
+
+    /**
+     * Checks that the product of a column-major array and its inverse is the identity.
+     */
+    static void assertInverse(const float mat[16], const float inv[16]) {
+        const M3d::Mat4 m = M3d::Mat4::fromArrayInColumnMajor(mat);
+        const M3d::Mat4 n = M3d::Mat4::fromArrayInColumnMajor(inv);
+        assertInverse(m, n, TOLERANCE_FLOAT);
+    }
+
+    /**
+     * Projects a point in eye space and returns its depth in normalized device coordinates.
+     */
+    static double findDepth(const M3d::Mat4& mat, double z) {
+        const M3d::Vec4 clip = mat * M3d::Vec4(0, 0, z, 1);
+        return clip.z / clip.w;
+    }
+
+public:
+
+    /**
+     * Ensures frustum matches the matrix documented for `glFrustum`.
+     */
+    void testFrustum() {
+        M3d::Mat4 mat, inv;
+        M3d::frustum(-1.0, 3.0, -2.0, 2.0, 1.0, 11.0, mat, inv);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, mat[0][0], TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, mat[1][1], TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, mat[2][0], TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, mat[2][1], TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(-1.2, mat[2][2], TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(-1.0, mat[2][3], TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(-2.2, mat[3][2], TOLERANCE);
+        assertInverse(mat, inv);
+    }
+
+    /**
+     * Ensures the single-precision frustum matches the double-precision one.
+     */
+    void testFrustumFloat() {
+        M3d::Mat4 mat, inv;
+        float arr[16], invArr[16];
+        M3d::frustum(-1.0, 3.0, -2.0, 2.0, 1.0, 11.0, mat, inv);
+        M3d::frustum(-1.0f, 3.0f, -2.0f, 2.0f, 1.0f, 11.0f, arr, invArr);
+        for (int i = 0; i < 16; ++i) {
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(mat[i / 4][i % 4], arr[i], TOLERANCE_FLOAT);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(inv[i / 4][i % 4], invArr[i], TOLERANCE_FLOAT);
+        }
+        assertInverse(arr, invArr);
+    }
+
+    /**
+     * Ensures lookAt moves the eye to the origin and the view direction to the negative Z axis.
+     */
+    void testLookAt() {
+        M3d::Mat4 mat, inv;
+        M3d::lookAt(M3d::Vec3(1, 2, 3), M3d::Vec3(1, 2, -7), M3d::Vec3(0, 1, 0), mat, inv);
+        const M3d::Vec4 eye = mat * M3d::Vec4(1, 2, 3, 1);
+        const M3d::Vec4 center = mat * M3d::Vec4(1, 2, -7, 1);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, eye.x, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, eye.y, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, eye.z, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(-10.0, center.z, TOLERANCE);
+        assertInverse(mat, inv);
+    }
+
+    /**
+     * Ensures the inverse of a rotated view matrix is correct.
+     */
+    void testLookAtRotated() {
+        M3d::Mat4 mat, inv;
+        float arr[16], invArr[16];
+        M3d::lookAt(M3d::Vec3(4, -2, 5), M3d::Vec3(-1, 3, 0), M3d::Vec3(0, 0, 1), mat, inv);
+        M3d::lookAt(M3d::Vec3(4, -2, 5), M3d::Vec3(-1, 3, 0), M3d::Vec3(0, 0, 1), arr, invArr);
+        assertInverse(mat, inv);
+        assertInverse(arr, invArr);
+    }
+
+    /**
+     * Ensures ortho maps the view volume to the unit cube.
+     */
+    void testOrtho() {
+        M3d::Mat4 mat, inv;
+        M3d::ortho(-2.0, 6.0, -1.0, 3.0, 1.0, 5.0, mat, inv);
+        const M3d::Vec4 corner = mat * M3d::Vec4(6, 3, -5, 1);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, corner.x, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, corner.y, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, corner.z, TOLERANCE);
+        assertInverse(mat, inv);
+
+        float arr[16], invArr[16];
+        M3d::ortho(-2.0f, 6.0f, -1.0f, 3.0f, 1.0f, 5.0f, arr, invArr);
+        assertInverse(arr, invArr);
+    }
+
+    /**
+     * Ensures perspective maps the near and far planes to the ends of the depth range.
+     */
+    void testPerspective() {
+        M3d::Mat4 mat, inv;
+        M3d::perspective(M3d::toRadians(60), 1.5, 0.5, 100.0, mat, inv);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(-1.0, findDepth(mat, -0.5), TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, findDepth(mat, -100), TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1 / tan(M3d::toRadians(30)), mat[1][1], TOLERANCE);
+        assertInverse(mat, inv);
+
+        float arr[16], invArr[16];
+        M3d::perspective((float) M3d::toRadians(60), 1.5f, 0.5f, 100.0f, arr, invArr);
+        assertInverse(arr, invArr);
+    }
+
+    /**
+     * Ensures the infinite perspective maps the near plane to -1 and approaches +1 far away.
+     */
+    void testPerspectiveInfinite() {
+        M3d::Mat4 mat, inv;
+        M3d::perspectiveInfinite(M3d::toRadians(60), 1.5, 0.5, mat, inv);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(-1.0, findDepth(mat, -0.5), TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, findDepth(mat, -1e9), 1e-6);
+        assertInverse(mat, inv);
+
+        float arr[16], invArr[16];
+        M3d::perspectiveInfinite((float) M3d::toRadians(60), 1.5f, 0.5f, arr, invArr);
+        assertInverse(arr, invArr);
+    }
+
+    /**
+     * Ensures the reversed perspective maps the near plane to one and the far plane to zero.
+     */
+    void testPerspectiveReversed() {
+        M3d::Mat4 mat, inv;
+        M3d::perspectiveReversed(M3d::toRadians(60), 1.5, 0.5, 100.0, mat, inv);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, findDepth(mat, -0.5), TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, findDepth(mat, -100), TOLERANCE);
+        assertInverse(mat, inv);
+
+        float arr[16], invArr[16];
+        M3d::perspectiveReversed((float) M3d::toRadians(60), 1.5f, 0.5f, 100.0f, arr, invArr);
+        assertInverse(arr, invArr);
+    }
+
+    /**
+     * Ensures the infinite reversed perspective maps the near plane to one and approaches zero far away.
+     */
+    void testPerspectiveInfiniteReversed() {
+        M3d::Mat4 mat, inv;
+        M3d::perspectiveInfiniteReversed(M3d::toRadians(60), 1.5, 0.5, mat, inv);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, findDepth(mat, -0.5), TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, findDepth(mat, -1e9), 1e-6);
+        assertInverse(mat, inv);
+
+        float arr[16], invArr[16];
+        M3d::perspectiveInfiniteReversed((float) M3d::toRadians(60), 1.5f, 0.5f, arr, invArr);
+        assertInverse(arr, invArr);
+    }
+
+    CPPUNIT_TEST_SUITE(ProjectionTest);
+    CPPUNIT_TEST(testFrustum);
+    CPPUNIT_TEST(testFrustumFloat);
+    CPPUNIT_TEST(testLookAt);
+    CPPUNIT_TEST(testLookAtRotated);
+    CPPUNIT_TEST(testOrtho);
+    CPPUNIT_TEST(testPerspective);
+    CPPUNIT_TEST(testPerspectiveInfinite);
+    CPPUNIT_TEST(testPerspectiveReversed);
+    CPPUNIT_TEST(testPerspectiveInfiniteReversed);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(ProjectionTest::suite());
+    runner.run();
+    return 0;
+}
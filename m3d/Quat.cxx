@@ -126,6 +126,40 @@ Quat Quat::identity() {
     return Quat(0, 0, 0, 1);
 }
 
+/**
+ * Writes the quaternion as text, the same way as `toString`, without allocating memory.
+ *
+ * Each component is written with the fewest digits that read back as exactly the same number.
+ *
+ * @param buf Buffer to write into, ended with a null character and cut short if too small
+ * @param size Number of characters the buffer can hold, where `FORMAT_SIZE` is always enough
+ * @return Length of the text, which is more than was written if the buffer was too small
+ */
+size_t Quat::formatTo(char* buf, size_t size) const {
+    char text[FORMAT_SIZE];
+    const double values[4] = { x, y, z, w };
+    return Format::copy(text, Format::formatList(text, values, 4), buf, size);
+}
+
+/**
+ * Reads a quaternion from text written by `formatTo` or `toString`.
+ *
+ * @param text Text to read from, where whitespace is allowed before and between tokens
+ * @param q Quaternion to store the result in, unchanged if the text is malformed
+ * @return Position after the quaternion, or `NULL` if the text does not start with one
+ */
+const char* Quat::parse(const char* text, Quat& q) {
+    double values[4];
+    text = Format::parseList(text, values, 4);
+    if (text != NULL) {
+        q.x = values[0];
+        q.y = values[1];
+        q.z = values[2];
+        q.w = values[3];
+    }
+    return text;
+}
+
 /**
  * Checks if the quaternion is the identity quaternion.
  *
@@ -308,9 +342,8 @@ Mat4 Quat::toMat4() const {
  * Returns a string representation of the quaternion.
  */
 string Quat::toString() const {
-    stringstream stream;
-    stream << (*this);
-    return stream.str();
+    char text[FORMAT_SIZE];
+    return string(text, formatTo(text, FORMAT_SIZE));
 }
 
 // FRIENDS
@@ -361,11 +394,9 @@ Quat normalize(const Quat& q) {
 } /* namespace M3d */
 
 ostream& operator<<(ostream& stream, const M3d::Quat& q) {
-    stream << "[";
-    stream << q.x << ", ";
-    stream << q.y << ", ";
-    stream << q.z << ", ";
-    stream << q.w;
-    stream << "]";
-    return stream;
+    if (!M3d::Format::isDefault(stream)) {
+        return stream << "[" << q.x << ", " << q.y << ", " << q.z << ", " << q.w << "]";
+    }
+    char text[M3d::Quat::FORMAT_SIZE];
+    return stream.write(text, q.formatTo(text, sizeof(text)));
 }
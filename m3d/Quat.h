@@ -40,6 +40,8 @@ namespace M3d {
  */
 class Quat {
 public:
+// Constants
+    static const size_t FORMAT_SIZE = 107; ///< Characters needed to format any quaternion, including the null character
 // Attributes
     double x; ///< First component of quaternion's vector part
     double y; ///< Second component of quaternion's vector part
@@ -52,6 +54,8 @@ public:
     static Quat fromMat3(const Mat3& m);
     static Quat fromMat4(const Mat4& m);
     static Quat identity();
+    static const char* parse(const char* text, Quat& q);
+    size_t formatTo(char* buf, size_t size) const;
     bool isIdentity() const;
     bool isInfinite() const;
     bool isNaN() const;
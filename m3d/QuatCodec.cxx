@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "m3d/QuatCodec.h"
+using namespace std;
+namespace M3d {
+
+
+/*
+ * Task decoding a range of codes stored as bytes.
+ */
+class QuatCodec::DecodeTask : public ParallelTask {
+public:
+    DecodeTask(const unsigned char* codes, Format format, Quat* quats)
+            : codes(codes), format(format), bytes(countBytes(format)), quats(quats) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const unsigned char* const code = codes + (i * bytes);
+            uint64_t value = 0;
+            for (size_t b = 0; b < bytes; ++b) {
+                value |= ((uint64_t) code[b]) << (8 * b);
+            }
+            quats[i] = decode(value, format);
+        }
+    }
+private:
+    const unsigned char* codes;
+    Format format;
+    size_t bytes;
+    Quat* quats;
+};
+
+
+/*
+ * Task encoding a range of quaternions as bytes.
+ */
+class QuatCodec::EncodeTask : public ParallelTask {
+public:
+    EncodeTask(const Quat* quats, Format format, unsigned char* codes)
+            : quats(quats), format(format), bytes(countBytes(format)), codes(codes) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const uint64_t value = encode(quats[i], format);
+            unsigned char* const code = codes + (i * bytes);
+            for (size_t b = 0; b < bytes; ++b) {
+                code[b] = (unsigned char) (value >> (8 * b));
+            }
+        }
+    }
+private:
+    const Quat* quats;
+    Format format;
+    size_t bytes;
+    unsigned char* codes;
+};
+
+// METHODS
+
+/**
+ * Returns the number of bits in each of the three stored components of a code.
+ *
+ * @throws invalid_argument if the format is unknown
+ */
+int QuatCodec::countBits(Format format) {
+    switch (format) {
+    case QUAT32:
+        return 10;
+    case QUAT48:
+        return 15;
+    case QUAT64:
+        return 20;
+    default:
+        throw invalid_argument("[QuatCodec] Unknown format!");
+    }
+}
+
+/**
+ * Returns the number of bytes each code takes in a batch.
+ *
+ * @throws invalid_argument if the format is unknown
+ */
+size_t QuatCodec::countBytes(Format format) {
+    return (2 + (3 * countBits(format)) + 7) / 8;
+}
+
+/**
+ * Decodes a rotation.
+ *
+ * @param code Code from `encode`
+ * @param format Layout of the code
+ * @return Unit quaternion with a non-negative largest component
+ * @throws invalid_argument if the format is unknown
+ */
+Quat QuatCodec::decode(uint64_t code, Format format) {
+
+    const int bits = countBits(format);
+    const uint64_t mask = (((uint64_t) 1) << bits) - 1;
+    const int64_t zero = ((int64_t) 1) << (bits - 1);
+    const double scale = 1 / ((zero - 1) * SQRT_TWO);
+
+    // Unpack the three smallest components and find the largest
+    const int largest = (int) (code & 3);
+    double components[4];
+    double sum = 0;
+    for (int i = 0, j = 0; i < 4; ++i) {
+        if (i != largest) {
+            components[i] = (((int64_t) ((code >> (2 + (j * bits))) & mask)) - zero) * scale;
+            sum += components[i] * components[i];
+            ++j;
+        }
+    }
+    components[largest] = sqrt(std::max(1 - sum, 0.0));
+
+    // Normalize, since rounding may have moved it off the sphere
+    const double length = sqrt(sum + (components[largest] * components[largest]));
+    return Quat(components[0] / length, components[1] / length, components[2] / length, components[3] / length);
+}
+
+/**
+ * Decodes a batch of rotations on several threads.
+ *
+ * @param codes Codes from `encode`, each `countBytes(format)` bytes in little-endian order
+ * @param count Number of codes
+ * @param format Layout of the codes
+ * @param quats Array with room for the rotations
+ * @throws invalid_argument if the format is unknown
+ */
+void QuatCodec::decode(const void* codes, size_t count, Format format, Quat* quats) {
+    countBits(format);
+    DecodeTask task(static_cast<const unsigned char*>(codes), format, quats);
+    Parallel::run(task, count, GRAIN_SIZE);
+}
+
+/**
+ * Encodes a rotation.
+ *
+ * @param quat Rotation to encode, which is normalized first, and which is taken as the identity if it is zero or not
+ *        finite
+ * @param format Layout of the code
+ * @return Code for the rotation
+ * @throws invalid_argument if the format is unknown
+ */
+uint64_t QuatCodec::encode(const Quat& quat, Format format) {
+
+    const int bits = countBits(format);
+    const double length = sqrt((quat.x * quat.x) + (quat.y * quat.y) + (quat.z * quat.z) + (quat.w * quat.w));
+    if (!(length > 0) || !(length < HUGE_VAL)) {
+        return encode(Quat::identity(), format);
+    }
+
+    // Find the largest component
+    const double components[4] = { quat.x / length, quat.y / length, quat.z / length, quat.w / length };
+    int largest = 0;
+    for (int i = 1; i < 4; ++i) {
+        if (fabs(components[i]) > fabs(components[largest])) {
+            largest = i;
+        }
+    }
+    const double sign = (components[largest] < 0) ? -1 : 1;
+
+    // Pack the others after its index
+    const int64_t zero = ((int64_t) 1) << (bits - 1);
+    const double scale = zero - 1;
+    uint64_t code = (uint64_t) largest;
+    for (int i = 0, j = 0; i < 4; ++i) {
+        if (i != largest) {
+            const double value = std::min(std::max(components[i] * sign * SQRT_TWO, -1.0), 1.0);
+            code |= ((uint64_t) (((int64_t) floor((value * scale) + 0.5)) + zero)) << (2 + (j * bits));
+            ++j;
+        }
+    }
+    return code;
+}
+
+/**
+ * Encodes a batch of rotations on several threads.
+ *
+ * @param quats Rotations to encode, which are normalized first
+ * @param count Number of rotations
+ * @param format Layout of the codes
+ * @param codes Buffer with room for `countBytes(format)` bytes per rotation, stored in little-endian order
+ * @throws invalid_argument if the format is unknown
+ */
+void QuatCodec::encode(const Quat* quats, size_t count, Format format, void* codes) {
+    countBits(format);
+    EncodeTask task(quats, format, static_cast<unsigned char*>(codes));
+    Parallel::run(task, count, GRAIN_SIZE);
+}
+
+} /* namespace M3d */
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_QUATCODEC_H
+#define M3D_QUATCODEC_H
+#include "m3d/common.h"
+#include <stdint.h>
+#include "m3d/Math.h"
+#include "m3d/Parallel.h"
+#include "m3d/Quat.h"
+namespace M3d {
+
+
+/**
+ * Utility for compressing rotations into four, six or eight bytes with the "smallest three" encoding.
+ *
+ * A unit quaternion and its negation are the same rotation, so the quaternion is flipped to make its largest component
+ * positive.  The largest component can then be found again from the other three, and is left out.  The code stores
+ * the index of the largest component in its lowest two bits, followed by the other three components in order.  Each is
+ * quantized over [-1/sqrt(2) .. 1/sqrt(2)], which is as far as they can go, with zero stored exactly.
+ *
+ * Formats use 10, 15 or 20 bits per component.  Angles between an encoded rotation and its decoded rotation are at
+ * most about 0.25, 0.008 and 0.00025 degrees respectively.  Batches are stored in little-endian order, so files of
+ * codes can be shared between machines.
+ */
+class QuatCodec {
+public:
+// Types
+    /** Layout of a code */
+    enum Format {
+        QUAT32, ///< 10 bits per component in 32 bits
+        QUAT48, ///< 15 bits per component in 48 bits, with the top bit zero
+        QUAT64 ///< 20 bits per component in 64 bits, with the top two bits zero
+    };
+// Methods
+    static int countBits(Format format);
+    static size_t countBytes(Format format);
+    static Quat decode(uint64_t code, Format format);
+    static void decode(const void* codes, size_t count, Format format, Quat* quats);
+    static uint64_t encode(const Quat& quat, Format format);
+    static void encode(const Quat* quats, size_t count, Format format, void* codes);
+private:
+// Types
+    class DecodeTask;
+    class EncodeTask;
+// Constants
+    static const size_t GRAIN_SIZE = 16384;
+};
+
+} /* namespace M3d */
+#endif
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/QuatCodec.h"
+using namespace std;
+
+
+/**
+ * Unit test for QuatCodec.
+ */
+class QuatCodecTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + ((upper - lower) * rand() / RAND_MAX);
+    }
+
+    /**
+     * Makes random rotations, not all of unit length.
+     */
+    static vector<M3d::Quat> makeQuats(size_t size) {
+        vector<M3d::Quat> quats(size);
+        for (size_t i = 0; i < size; ++i) {
+            M3d::Vec3 axis(random(-1, 1), random(-1, 1), random(-1, 1));
+            quats[i] = M3d::Quat::fromAxisAngle(normalize(axis), random(-M3d::PI, M3d::PI));
+            if ((i % 2) == 0) {
+                quats[i] = -quats[i];
+            } else if ((i % 3) == 0) {
+                quats[i] = M3d::Quat(quats[i].x * 3, quats[i].y * 3, quats[i].z * 3, quats[i].w * 3);
+            }
+        }
+        return quats;
+    }
+
+    /**
+     * Returns the angle in degrees of the rotation between two unit quaternions.
+     */
+    static double findAngle(const M3d::Quat& a, const M3d::Quat& b) {
+        const double cosine = fabs((a.x * b.x) + (a.y * b.y) + (a.z * b.z) + (a.w * b.w));
+        return M3d::toDegrees(2 * acos(std::min(cosine, 1.0)));
+    }
+
+    /**
+     * Finds the largest angle between rotations and their decoded codes.
+     */
+    static double findMaxError(const vector<M3d::Quat>& quats, M3d::QuatCodec::Format format) {
+        double maxError = 0;
+        for (size_t i = 0; i < quats.size(); ++i) {
+            const M3d::Quat expected = normalize(quats[i]);
+            const M3d::Quat actual = M3d::QuatCodec::decode(M3d::QuatCodec::encode(quats[i], format), format);
+            CPPUNIT_ASSERT(fabs(magnitude(actual) - 1) < 1e-12);
+            maxError = std::max(maxError, findAngle(expected, actual));
+        }
+        return maxError;
+    }
+
+public:
+
+    /**
+     * Resets the number of threads.
+     */
+    void tearDown() {
+        M3d::Parallel::setConcurrency(0);
+    }
+
+    /**
+     * Ensures codes fit in their bytes and special rotations come back exactly.
+     */
+    void testEncode() {
+        const M3d::QuatCodec::Format formats[3] = { M3d::QuatCodec::QUAT32, M3d::QuatCodec::QUAT48,
+                                                    M3d::QuatCodec::QUAT64 };
+        const size_t bytes[3] = { 4, 6, 8 };
+        for (int f = 0; f < 3; ++f) {
+            CPPUNIT_ASSERT_EQUAL(bytes[f], M3d::QuatCodec::countBytes(formats[f]));
+            const M3d::Quat identity = M3d::Quat::identity();
+            const M3d::Quat flipped(0, -1, 0, 0);
+            const uint64_t same = M3d::QuatCodec::encode(identity, formats[f]);
+            const uint64_t negated = M3d::QuatCodec::encode(flipped, formats[f]);
+            CPPUNIT_ASSERT(identity == M3d::QuatCodec::decode(same, formats[f]));
+            CPPUNIT_ASSERT(-flipped == M3d::QuatCodec::decode(negated, formats[f]));
+            const uint64_t zero = M3d::QuatCodec::encode(M3d::Quat(0, 0, 0, 0), formats[f]);
+            CPPUNIT_ASSERT(identity == M3d::QuatCodec::decode(zero, formats[f]));
+            for (int i = 0; i < 100; ++i) {
+                const M3d::Quat q(random(-1, 1), random(-1, 1), random(-1, 1), random(-1, 1));
+                const uint64_t code = M3d::QuatCodec::encode(q, formats[f]);
+                CPPUNIT_ASSERT((bytes[f] == 8) || ((code >> (8 * bytes[f])) == 0));
+                CPPUNIT_ASSERT((code >> 62) == 0);
+            }
+        }
+        CPPUNIT_ASSERT_THROW(M3d::QuatCodec::encode(M3d::Quat::identity(), (M3d::QuatCodec::Format) 5),
+                             invalid_argument);
+    }
+
+    /**
+     * Ensures decoded rotations are within the documented angles of the originals.
+     */
+    void testPrecision() {
+        const vector<M3d::Quat> quats = makeQuats(200000);
+        const double quat32 = findMaxError(quats, M3d::QuatCodec::QUAT32);
+        const double quat48 = findMaxError(quats, M3d::QuatCodec::QUAT48);
+        const double quat64 = findMaxError(quats, M3d::QuatCodec::QUAT64);
+        CPPUNIT_ASSERT(quat32 < 0.25);
+        CPPUNIT_ASSERT(quat48 < 0.008);
+        CPPUNIT_ASSERT(quat64 < 0.00025);
+    }
+
+    /**
+     * Ensures batches match single rotations, stored in little-endian order.
+     */
+    void testBatch() {
+        const vector<M3d::Quat> quats = makeQuats(50001);
+        M3d::Parallel::setConcurrency(4);
+        vector<unsigned char> codes(6 * quats.size());
+        M3d::QuatCodec::encode(&quats[0], quats.size(), M3d::QuatCodec::QUAT48, &codes[0]);
+        for (size_t i = 0; i < quats.size(); ++i) {
+            uint64_t stored = 0;
+            for (int b = 0; b < 6; ++b) {
+                stored |= ((uint64_t) codes[(6 * i) + b]) << (8 * b);
+            }
+            CPPUNIT_ASSERT_EQUAL(M3d::QuatCodec::encode(quats[i], M3d::QuatCodec::QUAT48), stored);
+        }
+
+        vector<M3d::Quat> decoded(quats.size());
+        M3d::QuatCodec::decode(&codes[0], quats.size(), M3d::QuatCodec::QUAT48, &decoded[0]);
+        for (size_t i = 0; i < quats.size(); ++i) {
+            const uint64_t code = M3d::QuatCodec::encode(quats[i], M3d::QuatCodec::QUAT48);
+            CPPUNIT_ASSERT(M3d::QuatCodec::decode(code, M3d::QuatCodec::QUAT48) == decoded[i]);
+        }
+    }
+
+    CPPUNIT_TEST_SUITE(QuatCodecTest);
+    CPPUNIT_TEST(testBatch);
+    CPPUNIT_TEST(testEncode);
+    CPPUNIT_TEST(testPrecision);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(QuatCodecTest::suite());
+    runner.run();
+    return 0;
+}
@@ -558,6 +558,19 @@ public:
         CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.259, mat[2][2], TOLERANCE);
     }
 
+    /**
+     * Ensures parse reads back exactly what toString writes.
+     */
+    void testParse() {
+
+        const M3d::Quat q = M3d::Quat::fromAxisAngle(M3d::Vec3(0,1,0), ANGLE_30);
+        M3d::Quat r;
+
+        CPPUNIT_ASSERT(M3d::Quat::parse(q.toString().c_str(), r) != NULL);
+        CPPUNIT_ASSERT(q == r);
+        CPPUNIT_ASSERT(M3d::Quat::parse("[0, 0, 0]", r) == NULL);
+    }
+
     CPPUNIT_TEST_SUITE(QuatTest);
     CPPUNIT_TEST(testDefaultConstructor);
     CPPUNIT_TEST(testConstructorWithExplicitValues);
@@ -594,6 +607,7 @@ public:
     CPPUNIT_TEST(testOperatorSubtract);
     CPPUNIT_TEST(testToMat3);
     CPPUNIT_TEST(testMultiply);
+    CPPUNIT_TEST(testParse);
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -0,0 +1,420 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "m3d/Quickhull.h"
+using namespace std;
+namespace M3d {
+
+
+/*
+ * Face of the hull, with the points in front of it that have not been added yet.
+ */
+struct Quickhull::Face {
+    uint32_t v[3];
+    Vec3 normal;
+    double offset;
+    vector<uint32_t> outside;
+    uint32_t farthest;
+    double farthestDistance;
+    bool alive;
+    bool visible;
+    double getDistance(const Vec3& p) const {
+        return dot(normal, p) - offset;
+    }
+};
+
+
+/*
+ * Task finding the points with the smallest and largest coordinate along each axis in a range of points.
+ */
+class Quickhull::ExtremeTask : public ParallelTask {
+public:
+    ExtremeTask(const Vec3Array& points, vector<uint32_t>& extremes, vector<Vec3>& magnitudes) :
+            points(points), extremes(extremes), magnitudes(magnitudes) { }
+    virtual void run(size_t chunk, size_t begin, size_t end) {
+        uint32_t* const e = &extremes[chunk * 6];
+        Vec3& m = magnitudes[chunk];
+        const vector<double>* const axes[3] = { &points.x, &points.y, &points.z };
+        for (int a = 0; a < 3; ++a) {
+            const vector<double>& c = *axes[a];
+            e[2 * a] = e[(2 * a) + 1] = (uint32_t) begin;
+            for (size_t i = begin + 1; i < end; ++i) {
+                e[2 * a] = (c[i] < c[e[2 * a]]) ? (uint32_t) i : e[2 * a];
+                e[(2 * a) + 1] = (c[i] > c[e[(2 * a) + 1]]) ? (uint32_t) i : e[(2 * a) + 1];
+            }
+            m[a] = std::max(fabs(c[e[2 * a]]), fabs(c[e[(2 * a) + 1]]));
+        }
+    }
+private:
+    const Vec3Array& points;
+    vector<uint32_t>& extremes;
+    vector<Vec3>& magnitudes;
+};
+
+
+/*
+ * Task finding the point in a range farthest from a line or a plane.
+ */
+class Quickhull::FarthestTask : public ParallelTask {
+public:
+    FarthestTask(const Vec3Array& points, const Vec3& origin, const Vec3& axis, bool line, vector<uint32_t>& best,
+                 vector<double>& scores) :
+            points(points), origin(origin), axis(axis), line(line), best(best), scores(scores) { }
+    virtual void run(size_t chunk, size_t begin, size_t end) {
+        best[chunk] = (uint32_t) begin;
+        scores[chunk] = -1;
+        for (size_t i = begin; i < end; ++i) {
+            const Vec3 d = points.get(i) - origin;
+            const Vec3 c = cross(d, axis);
+            const double score = line ? sqrt(dot(c, c)) : fabs(dot(d, axis));
+            if (score > scores[chunk]) {
+                scores[chunk] = score;
+                best[chunk] = (uint32_t) i;
+            }
+        }
+    }
+private:
+    const Vec3Array& points;
+    Vec3 origin;
+    Vec3 axis;
+    bool line;
+    vector<uint32_t>& best;
+    vector<double>& scores;
+};
+
+
+/*
+ * Task finding the first new face each point in a range is in front of.
+ */
+class Quickhull::AssignTask : public ParallelTask {
+public:
+    AssignTask(const Vec3Array& points, const vector<uint32_t>& candidates, const vector<uint32_t>& newFaces,
+               double epsilon, const vector<Face>& faces, vector<uint32_t>& owners, vector<double>& distances) :
+            points(points), candidates(candidates), newFaces(newFaces), epsilon(epsilon), faces(faces),
+            owners(owners), distances(distances) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const Vec3 p = points.get(candidates[i]);
+            owners[i] = NO_FACE;
+            for (size_t j = 0; j < newFaces.size(); ++j) {
+                const double d = faces[newFaces[j]].getDistance(p);
+                if (d > epsilon) {
+                    owners[i] = newFaces[j];
+                    distances[i] = d;
+                    break;
+                }
+            }
+        }
+    }
+private:
+    const Vec3Array& points;
+    const vector<uint32_t>& candidates;
+    const vector<uint32_t>& newFaces;
+    double epsilon;
+    const vector<Face>& faces;
+    vector<uint32_t>& owners;
+    vector<double>& distances;
+};
+
+// METHODS
+
+/**
+ * Constructs an empty hull.
+ */
+Quickhull::Quickhull() {
+    // pass
+}
+
+/**
+ * Builds the hull of a set of points, replacing any earlier hull.
+ *
+ * @param points Points to wrap
+ * @return `false` if there are fewer than four points or they all lie in one plane, leaving the hull empty
+ */
+bool Quickhull::build(const Vec3Array& points) {
+
+    indices.clear();
+
+    // Start from a tetrahedron
+    uint32_t simplex[4];
+    double epsilon;
+    if ((points.size() < 4) || !findSimplex(points, simplex, epsilon)) {
+        return false;
+    }
+    const Vec3 centroid = (points.get(simplex[0]) + points.get(simplex[1])
+            + points.get(simplex[2]) + points.get(simplex[3])) * 0.25;
+    const int corners[4][3] = { { 0, 1, 2 }, { 0, 3, 1 }, { 0, 2, 3 }, { 1, 3, 2 } };
+    vector<Face> faces;
+    EdgeMap edges;
+    vector<uint32_t> newFaces;
+    for (int i = 0; i < 4; ++i) {
+        const uint32_t a = simplex[corners[i][0]];
+        uint32_t b = simplex[corners[i][1]];
+        uint32_t c = simplex[corners[i][2]];
+        const Vec3 pa = points.get(a);
+        if (dot(cross(points.get(b) - pa, points.get(c) - pa), pa - centroid) < 0) {
+            swap(b, c);
+        }
+        newFaces.push_back(addFace(points, a, b, c, faces, edges));
+    }
+
+    // Put every other point in a conflict list
+    vector<uint32_t> candidates;
+    candidates.reserve(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        if ((i != simplex[0]) && (i != simplex[1]) && (i != simplex[2]) && (i != simplex[3])) {
+            candidates.push_back((uint32_t) i);
+        }
+    }
+    assign(points, candidates, newFaces, epsilon, faces);
+
+    // Add the farthest point of each face until none are left
+    vector<uint32_t> pending(newFaces.rbegin(), newFaces.rend());
+    while (!pending.empty()) {
+        const uint32_t f = pending.back();
+        pending.pop_back();
+        if (!faces[f].alive || faces[f].outside.empty()) {
+            continue;
+        }
+        const uint32_t eye = faces[f].farthest;
+        const Vec3 p = points.get(eye);
+
+        // Find faces the point can see, spreading out from this one
+        vector<uint32_t> visible(1, f);
+        faces[f].visible = true;
+        for (size_t k = 0; k < visible.size(); ++k) {
+            for (int e = 0; e < 3; ++e) {
+                const Face& face = faces[visible[k]];
+                const uint32_t neighbor = edges[make_pair(face.v[(e + 1) % 3], face.v[e])];
+                if (!faces[neighbor].visible && (faces[neighbor].getDistance(p) > epsilon)) {
+                    faces[neighbor].visible = true;
+                    visible.push_back(neighbor);
+                }
+            }
+        }
+
+        // Find edges around them and remove them, keeping their points
+        vector< pair<uint32_t,uint32_t> > horizon;
+        candidates.clear();
+        for (size_t k = 0; k < visible.size(); ++k) {
+            Face& face = faces[visible[k]];
+            for (int e = 0; e < 3; ++e) {
+                const uint32_t neighbor = edges[make_pair(face.v[(e + 1) % 3], face.v[e])];
+                if (!faces[neighbor].visible) {
+                    horizon.push_back(make_pair(face.v[e], face.v[(e + 1) % 3]));
+                }
+            }
+            for (size_t i = 0; i < face.outside.size(); ++i) {
+                if (face.outside[i] != eye) {
+                    candidates.push_back(face.outside[i]);
+                }
+            }
+            vector<uint32_t>().swap(face.outside);
+            face.alive = false;
+        }
+        for (size_t k = 0; k < visible.size(); ++k) {
+            const Face& face = faces[visible[k]];
+            for (int e = 0; e < 3; ++e) {
+                edges.erase(make_pair(face.v[e], face.v[(e + 1) % 3]));
+            }
+        }
+
+        // Fill the hole and hand out the points
+        newFaces.clear();
+        for (size_t i = 0; i < horizon.size(); ++i) {
+            newFaces.push_back(addFace(points, horizon[i].first, horizon[i].second, eye, faces, edges));
+        }
+        assign(points, candidates, newFaces, epsilon, faces);
+        for (size_t i = 0; i < newFaces.size(); ++i) {
+            if (!faces[newFaces[i]].outside.empty()) {
+                pending.push_back(newFaces[i]);
+            }
+        }
+    }
+
+    // Collect triangles
+    for (size_t i = 0; i < faces.size(); ++i) {
+        if (faces[i].alive) {
+            indices.insert(indices.end(), faces[i].v, faces[i].v + 3);
+        }
+    }
+    return true;
+}
+
+/**
+ * Returns the corners of each triangle, three per triangle, wound counter-clockwise seen from outside.
+ */
+const vector<uint32_t>& Quickhull::getIndices() const {
+    return indices;
+}
+
+/**
+ * Returns the number of triangles in the hull.
+ */
+size_t Quickhull::getTriangleCount() const {
+    return indices.size() / 3;
+}
+
+/**
+ * Finds the points that are corners of the hull.
+ *
+ * @param vertices List to store indices of points in, in increasing order
+ */
+void Quickhull::getVertices(vector<uint32_t>& vertices) const {
+    vertices = indices;
+    sort(vertices.begin(), vertices.end());
+    vertices.erase(unique(vertices.begin(), vertices.end()), vertices.end());
+}
+
+// HELPERS
+
+/*
+ * Adds a face to the hull and records its edges, returning its index.
+ */
+uint32_t Quickhull::addFace(const Vec3Array& points, uint32_t a, uint32_t b, uint32_t c, vector<Face>& faces,
+                            EdgeMap& edges) {
+
+    const uint32_t index = (uint32_t) faces.size();
+    const Vec3 pa = points.get(a);
+    const Vec3 n = cross(points.get(b) - pa, points.get(c) - pa);
+    const double len = length(n);
+
+    faces.push_back(Face());
+    Face& face = faces.back();
+    face.v[0] = a;
+    face.v[1] = b;
+    face.v[2] = c;
+    face.normal = (len > 0) ? (n / len) : n;
+    face.offset = dot(face.normal, pa);
+    face.farthest = 0;
+    face.farthestDistance = 0;
+    face.alive = true;
+    face.visible = false;
+    edges[make_pair(a, b)] = index;
+    edges[make_pair(b, c)] = index;
+    edges[make_pair(c, a)] = index;
+    return index;
+}
+
+/*
+ * Puts points in the conflict lists of the first new face each is in front of, on several threads.
+ */
+void Quickhull::assign(const Vec3Array& points, const vector<uint32_t>& candidates, const vector<uint32_t>& newFaces,
+                       double epsilon, vector<Face>& faces) {
+
+    vector<uint32_t> owners(candidates.size());
+    vector<double> distances(candidates.size());
+    AssignTask task(points, candidates, newFaces, epsilon, faces, owners, distances);
+    Parallel::run(task, candidates.size(), GRAIN_SIZE);
+
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (owners[i] != NO_FACE) {
+            Face& face = faces[owners[i]];
+            if (face.outside.empty() || (distances[i] > face.farthestDistance)) {
+                face.farthest = candidates[i];
+                face.farthestDistance = distances[i];
+            }
+            face.outside.push_back(candidates[i]);
+        }
+    }
+}
+
+/*
+ * Finds four points spanning a tetrahedron, using the extremes along each axis, and a tolerance for the points.
+ */
+bool Quickhull::findSimplex(const Vec3Array& points, uint32_t simplex[4], double& epsilon) {
+
+    const size_t size = points.size();
+    const size_t chunks = Parallel::countChunks(size, GRAIN_SIZE);
+
+    // Find extremes along each axis
+    vector<uint32_t> extremes(chunks * 6);
+    vector<Vec3> magnitudes(chunks);
+    ExtremeTask extremeTask(points, extremes, magnitudes);
+    Parallel::run(extremeTask, size, GRAIN_SIZE);
+    Vec3 magnitude(0, 0, 0);
+    for (size_t i = 0; i < chunks; ++i) {
+        magnitude = max(magnitude, magnitudes[i]);
+    }
+    epsilon = 3 * DBL_EPSILON * (magnitude.x + magnitude.y + magnitude.z);
+
+    // Reduce to one minimum and maximum per axis, keeping the earliest chunk on ties so the lowest index wins
+    uint32_t extreme[6];
+    const vector<double>* const axes[3] = { &points.x, &points.y, &points.z };
+    for (int a = 0; a < 3; ++a) {
+        const vector<double>& c = *axes[a];
+        uint32_t& low = extreme[2 * a];
+        uint32_t& high = extreme[(2 * a) + 1];
+        low = extremes[2 * a];
+        high = extremes[(2 * a) + 1];
+        for (size_t i = 1; i < chunks; ++i) {
+            const uint32_t* const e = &extremes[i * 6];
+            low = (c[e[2 * a]] < c[low]) ? e[2 * a] : low;
+            high = (c[e[(2 * a) + 1]] > c[high]) ? e[(2 * a) + 1] : high;
+        }
+    }
+
+    // Use the two extremes farthest apart
+    double widest = 0;
+    for (int i = 0; i < 6; ++i) {
+        for (int j = i + 1; j < 6; ++j) {
+            const double d = length(points.get(extreme[j]) - points.get(extreme[i]));
+            if (d > widest) {
+                widest = d;
+                simplex[0] = extreme[i];
+                simplex[1] = extreme[j];
+            }
+        }
+    }
+    if (!(widest > epsilon)) {
+        return false;
+    }
+
+    // Add the points farthest from their line, then from their plane
+    vector<uint32_t> best(chunks);
+    vector<double> scores(chunks);
+    for (int k = 2; k < 4; ++k) {
+        const Vec3 a = points.get(simplex[0]);
+        const Vec3 axis = (k == 2) ? normalize(points.get(simplex[1]) - a)
+                                   : normalize(cross(points.get(simplex[1]) - a, points.get(simplex[2]) - a));
+        FarthestTask farthestTask(points, a, axis, k == 2, best, scores);
+        Parallel::run(farthestTask, size, GRAIN_SIZE);
+        size_t chosen = 0;
+        for (size_t i = 1; i < chunks; ++i) {
+            chosen = (scores[i] > scores[chosen]) ? i : chosen;
+        }
+        if (!(scores[chosen] > epsilon)) {
+            return false;
+        }
+        simplex[k] = best[chosen];
+    }
+    return true;
+}
+
+} /* namespace M3d */
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_QUICKHULL_H
+#define M3D_QUICKHULL_H
+#include "m3d/common.h"
+#include <map>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+#include "m3d/Parallel.h"
+#include "m3d/Vec3.h"
+#include "m3d/Vec3Array.h"
+namespace M3d {
+
+
+/**
+ * Convex hull of a set of points, built with Quickhull.
+ *
+ * The hull starts as a tetrahedron between extreme points, and each point outside it is put in the conflict list of
+ * one face it is in front of.  Then, while any face has points in front of it, the farthest of those points is added:
+ * the faces it can see are removed, the hole is filled with faces joining the point to the edge of the hole, and the
+ * points of the removed faces are handed out to the new faces.  Points behind every face are inside the hull and
+ * dropped.
+ *
+ * Finding the extreme points of the tetrahedron and assigning points to conflict lists are split across threads,
+ * since they touch every point.
+ *
+ * The result is a list of triangles, as indices into the input points, wound counter-clockwise seen from outside.
+ */
+class Quickhull {
+public:
+// Methods
+    explicit Quickhull();
+    bool build(const Vec3Array& points);
+    const std::vector<uint32_t>& getIndices() const;
+    size_t getTriangleCount() const;
+    void getVertices(std::vector<uint32_t>& vertices) const;
+private:
+// Types
+    struct Face;
+    class AssignTask;
+    class ExtremeTask;
+    class FarthestTask;
+    typedef std::map<std::pair<uint32_t,uint32_t>,uint32_t> EdgeMap;
+// Constants
+    static const size_t GRAIN_SIZE = 16384;
+    static const uint32_t NO_FACE = 0xFFFFFFFF;
+// Attributes
+    std::vector<uint32_t> indices;
+// Helpers
+    static uint32_t addFace(const Vec3Array& points, uint32_t a, uint32_t b, uint32_t c, std::vector<Face>& faces,
+                            EdgeMap& edges);
+    static void assign(const Vec3Array& points, const std::vector<uint32_t>& candidates,
+                       const std::vector<uint32_t>& newFaces, double epsilon, std::vector<Face>& faces);
+    static bool findSimplex(const Vec3Array& points, uint32_t simplex[4], double& epsilon);
+};
+
+} /* namespace M3d */
+#endif
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <utility>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/Quickhull.h"
+using namespace std;
+
+/*
+ * Constants
+ */
+const double TOLERANCE = 1e-9;
+
+
+/**
+ * Unit test for Quickhull.
+ */
+class QuickhullTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + (upper - lower) * (rand() / (double) RAND_MAX);
+    }
+
+    /**
+     * Makes an array of random points in a cube.
+     */
+    static M3d::Vec3Array randomPoints(size_t size, double extent) {
+        M3d::Vec3Array arr(size);
+        for (size_t i = 0; i < size; ++i) {
+            arr.set(i, M3d::Vec3(random(-extent, extent), random(-extent, extent), random(-extent, extent)));
+        }
+        return arr;
+    }
+
+    /**
+     * Checks that a hull is closed, wound outward, and has every point behind each of its triangles.
+     */
+    static void checkHull(const M3d::Quickhull& hull, const M3d::Vec3Array& points) {
+        const vector<uint32_t>& indices = hull.getIndices();
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, indices.size() % 3);
+
+        // Each edge is shared by exactly two triangles going opposite ways
+        map<pair<uint32_t,uint32_t>,int> edges;
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            for (int e = 0; e < 3; ++e) {
+                ++edges[make_pair(indices[i + e], indices[i + ((e + 1) % 3)])];
+            }
+        }
+        for (map<pair<uint32_t,uint32_t>,int>::const_iterator it = edges.begin(); it != edges.end(); ++it) {
+            CPPUNIT_ASSERT_EQUAL(1, it->second);
+            CPPUNIT_ASSERT(edges.count(make_pair(it->first.second, it->first.first)) == 1);
+        }
+
+        // Closed triangle meshes around a convex solid satisfy F = 2V - 4
+        vector<uint32_t> vertices;
+        hull.getVertices(vertices);
+        CPPUNIT_ASSERT_EQUAL(2 * vertices.size() - 4, hull.getTriangleCount());
+
+        // Every point is behind every triangle
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            const M3d::Vec3 a = points.get(indices[i]);
+            const M3d::Vec3 b = points.get(indices[i + 1]);
+            const M3d::Vec3 c = points.get(indices[i + 2]);
+            const M3d::Vec3 n = M3d::normalize(M3d::cross(b - a, c - a));
+            for (size_t j = 0; j < points.size(); ++j) {
+                CPPUNIT_ASSERT(M3d::dot(n, points.get(j) - a) <= TOLERANCE);
+            }
+        }
+    }
+
+public:
+
+    /**
+     * Resets the number of threads.
+     */
+    void tearDown() {
+        M3d::Parallel::setConcurrency(0);
+    }
+
+    /**
+     * Ensures a hull around a cube with points inside keeps only the corners.
+     */
+    void testBuildCube() {
+        M3d::Vec3Array points(40);
+        for (size_t i = 0; i < 8; ++i) {
+            points.set(i, M3d::Vec3((i & 1) ? 1 : -1, (i & 2) ? 1 : -1, (i & 4) ? 1 : -1));
+        }
+        for (size_t i = 8; i < points.size(); ++i) {
+            points.set(i, M3d::Vec3(random(-0.9, 0.9), random(-0.9, 0.9), random(-0.9, 0.9)));
+        }
+        points.set(20, M3d::Vec3(0, 0, 1));
+        points.set(21, M3d::Vec3(1, 0.5, 0.5));
+
+        M3d::Quickhull hull;
+        CPPUNIT_ASSERT(hull.build(points));
+        CPPUNIT_ASSERT_EQUAL((size_t) 12, hull.getTriangleCount());
+        vector<uint32_t> vertices;
+        hull.getVertices(vertices);
+        CPPUNIT_ASSERT_EQUAL((size_t) 8, vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            CPPUNIT_ASSERT_EQUAL((uint32_t) i, vertices[i]);
+        }
+        checkHull(hull, points);
+    }
+
+    /**
+     * Ensures building fails for too few points or points in one plane.
+     */
+    void testBuildDegenerate() {
+        M3d::Quickhull hull;
+        CPPUNIT_ASSERT(!hull.build(M3d::Vec3Array(3)));
+        CPPUNIT_ASSERT(!hull.build(M3d::Vec3Array(10)));
+
+        M3d::Vec3Array points(50);
+        for (size_t i = 0; i < points.size(); ++i) {
+            points.set(i, M3d::Vec3(random(-1, 1), random(-1, 1), 2));
+        }
+        CPPUNIT_ASSERT(!hull.build(points));
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, hull.getTriangleCount());
+    }
+
+    /**
+     * Ensures a parallel build makes the same hull as a serial one.
+     */
+    void testBuildParallel() {
+        const M3d::Vec3Array points = randomPoints(100000, 10);
+        M3d::Quickhull serial, parallel;
+        M3d::Parallel::setConcurrency(1);
+        CPPUNIT_ASSERT(serial.build(points));
+        M3d::Parallel::setConcurrency(4);
+        CPPUNIT_ASSERT(parallel.build(points));
+        CPPUNIT_ASSERT(serial.getIndices() == parallel.getIndices());
+    }
+
+    /**
+     * Ensures a hull around random points in a cube wraps all of them.
+     */
+    void testBuildRandom() {
+        const M3d::Vec3Array points = randomPoints(2000, 5);
+        M3d::Quickhull hull;
+        CPPUNIT_ASSERT(hull.build(points));
+        checkHull(hull, points);
+    }
+
+    /**
+     * Ensures a hull around points on a sphere uses every point.
+     */
+    void testBuildSphere() {
+        M3d::Vec3Array points(500);
+        for (size_t i = 0; i < points.size(); ++i) {
+            const M3d::Vec3 v(random(-1, 1), random(-1, 1), random(-1, 1));
+            points.set(i, M3d::normalize(v) * 3.0);
+        }
+        M3d::Quickhull hull;
+        CPPUNIT_ASSERT(hull.build(points));
+        checkHull(hull, points);
+        vector<uint32_t> vertices;
+        hull.getVertices(vertices);
+        CPPUNIT_ASSERT_EQUAL(points.size(), vertices.size());
+    }
+
+    CPPUNIT_TEST_SUITE(QuickhullTest);
+    CPPUNIT_TEST(testBuildCube);
+    CPPUNIT_TEST(testBuildDegenerate);
+    CPPUNIT_TEST(testBuildParallel);
+    CPPUNIT_TEST(testBuildRandom);
+    CPPUNIT_TEST(testBuildSphere);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(QuickhullTest::suite());
+    runner.run();
+    return 0;
+}
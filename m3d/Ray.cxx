@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include "m3d/Ray.h"
+using namespace std;
+namespace M3d {
+
+/**
+ * Constructs a ray at the origin pointing down the negative Z axis.
+ */
+Ray::Ray() : origin(0, 0, 0), direction(0, 0, -1), inverseDirection(HUGE_VAL, HUGE_VAL, -1) {
+    // pass
+}
+
+/**
+ * Constructs a ray from an origin and a direction.
+ *
+ * @param origin Starting point
+ * @param direction Direction of travel, not necessarily unit length
+ */
+Ray::Ray(const Vec3& origin, const Vec3& direction) : origin(origin) {
+    setDirection(direction);
+}
+
+/**
+ * Computes the transform that maps the ray onto the positive Z axis, for watertight triangle tests.
+ *
+ * The axis the direction is longest along becomes Z, and the other two are ordered to keep the winding of triangles.
+ * Points are then moved to the origin and sheared by `x - shear.x * z` and `y - shear.y * z`, and their Z is scaled by
+ * `shear.z`.
+ *
+ * @param axes Indices of the axes that become X, Y and Z
+ * @param shear Shear factors for X and Y, and the scale for Z
+ */
+void Ray::findShear(int axes[3], Vec3& shear) const {
+
+    const Vec3 length(fabs(direction.x), fabs(direction.y), fabs(direction.z));
+    const int kz = (length.x > length.y) ? ((length.x > length.z) ? 0 : 2) : ((length.y > length.z) ? 1 : 2);
+    int kx = (kz + 1) % 3;
+    int ky = (kx + 1) % 3;
+
+    if (direction[kz] < 0) {
+        std::swap(kx, ky);
+    }
+    axes[0] = kx;
+    axes[1] = ky;
+    axes[2] = kz;
+    shear = Vec3(direction[kx] / direction[kz], direction[ky] / direction[kz], 1 / direction[kz]);
+}
+
+/**
+ * Computes a point along the ray.
+ *
+ * @param t Distance along the ray in multiples of the direction
+ * @return Point at `origin + direction * t`
+ */
+Vec3 Ray::getPoint(double t) const {
+    return origin + (direction * t);
+}
+
+/**
+ * Checks if the ray hits a box, using the slab method.
+ *
+ * @param box Box to check
+ * @param tMax Largest distance along the ray to accept
+ * @param tNear Distance where the ray enters the box, or zero if it starts inside, unchanged if there is no hit
+ * @return `true` if the ray hits the box in [0 .. tMax]
+ */
+bool Ray::intersects(const Aabb& box, double tMax, double& tNear) const {
+
+    const double tx1 = (box.lower.x - origin.x) * inverseDirection.x;
+    const double tx2 = (box.upper.x - origin.x) * inverseDirection.x;
+    double t0 = std::min(tx1, tx2);
+    double t1 = std::max(tx1, tx2);
+
+    const double ty1 = (box.lower.y - origin.y) * inverseDirection.y;
+    const double ty2 = (box.upper.y - origin.y) * inverseDirection.y;
+    t0 = std::max(t0, std::min(ty1, ty2));
+    t1 = std::min(t1, std::max(ty1, ty2));
+
+    const double tz1 = (box.lower.z - origin.z) * inverseDirection.z;
+    const double tz2 = (box.upper.z - origin.z) * inverseDirection.z;
+    t0 = std::max(t0, std::min(tz1, tz2));
+    t1 = std::min(t1, std::max(tz1, tz2));
+
+    t0 = std::max(t0, 0.0);
+    t1 = std::min(t1, tMax);
+    if (t0 <= t1) {
+        tNear = t0;
+        return true;
+    } else {
+        return false;
+    }
+}
+
+/**
+ * Changes the direction of the ray, updating its reciprocal.
+ *
+ * @param direction New direction of travel, not necessarily unit length
+ */
+void Ray::setDirection(const Vec3& direction) {
+    this->direction = direction;
+    this->inverseDirection = Vec3(1 / direction.x, 1 / direction.y, 1 / direction.z);
+}
+
+/**
+ * Returns a string representation of the ray.
+ */
+string Ray::toString() const {
+    stringstream stream;
+    stream << (*this);
+    return stream.str();
+}
+
+} /* namespace M3d */
+
+/**
+ * Appends a ray to a stream.
+ *
+ * @param stream Stream to append to
+ * @param ray Ray to append
+ * @return Reference to the stream
+ */
+ostream& operator<<(ostream& stream, const M3d::Ray& ray) {
+    stream << '[' << ray.origin << ", " << ray.direction << ']';
+    return stream;
+}
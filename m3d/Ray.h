@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_RAY_H
+#define M3D_RAY_H
+#include "m3d/common.h"
+#include <iostream>
+#include <string>
+#include "m3d/Aabb.h"
+#include "m3d/Vec3.h"
+namespace M3d {
+
+
+/**
+ * Half-line starting at an origin and extending in a direction.
+ *
+ * The reciprocal of the direction is computed once when the ray is made, since intersection tests against boxes
+ * divide by the direction many times.  Use `setDirection` rather than assigning to `direction` directly so the two stay
+ * consistent.
+ */
+class Ray {
+public:
+// Attributes
+    Vec3 origin; ///< Starting point
+    Vec3 direction; ///< Direction of travel, not necessarily unit length
+    Vec3 inverseDirection; ///< Reciprocal of each component of the direction
+// Methods
+    explicit Ray();
+    explicit Ray(const Vec3& origin, const Vec3& direction);
+    void findShear(int axes[3], Vec3& shear) const;
+    Vec3 getPoint(double t) const;
+    bool intersects(const Aabb& box, double tMax, double& tNear) const;
+    void setDirection(const Vec3& direction);
+    std::string toString() const;
+};
+
+} /* namespace M3d */
+
+std::ostream& operator<<(std::ostream& stream, const M3d::Ray& ray);
+#endif
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include <stdexcept>
+#include "m3d/RayPacket.h"
+using namespace std;
+namespace M3d {
+
+/**
+ * Constructs a packet with every ray at the origin pointing down the negative Z axis.
+ */
+template <size_t N>
+RayPacket<N>::RayPacket() {
+    const Ray ray;
+    for (size_t i = 0; i < N; ++i) {
+        setRay(i, ray);
+    }
+}
+
+/**
+ * Constructs a packet from an array of rays.
+ *
+ * @param rays Array of rays with one for each slot
+ */
+template <size_t N>
+RayPacket<N>::RayPacket(const Ray rays[N]) {
+    for (size_t i = 0; i < N; ++i) {
+        setRay(i, rays[i]);
+    }
+}
+
+/**
+ * Returns one of the rays in the packet.
+ *
+ * @param i Index of the ray
+ * @return Copy of the ray
+ * @throws std::out_of_range if index is not less than the size of the packet
+ */
+template <size_t N>
+Ray RayPacket<N>::getRay(size_t i) const {
+    if (i >= N) {
+        throw out_of_range("[RayPacket] Index out of bounds!");
+    }
+    return Ray(Vec3(originX[i], originY[i], originZ[i]), Vec3(directionX[i], directionY[i], directionZ[i]));
+}
+
+/**
+ * Checks which rays in the packet hit a box, using the slab method on every ray at once.
+ *
+ * @param box Box to check
+ * @param tMax Largest distance along each ray to accept
+ * @param tNear Distances where each ray enters the box, or zero if it starts inside, set only for rays that hit
+ * @return Mask with bit `i` set if ray `i` hits the box in [0 .. tMax[i]]
+ */
+template <size_t N>
+unsigned int RayPacket<N>::intersects(const Aabb& box, const double tMax[N], double tNear[N]) const {
+
+    bool hits[N];
+
+    for (size_t i = 0; i < N; ++i) {
+        const double tx1 = (box.lower.x - originX[i]) * inverseX[i];
+        const double tx2 = (box.upper.x - originX[i]) * inverseX[i];
+        const double ty1 = (box.lower.y - originY[i]) * inverseY[i];
+        const double ty2 = (box.upper.y - originY[i]) * inverseY[i];
+        const double tz1 = (box.lower.z - originZ[i]) * inverseZ[i];
+        const double tz2 = (box.upper.z - originZ[i]) * inverseZ[i];
+        double t0 = std::max(std::min(tx1, tx2), std::min(ty1, ty2));
+        double t1 = std::min(std::max(tx1, tx2), std::max(ty1, ty2));
+        t0 = std::max(std::max(t0, std::min(tz1, tz2)), 0.0);
+        t1 = std::min(std::min(t1, std::max(tz1, tz2)), tMax[i]);
+        hits[i] = (t0 <= t1);
+        tNear[i] = hits[i] ? t0 : tNear[i];
+    }
+
+    unsigned int mask = 0;
+    for (size_t i = 0; i < N; ++i) {
+        mask |= ((unsigned int) hits[i]) << i;
+    }
+    return mask;
+}
+
+/**
+ * Changes one of the rays in the packet.
+ *
+ * @param i Index of the ray
+ * @param ray Ray to copy into the packet
+ * @throws std::out_of_range if index is not less than the size of the packet
+ */
+template <size_t N>
+void RayPacket<N>::setRay(size_t i, const Ray& ray) {
+
+    if (i >= N) {
+        throw out_of_range("[RayPacket] Index out of bounds!");
+    }
+
+    originX[i] = ray.origin.x;
+    originY[i] = ray.origin.y;
+    originZ[i] = ray.origin.z;
+    directionX[i] = ray.direction.x;
+    directionY[i] = ray.direction.y;
+    directionZ[i] = ray.direction.z;
+    inverseX[i] = ray.inverseDirection.x;
+    inverseY[i] = ray.inverseDirection.y;
+    inverseZ[i] = ray.inverseDirection.z;
+
+    int k[3];
+    Vec3 shear;
+    ray.findShear(k, shear);
+    axes[0][i] = k[0];
+    axes[1][i] = k[1];
+    axes[2][i] = k[2];
+    shearX[i] = shear.x;
+    shearY[i] = shear.y;
+    shearZ[i] = shear.z;
+}
+
+template class RayPacket<4>;
+template class RayPacket<8>;
+
+} /* namespace M3d */
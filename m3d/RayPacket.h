@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_RAYPACKET_H
+#define M3D_RAYPACKET_H
+#include "m3d/common.h"
+#include "m3d/Aabb.h"
+#include "m3d/Ray.h"
+#include "m3d/Vec3.h"
+namespace M3d {
+
+
+/**
+ * Small group of rays stored as separate arrays of components.
+ *
+ * Tests against a packet run the same steps for every ray at once, so with the components of each ray in separate
+ * arrays they compile to SIMD instructions.  Packets are most effective when the rays are coherent, e.g. neighbouring
+ * pixels or samples.  Each ray keeps the reciprocal of its direction for box tests and the shear from
+ * `Ray::findShear` for watertight triangle tests.
+ *
+ * Only packets of four and eight rays are available, as `RayPacket4` and `RayPacket8`.
+ */
+template <size_t N>
+class RayPacket {
+public:
+// Constants
+    static const size_t SIZE = N; ///< Number of rays in the packet
+// Attributes
+    double originX[N]; ///< X coordinates of origins
+    double originY[N]; ///< Y coordinates of origins
+    double originZ[N]; ///< Z coordinates of origins
+    double directionX[N]; ///< X components of directions
+    double directionY[N]; ///< Y components of directions
+    double directionZ[N]; ///< Z components of directions
+    double inverseX[N]; ///< Reciprocals of X components of directions
+    double inverseY[N]; ///< Reciprocals of Y components of directions
+    double inverseZ[N]; ///< Reciprocals of Z components of directions
+    int axes[3][N]; ///< Axes that become X, Y and Z for watertight tests
+    double shearX[N]; ///< Shear factors for X for watertight tests
+    double shearY[N]; ///< Shear factors for Y for watertight tests
+    double shearZ[N]; ///< Scales for Z for watertight tests
+// Methods
+    explicit RayPacket();
+    explicit RayPacket(const Ray rays[N]);
+    Ray getRay(size_t i) const;
+    unsigned int intersects(const Aabb& box, const double tMax[N], double tNear[N]) const;
+    void setRay(size_t i, const Ray& ray);
+};
+
+typedef RayPacket<4> RayPacket4;
+typedef RayPacket<8> RayPacket8;
+
+} /* namespace M3d */
+#endif
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/RayPacket.h"
+using namespace std;
+
+
+/**
+ * Unit test for RayPacket.
+ */
+class RayPacketTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + (upper - lower) * (rand() / (double) RAND_MAX);
+    }
+
+    /**
+     * Returns a random ray.
+     */
+    static M3d::Ray randomRay() {
+        const M3d::Vec3 origin(random(-5, 5), random(-5, 5), random(-5, 5));
+        const M3d::Vec3 direction(random(-1, 1), random(-1, 1), random(-1, 1));
+        return M3d::Ray(origin, direction);
+    }
+
+public:
+
+    /**
+     * Ensures rays put into a packet come back out with their reciprocals and shears.
+     */
+    void testSetRay() {
+
+        M3d::RayPacket4 packet;
+        const M3d::Ray ray(M3d::Vec3(1, 2, 3), M3d::Vec3(0.5, -4, 2));
+        packet.setRay(2, ray);
+        CPPUNIT_ASSERT(packet.getRay(2).origin == ray.origin);
+        CPPUNIT_ASSERT(packet.getRay(2).direction == ray.direction);
+        CPPUNIT_ASSERT_EQUAL(2.0, packet.inverseX[2]);
+        CPPUNIT_ASSERT_EQUAL(-0.25, packet.inverseY[2]);
+
+        int k[3];
+        M3d::Vec3 shear;
+        ray.findShear(k, shear);
+        CPPUNIT_ASSERT_EQUAL(1, packet.axes[2][2]);
+        CPPUNIT_ASSERT_EQUAL(k[0], packet.axes[0][2]);
+        CPPUNIT_ASSERT_EQUAL(shear.z, packet.shearZ[2]);
+
+        CPPUNIT_ASSERT(packet.getRay(0).direction == M3d::Vec3(0, 0, -1));
+        CPPUNIT_ASSERT_THROW(packet.setRay(4, ray), std::out_of_range);
+        CPPUNIT_ASSERT_THROW(packet.getRay(4), std::out_of_range);
+    }
+
+    /**
+     * Ensures testing a packet against a box gives the same results as testing each ray.
+     */
+    void testIntersects() {
+        const M3d::Aabb box(M3d::Vec3(-1, -2, -1), M3d::Vec3(2, 1, 1));
+        for (int i = 0; i < 200; ++i) {
+            M3d::Ray rays[8];
+            double tMax[8], tNear[8];
+            for (int j = 0; j < 8; ++j) {
+                rays[j] = randomRay();
+                tMax[j] = (j % 2) ? HUGE_VAL : 3;
+                tNear[j] = -1;
+            }
+            const M3d::RayPacket8 packet(rays);
+            const unsigned int mask = packet.intersects(box, tMax, tNear);
+            for (int j = 0; j < 8; ++j) {
+                double t = -1;
+                CPPUNIT_ASSERT_EQUAL(rays[j].intersects(box, tMax[j], t), (bool) ((mask >> j) & 1));
+                CPPUNIT_ASSERT_EQUAL(t, tNear[j]);
+            }
+        }
+    }
+
+    CPPUNIT_TEST_SUITE(RayPacketTest);
+    CPPUNIT_TEST(testSetRay);
+    CPPUNIT_TEST(testIntersects);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(RayPacketTest::suite());
+    runner.run();
+    return 0;
+}
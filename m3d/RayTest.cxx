@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cmath>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/Ray.h"
+using namespace std;
+
+/*
+ * Constants
+ */
+const double TOLERANCE = 1e-9;
+
+
+/**
+ * Unit test for Ray.
+ */
+class RayTest : public CppUnit::TestFixture {
+public:
+
+    /**
+     * Ensures the constructors and setDirection keep the reciprocal of the direction.
+     */
+    void testSetDirection() {
+        M3d::Ray ray(M3d::Vec3(1, 2, 3), M3d::Vec3(2, -4, 0.5));
+        CPPUNIT_ASSERT(ray.inverseDirection == M3d::Vec3(0.5, -0.25, 2));
+        ray.setDirection(M3d::Vec3(0, 1, 0));
+        CPPUNIT_ASSERT(ray.direction == M3d::Vec3(0, 1, 0));
+        CPPUNIT_ASSERT_EQUAL(HUGE_VAL, ray.inverseDirection.x);
+        CPPUNIT_ASSERT_EQUAL(1.0, ray.inverseDirection.y);
+
+        const M3d::Ray def;
+        CPPUNIT_ASSERT(def.origin == M3d::Vec3(0, 0, 0));
+        CPPUNIT_ASSERT(def.direction == M3d::Vec3(0, 0, -1));
+        CPPUNIT_ASSERT_EQUAL(-1.0, def.inverseDirection.z);
+    }
+
+    /**
+     * Ensures getPoint moves along the direction.
+     */
+    void testGetPoint() {
+        const M3d::Ray ray(M3d::Vec3(1, 2, 3), M3d::Vec3(1, 0, -2));
+        CPPUNIT_ASSERT(ray.getPoint(0) == M3d::Vec3(1, 2, 3));
+        CPPUNIT_ASSERT(ray.getPoint(2.5) == M3d::Vec3(3.5, 2, -2));
+    }
+
+    /**
+     * Ensures intersects finds where a ray enters a box and respects the range.
+     */
+    void testIntersects() {
+        const M3d::Aabb box(M3d::Vec3(-1, -1, -1), M3d::Vec3(1, 1, 1));
+        double t = -1;
+
+        // In front along an axis
+        const M3d::Ray ray(M3d::Vec3(0, 0, 5), M3d::Vec3(0, 0, -1));
+        CPPUNIT_ASSERT(ray.intersects(box, HUGE_VAL, t));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(4.0, t, TOLERANCE);
+        CPPUNIT_ASSERT(!ray.intersects(box, 3.5, t));
+
+        // Starting inside
+        const M3d::Ray inside(M3d::Vec3(0.5, 0, 0), M3d::Vec3(1, 1, 0));
+        CPPUNIT_ASSERT(inside.intersects(box, HUGE_VAL, t));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, t, TOLERANCE);
+
+        // Pointing away and passing beside
+        const M3d::Ray away(M3d::Vec3(0, 0, 5), M3d::Vec3(0, 0, 1));
+        CPPUNIT_ASSERT(!away.intersects(box, HUGE_VAL, t));
+        const M3d::Ray beside(M3d::Vec3(2, 0, 5), M3d::Vec3(0, 0, -1));
+        CPPUNIT_ASSERT(!beside.intersects(box, HUGE_VAL, t));
+
+        // Diagonal
+        const M3d::Ray diagonal(M3d::Vec3(-3, -3, 0), M3d::Vec3(1, 1, 0));
+        CPPUNIT_ASSERT(diagonal.intersects(box, HUGE_VAL, t));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(2.0, t, TOLERANCE);
+    }
+
+    /**
+     * Ensures toString works correctly.
+     */
+    void testToString() {
+        const M3d::Ray ray(M3d::Vec3(1, 2, 3), M3d::Vec3(0, 0, -1));
+        CPPUNIT_ASSERT_EQUAL(string("[[1, 2, 3], [0, 0, -1]]"), ray.toString());
+    }
+
+    CPPUNIT_TEST_SUITE(RayTest);
+    CPPUNIT_TEST(testSetDirection);
+    CPPUNIT_TEST(testGetPoint);
+    CPPUNIT_TEST(testIntersects);
+    CPPUNIT_TEST(testToString);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(RayTest::suite());
+    runner.run();
+    return 0;
+}
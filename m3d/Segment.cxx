@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include "m3d/Segment.h"
+using namespace std;
+namespace M3d {
+
+/**
+ * Constructs a segment with both end points at the origin.
+ */
+Segment::Segment() : start(0, 0, 0), end(0, 0, 0) {
+    // pass
+}
+
+/**
+ * Constructs a segment between two points.
+ *
+ * @param start First end point
+ * @param end Second end point
+ */
+Segment::Segment(const Vec3& start, const Vec3& end) : start(start), end(end) {
+    // pass
+}
+
+/**
+ * Finds the point on the segment closest to another point.
+ *
+ * @param point Point to find closest point to
+ * @return Closest point on the segment
+ */
+Vec3 Segment::getClosestPoint(const Vec3& point) const {
+
+    const Vec3 d = end - start;
+    const double lengthSquared = dot(d, d);
+
+    if (lengthSquared == 0) {
+        return start;
+    }
+    const double t = std::min(std::max(dot(point - start, d) / lengthSquared, 0.0), 1.0);
+    return getPoint(t);
+}
+
+/**
+ * Returns the distance between the end points.
+ */
+double Segment::getLength() const {
+    return length(end - start);
+}
+
+/**
+ * Computes a point along the segment.
+ *
+ * @param t Parameter of the point, where zero is the start and one is the end
+ * @return Point at `start + (end - start) * t`
+ */
+Vec3 Segment::getPoint(double t) const {
+    return start + ((end - start) * t);
+}
+
+/**
+ * Checks if the segment passes through a box, using the slab method.
+ *
+ * @param box Box to check
+ * @param t Parameter where the segment enters the box, or zero if it starts inside, set only if there is a hit
+ * @return `true` if any part of the segment is in the box
+ */
+bool Segment::intersects(const Aabb& box, double& t) const {
+
+    const Vec3 inverse = Vec3(1, 1, 1) / (end - start);
+    double t0 = 0;
+    double t1 = 1;
+
+    for (int i = 0; i < 3; ++i) {
+        const double a = (box.lower[i] - start[i]) * inverse[i];
+        const double b = (box.upper[i] - start[i]) * inverse[i];
+        t0 = std::max(t0, std::min(a, b));
+        t1 = std::min(t1, std::max(a, b));
+    }
+    if (t0 > t1) {
+        return false;
+    }
+    t = t0;
+    return true;
+}
+
+/**
+ * Tests the segment against many boxes.
+ *
+ * @param lower Minimum corners of boxes
+ * @param upper Maximum corners of boxes, the same size as `lower`
+ * @param t Array to store the parameter where the segment enters each box in, or `HUGE_VAL` if missed, with room for
+ *          every box
+ * @param mask Bitmask to store results in, which is resized to hold one bit per box
+ * @return Number of boxes hit
+ */
+size_t Segment::markHits(const Vec3Array& lower, const Vec3Array& upper, double* t, vector<uint32_t>& mask) const {
+
+    const size_t n = lower.size();
+    const Vec3 inverse = Vec3(1, 1, 1) / (end - start);
+    double margin[BLOCK_SIZE];
+    size_t count = 0;
+
+    mask.resize((n + 31) / 32);
+    for (size_t begin = 0; begin < n; begin += BLOCK_SIZE) {
+        const size_t stop = std::min(begin + BLOCK_SIZE, n);
+        for (size_t i = begin; i < stop; ++i) {
+            const double ax = (lower.x[i] - start.x) * inverse.x;
+            const double bx = (upper.x[i] - start.x) * inverse.x;
+            const double ay = (lower.y[i] - start.y) * inverse.y;
+            const double by = (upper.y[i] - start.y) * inverse.y;
+            const double az = (lower.z[i] - start.z) * inverse.z;
+            const double bz = (upper.z[i] - start.z) * inverse.z;
+            double t0 = std::max(std::min(ax, bx), std::min(ay, by));
+            double t1 = std::min(std::max(ax, bx), std::max(ay, by));
+            t0 = std::max(std::max(t0, std::min(az, bz)), 0.0);
+            t1 = std::min(std::min(t1, std::max(az, bz)), 1.0);
+            const bool hit = t0 <= t1;
+            t[i] = hit ? t0 : HUGE_VAL;
+            margin[i - begin] = hit ? 0 : -1;
+        }
+        count += Bitmask::setFromMargins(margin, begin, stop, &mask[0]);
+    }
+    return count;
+}
+
+/**
+ * Returns a string representation of the segment.
+ */
+string Segment::toString() const {
+    stringstream stream;
+    stream << (*this);
+    return stream.str();
+}
+
+} /* namespace M3d */
+
+/**
+ * Appends a segment to a stream.
+ *
+ * @param stream Stream to append to
+ * @param segment Segment to append
+ * @return Reference to the stream
+ */
+ostream& operator<<(ostream& stream, const M3d::Segment& segment) {
+    stream << '[' << segment.start << ", " << segment.end << ']';
+    return stream;
+}
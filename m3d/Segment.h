@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_SEGMENT_H
+#define M3D_SEGMENT_H
+#include "m3d/common.h"
+#include <iostream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "m3d/Aabb.h"
+#include "m3d/Bitmask.h"
+#include "m3d/Vec3.h"
+#include "m3d/Vec3Array.h"
+namespace M3d {
+
+
+/**
+ * Line segment between two points.
+ *
+ * Points along the segment are given by a parameter `t` in [0 .. 1], from `start` at zero to `end` at one.
+ *
+ * The batch test takes boxes as separate arrays of components so the segment can be tested against many boxes at once
+ * with SIMD instructions.  Results are written as the parameter where the segment enters each box and as a bitmask
+ * with one bit per box.
+ */
+class Segment {
+public:
+// Attributes
+    Vec3 start; ///< First end point
+    Vec3 end; ///< Second end point
+// Methods
+    explicit Segment();
+    explicit Segment(const Vec3& start, const Vec3& end);
+    Vec3 getClosestPoint(const Vec3& point) const;
+    double getLength() const;
+    Vec3 getPoint(double t) const;
+    bool intersects(const Aabb& box, double& t) const;
+    size_t markHits(const Vec3Array& lower, const Vec3Array& upper, double* t, std::vector<uint32_t>& mask) const;
+    std::string toString() const;
+private:
+// Constants
+    static const size_t BLOCK_SIZE = 256;
+};
+
+} /* namespace M3d */
+
+std::ostream& operator<<(std::ostream& stream, const M3d::Segment& segment);
+#endif
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cmath>
+#include <cstdlib>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/Segment.h"
+using namespace std;
+
+/*
+ * Constants
+ */
+const double TOLERANCE = 1e-9;
+
+
+/**
+ * Unit test for Segment.
+ */
+class SegmentTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + (upper - lower) * (rand() / (double) RAND_MAX);
+    }
+
+public:
+
+    /**
+     * Ensures getPoint, getLength and getClosestPoint work correctly.
+     */
+    void testPoints() {
+        const M3d::Segment segment(M3d::Vec3(0, 0, 0), M3d::Vec3(4, 0, 0));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(4.0, segment.getLength(), TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, segment.getPoint(0.25).x, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, segment.getClosestPoint(M3d::Vec3(3, 5, 0)).x, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, segment.getClosestPoint(M3d::Vec3(-2, 1, 0)).x, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(4.0, segment.getClosestPoint(M3d::Vec3(9, 1, 0)).x, TOLERANCE);
+    }
+
+    /**
+     * Ensures intersects with a box finds the entry parameter and rejects boxes beyond either end.
+     */
+    void testIntersects() {
+        const M3d::Aabb box(M3d::Vec3(1, -1, -1), M3d::Vec3(2, 1, 1));
+        double t = -1;
+        CPPUNIT_ASSERT(M3d::Segment(M3d::Vec3(0, 0, 0), M3d::Vec3(4, 0, 0)).intersects(box, t));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.25, t, TOLERANCE);
+        CPPUNIT_ASSERT(M3d::Segment(M3d::Vec3(1.5, 0, 0), M3d::Vec3(4, 0, 0)).intersects(box, t));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, t, TOLERANCE);
+        CPPUNIT_ASSERT(!M3d::Segment(M3d::Vec3(0, 0, 0), M3d::Vec3(0.5, 0, 0)).intersects(box, t));
+        CPPUNIT_ASSERT(!M3d::Segment(M3d::Vec3(3, 0, 0), M3d::Vec3(4, 0, 0)).intersects(box, t));
+        CPPUNIT_ASSERT(!M3d::Segment(M3d::Vec3(0, 2, 0), M3d::Vec3(4, 2, 0)).intersects(box, t));
+    }
+
+    /**
+     * Ensures the batch box test agrees with the single box test.
+     */
+    void testMarkHits() {
+
+        const size_t n = 1000;
+        M3d::Vec3Array lower(n), upper(n);
+        for (size_t i = 0; i < n; ++i) {
+            const M3d::Vec3 p(random(-20, 20), random(-20, 20), random(-20, 20));
+            lower.set(i, p);
+            upper.set(i, p + M3d::Vec3(random(0, 5), random(0, 5), random(0, 5)));
+        }
+        const M3d::Segment segment(M3d::Vec3(-15, -3, -2), M3d::Vec3(15, 4, 3));
+
+        vector<double> t(n);
+        vector<uint32_t> mask;
+        const size_t count = segment.markHits(lower, upper, &t[0], mask);
+
+        CPPUNIT_ASSERT_EQUAL((n + 31) / 32, mask.size());
+        size_t expected = 0;
+        for (size_t i = 0; i < n; ++i) {
+            double tHit;
+            const bool hit = segment.intersects(M3d::Aabb(lower.get(i), upper.get(i)), tHit);
+            CPPUNIT_ASSERT_EQUAL(hit, M3d::Bitmask::get(mask, i));
+            if (hit) {
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(tHit, t[i], TOLERANCE);
+                ++expected;
+            } else {
+                CPPUNIT_ASSERT_EQUAL(HUGE_VAL, t[i]);
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL(expected, count);
+        CPPUNIT_ASSERT(count > 0 && count < n);
+    }
+
+    CPPUNIT_TEST_SUITE(SegmentTest);
+    CPPUNIT_TEST(testPoints);
+    CPPUNIT_TEST(testIntersects);
+    CPPUNIT_TEST(testMarkHits);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(SegmentTest::suite());
+    runner.run();
+    return 0;
+}
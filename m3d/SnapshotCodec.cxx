@@ -0,0 +1,510 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <cmath>
+#include <stdexcept>
+#include "m3d/SnapshotCodec.h"
+using namespace std;
+namespace M3d {
+
+/* Halves of a unit scale, used for transforms missing from a baseline */
+static const uint16_t UNIT_SCALES[3] = { 0x3C00, 0x3C00, 0x3C00 };
+
+
+/*
+ * Reader of values packed into bits, lowest bits first.
+ */
+class SnapshotCodec::BitReader {
+public:
+    BitReader(const unsigned char* data, size_t size) : data(data), size(size), offset(0), pending(0), count(0) { }
+    size_t countBytes() const {
+        return offset;
+    }
+    uint64_t read(int bits) {
+        if (bits > 32) {
+            const uint64_t low = read(32);
+            return low | (read(bits - 32) << 32);
+        }
+        while (count < bits) {
+            if (offset >= size) {
+                throw runtime_error("[SnapshotCodec] Snapshot is truncated!");
+            }
+            pending |= ((uint64_t) data[offset++]) << count;
+            count += 8;
+        }
+        const uint64_t value = pending & ((((uint64_t) 1) << bits) - 1);
+        pending >>= bits;
+        count -= bits;
+        return value;
+    }
+private:
+    const unsigned char* data;
+    size_t size;
+    size_t offset;
+    uint64_t pending;
+    int count;
+};
+
+
+/*
+ * Writer of values packed into bits, lowest bits first.
+ */
+class SnapshotCodec::BitWriter {
+public:
+    explicit BitWriter(vector<unsigned char>& buffer) : buffer(buffer), pending(0), count(0) { }
+    void flush() {
+        if (count > 0) {
+            buffer.push_back((unsigned char) pending);
+            pending = 0;
+            count = 0;
+        }
+    }
+    void write(uint64_t value, int bits) {
+        if (bits > 32) {
+            write(value, 32);
+            value >>= 32;
+            bits -= 32;
+        }
+        pending |= (value & ((((uint64_t) 1) << bits) - 1)) << count;
+        count += bits;
+        while (count >= 8) {
+            buffer.push_back((unsigned char) pending);
+            pending >>= 8;
+            count -= 8;
+        }
+    }
+private:
+    vector<unsigned char>& buffer;
+    uint64_t pending;
+    int count;
+};
+
+
+/*
+ * Task converting a range of a snapshot back to transforms.
+ */
+class SnapshotCodec::DequantizeTask : public ParallelTask {
+public:
+    DequantizeTask(const SnapshotCodec& codec, const Snapshot& snapshot, Vec3* translations, Quat* rotations,
+                   Vec3* scales)
+            : codec(codec), snapshot(snapshot), translations(translations), rotations(rotations), scales(scales) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        const Vec3& lower = codec.bounds.lower;
+        const double precision = codec.precision;
+        for (size_t i = begin; i < end; ++i) {
+            if (translations != NULL) {
+                const uint32_t* const cells = &snapshot.cells[3 * i];
+                translations[i] = Vec3(lower.x + (cells[0] * precision),
+                                       lower.y + (cells[1] * precision),
+                                       lower.z + (cells[2] * precision));
+            }
+            if (rotations != NULL) {
+                rotations[i] = QuatCodec::decode(snapshot.rotations[i], codec.format);
+            }
+            if (scales != NULL) {
+                const uint16_t* const halves = &snapshot.scales[3 * i];
+                scales[i] = Vec3(Half::toDouble(halves[0]), Half::toDouble(halves[1]), Half::toDouble(halves[2]));
+            }
+        }
+    }
+private:
+    const SnapshotCodec& codec;
+    const Snapshot& snapshot;
+    Vec3* translations;
+    Quat* rotations;
+    Vec3* scales;
+};
+
+
+/*
+ * Task quantizing a range of transforms into a snapshot.
+ */
+class SnapshotCodec::QuantizeTask : public ParallelTask {
+public:
+    QuantizeTask(const SnapshotCodec& codec, const Vec3* translations, const Quat* rotations, const Vec3* scales,
+                 Snapshot& snapshot)
+            : codec(codec), translations(translations), rotations(rotations), scales(scales), snapshot(snapshot) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t* const cells = &snapshot.cells[3 * i];
+            if (translations != NULL) {
+                codec.quantizeTranslation(translations[i], cells);
+            } else {
+                codec.quantizeTranslation(Vec3(0, 0, 0), cells);
+            }
+            if (rotations != NULL) {
+                snapshot.rotations[i] = QuatCodec::encode(rotations[i], codec.format);
+            } else {
+                snapshot.rotations[i] = codec.identity;
+            }
+            uint16_t* const halves = &snapshot.scales[3 * i];
+            if (scales != NULL) {
+                halves[0] = Half::fromDouble(scales[i].x);
+                halves[1] = Half::fromDouble(scales[i].y);
+                halves[2] = Half::fromDouble(scales[i].z);
+            } else {
+                halves[0] = halves[1] = halves[2] = UNIT_SCALES[0];
+            }
+        }
+    }
+private:
+    const SnapshotCodec& codec;
+    const Vec3* translations;
+    const Quat* rotations;
+    const Vec3* scales;
+    Snapshot& snapshot;
+};
+
+// METHODS
+
+/**
+ * Constructs a codec.
+ *
+ * @param bounds Box translations are quantized over
+ * @param precision Width of each cell of the grid over the box
+ * @param format Layout of rotation codes
+ * @throws invalid_argument if the box is empty, the precision is not positive, the box has more than 2^30 cells along
+ *         an axis, or the format is unknown
+ */
+SnapshotCodec::SnapshotCodec(const Aabb& bounds, double precision, QuatCodec::Format format)
+        : bounds(bounds), precision(precision), format(format) {
+
+    if (bounds.isEmpty()) {
+        throw invalid_argument("[SnapshotCodec] Box is empty!");
+    } else if (!(precision > 0)) {
+        throw invalid_argument("[SnapshotCodec] Precision is not positive!");
+    }
+
+    const Vec3 extent = bounds.getExtent();
+    const double maxCells = (double) ((((uint64_t) 1) << MAX_CELL_BITS) - 1);
+    for (int i = 0; i < 3; ++i) {
+        const double cells = ceil(extent[i] / precision);
+        if (!(cells <= maxCells)) {
+            throw invalid_argument("[SnapshotCodec] Box has too many cells for precision!");
+        }
+        maxCell[i] = (uint32_t) cells;
+    }
+
+    rotationBits = QuatCodec::countBits(format);
+    identity = QuatCodec::encode(Quat::identity(), format);
+    quantizeTranslation(Vec3(0, 0, 0), origin);
+}
+
+/**
+ * Decodes a snapshot.
+ *
+ * @param data Bytes from `encode`
+ * @param size Number of bytes available, which may include bytes after the snapshot
+ * @param baseline Snapshot the bytes were encoded against, which may be the same object as the snapshot
+ * @param snapshot Snapshot to store the decoded transforms in
+ * @return Number of bytes the snapshot took
+ * @throws runtime_error if the bytes are truncated or corrupt, in which case the snapshot is unchanged
+ */
+size_t SnapshotCodec::decode(const void* data, size_t size, const Snapshot& baseline, Snapshot& snapshot) const {
+
+    BitReader reader(static_cast<const unsigned char*>(data), size);
+    const size_t count = (size_t) reader.read(32);
+    if (count > (8 * size)) {
+        throw runtime_error("[SnapshotCodec] Snapshot is corrupt!");
+    }
+
+    Snapshot result;
+    result.resize(count);
+    const uint64_t rotationMask = (((uint64_t) 1) << rotationBits) - 1;
+    for (size_t i = 0; i < count; ++i) {
+
+        // Start from the baseline, or the identity if the baseline does not have the transform
+        const bool inBaseline = (i < baseline.getCount());
+        const uint32_t* const previousCells = inBaseline ? &baseline.cells[3 * i] : origin;
+        const uint64_t previousRotation = inBaseline ? baseline.rotations[i] : identity;
+        const uint16_t* const previousScales = inBaseline ? &baseline.scales[3 * i] : UNIT_SCALES;
+        uint32_t* const cells = &result.cells[3 * i];
+        uint16_t* const scales = &result.scales[3 * i];
+        for (int j = 0; j < 3; ++j) {
+            cells[j] = previousCells[j];
+            scales[j] = previousScales[j];
+        }
+        result.rotations[i] = previousRotation;
+        if (reader.read(1) == 0) {
+            continue;
+        }
+
+        // Apply whichever fields changed
+        const uint64_t changed = reader.read(3);
+        if (changed & 1) {
+            for (int j = 0; j < 3; ++j) {
+                cells[j] = decodeDelta(reader, previousCells[j]);
+                if (cells[j] > maxCell[j]) {
+                    throw runtime_error("[SnapshotCodec] Snapshot is corrupt!");
+                }
+            }
+        }
+        if (changed & 2) {
+            if (reader.read(1) == 0) {
+                result.rotations[i] = reader.read(2 + (3 * rotationBits));
+            } else {
+                uint64_t rotation = previousRotation & 3;
+                for (int j = 0; j < 3; ++j) {
+                    const int shift = 2 + (j * rotationBits);
+                    const uint32_t previous = (uint32_t) ((previousRotation >> shift) & rotationMask);
+                    const uint32_t component = decodeDelta(reader, previous);
+                    if (component > rotationMask) {
+                        throw runtime_error("[SnapshotCodec] Snapshot is corrupt!");
+                    }
+                    rotation |= ((uint64_t) component) << shift;
+                }
+                result.rotations[i] = rotation;
+            }
+        }
+        if (changed & 4) {
+            for (int j = 0; j < 3; ++j) {
+                const uint32_t half = decodeDelta(reader, previousScales[j]);
+                if (half > 0xFFFF) {
+                    throw runtime_error("[SnapshotCodec] Snapshot is corrupt!");
+                }
+                scales[j] = (uint16_t) half;
+            }
+        }
+    }
+
+    snapshot.cells.swap(result.cells);
+    snapshot.rotations.swap(result.rotations);
+    snapshot.scales.swap(result.scales);
+    return reader.countBytes();
+}
+
+/**
+ * Converts a snapshot back to transforms, on several threads.
+ *
+ * @param snapshot Snapshot to convert
+ * @param translations Array with room for each translation, or `NULL` to skip translations
+ * @param rotations Array with room for each rotation, or `NULL` to skip rotations
+ * @param scales Array with room for each scale, or `NULL` to skip scales
+ */
+void SnapshotCodec::dequantize(const Snapshot& snapshot, Vec3* translations, Quat* rotations, Vec3* scales) const {
+    DequantizeTask task(*this, snapshot, translations, rotations, scales);
+    Parallel::run(task, snapshot.getCount(), GRAIN_SIZE);
+}
+
+/**
+ * Encodes the differences between a snapshot and a baseline.
+ *
+ * @param snapshot Snapshot to encode
+ * @param baseline Snapshot the receiver already has, or an empty snapshot
+ * @param buffer Buffer to append the bytes to
+ * @throws invalid_argument if the snapshot has 2^32 or more transforms
+ */
+void SnapshotCodec::encode(const Snapshot& snapshot, const Snapshot& baseline, vector<unsigned char>& buffer) const {
+
+    const size_t count = snapshot.getCount();
+    if (((uint64_t) count) >> 32) {
+        throw invalid_argument("[SnapshotCodec] Snapshot has too many transforms!");
+    }
+
+    BitWriter writer(buffer);
+    writer.write(count, 32);
+    const uint64_t rotationMask = (((uint64_t) 1) << rotationBits) - 1;
+    for (size_t i = 0; i < count; ++i) {
+
+        // Compare to the baseline, or the identity if the baseline does not have the transform
+        const bool inBaseline = (i < baseline.getCount());
+        const uint32_t* const previousCells = inBaseline ? &baseline.cells[3 * i] : origin;
+        const uint64_t previousRotation = inBaseline ? baseline.rotations[i] : identity;
+        const uint16_t* const previousScales = inBaseline ? &baseline.scales[3 * i] : UNIT_SCALES;
+        const uint32_t* const cells = &snapshot.cells[3 * i];
+        const uint64_t rotation = snapshot.rotations[i];
+        const uint16_t* const scales = &snapshot.scales[3 * i];
+        uint64_t changed = 0;
+        if ((cells[0] != previousCells[0]) || (cells[1] != previousCells[1]) || (cells[2] != previousCells[2])) {
+            changed |= 1;
+        }
+        if (rotation != previousRotation) {
+            changed |= 2;
+        }
+        if ((scales[0] != previousScales[0]) || (scales[1] != previousScales[1]) || (scales[2] != previousScales[2])) {
+            changed |= 4;
+        }
+        if (changed == 0) {
+            writer.write(0, 1);
+            continue;
+        }
+
+        // Store whichever fields changed
+        writer.write(1, 1);
+        writer.write(changed, 3);
+        if (changed & 1) {
+            for (int j = 0; j < 3; ++j) {
+                encodeDelta(writer, previousCells[j], cells[j]);
+            }
+        }
+        if (changed & 2) {
+            if ((rotation & 3) != (previousRotation & 3)) {
+                writer.write(0, 1);
+                writer.write(rotation, 2 + (3 * rotationBits));
+            } else {
+                writer.write(1, 1);
+                for (int j = 0; j < 3; ++j) {
+                    const int shift = 2 + (j * rotationBits);
+                    encodeDelta(writer,
+                                (uint32_t) ((previousRotation >> shift) & rotationMask),
+                                (uint32_t) ((rotation >> shift) & rotationMask));
+                }
+            }
+        }
+        if (changed & 4) {
+            for (int j = 0; j < 3; ++j) {
+                encodeDelta(writer, previousScales[j], scales[j]);
+            }
+        }
+    }
+    writer.flush();
+}
+
+/**
+ * Returns the box translations are quantized over.
+ */
+Aabb SnapshotCodec::getBounds() const {
+    return bounds;
+}
+
+/**
+ * Returns the layout of rotation codes.
+ */
+QuatCodec::Format SnapshotCodec::getFormat() const {
+    return format;
+}
+
+/**
+ * Returns the width of each cell of the grid translations are quantized to.
+ */
+double SnapshotCodec::getPrecision() const {
+    return precision;
+}
+
+/**
+ * Quantizes transforms into a snapshot, on several threads.
+ *
+ * @param translations Translation of each transform, or `NULL` for none
+ * @param rotations Rotation of each transform, which is normalized first, or `NULL` for none
+ * @param scales Scale factors along each axis of each transform, or `NULL` for none
+ * @param count Number of transforms
+ * @param snapshot Snapshot to store the quantized transforms in
+ */
+void SnapshotCodec::quantize(const Vec3* translations, const Quat* rotations, const Vec3* scales, size_t count,
+                             Snapshot& snapshot) const {
+    snapshot.resize(count);
+    QuantizeTask task(*this, translations, rotations, scales, snapshot);
+    Parallel::run(task, count, GRAIN_SIZE);
+}
+
+// HELPERS
+
+/*
+ * Reads a difference from a value, stored as a five-bit length followed by the difference in zigzag order.
+ */
+uint32_t SnapshotCodec::decodeDelta(BitReader& reader, uint32_t previous) {
+    const int length = (int) reader.read(LENGTH_BITS);
+    const uint64_t zigzag = reader.read(length);
+    const int64_t delta = (zigzag & 1) ? -((int64_t) ((zigzag + 1) >> 1)) : (int64_t) (zigzag >> 1);
+    const int64_t value = ((int64_t) previous) + delta;
+    if ((value < 0) || (value > (int64_t) 0xFFFFFFFF)) {
+        throw runtime_error("[SnapshotCodec] Snapshot is corrupt!");
+    }
+    return (uint32_t) value;
+}
+
+/*
+ * Writes the difference between two values, as a five-bit length followed by the difference in zigzag order.
+ */
+void SnapshotCodec::encodeDelta(BitWriter& writer, uint32_t previous, uint32_t current) {
+    const int64_t delta = ((int64_t) current) - ((int64_t) previous);
+    const uint64_t zigzag = (delta < 0) ? ((((uint64_t) -delta) << 1) - 1) : (((uint64_t) delta) << 1);
+    int length = 0;
+    while ((zigzag >> length) != 0) {
+        ++length;
+    }
+    writer.write(length, LENGTH_BITS);
+    writer.write(zigzag, length);
+}
+
+/*
+ * Rounds a translation to the nearest cell of the grid, clamped to the box.
+ */
+void SnapshotCodec::quantizeTranslation(const Vec3& translation, uint32_t cells[3]) const {
+    for (int i = 0; i < 3; ++i) {
+        const double cell = floor(((translation[i] - bounds.lower[i]) / precision) + 0.5);
+        if (!(cell > 0)) {
+            cells[i] = 0;
+        } else if (cell >= maxCell[i]) {
+            cells[i] = maxCell[i];
+        } else {
+            cells[i] = (uint32_t) cell;
+        }
+    }
+}
+
+// SNAPSHOT METHODS
+
+/**
+ * Constructs an empty snapshot.
+ */
+SnapshotCodec::Snapshot::Snapshot() {
+    // pass
+}
+
+/**
+ * Returns the number of transforms in the snapshot.
+ */
+size_t SnapshotCodec::Snapshot::getCount() const {
+    return rotations.size();
+}
+
+/**
+ * Checks if another snapshot holds exactly the same quantized transforms.
+ */
+bool SnapshotCodec::Snapshot::operator==(const Snapshot& snapshot) const {
+    return (cells == snapshot.cells) && (rotations == snapshot.rotations) && (scales == snapshot.scales);
+}
+
+/**
+ * Checks if another snapshot holds different quantized transforms.
+ */
+bool SnapshotCodec::Snapshot::operator!=(const Snapshot& snapshot) const {
+    return !(*this == snapshot);
+}
+
+// SNAPSHOT HELPERS
+
+/*
+ * Changes the number of transforms in the snapshot.
+ */
+void SnapshotCodec::Snapshot::resize(size_t count) {
+    cells.resize(3 * count);
+    rotations.resize(count);
+    scales.resize(3 * count);
+}
+
+} /* namespace M3d */
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_SNAPSHOTCODEC_H
+#define M3D_SNAPSHOTCODEC_H
+#include "m3d/common.h"
+#include <stdint.h>
+#include <vector>
+#include "m3d/Aabb.h"
+#include "m3d/Half.h"
+#include "m3d/Parallel.h"
+#include "m3d/Quat.h"
+#include "m3d/QuatCodec.h"
+#include "m3d/Vec3.h"
+namespace M3d {
+
+
+/**
+ * Compressor for streams of snapshots of many transforms, each made of a translation, a rotation and a scale.
+ *
+ * Transforms are first quantized into a snapshot.  Translations are rounded to a grid over a box, where each cell is as
+ * wide as the codec's precision, so translations inside the box are off by at most half the precision along each axis,
+ * and translations outside are clamped to it.  Rotations are stored with `QuatCodec` and scales as halves.  Sender and
+ * receiver both keep quantized snapshots, so they agree exactly on every value.
+ *
+ * A snapshot is then encoded against a baseline, usually the last snapshot the receiver acknowledged, which it must
+ * still have to decode it.  Each transform costs a single bit if nothing changed, and otherwise stores only the fields
+ * that changed, as differences packed into as few bits as they need.  Transforms the baseline does not have are
+ * encoded against the identity, so an empty baseline gives a snapshot that decodes on its own.  Codes are
+ * little-endian, and the sender and receiver must use codecs made with the same box, precision and format.
+ *
+ * Quantizing and dequantizing large snapshots is split across several threads.
+ */
+class SnapshotCodec {
+public:
+// Types
+    class Snapshot;
+// Methods
+    explicit SnapshotCodec(const Aabb& bounds, double precision, QuatCodec::Format format = QuatCodec::QUAT48);
+    size_t decode(const void* data, size_t size, const Snapshot& baseline, Snapshot& snapshot) const;
+    void dequantize(const Snapshot& snapshot, Vec3* translations, Quat* rotations, Vec3* scales) const;
+    void encode(const Snapshot& snapshot, const Snapshot& baseline, std::vector<unsigned char>& buffer) const;
+    Aabb getBounds() const;
+    QuatCodec::Format getFormat() const;
+    double getPrecision() const;
+    void quantize(const Vec3* translations, const Quat* rotations, const Vec3* scales, size_t count,
+                  Snapshot& snapshot) const;
+private:
+// Types
+    class BitReader;
+    class BitWriter;
+    class DequantizeTask;
+    class QuantizeTask;
+// Constants
+    static const int MAX_CELL_BITS = 30;
+    static const int LENGTH_BITS = 5;
+    static const size_t GRAIN_SIZE = 16384;
+// Attributes
+    Aabb bounds;
+    double precision;
+    QuatCodec::Format format;
+    int rotationBits;
+    uint32_t maxCell[3];
+    uint32_t origin[3];
+    uint64_t identity;
+// Helpers
+    static uint32_t decodeDelta(BitReader& reader, uint32_t previous);
+    static void encodeDelta(BitWriter& writer, uint32_t previous, uint32_t current);
+    void quantizeTranslation(const Vec3& translation, uint32_t cells[3]) const;
+};
+
+
+/**
+ * Transforms quantized by a `SnapshotCodec`.
+ *
+ * Snapshots can be copied, so one can be kept as the baseline for the next.
+ */
+class SnapshotCodec::Snapshot {
+public:
+// Methods
+    explicit Snapshot();
+    size_t getCount() const;
+// Operators
+    bool operator==(const Snapshot& snapshot) const;
+    bool operator!=(const Snapshot& snapshot) const;
+// Friends
+    friend class SnapshotCodec;
+private:
+// Attributes
+    std::vector<uint32_t> cells;
+    std::vector<uint64_t> rotations;
+    std::vector<uint16_t> scales;
+// Helpers
+    void resize(size_t count);
+};
+
+} /* namespace M3d */
+#endif
@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/SnapshotCodec.h"
+using namespace std;
+
+
+/**
+ * Unit test for SnapshotCodec.
+ */
+class SnapshotCodecTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + ((upper - lower) * rand() / RAND_MAX);
+    }
+
+    /**
+     * Makes random transforms.
+     */
+    static void makeTransforms(size_t size, vector<M3d::Vec3>& translations, vector<M3d::Quat>& rotations,
+                               vector<M3d::Vec3>& scales) {
+        translations.resize(size);
+        rotations.resize(size);
+        scales.resize(size);
+        for (size_t i = 0; i < size; ++i) {
+            translations[i] = M3d::Vec3(random(-500, 500), random(0, 50), random(-500, 500));
+            const M3d::Vec3 axis(random(-1, 1), random(-1, 1), random(-1, 1));
+            rotations[i] = M3d::Quat::fromAxisAngle(normalize(axis), random(-M3d::PI, M3d::PI));
+            const double scale = random(0.5, 2);
+            scales[i] = M3d::Vec3(scale, scale, scale);
+        }
+    }
+
+    /**
+     * Makes the codec used by the tests.
+     */
+    static M3d::SnapshotCodec makeCodec() {
+        const M3d::Aabb bounds(M3d::Vec3(-512, -16, -512), M3d::Vec3(512, 64, 512));
+        return M3d::SnapshotCodec(bounds, 0.01);
+    }
+
+public:
+
+    /**
+     * Resets the number of threads.
+     */
+    void tearDown() {
+        M3d::Parallel::setConcurrency(0);
+    }
+
+    /**
+     * Ensures transforms are quantized within the precision of the codec.
+     */
+    void testQuantize() {
+
+        M3d::Parallel::setConcurrency(4);
+        vector<M3d::Vec3> translations, scales;
+        vector<M3d::Quat> rotations;
+        makeTransforms(50001, translations, rotations, scales);
+        translations[0] = M3d::Vec3(1000, -1000, 0);
+        const M3d::SnapshotCodec codec = makeCodec();
+        M3d::SnapshotCodec::Snapshot snapshot;
+        codec.quantize(&translations[0], &rotations[0], &scales[0], translations.size(), snapshot);
+        CPPUNIT_ASSERT_EQUAL(translations.size(), snapshot.getCount());
+
+        vector<M3d::Vec3> outTranslations(translations.size()), outScales(translations.size());
+        vector<M3d::Quat> outRotations(translations.size());
+        codec.dequantize(snapshot, &outTranslations[0], &outRotations[0], &outScales[0]);
+        CPPUNIT_ASSERT(fabs(outTranslations[0].x - 512) < 1e-9);
+        CPPUNIT_ASSERT(fabs(outTranslations[0].y + 16) < 1e-9);
+        for (size_t i = 1; i < translations.size(); ++i) {
+            const M3d::Vec3 error = outTranslations[i] - translations[i];
+            CPPUNIT_ASSERT(std::max(fabs(error.x), std::max(fabs(error.y), fabs(error.z))) <= 0.005 + 1e-9);
+            const uint64_t code = M3d::QuatCodec::encode(rotations[i], M3d::QuatCodec::QUAT48);
+            CPPUNIT_ASSERT(M3d::QuatCodec::decode(code, M3d::QuatCodec::QUAT48) == outRotations[i]);
+            CPPUNIT_ASSERT(fabs(outScales[i].x - scales[i].x) <= 0.001);
+        }
+
+        // Missing fields are the identity
+        codec.quantize(NULL, NULL, NULL, 3, snapshot);
+        codec.dequantize(snapshot, &outTranslations[0], &outRotations[0], &outScales[0]);
+        for (size_t i = 0; i < 3; ++i) {
+            CPPUNIT_ASSERT(M3d::Vec3(0, 0, 0) == outTranslations[i]);
+            CPPUNIT_ASSERT(M3d::Quat::identity() == outRotations[i]);
+            CPPUNIT_ASSERT(M3d::Vec3(1, 1, 1) == outScales[i]);
+        }
+
+        CPPUNIT_ASSERT_THROW(M3d::SnapshotCodec(M3d::Aabb(), 0.01), invalid_argument);
+        CPPUNIT_ASSERT_THROW(M3d::SnapshotCodec(M3d::Aabb(M3d::Vec3(0, 0, 0)), 0), invalid_argument);
+        CPPUNIT_ASSERT_THROW(M3d::SnapshotCodec(M3d::Aabb(M3d::Vec3(0, 0, 0), M3d::Vec3(1e9, 1, 1)), 0.1),
+                             invalid_argument);
+    }
+
+    /**
+     * Ensures snapshots decode exactly, and only changed transforms take more than a bit.
+     */
+    void testEncode() {
+
+        vector<M3d::Vec3> translations, scales;
+        vector<M3d::Quat> rotations;
+        const size_t count = 10000;
+        makeTransforms(count, translations, rotations, scales);
+        const M3d::SnapshotCodec codec = makeCodec();
+        const M3d::SnapshotCodec::Snapshot empty;
+        M3d::SnapshotCodec::Snapshot first, second;
+        codec.quantize(&translations[0], &rotations[0], &scales[0], count, first);
+
+        // Change a few transforms a little, and one rotation a lot
+        for (size_t i = 0; i < count; i += 100) {
+            translations[i] = translations[i] + M3d::Vec3(0.05, 0, -0.02);
+            rotations[i] = rotations[i] * M3d::Quat::fromAxisAngle(M3d::Vec3(0, 1, 0), 0.01);
+        }
+        rotations[1] = rotations[1] * M3d::Quat::fromAxisAngle(M3d::Vec3(1, 0, 0), 2);
+        scales[2] = M3d::Vec3(1, 2, 3);
+        codec.quantize(&translations[0], &rotations[0], &scales[0], count, second);
+
+        // Encode a full snapshot and a delta in one buffer
+        vector<unsigned char> buffer;
+        codec.encode(first, empty, buffer);
+        const size_t full = buffer.size();
+        codec.encode(second, first, buffer);
+        const size_t delta = buffer.size() - full;
+        CPPUNIT_ASSERT(full < (count * 21));
+        CPPUNIT_ASSERT(delta < ((count / 8) + (count / 100 * 20) + 64));
+
+        M3d::SnapshotCodec::Snapshot received;
+        CPPUNIT_ASSERT_EQUAL(full, codec.decode(&buffer[0], buffer.size(), empty, received));
+        CPPUNIT_ASSERT(first == received);
+        CPPUNIT_ASSERT_EQUAL(delta, codec.decode(&buffer[full], delta, received, received));
+        CPPUNIT_ASSERT(second == received);
+        CPPUNIT_ASSERT(first != received);
+
+        // Unchanged snapshots take a bit per transform
+        buffer.clear();
+        codec.encode(second, second, buffer);
+        CPPUNIT_ASSERT_EQUAL(4 + (count / 8), buffer.size());
+        CPPUNIT_ASSERT_EQUAL(buffer.size(), codec.decode(&buffer[0], buffer.size(), second, received));
+        CPPUNIT_ASSERT(second == received);
+
+        // Snapshots with fewer transforms than the baseline
+        buffer.clear();
+        codec.quantize(&translations[0], &rotations[0], &scales[0], 10, received);
+        codec.encode(received, second, buffer);
+        M3d::SnapshotCodec::Snapshot shorter;
+        codec.decode(&buffer[0], buffer.size(), second, shorter);
+        CPPUNIT_ASSERT(received == shorter);
+    }
+
+    /**
+     * Ensures truncated or corrupt bytes are rejected without changing the snapshot.
+     */
+    void testDecode() {
+
+        vector<M3d::Vec3> translations, scales;
+        vector<M3d::Quat> rotations;
+        makeTransforms(100, translations, rotations, scales);
+        const M3d::SnapshotCodec codec = makeCodec();
+        const M3d::SnapshotCodec::Snapshot empty;
+        M3d::SnapshotCodec::Snapshot snapshot, received;
+        codec.quantize(&translations[0], &rotations[0], &scales[0], translations.size(), snapshot);
+        vector<unsigned char> buffer;
+        codec.encode(snapshot, empty, buffer);
+
+        for (size_t size = 0; size < buffer.size(); size += 7) {
+            CPPUNIT_ASSERT_THROW(codec.decode(&buffer[0], size, empty, received), runtime_error);
+            CPPUNIT_ASSERT_EQUAL((size_t) 0, received.getCount());
+        }
+        buffer[3] = 0x40;
+        CPPUNIT_ASSERT_THROW(codec.decode(&buffer[0], buffer.size(), empty, received), runtime_error);
+
+        // A translation past the far corner of the box
+        M3d::SnapshotCodec::Snapshot corner;
+        const M3d::Vec3 outside(512, 64, 512);
+        codec.quantize(&outside, NULL, NULL, 1, corner);
+        buffer.clear();
+        codec.encode(corner, empty, buffer);
+        const M3d::SnapshotCodec smaller(M3d::Aabb(M3d::Vec3(-512, -16, -512), M3d::Vec3(0, 0, 0)), 0.01);
+        CPPUNIT_ASSERT_THROW(smaller.decode(&buffer[0], buffer.size(), empty, received), runtime_error);
+    }
+
+    CPPUNIT_TEST_SUITE(SnapshotCodecTest);
+    CPPUNIT_TEST(testDecode);
+    CPPUNIT_TEST(testEncode);
+    CPPUNIT_TEST(testQuantize);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(SnapshotCodecTest::suite());
+    runner.run();
+    return 0;
+}
@@ -0,0 +1,483 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "m3d/SpatialHashGrid.h"
+using namespace std;
+namespace M3d {
+
+
+/*
+ * Task hashing the cells of a range of points.
+ */
+class SpatialHashGrid::HashTask : public ParallelTask {
+public:
+    HashTask(const SpatialHashGrid& grid, const Vec3Array& points, uint32_t* keys, uint32_t* values) :
+            grid(grid), points(points), keys(keys), values(values) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        int cell[3];
+        for (size_t i = begin; i < end; ++i) {
+            grid.findCell(points.x[i], points.y[i], points.z[i], cell);
+            keys[i] = grid.hash(cell[0], cell[1], cell[2]);
+            values[i] = (uint32_t) i;
+        }
+    }
+private:
+    const SpatialHashGrid& grid;
+    const Vec3Array& points;
+    uint32_t* keys;
+    uint32_t* values;
+};
+
+
+/*
+ * Task finding where each table entry starts and ends in a range of sorted keys, and gathering the points there.
+ *
+ * Every entry starts and ends at exactly one place in the sorted keys, so chunks never write to the same entry.
+ */
+class SpatialHashGrid::RangeTask : public ParallelTask {
+public:
+    RangeTask(SpatialHashGrid& grid, const Vec3Array& points, const vector<uint32_t>& keys) :
+            grid(grid), points(points), keys(keys) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        const size_t size = keys.size();
+        for (size_t i = begin; i < end; ++i) {
+            const uint32_t key = keys[i];
+            if ((i == 0) || (keys[i - 1] != key)) {
+                grid.starts[key] = (uint32_t) i;
+            }
+            if ((i + 1 == size) || (keys[i + 1] != key)) {
+                grid.ends[key] = (uint32_t) (i + 1);
+            }
+            const uint32_t j = grid.indices[i];
+            grid.points.x[i] = points.x[j];
+            grid.points.y[i] = points.y[j];
+            grid.points.z[i] = points.z[j];
+        }
+    }
+private:
+    SpatialHashGrid& grid;
+    const Vec3Array& points;
+    const vector<uint32_t>& keys;
+};
+
+
+/*
+ * Task finding points within a radius of a range of queries.
+ *
+ * Each chunk collects its results separately, along with how many each query found, so they can be joined in order
+ * afterwards.
+ */
+class SpatialHashGrid::RadiusTask : public ParallelTask {
+public:
+    RadiusTask(const SpatialHashGrid& grid, const Vec3Array& queries, double radius, vector<size_t>& offsets,
+               vector< vector<uint32_t> >& results) :
+            grid(grid), queries(queries), radius(radius), offsets(offsets), results(results) { }
+    virtual void run(size_t chunk, size_t begin, size_t end) {
+        vector<uint32_t>& result = results[chunk];
+        for (size_t i = begin; i < end; ++i) {
+            const size_t first = result.size();
+            grid.searchRadius(queries.get(i), radius, result);
+            for (size_t j = first; j < result.size(); ++j) {
+                result[j] = grid.indices[result[j]];
+            }
+            offsets[i + 1] = result.size() - first;
+        }
+    }
+private:
+    const SpatialHashGrid& grid;
+    const Vec3Array& queries;
+    double radius;
+    vector<size_t>& offsets;
+    vector< vector<uint32_t> >& results;
+};
+
+
+/*
+ * Task finding the nearest points to a range of queries.
+ */
+class SpatialHashGrid::NearestTask : public ParallelTask {
+public:
+    NearestTask(const SpatialHashGrid& grid, const Vec3Array& queries, size_t k, uint32_t* result) :
+            grid(grid), queries(queries), k(k), result(result) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        vector<Candidate> heap;
+        heap.reserve(k);
+        for (size_t i = begin; i < end; ++i) {
+            grid.searchNearest(queries.get(i), k, heap);
+            uint32_t* const r = result + (i * k);
+            for (size_t j = 0; j < k; ++j) {
+                r[j] = (j < heap.size()) ? grid.indices[heap[j].second] : (uint32_t) NO_POINT;
+            }
+        }
+    }
+private:
+    const SpatialHashGrid& grid;
+    const Vec3Array& queries;
+    size_t k;
+    uint32_t* result;
+};
+
+// METHODS
+
+/**
+ * Constructs an empty grid with cells one unit wide.
+ */
+SpatialHashGrid::SpatialHashGrid() : cellSize(1), inverseCellSize(1) {
+    // pass
+}
+
+/**
+ * Constructs an empty grid.
+ *
+ * @param cellSize Width of each cell, which should be about the radius of most queries
+ * @throws invalid_argument if cell size is not positive
+ */
+SpatialHashGrid::SpatialHashGrid(double cellSize) : cellSize(cellSize), inverseCellSize(1 / cellSize) {
+    if (!(cellSize > 0)) {
+        throw invalid_argument("[SpatialHashGrid] Cell size must be positive!");
+    }
+}
+
+/**
+ * Builds the grid over a set of points, replacing anything already in it.
+ *
+ * @param points Points to put in the grid, which are copied
+ */
+void SpatialHashGrid::build(const Vec3Array& points) {
+
+    const size_t size = points.size();
+
+    // Size the table
+    size_t tableSize = 1;
+    while (tableSize < size * 2) {
+        tableSize *= 2;
+    }
+    starts.assign(tableSize, 0);
+    ends.assign(tableSize, 0);
+    const Aabb bounds = Aabb::fromPoints(points);
+    findCell(bounds.lower.x, bounds.lower.y, bounds.lower.z, lowerCell);
+    findCell(bounds.upper.x, bounds.upper.y, bounds.upper.z, upperCell);
+
+    // Sort points by the hashes of their cells
+    vector<uint32_t> keys(size);
+    indices.resize(size);
+    if (size > 0) {
+        HashTask hashTask(*this, points, &keys[0], &indices[0]);
+        Parallel::run(hashTask, size, GRAIN_SIZE);
+        sortMortonCodes(&keys[0], &indices[0], size);
+    }
+
+    // Find ranges of table entries and reorder points
+    this->points.resize(size);
+    RangeTask rangeTask(*this, points, keys);
+    Parallel::run(rangeTask, size, GRAIN_SIZE);
+}
+
+/**
+ * Finds every point within a distance of another point.
+ *
+ * @param point Point to search around
+ * @param radius Largest distance to include, including points exactly that far away
+ * @param result List to store indices of points in, which is cleared first
+ */
+void SpatialHashGrid::findInRadius(const Vec3& point, double radius, vector<size_t>& result) const {
+
+    vector<uint32_t> slots;
+
+    searchRadius(point, radius, slots);
+    result.resize(slots.size());
+    for (size_t i = 0; i < slots.size(); ++i) {
+        result[i] = indices[slots[i]];
+    }
+}
+
+/**
+ * Finds every point within a distance of each of many points, on several threads.
+ *
+ * @param queries Points to search around
+ * @param radius Largest distance to include, including points exactly that far away
+ * @param offsets List to store where the results of each query start in, followed by the total number of results
+ * @param result List to store indices of points in, with the results of each query in order
+ */
+void SpatialHashGrid::findInRadius(const Vec3Array& queries, double radius, vector<size_t>& offsets,
+                                   vector<uint32_t>& result) const {
+
+    const size_t size = queries.size();
+    vector< vector<uint32_t> > results(Parallel::countChunks(size, QUERY_GRAIN_SIZE));
+
+    // Search on separate threads
+    offsets.assign(size + 1, 0);
+    RadiusTask task(*this, queries, radius, offsets, results);
+    Parallel::run(task, size, QUERY_GRAIN_SIZE);
+
+    // Join results
+    for (size_t i = 0; i < size; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+    result.resize(offsets[size]);
+    size_t position = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        copy(results[i].begin(), results[i].end(), result.begin() + position);
+        position += results[i].size();
+    }
+}
+
+/**
+ * Finds the points closest to another point.
+ *
+ * @param point Point to search around
+ * @param k Number of points to find
+ * @param result List to store indices of points in, nearest first, which has fewer than `k` only if the grid does
+ */
+void SpatialHashGrid::findNearest(const Vec3& point, size_t k, vector<size_t>& result) const {
+
+    vector<Candidate> heap;
+
+    searchNearest(point, k, heap);
+    result.resize(heap.size());
+    for (size_t i = 0; i < heap.size(); ++i) {
+        result[i] = indices[heap[i].second];
+    }
+}
+
+/**
+ * Finds the points closest to each of many points, on several threads.
+ *
+ * @param queries Points to search around
+ * @param k Number of points to find for each query
+ * @param result List to store indices of points in, `k` per query nearest first, padded with `NO_POINT` if the grid
+ *               has fewer than `k` points
+ */
+void SpatialHashGrid::findNearest(const Vec3Array& queries, size_t k, vector<uint32_t>& result) const {
+
+    const size_t size = queries.size();
+
+    result.resize(size * k);
+    if (k > 0) {
+        NearestTask task(*this, queries, k, &result[0]);
+        Parallel::run(task, size, QUERY_GRAIN_SIZE);
+    }
+}
+
+/**
+ * Returns the width of each cell.
+ */
+double SpatialHashGrid::getCellSize() const {
+    return cellSize;
+}
+
+/**
+ * Returns the index each point had when given to `build`, in the order the points are stored.
+ */
+const uint32_t* SpatialHashGrid::getIndices() const {
+    return indices.empty() ? NULL : &indices[0];
+}
+
+/**
+ * Returns the points in the order they are stored, with points in the same cell next to each other.
+ */
+const Vec3Array& SpatialHashGrid::getPoints() const {
+    return points;
+}
+
+/**
+ * Returns the number of points in the grid.
+ */
+size_t SpatialHashGrid::getSize() const {
+    return indices.size();
+}
+
+/**
+ * Returns the number of entries in the hash table.
+ */
+size_t SpatialHashGrid::getTableSize() const {
+    return starts.size();
+}
+
+// HELPERS
+
+/*
+ * Finds the integer coordinate of the cell containing a coordinate, clamped so far away cells still fit in an `int`.
+ */
+int SpatialHashGrid::findCell(double coordinate) const {
+    const double cell = floor(coordinate * inverseCellSize);
+    if (!(cell > -MAX_CELL)) {
+        return -MAX_CELL;
+    } else if (cell > MAX_CELL) {
+        return MAX_CELL;
+    }
+    return (int) cell;
+}
+
+/*
+ * Finds the integer coordinates of the cell containing a point.
+ */
+void SpatialHashGrid::findCell(double x, double y, double z, int cell[3]) const {
+    cell[0] = findCell(x);
+    cell[1] = findCell(y);
+    cell[2] = findCell(z);
+}
+
+/*
+ * Computes the table entry of a cell, using the hash from Teschner et al.
+ */
+uint32_t SpatialHashGrid::hash(int x, int y, int z) const {
+    const uint32_t h = ((uint32_t) x * 73856093u) ^ ((uint32_t) y * 19349663u) ^ ((uint32_t) z * 83492791u);
+    return h & (uint32_t) (starts.size() - 1);
+}
+
+/*
+ * Checks if a stored point is in a cell, rather than another cell with the same hash.
+ */
+bool SpatialHashGrid::isInCell(size_t slot, int x, int y, int z) const {
+    int cell[3];
+    findCell(points.x[slot], points.y[slot], points.z[slot], cell);
+    return (cell[0] == x) && (cell[1] == y) && (cell[2] == z);
+}
+
+/*
+ * Finds the stored points closest to a point, leaving them sorted nearest first.
+ *
+ * Cells are searched in rings of growing size around the cell containing the point, skipping cells outside the range
+ * of cells holding points.  Rings start at the first one reaching that range.  Points in rings after ring `r` are at
+ * least `r` cells away, so the search stops once the `k` closest points found so far are all nearer than that, or once
+ * the rings cover every point.
+ */
+void SpatialHashGrid::searchNearest(const Vec3& point, size_t k, vector<Candidate>& heap) const {
+
+    heap.clear();
+    if ((k == 0) || indices.empty()) {
+        return;
+    }
+
+    // Find the offsets of the occupied cells, and the rings that reach them
+    int cell[3], lower[3], upper[3];
+    findCell(point.x, point.y, point.z, cell);
+    int first = 0, last = 0;
+    for (int i = 0; i < 3; ++i) {
+        lower[i] = lowerCell[i] - cell[i];
+        upper[i] = upperCell[i] - cell[i];
+        first = std::max(first, std::max(lower[i], -upper[i]));
+        last = std::max(last, std::max(-lower[i], upper[i]));
+    }
+
+    // Search the occupied part of each ring
+    for (int r = first; r <= last; ++r) {
+        const int dxEnd = std::min(r, upper[0]);
+        const int dyEnd = std::min(r, upper[1]);
+        const int dzBegin = std::max(-r, lower[2]);
+        const int dzEnd = std::min(r, upper[2]);
+        for (int dx = std::max(-r, lower[0]); dx <= dxEnd; ++dx) {
+            for (int dy = std::max(-r, lower[1]); dy <= dyEnd; ++dy) {
+                const bool side = (dx == -r) || (dx == r) || (dy == -r) || (dy == r);
+                if (side) {
+                    for (int dz = dzBegin; dz <= dzEnd; ++dz) {
+                        searchNearestCell(point, cell[0] + dx, cell[1] + dy, cell[2] + dz, k, heap);
+                    }
+                } else {
+                    if (dzBegin == -r) {
+                        searchNearestCell(point, cell[0] + dx, cell[1] + dy, cell[2] - r, k, heap);
+                    }
+                    if (dzEnd == r) {
+                        searchNearestCell(point, cell[0] + dx, cell[1] + dy, cell[2] + r, k, heap);
+                    }
+                }
+            }
+        }
+        const double reach = r * cellSize;
+        if ((heap.size() == k) && (heap.front().first <= reach * reach)) {
+            break;
+        }
+    }
+    sort_heap(heap.begin(), heap.end());
+}
+
+/*
+ * Adds points in one cell to a heap of the closest points found so far, with the farthest on top.
+ */
+void SpatialHashGrid::searchNearestCell(const Vec3& point, int x, int y, int z, size_t k,
+                                        vector<Candidate>& heap) const {
+
+    const uint32_t h = hash(x, y, z);
+
+    for (uint32_t i = starts[h]; i < ends[h]; ++i) {
+        const double dx = points.x[i] - point.x;
+        const double dy = points.y[i] - point.y;
+        const double dz = points.z[i] - point.z;
+        const double d2 = (dx * dx) + (dy * dy) + (dz * dz);
+        if ((heap.size() == k) && !(d2 < heap.front().first)) {
+            continue;
+        } else if (!isInCell(i, x, y, z)) {
+            continue;
+        }
+        if (heap.size() == k) {
+            pop_heap(heap.begin(), heap.end());
+            heap.pop_back();
+        }
+        heap.push_back(Candidate(d2, i));
+        push_heap(heap.begin(), heap.end());
+    }
+}
+
+/*
+ * Appends the positions of stored points within a distance of a point, only searching cells holding points.
+ */
+void SpatialHashGrid::searchRadius(const Vec3& point, double radius, vector<uint32_t>& slots) const {
+
+    if (indices.empty()) {
+        return;
+    }
+
+    const double r2 = radius * radius;
+    int lower[3], upper[3];
+
+    findCell(point.x - radius, point.y - radius, point.z - radius, lower);
+    findCell(point.x + radius, point.y + radius, point.z + radius, upper);
+    for (int i = 0; i < 3; ++i) {
+        lower[i] = std::max(lower[i], lowerCell[i]);
+        upper[i] = std::min(upper[i], upperCell[i]);
+    }
+    for (int x = lower[0]; x <= upper[0]; ++x) {
+        for (int y = lower[1]; y <= upper[1]; ++y) {
+            for (int z = lower[2]; z <= upper[2]; ++z) {
+                const uint32_t h = hash(x, y, z);
+                for (uint32_t i = starts[h]; i < ends[h]; ++i) {
+                    const double dx = points.x[i] - point.x;
+                    const double dy = points.y[i] - point.y;
+                    const double dz = points.z[i] - point.z;
+                    if ((((dx * dx) + (dy * dy) + (dz * dz)) <= r2) && isInCell(i, x, y, z)) {
+                        slots.push_back(i);
+                    }
+                }
+            }
+        }
+    }
+}
+
+} /* namespace M3d */
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_SPATIALHASHGRID_H
+#define M3D_SPATIALHASHGRID_H
+#include "m3d/common.h"
+#include <stdint.h>
+#include <utility>
+#include <vector>
+#include "m3d/Aabb.h"
+#include "m3d/Morton.h"
+#include "m3d/Parallel.h"
+#include "m3d/Vec3.h"
+#include "m3d/Vec3Array.h"
+namespace M3d {
+
+
+/**
+ * Uniform grid over points, stored in a hash table so only occupied cells take space.
+ *
+ * Space is divided into cubes of equal size, and each cell is hashed into a table with a power of two entries, about
+ * twice as many as there are points.  Building sorts the points by the hashes of their cells with a counting sort, so
+ * points in the same cell end up next to each other, and each table entry only needs the range of sorted points in
+ * it.  Every step of the build runs on several threads.
+ *
+ * Radius queries look in every cell overlapping the sphere, so the cell size should be about the same as the radius
+ * used most, e.g. the smoothing length of a particle simulation.  Nearest queries look in rings of cells around the
+ * point until no closer point can be found.
+ *
+ * Results are indices into the array of points given to `build`.  The points are also kept in sorted order, along
+ * with the index of each one, so simulations can reorder their own data the same way for better locality.
+ */
+class SpatialHashGrid {
+public:
+// Constants
+    static const uint32_t NO_POINT = 0xFFFFFFFF; ///< Index padding batch nearest results when there are too few points
+// Methods
+    explicit SpatialHashGrid();
+    explicit SpatialHashGrid(double cellSize);
+    void build(const Vec3Array& points);
+    void findInRadius(const Vec3& point, double radius, std::vector<size_t>& result) const;
+    void findInRadius(const Vec3Array& queries, double radius, std::vector<size_t>& offsets,
+                      std::vector<uint32_t>& result) const;
+    void findNearest(const Vec3& point, size_t k, std::vector<size_t>& result) const;
+    void findNearest(const Vec3Array& queries, size_t k, std::vector<uint32_t>& result) const;
+    double getCellSize() const;
+    const uint32_t* getIndices() const;
+    const Vec3Array& getPoints() const;
+    size_t getSize() const;
+    size_t getTableSize() const;
+private:
+// Types
+    class HashTask;
+    class NearestTask;
+    class RadiusTask;
+    class RangeTask;
+    typedef std::pair<double,uint32_t> Candidate;
+// Constants
+    static const size_t GRAIN_SIZE = 65536;
+    static const size_t QUERY_GRAIN_SIZE = 1024;
+    static const int MAX_CELL = 1 << 29;
+// Attributes
+    double cellSize;
+    double inverseCellSize;
+    int lowerCell[3];
+    int upperCell[3];
+    Vec3Array points;
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> starts;
+    std::vector<uint32_t> ends;
+// Helpers
+    int findCell(double coordinate) const;
+    void findCell(double x, double y, double z, int cell[3]) const;
+    uint32_t hash(int x, int y, int z) const;
+    bool isInCell(size_t slot, int x, int y, int z) const;
+    void searchNearest(const Vec3& point, size_t k, std::vector<Candidate>& heap) const;
+    void searchNearestCell(const Vec3& point, int x, int y, int z, size_t k, std::vector<Candidate>& heap) const;
+    void searchRadius(const Vec3& point, double radius, std::vector<uint32_t>& slots) const;
+};
+
+} /* namespace M3d */
+#endif
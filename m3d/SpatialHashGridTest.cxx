@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/SpatialHashGrid.h"
+using namespace std;
+
+
+/**
+ * Unit test for SpatialHashGrid.
+ */
+class SpatialHashGridTest : public CppUnit::TestFixture {
+private:
+    M3d::Vec3Array points;
+    M3d::Vec3Array queries;
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + (upper - lower) * (rand() / (double) RAND_MAX);
+    }
+
+    /**
+     * Makes an array of random points in a cube.
+     */
+    static M3d::Vec3Array randomPoints(size_t size, double extent) {
+        M3d::Vec3Array arr(size);
+        for (size_t i = 0; i < size; ++i) {
+            arr.set(i, M3d::Vec3(random(-extent, extent), random(-extent, extent), random(-extent, extent)));
+        }
+        return arr;
+    }
+
+    /**
+     * Finds every point within a distance of another point by checking them all.
+     */
+    vector<size_t> findInRadius(const M3d::Vec3& point, double radius) const {
+        vector<size_t> result;
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (M3d::length(points.get(i) - point) <= radius) {
+                result.push_back(i);
+            }
+        }
+        return result;
+    }
+
+    /**
+     * Finds the points closest to another point by checking them all.
+     */
+    vector<size_t> findNearest(const M3d::Vec3& point, size_t k) const {
+        vector< pair<double,size_t> > candidates;
+        for (size_t i = 0; i < points.size(); ++i) {
+            candidates.push_back(make_pair(M3d::length(points.get(i) - point), i));
+        }
+        sort(candidates.begin(), candidates.end());
+        vector<size_t> result;
+        for (size_t i = 0; i < k && i < candidates.size(); ++i) {
+            result.push_back(candidates[i].second);
+        }
+        return result;
+    }
+
+public:
+
+    /**
+     * Prepares the fixture before running each test case.
+     */
+    void setUp() {
+        points = randomPoints(2000, 10);
+        queries = randomPoints(2500, 12);
+    }
+
+    /**
+     * Restores the default number of threads after each test case.
+     */
+    void tearDown() {
+        M3d::Parallel::setConcurrency(0);
+    }
+
+    /**
+     * Ensures the constructor rejects cells without a positive size.
+     */
+    void testConstructorInvalid() {
+        CPPUNIT_ASSERT_THROW(M3d::SpatialHashGrid(0), invalid_argument);
+    }
+
+    /**
+     * Ensures build stores the points sorted by cell along with their original indices.
+     */
+    void testBuild() {
+
+        M3d::SpatialHashGrid grid(1.5);
+        grid.build(points);
+
+        CPPUNIT_ASSERT_EQUAL(points.size(), grid.getSize());
+        CPPUNIT_ASSERT_EQUAL((size_t) 4096, grid.getTableSize());
+        const uint32_t* indices = grid.getIndices();
+        vector<bool> seen(points.size(), false);
+        for (size_t i = 0; i < grid.getSize(); ++i) {
+            CPPUNIT_ASSERT(!seen[indices[i]]);
+            seen[indices[i]] = true;
+            const M3d::Vec3 expected = points.get(indices[i]);
+            const M3d::Vec3 actual = grid.getPoints().get(i);
+            CPPUNIT_ASSERT_EQUAL(expected.x, actual.x);
+            CPPUNIT_ASSERT_EQUAL(expected.y, actual.y);
+            CPPUNIT_ASSERT_EQUAL(expected.z, actual.z);
+        }
+    }
+
+    /**
+     * Ensures building on several threads gives the same order as building on one.
+     */
+    void testBuildParallel() {
+
+        const M3d::Vec3Array many = randomPoints(200000, 50);
+        M3d::SpatialHashGrid serial(1), parallel(1);
+
+        M3d::Parallel::setConcurrency(1);
+        serial.build(many);
+        M3d::Parallel::setConcurrency(4);
+        parallel.build(many);
+
+        for (size_t i = 0; i < many.size(); ++i) {
+            CPPUNIT_ASSERT_EQUAL(serial.getIndices()[i], parallel.getIndices()[i]);
+        }
+    }
+
+    /**
+     * Ensures findInRadius finds the same points as checking every point.
+     */
+    void testFindInRadius() {
+
+        M3d::SpatialHashGrid grid(1);
+        grid.build(points);
+
+        for (size_t i = 0; i < 200; ++i) {
+            const M3d::Vec3 query = queries.get(i);
+            vector<size_t> result;
+            grid.findInRadius(query, 1.5, result);
+            sort(result.begin(), result.end());
+            const vector<size_t> expected = findInRadius(query, 1.5);
+            CPPUNIT_ASSERT(result == expected);
+        }
+    }
+
+    /**
+     * Ensures the batch findInRadius gives the same results as the single one on several threads.
+     */
+    void testFindInRadiusBatch() {
+
+        M3d::SpatialHashGrid grid(1);
+        grid.build(points);
+
+        M3d::Parallel::setConcurrency(4);
+        vector<size_t> offsets;
+        vector<uint32_t> result;
+        grid.findInRadius(queries, 1, offsets, result);
+
+        CPPUNIT_ASSERT_EQUAL(queries.size() + 1, offsets.size());
+        CPPUNIT_ASSERT_EQUAL(result.size(), offsets.back());
+        for (size_t i = 0; i < queries.size(); ++i) {
+            vector<size_t> expected;
+            grid.findInRadius(queries.get(i), 1, expected);
+            CPPUNIT_ASSERT_EQUAL(expected.size(), offsets[i + 1] - offsets[i]);
+            for (size_t j = 0; j < expected.size(); ++j) {
+                CPPUNIT_ASSERT_EQUAL(expected[j], (size_t) result[offsets[i] + j]);
+            }
+        }
+    }
+
+    /**
+     * Ensures findNearest finds the same points as checking every point, including queries far from every point.
+     */
+    void testFindNearest() {
+
+        M3d::SpatialHashGrid grid(1);
+        grid.build(points);
+
+        for (size_t i = 0; i < 200; ++i) {
+            const M3d::Vec3 query = (i % 10 == 0) ? (queries.get(i) * 3.0) : queries.get(i);
+            vector<size_t> result;
+            grid.findNearest(query, 8, result);
+            CPPUNIT_ASSERT(result == findNearest(query, 8));
+        }
+    }
+
+    /**
+     * Ensures queries far outside the points only search the cells holding points.
+     */
+    void testFindFarAway() {
+
+        points = randomPoints(1000, 1);
+        M3d::SpatialHashGrid grid(0.1);
+        grid.build(points);
+
+        for (size_t i = 0; i < 100; ++i) {
+            const M3d::Vec3 query(random(50, 70), random(-1, 1), random(-1e6, 1e6) * (i % 2));
+            vector<size_t> result;
+            grid.findNearest(query, 4, result);
+            CPPUNIT_ASSERT(result == findNearest(query, 4));
+            grid.findInRadius(query, 20, result);
+            CPPUNIT_ASSERT(result.empty());
+        }
+
+        vector<size_t> result;
+        grid.findInRadius(M3d::Vec3(10, 0, 0), 20, result);
+        CPPUNIT_ASSERT_EQUAL(points.size(), result.size());
+        grid.findNearest(M3d::Vec3(1e300, -1e300, 0), 3, result);
+        CPPUNIT_ASSERT_EQUAL((size_t) 3, result.size());
+        grid.findInRadius(M3d::Vec3(0, 0, 0), 1e300, result);
+        CPPUNIT_ASSERT_EQUAL(points.size(), result.size());
+    }
+
+    /**
+     * Ensures the batch findNearest gives the same results as the single one, padding when there are too few points.
+     */
+    void testFindNearestBatch() {
+
+        M3d::SpatialHashGrid grid(2);
+        grid.build(points);
+
+        M3d::Parallel::setConcurrency(4);
+        vector<uint32_t> result;
+        grid.findNearest(queries, 5, result);
+
+        CPPUNIT_ASSERT_EQUAL(queries.size() * 5, result.size());
+        for (size_t i = 0; i < queries.size(); ++i) {
+            vector<size_t> expected;
+            grid.findNearest(queries.get(i), 5, expected);
+            for (size_t j = 0; j < 5; ++j) {
+                CPPUNIT_ASSERT_EQUAL(expected[j], (size_t) result[(i * 5) + j]);
+            }
+        }
+
+        M3d::Vec3Array few(3);
+        M3d::SpatialHashGrid small(1);
+        small.build(few);
+        small.findNearest(queries, 5, result);
+        const uint32_t none = M3d::SpatialHashGrid::NO_POINT;
+        CPPUNIT_ASSERT(result[2] != none);
+        CPPUNIT_ASSERT_EQUAL(none, result[3]);
+        CPPUNIT_ASSERT_EQUAL(none, result[4]);
+    }
+
+    CPPUNIT_TEST_SUITE(SpatialHashGridTest);
+    CPPUNIT_TEST(testConstructorInvalid);
+    CPPUNIT_TEST(testBuild);
+    CPPUNIT_TEST(testBuildParallel);
+    CPPUNIT_TEST(testFindInRadius);
+    CPPUNIT_TEST(testFindInRadiusBatch);
+    CPPUNIT_TEST(testFindFarAway);
+    CPPUNIT_TEST(testFindNearest);
+    CPPUNIT_TEST(testFindNearestBatch);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(SpatialHashGridTest::suite());
+    runner.run();
+    return 0;
+}
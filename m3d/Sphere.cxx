@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include "m3d/Sphere.h"
+using namespace std;
+namespace M3d {
+
+/**
+ * Constructs a unit sphere at the origin.
+ */
+Sphere::Sphere() : center(0, 0, 0), radius(1) {
+    // pass
+}
+
+/**
+ * Constructs a sphere from a center and a radius.
+ *
+ * @param center Center
+ * @param radius Radius
+ */
+Sphere::Sphere(const Vec3& center, double radius) : center(center), radius(radius) {
+    // pass
+}
+
+/**
+ * Checks if a point is inside or on the sphere.
+ */
+bool Sphere::contains(const Vec3& point) const {
+    const Vec3 d = point - center;
+    return dot(d, d) <= (radius * radius);
+}
+
+/**
+ * Returns the smallest box containing the sphere.
+ */
+Aabb Sphere::getBounds() const {
+    return Aabb(center - radius, center + radius);
+}
+
+/**
+ * Checks if the sphere overlaps a box, including touching.
+ *
+ * @param box Box to check
+ * @return `true` if the point of the box closest to the center is within the radius
+ */
+bool Sphere::intersects(const Aabb& box) const {
+    const Vec3 d = center - max(box.lower, min(center, box.upper));
+    return dot(d, d) <= (radius * radius);
+}
+
+/**
+ * Checks if a ray hits the sphere.
+ *
+ * @param ray Ray to check
+ * @param tMax Largest distance along the ray to accept
+ * @param t Distance where the ray enters the sphere, or zero if it starts inside, set only if there is a hit
+ * @return `true` if the ray hits the sphere in [0 .. tMax]
+ */
+bool Sphere::intersects(const Ray& ray, double tMax, double& t) const {
+
+    // Solve |origin + direction * t - center|^2 = radius^2, with the middle coefficient halved
+    const Vec3 m = ray.origin - center;
+    const double a = dot(ray.direction, ray.direction);
+    const double b = dot(m, ray.direction);
+    const double c = dot(m, m) - (radius * radius);
+
+    // Outside and pointing away
+    if ((c > 0) && (b > 0)) {
+        return false;
+    }
+
+    const double discriminant = (b * b) - (a * c);
+    if (discriminant < 0) {
+        return false;
+    }
+
+    const double tHit = std::max((-b - sqrt(discriminant)) / a, 0.0);
+    if (tHit > tMax) {
+        return false;
+    }
+    t = tHit;
+    return true;
+}
+
+/**
+ * Checks if the sphere overlaps another sphere, including touching.
+ */
+bool Sphere::intersects(const Sphere& sphere) const {
+    const Vec3 d = sphere.center - center;
+    const double r = radius + sphere.radius;
+    return dot(d, d) <= (r * r);
+}
+
+/**
+ * Tests a ray against many spheres.
+ *
+ * @param ray Ray to test
+ * @param centers Centers of spheres
+ * @param radii Radii of spheres, the same size as `centers`
+ * @param tMax Largest distance along the ray to accept
+ * @param t Array to store the distance to each sphere in, or `HUGE_VAL` if missed, with room for every sphere
+ * @param mask Bitmask to store results in, which is resized to hold one bit per sphere
+ * @return Number of spheres hit
+ */
+size_t Sphere::markHits(const Ray& ray, const Vec3Array& centers, const vector<double>& radii, double tMax, double* t,
+                        vector<uint32_t>& mask) {
+
+    const size_t n = centers.size();
+    const double a = dot(ray.direction, ray.direction);
+    double margin[BLOCK_SIZE];
+    size_t count = 0;
+
+    mask.resize((n + 31) / 32);
+    for (size_t begin = 0; begin < n; begin += BLOCK_SIZE) {
+        const size_t end = std::min(begin + BLOCK_SIZE, n);
+        for (size_t i = begin; i < end; ++i) {
+            const double mx = ray.origin.x - centers.x[i];
+            const double my = ray.origin.y - centers.y[i];
+            const double mz = ray.origin.z - centers.z[i];
+            const double b = (mx * ray.direction.x) + (my * ray.direction.y) + (mz * ray.direction.z);
+            const double c = (mx * mx) + (my * my) + (mz * mz) - (radii[i] * radii[i]);
+            const double discriminant = (b * b) - (a * c);
+            const double tHit = std::max((-b - sqrt(std::max(discriminant, 0.0))) / a, 0.0);
+            const bool hit = (discriminant >= 0) & ((c <= 0) | (b <= 0)) & (tHit <= tMax);
+            t[i] = hit ? tHit : HUGE_VAL;
+            margin[i - begin] = hit ? 0 : -1;
+        }
+        count += Bitmask::setFromMargins(margin, begin, end, &mask[0]);
+    }
+    return count;
+}
+
+/**
+ * Tests the sphere against many boxes.
+ *
+ * @param lower Minimum corners of boxes
+ * @param upper Maximum corners of boxes, the same size as `lower`
+ * @param mask Bitmask to store results in, which is resized to hold one bit per box
+ * @return Number of boxes overlapping the sphere
+ */
+size_t Sphere::markOverlappingBoxes(const Vec3Array& lower, const Vec3Array& upper, vector<uint32_t>& mask) const {
+
+    const size_t n = lower.size();
+    const double r2 = radius * radius;
+    double margin[BLOCK_SIZE];
+    size_t count = 0;
+
+    mask.resize((n + 31) / 32);
+    for (size_t begin = 0; begin < n; begin += BLOCK_SIZE) {
+        const size_t end = std::min(begin + BLOCK_SIZE, n);
+        for (size_t i = begin; i < end; ++i) {
+            const double dx = center.x - std::max(lower.x[i], std::min(center.x, upper.x[i]));
+            const double dy = center.y - std::max(lower.y[i], std::min(center.y, upper.y[i]));
+            const double dz = center.z - std::max(lower.z[i], std::min(center.z, upper.z[i]));
+            margin[i - begin] = r2 - ((dx * dx) + (dy * dy) + (dz * dz));
+        }
+        count += Bitmask::setFromMargins(margin, begin, end, &mask[0]);
+    }
+    return count;
+}
+
+/**
+ * Tests the sphere against many other spheres.
+ *
+ * @param centers Centers of spheres
+ * @param radii Radii of spheres, the same size as `centers`
+ * @param mask Bitmask to store results in, which is resized to hold one bit per sphere
+ * @return Number of spheres overlapping this one
+ */
+size_t Sphere::markOverlappingSpheres(const Vec3Array& centers, const vector<double>& radii,
+                                      vector<uint32_t>& mask) const {
+
+    const size_t n = centers.size();
+    double margin[BLOCK_SIZE];
+    size_t count = 0;
+
+    mask.resize((n + 31) / 32);
+    for (size_t begin = 0; begin < n; begin += BLOCK_SIZE) {
+        const size_t end = std::min(begin + BLOCK_SIZE, n);
+        for (size_t i = begin; i < end; ++i) {
+            const double dx = centers.x[i] - center.x;
+            const double dy = centers.y[i] - center.y;
+            const double dz = centers.z[i] - center.z;
+            const double r = radius + radii[i];
+            margin[i - begin] = (r * r) - ((dx * dx) + (dy * dy) + (dz * dz));
+        }
+        count += Bitmask::setFromMargins(margin, begin, end, &mask[0]);
+    }
+    return count;
+}
+
+/**
+ * Returns a string representation of the sphere.
+ */
+string Sphere::toString() const {
+    stringstream stream;
+    stream << (*this);
+    return stream.str();
+}
+
+} /* namespace M3d */
+
+/**
+ * Appends a sphere to a stream.
+ *
+ * @param stream Stream to append to
+ * @param sphere Sphere to append
+ * @return Reference to the stream
+ */
+ostream& operator<<(ostream& stream, const M3d::Sphere& sphere) {
+    stream << '[' << sphere.center << ", " << sphere.radius << ']';
+    return stream;
+}
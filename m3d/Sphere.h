@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_SPHERE_H
+#define M3D_SPHERE_H
+#include "m3d/common.h"
+#include <iostream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "m3d/Aabb.h"
+#include "m3d/Bitmask.h"
+#include "m3d/Ray.h"
+#include "m3d/Vec3.h"
+#include "m3d/Vec3Array.h"
+namespace M3d {
+
+
+/**
+ * Sphere defined by a center and a radius.
+ *
+ * The batch tests take spheres or boxes as separate arrays of components so one object can be tested against many at
+ * once with SIMD instructions.  Results are written as a bitmask with one bit per object, and for rays also as a
+ * distance for each sphere.
+ */
+class Sphere {
+public:
+// Attributes
+    Vec3 center; ///< Center
+    double radius; ///< Radius
+// Methods
+    explicit Sphere();
+    explicit Sphere(const Vec3& center, double radius);
+    bool contains(const Vec3& point) const;
+    Aabb getBounds() const;
+    bool intersects(const Aabb& box) const;
+    bool intersects(const Ray& ray, double tMax, double& t) const;
+    bool intersects(const Sphere& sphere) const;
+    static size_t markHits(const Ray& ray, const Vec3Array& centers, const std::vector<double>& radii, double tMax,
+                           double* t, std::vector<uint32_t>& mask);
+    size_t markOverlappingBoxes(const Vec3Array& lower, const Vec3Array& upper, std::vector<uint32_t>& mask) const;
+    size_t markOverlappingSpheres(const Vec3Array& centers, const std::vector<double>& radii,
+                                  std::vector<uint32_t>& mask) const;
+    std::string toString() const;
+private:
+// Constants
+    static const size_t BLOCK_SIZE = 256;
+};
+
+} /* namespace M3d */
+
+std::ostream& operator<<(std::ostream& stream, const M3d::Sphere& sphere);
+#endif
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cmath>
+#include <cstdlib>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/Sphere.h"
+using namespace std;
+
+/*
+ * Constants
+ */
+const double TOLERANCE = 1e-9;
+
+
+/**
+ * Unit test for Sphere.
+ */
+class SphereTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + (upper - lower) * (rand() / (double) RAND_MAX);
+    }
+
+public:
+
+    /**
+     * Ensures contains and getBounds work correctly.
+     */
+    void testContainsAndGetBounds() {
+        const M3d::Sphere sphere(M3d::Vec3(1, 2, 3), 2);
+        CPPUNIT_ASSERT(sphere.contains(M3d::Vec3(1, 2, 5)));
+        CPPUNIT_ASSERT(!sphere.contains(M3d::Vec3(2.5, 3.5, 3)));
+        const M3d::Aabb bounds = sphere.getBounds();
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(-1.0, bounds.lower.x, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0, bounds.upper.z, TOLERANCE);
+    }
+
+    /**
+     * Ensures intersects with a ray finds the near hit, or zero if the ray starts inside.
+     */
+    void testIntersectsRay() {
+        const M3d::Sphere sphere(M3d::Vec3(0, 0, -10), 2);
+        double t = -1;
+        CPPUNIT_ASSERT(sphere.intersects(M3d::Ray(M3d::Vec3(0, 0, 0), M3d::Vec3(0, 0, -1)), 100, t));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(8.0, t, TOLERANCE);
+        CPPUNIT_ASSERT(sphere.intersects(M3d::Ray(M3d::Vec3(0, 1, -10), M3d::Vec3(1, 0, 0)), 100, t));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, t, TOLERANCE);
+        CPPUNIT_ASSERT(!sphere.intersects(M3d::Ray(M3d::Vec3(0, 0, 0), M3d::Vec3(0, 0, 1)), 100, t));
+        CPPUNIT_ASSERT(!sphere.intersects(M3d::Ray(M3d::Vec3(0, 3, 0), M3d::Vec3(0, 0, -1)), 100, t));
+        CPPUNIT_ASSERT(!sphere.intersects(M3d::Ray(M3d::Vec3(0, 0, 0), M3d::Vec3(0, 0, -1)), 5, t));
+    }
+
+    /**
+     * Ensures intersects with boxes and spheres works correctly.
+     */
+    void testIntersectsBoxAndSphere() {
+        const M3d::Sphere sphere(M3d::Vec3(0, 0, 0), 1);
+        CPPUNIT_ASSERT(sphere.intersects(M3d::Aabb(M3d::Vec3(0.5, 0.5, -1), M3d::Vec3(2, 2, 1))));
+        CPPUNIT_ASSERT(!sphere.intersects(M3d::Aabb(M3d::Vec3(0.8, 0.8, -1), M3d::Vec3(2, 2, 1))));
+        CPPUNIT_ASSERT(sphere.intersects(M3d::Sphere(M3d::Vec3(2, 0, 0), 1)));
+        CPPUNIT_ASSERT(!sphere.intersects(M3d::Sphere(M3d::Vec3(2, 1, 0), 1)));
+    }
+
+    /**
+     * Ensures the batch ray test agrees with the single ray test.
+     */
+    void testMarkHits() {
+
+        const size_t n = 1000;
+        M3d::Vec3Array centers(n);
+        vector<double> radii(n);
+        for (size_t i = 0; i < n; ++i) {
+            centers.set(i, M3d::Vec3(random(-20, 20), random(-20, 20), random(-20, 20)));
+            radii[i] = random(0.5, 3);
+        }
+        const M3d::Ray ray(M3d::Vec3(-20, -1, 0), M3d::normalize(M3d::Vec3(1, 0.1, 0.05)));
+
+        vector<double> t(n);
+        vector<uint32_t> mask;
+        const size_t count = M3d::Sphere::markHits(ray, centers, radii, 30, &t[0], mask);
+
+        CPPUNIT_ASSERT_EQUAL((n + 31) / 32, mask.size());
+        size_t expected = 0;
+        for (size_t i = 0; i < n; ++i) {
+            double tHit;
+            const bool hit = M3d::Sphere(centers.get(i), radii[i]).intersects(ray, 30, tHit);
+            CPPUNIT_ASSERT_EQUAL(hit, M3d::Bitmask::get(mask, i));
+            if (hit) {
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(tHit, t[i], TOLERANCE);
+                ++expected;
+            } else {
+                CPPUNIT_ASSERT_EQUAL(HUGE_VAL, t[i]);
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL(expected, count);
+        CPPUNIT_ASSERT(count > 0 && count < n);
+    }
+
+    /**
+     * Ensures the batch box and sphere overlap tests agree with the single tests.
+     */
+    void testMarkOverlapping() {
+
+        const size_t n = 1000;
+        M3d::Vec3Array lower(n), upper(n), centers(n);
+        vector<double> radii(n);
+        for (size_t i = 0; i < n; ++i) {
+            const M3d::Vec3 p(random(-20, 20), random(-20, 20), random(-20, 20));
+            lower.set(i, p);
+            upper.set(i, p + M3d::Vec3(random(0, 5), random(0, 5), random(0, 5)));
+            centers.set(i, M3d::Vec3(random(-20, 20), random(-20, 20), random(-20, 20)));
+            radii[i] = random(0, 5);
+        }
+        const M3d::Sphere sphere(M3d::Vec3(1, -2, 3), 8);
+
+        vector<uint32_t> boxMask, sphereMask;
+        const size_t boxCount = sphere.markOverlappingBoxes(lower, upper, boxMask);
+        const size_t sphereCount = sphere.markOverlappingSpheres(centers, radii, sphereMask);
+
+        size_t boxExpected = 0, sphereExpected = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const bool box = sphere.intersects(M3d::Aabb(lower.get(i), upper.get(i)));
+            const bool other = sphere.intersects(M3d::Sphere(centers.get(i), radii[i]));
+            CPPUNIT_ASSERT_EQUAL(box, M3d::Bitmask::get(boxMask, i));
+            CPPUNIT_ASSERT_EQUAL(other, M3d::Bitmask::get(sphereMask, i));
+            boxExpected += box ? 1 : 0;
+            sphereExpected += other ? 1 : 0;
+        }
+        CPPUNIT_ASSERT_EQUAL(boxExpected, boxCount);
+        CPPUNIT_ASSERT_EQUAL(sphereExpected, sphereCount);
+        CPPUNIT_ASSERT(boxCount > 0 && boxCount < n);
+        CPPUNIT_ASSERT(sphereCount > 0 && sphereCount < n);
+    }
+
+    CPPUNIT_TEST_SUITE(SphereTest);
+    CPPUNIT_TEST(testContainsAndGetBounds);
+    CPPUNIT_TEST(testIntersectsRay);
+    CPPUNIT_TEST(testIntersectsBoxAndSphere);
+    CPPUNIT_TEST(testMarkHits);
+    CPPUNIT_TEST(testMarkOverlapping);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(SphereTest::suite());
+    runner.run();
+    return 0;
+}
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include "m3d/SweepAndPrune.h"
+using namespace std;
+namespace M3d {
+
+
+/*
+ * Compares boxes by their lower bounds along the sweep axis.
+ */
+class SweepAndPrune::KeyLess {
+public:
+    KeyLess(const Aabb* boxes, int axis) : boxes(boxes), axis(axis) { }
+    bool operator()(uint32_t a, uint32_t b) const {
+        return boxes[a].lower[axis] < boxes[b].lower[axis];
+    }
+private:
+    const Aabb* boxes;
+    int axis;
+};
+
+
+/*
+ * Task sweeping from a range of boxes, collecting pairs for each chunk separately so they can be joined in order.
+ */
+class SweepAndPrune::PairTask : public ParallelTask {
+public:
+    PairTask(const SweepAndPrune& sap, vector< vector<Pair> >& results) : sap(sap), results(results) { }
+    virtual void run(size_t chunk, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            sap.sweep(i, results[chunk]);
+        }
+    }
+private:
+    const SweepAndPrune& sap;
+    vector< vector<Pair> >& results;
+};
+
+// METHODS
+
+/**
+ * Constructs an empty broadphase sweeping along X.
+ */
+SweepAndPrune::SweepAndPrune() : axis(0) {
+    // pass
+}
+
+/**
+ * Finds every pair of overlapping boxes, including boxes that only touch, on several threads.
+ *
+ * @param pairs List to store pairs in, which is cleared first
+ * @return Number of pairs found
+ */
+size_t SweepAndPrune::findPairs(vector<Pair>& pairs) const {
+
+    const size_t size = order.size();
+    vector< vector<Pair> > results(Parallel::countChunks(size, GRAIN_SIZE));
+
+    // Sweep on separate threads
+    PairTask task(*this, results);
+    Parallel::run(task, size, GRAIN_SIZE);
+
+    // Join results
+    size_t total = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        total += results[i].size();
+    }
+    pairs.resize(total);
+    size_t position = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        copy(results[i].begin(), results[i].end(), pairs.begin() + position);
+        position += results[i].size();
+    }
+    return total;
+}
+
+/**
+ * Returns the index of the axis boxes are sorted along, where zero is X.
+ */
+int SweepAndPrune::getAxis() const {
+    return axis;
+}
+
+/**
+ * Returns indices of the boxes in sorted order.
+ */
+const uint32_t* SweepAndPrune::getOrder() const {
+    return order.empty() ? NULL : &order[0];
+}
+
+/**
+ * Returns the number of boxes.
+ */
+size_t SweepAndPrune::getSize() const {
+    return order.size();
+}
+
+/**
+ * Sorts a new set of boxes from scratch, choosing the axis their centers spread the most along.
+ *
+ * @param boxes Array of boxes, which are copied, so the array is not needed after the call
+ * @param size Number of boxes
+ */
+void SweepAndPrune::setBoxes(const Aabb* boxes, size_t size) {
+
+    // Find variance of centers along each axis
+    Vec3 sum(0, 0, 0), sumSquares(0, 0, 0);
+    for (size_t i = 0; i < size; ++i) {
+        const Vec3 center = boxes[i].getCenter();
+        sum = sum + center;
+        sumSquares = sumSquares + (center * center);
+    }
+    const Vec3 mean = (size > 0) ? (sum / (double) size) : sum;
+    const Vec3 variance = (size > 0) ? ((sumSquares / (double) size) - (mean * mean)) : sum;
+    axis = (variance.x >= variance.y) ? ((variance.x >= variance.z) ? 0 : 2) : ((variance.y >= variance.z) ? 1 : 2);
+
+    // Sort along that axis
+    order.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+        order[i] = (uint32_t) i;
+    }
+    sort(order.begin(), order.end(), KeyLess(boxes, axis));
+    keys.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+        keys[i] = boxes[order[i]].lower[axis];
+    }
+    gather(boxes);
+}
+
+/**
+ * Fixes the order after boxes have moved, keeping the same axis.
+ *
+ * @param boxes Array of boxes, the same size as given to `setBoxes`
+ * @return Number of times boxes changed places
+ */
+size_t SweepAndPrune::update(const Aabb* boxes) {
+
+    const size_t size = order.size();
+    size_t swaps = 0;
+
+    // Insertion sort by new lower bounds
+    for (size_t i = 0; i < size; ++i) {
+        keys[i] = boxes[order[i]].lower[axis];
+    }
+    for (size_t i = 1; i < size; ++i) {
+        const double key = keys[i];
+        const uint32_t index = order[i];
+        size_t j = i;
+        while ((j > 0) && (keys[j - 1] > key)) {
+            keys[j] = keys[j - 1];
+            order[j] = order[j - 1];
+            --j;
+        }
+        keys[j] = key;
+        order[j] = index;
+        swaps += i - j;
+    }
+    gather(boxes);
+    return swaps;
+}
+
+// HELPERS
+
+/*
+ * Copies the bounds of the boxes into sorted order.
+ */
+void SweepAndPrune::gather(const Aabb* boxes) {
+    const size_t size = order.size();
+    lower.resize(size);
+    upper.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+        const Aabb& box = boxes[order[i]];
+        lower.set(i, box.lower);
+        upper.set(i, box.upper);
+    }
+}
+
+/*
+ * Returns one component array of a vector array.
+ */
+const vector<double>& SweepAndPrune::getComponent(const Vec3Array& arr, int i) const {
+    return (i == 0) ? arr.x : ((i == 1) ? arr.y : arr.z);
+}
+
+/*
+ * Finds the boxes after one in sorted order that overlap it.
+ *
+ * Boxes are checked a block at a time, stopping after the first block that reaches past the box along the sweep axis.
+ */
+void SweepAndPrune::sweep(size_t i, vector<Pair>& pairs) const {
+
+    const size_t size = order.size();
+    const int b = (axis + 1) % 3;
+    const int c = (axis + 2) % 3;
+    const double* const lowerA = &getComponent(lower, axis)[0];
+    const double* const lowerB = &getComponent(lower, b)[0];
+    const double* const lowerC = &getComponent(lower, c)[0];
+    const double* const upperB = &getComponent(upper, b)[0];
+    const double* const upperC = &getComponent(upper, c)[0];
+    const double endA = getComponent(upper, axis)[i];
+    const double startB = lowerB[i], endB = upperB[i];
+    const double startC = lowerC[i], endC = upperC[i];
+    bool overlaps[BLOCK_SIZE];
+
+    for (size_t first = i + 1; first < size; first += BLOCK_SIZE) {
+        const size_t count = ((size - first) < BLOCK_SIZE) ? (size - first) : BLOCK_SIZE;
+        for (size_t k = 0; k < count; ++k) {
+            const size_t j = first + k;
+            overlaps[k] = (lowerA[j] <= endA)
+                    & (lowerB[j] <= endB) & (upperB[j] >= startB)
+                    & (lowerC[j] <= endC) & (upperC[j] >= startC);
+        }
+        for (size_t k = 0; k < count; ++k) {
+            if (overlaps[k]) {
+                const uint32_t p = order[i];
+                const uint32_t q = order[first + k];
+                pairs.push_back((p < q) ? Pair(p, q) : Pair(q, p));
+            }
+        }
+        if (lowerA[first + count - 1] > endA) {
+            break;
+        }
+    }
+}
+
+} /* namespace M3d */
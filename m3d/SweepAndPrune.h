@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_SWEEPANDPRUNE_H
+#define M3D_SWEEPANDPRUNE_H
+#include "m3d/common.h"
+#include <stdint.h>
+#include <utility>
+#include <vector>
+#include "m3d/Aabb.h"
+#include "m3d/Parallel.h"
+#include "m3d/Vec3Array.h"
+namespace M3d {
+
+
+/**
+ * Broadphase finding overlapping pairs of boxes by sorting them along one axis.
+ *
+ * Boxes are kept sorted by their lower bounds along the axis where their centers spread the most.  Each box can then
+ * only overlap the boxes after it whose lower bounds are not past its upper bound, so pairs are found by sweeping
+ * forward from each box and checking the other two axes.  Bounds are stored in sorted order as separate arrays of
+ * components, and each sweep checks a block of boxes at a time without branching so the compiler can vectorize it.
+ *
+ * When boxes move a little between frames, `update` fixes the order with an insertion sort, which is close to linear
+ * time because few boxes change places.  If they move a lot, or the best axis changes, call `setBoxes` again.
+ */
+class SweepAndPrune {
+public:
+// Types
+    typedef std::pair<uint32_t,uint32_t> Pair; ///< Indices of two overlapping boxes, smallest first
+// Methods
+    explicit SweepAndPrune();
+    size_t findPairs(std::vector<Pair>& pairs) const;
+    int getAxis() const;
+    const uint32_t* getOrder() const;
+    size_t getSize() const;
+    void setBoxes(const Aabb* boxes, size_t size);
+    size_t update(const Aabb* boxes);
+private:
+// Types
+    class KeyLess;
+    class PairTask;
+// Constants
+    static const size_t BLOCK_SIZE = 64;
+    static const size_t GRAIN_SIZE = 16384;
+// Attributes
+    int axis;
+    std::vector<uint32_t> order;
+    std::vector<double> keys;
+    Vec3Array lower;
+    Vec3Array upper;
+// Helpers
+    void gather(const Aabb* boxes);
+    void sweep(size_t i, std::vector<Pair>& pairs) const;
+    const std::vector<double>& getComponent(const Vec3Array& arr, int i) const;
+};
+
+} /* namespace M3d */
+#endif
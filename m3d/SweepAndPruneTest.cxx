@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/SweepAndPrune.h"
+using namespace std;
+
+
+/**
+ * Unit test for SweepAndPrune.
+ */
+class SweepAndPruneTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + (upper - lower) * (rand() / (double) RAND_MAX);
+    }
+
+    /**
+     * Makes random boxes with centers spread more along Y than the other axes.
+     */
+    static vector<M3d::Aabb> randomBoxes(size_t size, double extent) {
+        vector<M3d::Aabb> boxes(size);
+        for (size_t i = 0; i < size; ++i) {
+            const M3d::Vec3 p(random(-extent, extent), random(-extent * 2, extent * 2), random(-extent, extent));
+            boxes[i] = M3d::Aabb(p, p + M3d::Vec3(random(0, 2), random(0, 2), random(0, 2)));
+        }
+        return boxes;
+    }
+
+    /**
+     * Finds every pair of overlapping boxes by checking them all.
+     */
+    static vector<M3d::SweepAndPrune::Pair> findPairs(const vector<M3d::Aabb>& boxes) {
+        vector<M3d::SweepAndPrune::Pair> pairs;
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            for (size_t j = i + 1; j < boxes.size(); ++j) {
+                if (boxes[i].intersects(boxes[j])) {
+                    pairs.push_back(M3d::SweepAndPrune::Pair(i, j));
+                }
+            }
+        }
+        return pairs;
+    }
+
+public:
+
+    /**
+     * Restores the default number of threads after each test case.
+     */
+    void tearDown() {
+        M3d::Parallel::setConcurrency(0);
+    }
+
+    /**
+     * Ensures setBoxes picks the axis with the most spread and sorts along it.
+     */
+    void testSetBoxes() {
+
+        const vector<M3d::Aabb> boxes = randomBoxes(1000, 20);
+        M3d::SweepAndPrune sap;
+        sap.setBoxes(&boxes[0], boxes.size());
+
+        CPPUNIT_ASSERT_EQUAL(1, sap.getAxis());
+        CPPUNIT_ASSERT_EQUAL(boxes.size(), sap.getSize());
+        for (size_t i = 1; i < sap.getSize(); ++i) {
+            CPPUNIT_ASSERT(boxes[sap.getOrder()[i - 1]].lower.y <= boxes[sap.getOrder()[i]].lower.y);
+        }
+    }
+
+    /**
+     * Ensures findPairs finds the same pairs as checking every pair.
+     */
+    void testFindPairs() {
+
+        const vector<M3d::Aabb> boxes = randomBoxes(3000, 20);
+        M3d::SweepAndPrune sap;
+        sap.setBoxes(&boxes[0], boxes.size());
+
+        vector<M3d::SweepAndPrune::Pair> pairs;
+        const size_t count = sap.findPairs(pairs);
+        sort(pairs.begin(), pairs.end());
+
+        CPPUNIT_ASSERT_EQUAL(pairs.size(), count);
+        CPPUNIT_ASSERT(count > 0);
+        CPPUNIT_ASSERT(pairs == findPairs(boxes));
+    }
+
+    /**
+     * Ensures update keeps the order sorted and the pairs correct after boxes move a little.
+     */
+    void testUpdate() {
+
+        vector<M3d::Aabb> boxes = randomBoxes(3000, 20);
+        M3d::SweepAndPrune sap;
+        sap.setBoxes(&boxes[0], boxes.size());
+
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            const M3d::Vec3 offset(random(-0.5, 0.5), random(-0.5, 0.5), random(-0.5, 0.5));
+            boxes[i] = M3d::Aabb(boxes[i].lower + offset, boxes[i].upper + offset);
+        }
+        const size_t swaps = sap.update(&boxes[0]);
+
+        CPPUNIT_ASSERT(swaps > 0);
+        for (size_t i = 1; i < sap.getSize(); ++i) {
+            CPPUNIT_ASSERT(boxes[sap.getOrder()[i - 1]].lower.y <= boxes[sap.getOrder()[i]].lower.y);
+        }
+        vector<M3d::SweepAndPrune::Pair> pairs;
+        sap.findPairs(pairs);
+        sort(pairs.begin(), pairs.end());
+        CPPUNIT_ASSERT(pairs == findPairs(boxes));
+    }
+
+    /**
+     * Ensures finding pairs on several threads gives the same pairs in the same order as on one.
+     */
+    void testFindPairsParallel() {
+
+        const vector<M3d::Aabb> boxes = randomBoxes(50000, 100);
+        M3d::SweepAndPrune sap;
+        sap.setBoxes(&boxes[0], boxes.size());
+
+        vector<M3d::SweepAndPrune::Pair> serial, parallel;
+        M3d::Parallel::setConcurrency(1);
+        sap.findPairs(serial);
+        M3d::Parallel::setConcurrency(4);
+        sap.findPairs(parallel);
+
+        CPPUNIT_ASSERT(!serial.empty());
+        CPPUNIT_ASSERT(serial == parallel);
+    }
+
+    CPPUNIT_TEST_SUITE(SweepAndPruneTest);
+    CPPUNIT_TEST(testSetBoxes);
+    CPPUNIT_TEST(testFindPairs);
+    CPPUNIT_TEST(testUpdate);
+    CPPUNIT_TEST(testFindPairsParallel);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(SweepAndPruneTest::suite());
+    runner.run();
+    return 0;
+}
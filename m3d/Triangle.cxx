@@ -0,0 +1,332 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <sstream>
+#include "m3d/Triangle.h"
+using namespace std;
+namespace M3d {
+
+/*
+ * Packs an array of flags into a mask, with bit `i` set if flag `i` is.
+ */
+static unsigned int toMask(const bool* flags, size_t size) {
+    unsigned int mask = 0;
+    for (size_t i = 0; i < size; ++i) {
+        mask |= ((unsigned int) flags[i]) << i;
+    }
+    return mask;
+}
+
+/*
+ * Tests a ray that has already been sheared onto the Z axis against a triangle.
+ */
+static bool intersectSheared(const Vec3& a, const Vec3& b, const Vec3& c, const Vec3& origin, const int k[3],
+                             const Vec3& shear, double tMax, double& t, double& u, double& v) {
+
+    // Move vertices into the space of the ray
+    const Vec3 pa = a - origin;
+    const Vec3 pb = b - origin;
+    const Vec3 pc = c - origin;
+    const double ax = pa[k[0]] - (shear.x * pa[k[2]]);
+    const double ay = pa[k[1]] - (shear.y * pa[k[2]]);
+    const double bx = pb[k[0]] - (shear.x * pb[k[2]]);
+    const double by = pb[k[1]] - (shear.y * pb[k[2]]);
+    const double cx = pc[k[0]] - (shear.x * pc[k[2]]);
+    const double cy = pc[k[1]] - (shear.y * pc[k[2]]);
+
+    // Check which side of each edge the ray is on
+    const double ea = (cx * by) - (cy * bx);
+    const double eb = (ax * cy) - (ay * cx);
+    const double ec = (bx * ay) - (by * ax);
+    if (((ea < 0) || (eb < 0) || (ec < 0)) && ((ea > 0) || (eb > 0) || (ec > 0))) {
+        return false;
+    }
+    const double det = ea + eb + ec;
+    if (det == 0) {
+        return false;
+    }
+
+    // Check the distance while still scaled by the determinant
+    const double scaled = (ea * shear.z * pa[k[2]]) + (eb * shear.z * pb[k[2]]) + (ec * shear.z * pc[k[2]]);
+    if ((det > 0) ? ((scaled < 0) || (scaled > tMax * det)) : ((scaled > 0) || (scaled < tMax * det))) {
+        return false;
+    }
+
+    const double inv = 1 / det;
+    t = scaled * inv;
+    u = eb * inv;
+    v = ec * inv;
+    return true;
+}
+
+/*
+ * Tests a packet of rays against a triangle with Moller and Trumbore's method, updating distances of rays that hit.
+ */
+template <size_t N>
+static unsigned int intersectPacket(const Triangle& triangle, const RayPacket<N>& packet, double t[N]) {
+
+    const Vec3 e1 = triangle.b - triangle.a;
+    const Vec3 e2 = triangle.c - triangle.a;
+    bool hits[N];
+
+    for (size_t i = 0; i < N; ++i) {
+        const double dx = packet.directionX[i];
+        const double dy = packet.directionY[i];
+        const double dz = packet.directionZ[i];
+        const double px = (dy * e2.z) - (dz * e2.y);
+        const double py = (dz * e2.x) - (dx * e2.z);
+        const double pz = (dx * e2.y) - (dy * e2.x);
+        const double det = (e1.x * px) + (e1.y * py) + (e1.z * pz);
+        const double inv = 1 / det;
+        const double sx = packet.originX[i] - triangle.a.x;
+        const double sy = packet.originY[i] - triangle.a.y;
+        const double sz = packet.originZ[i] - triangle.a.z;
+        const double u = ((sx * px) + (sy * py) + (sz * pz)) * inv;
+        const double qx = (sy * e1.z) - (sz * e1.y);
+        const double qy = (sz * e1.x) - (sx * e1.z);
+        const double qz = (sx * e1.y) - (sy * e1.x);
+        const double v = ((dx * qx) + (dy * qy) + (dz * qz)) * inv;
+        const double d = ((e2.x * qx) + (e2.y * qy) + (e2.z * qz)) * inv;
+        hits[i] = (det != 0) & (u >= 0) & (v >= 0) & ((u + v) <= 1) & (d >= 0) & (d <= t[i]);
+        t[i] = hits[i] ? d : t[i];
+    }
+    return toMask(hits, N);
+}
+
+/*
+ * Tests a packet of rays against a triangle with the watertight method, updating distances of rays that hit.
+ *
+ * Each ray has its own shear axes, so the vertices are first resolved into the space of each ray, after which the test
+ * is the same branch-free arithmetic for every ray.
+ */
+template <size_t N>
+static unsigned int intersectPacketWatertight(const Triangle& triangle, const RayPacket<N>& packet, double t[N]) {
+
+    const double as[3] = { triangle.a.x, triangle.a.y, triangle.a.z };
+    const double bs[3] = { triangle.b.x, triangle.b.y, triangle.b.z };
+    const double cs[3] = { triangle.c.x, triangle.c.y, triangle.c.z };
+    const double* origins[3] = { packet.originX, packet.originY, packet.originZ };
+    double ax[N], ay[N], az[N], bx[N], by[N], bz[N], cx[N], cy[N], cz[N];
+    bool hits[N];
+
+    // Move vertices into the space of each ray
+    for (size_t i = 0; i < N; ++i) {
+        const int kx = packet.axes[0][i];
+        const int ky = packet.axes[1][i];
+        const int kz = packet.axes[2][i];
+        const double ox = origins[kx][i];
+        const double oy = origins[ky][i];
+        const double oz = origins[kz][i];
+        ax[i] = as[kx] - ox;
+        ay[i] = as[ky] - oy;
+        az[i] = as[kz] - oz;
+        bx[i] = bs[kx] - ox;
+        by[i] = bs[ky] - oy;
+        bz[i] = bs[kz] - oz;
+        cx[i] = cs[kx] - ox;
+        cy[i] = cs[ky] - oy;
+        cz[i] = cs[kz] - oz;
+    }
+
+    // Shear, then check edges and distance while still scaled by the determinant
+    for (size_t i = 0; i < N; ++i) {
+        const double sx = packet.shearX[i];
+        const double sy = packet.shearY[i];
+        const double sz = packet.shearZ[i];
+        const double pax = ax[i] - (sx * az[i]);
+        const double pay = ay[i] - (sy * az[i]);
+        const double pbx = bx[i] - (sx * bz[i]);
+        const double pby = by[i] - (sy * bz[i]);
+        const double pcx = cx[i] - (sx * cz[i]);
+        const double pcy = cy[i] - (sy * cz[i]);
+        const double ea = (pcx * pby) - (pcy * pbx);
+        const double eb = (pax * pcy) - (pay * pcx);
+        const double ec = (pbx * pay) - (pby * pax);
+        const double det = ea + eb + ec;
+        const double scaled = (ea * sz * az[i]) + (eb * sz * bz[i]) + (ec * sz * cz[i]);
+        const double limit = t[i] * det;
+        const bool inside = ((ea >= 0) & (eb >= 0) & (ec >= 0)) | ((ea <= 0) & (eb <= 0) & (ec <= 0));
+        const bool front = ((det > 0) & (scaled >= 0) & (scaled <= limit))
+                | ((det < 0) & (scaled <= 0) & (scaled >= limit));
+        hits[i] = inside & front;
+        t[i] = hits[i] ? (scaled * (1 / det)) : t[i];
+    }
+    return toMask(hits, N);
+}
+
+/**
+ * Constructs a triangle with all three vertices at the origin.
+ */
+Triangle::Triangle() : a(0, 0, 0), b(0, 0, 0), c(0, 0, 0) {
+    // pass
+}
+
+/**
+ * Constructs a triangle from three vertices.
+ *
+ * @param a First vertex
+ * @param b Second vertex
+ * @param c Third vertex
+ */
+Triangle::Triangle(const Vec3& a, const Vec3& b, const Vec3& c) : a(a), b(b), c(c) {
+    // pass
+}
+
+/**
+ * Computes the unit normal of the triangle, facing the side its vertices wind counter-clockwise around.
+ */
+Vec3 Triangle::getNormal() const {
+    return normalize(cross(b - a, c - a));
+}
+
+/**
+ * Tests a ray against the triangle with Moller and Trumbore's method.
+ *
+ * @param ray Ray to test
+ * @param tMax Largest distance along the ray to accept
+ * @param t Distance to the hit, set only if there is one
+ * @param u Barycentric coordinate of the hit for the second vertex, set only if there is one
+ * @param v Barycentric coordinate of the hit for the third vertex, set only if there is one
+ * @return `true` if the ray hits the triangle in [0 .. tMax]
+ */
+bool Triangle::intersect(const Ray& ray, double tMax, double& t, double& u, double& v) const {
+
+    const Vec3 e1 = b - a;
+    const Vec3 e2 = c - a;
+    const Vec3 p = cross(ray.direction, e2);
+    const double det = dot(e1, p);
+    if (det == 0) {
+        return false;
+    }
+
+    const double inv = 1 / det;
+    const Vec3 s = ray.origin - a;
+    const double uHit = dot(s, p) * inv;
+    if ((uHit < 0) || (uHit > 1)) {
+        return false;
+    }
+
+    const Vec3 q = cross(s, e1);
+    const double vHit = dot(ray.direction, q) * inv;
+    if ((vHit < 0) || ((uHit + vHit) > 1)) {
+        return false;
+    }
+
+    const double tHit = dot(e2, q) * inv;
+    if ((tHit < 0) || (tHit > tMax)) {
+        return false;
+    }
+    t = tHit;
+    u = uHit;
+    v = vHit;
+    return true;
+}
+
+/**
+ * Tests a packet of four rays against the triangle with Moller and Trumbore's method.
+ *
+ * @param packet Rays to test
+ * @param t Largest distance to accept for each ray, replaced by the distance to the hit for rays that hit
+ * @return Mask with bit `i` set if ray `i` hits the triangle
+ */
+unsigned int Triangle::intersect(const RayPacket4& packet, double t[4]) const {
+    return intersectPacket(*this, packet, t);
+}
+
+/**
+ * Tests a packet of eight rays against the triangle with Moller and Trumbore's method.
+ *
+ * @param packet Rays to test
+ * @param t Largest distance to accept for each ray, replaced by the distance to the hit for rays that hit
+ * @return Mask with bit `i` set if ray `i` hits the triangle
+ */
+unsigned int Triangle::intersect(const RayPacket8& packet, double t[8]) const {
+    return intersectPacket(*this, packet, t);
+}
+
+/**
+ * Tests a ray against the triangle with the watertight method.
+ *
+ * @param ray Ray to test
+ * @param tMax Largest distance along the ray to accept
+ * @param t Distance to the hit, set only if there is one
+ * @param u Barycentric coordinate of the hit for the second vertex, set only if there is one
+ * @param v Barycentric coordinate of the hit for the third vertex, set only if there is one
+ * @return `true` if the ray hits the triangle in [0 .. tMax]
+ */
+bool Triangle::intersectWatertight(const Ray& ray, double tMax, double& t, double& u, double& v) const {
+
+    int k[3];
+    Vec3 shear;
+
+    ray.findShear(k, shear);
+    return intersectSheared(a, b, c, ray.origin, k, shear, tMax, t, u, v);
+}
+
+/**
+ * Tests a packet of four rays against the triangle with the watertight method.
+ *
+ * @param packet Rays to test
+ * @param t Largest distance to accept for each ray, replaced by the distance to the hit for rays that hit
+ * @return Mask with bit `i` set if ray `i` hits the triangle
+ */
+unsigned int Triangle::intersectWatertight(const RayPacket4& packet, double t[4]) const {
+    return intersectPacketWatertight(*this, packet, t);
+}
+
+/**
+ * Tests a packet of eight rays against the triangle with the watertight method.
+ *
+ * @param packet Rays to test
+ * @param t Largest distance to accept for each ray, replaced by the distance to the hit for rays that hit
+ * @return Mask with bit `i` set if ray `i` hits the triangle
+ */
+unsigned int Triangle::intersectWatertight(const RayPacket8& packet, double t[8]) const {
+    return intersectPacketWatertight(*this, packet, t);
+}
+
+/**
+ * Returns a string representation of the triangle.
+ */
+string Triangle::toString() const {
+    stringstream stream;
+    stream << (*this);
+    return stream.str();
+}
+
+} /* namespace M3d */
+
+/**
+ * Appends a triangle to a stream.
+ *
+ * @param stream Stream to append to
+ * @param triangle Triangle to append
+ * @return Reference to the stream
+ */
+ostream& operator<<(ostream& stream, const M3d::Triangle& triangle) {
+    stream << '[' << triangle.a << ", " << triangle.b << ", " << triangle.c << ']';
+    return stream;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_TRIANGLE_H
+#define M3D_TRIANGLE_H
+#include "m3d/common.h"
+#include <iostream>
+#include <string>
+#include "m3d/Ray.h"
+#include "m3d/RayPacket.h"
+#include "m3d/Vec3.h"
+namespace M3d {
+
+
+/**
+ * Triangle defined by three vertices, with ray intersection tests.
+ *
+ * Two tests are provided.  `intersect` uses Moller and Trumbore's method, which is fast but can miss rays passing
+ * exactly through a shared edge or vertex because of rounding.  `intersectWatertight` uses the method of Woop, Benthin
+ * and Wald, which transforms the triangle into a space where the ray is the Z axis so that neighbouring triangles
+ * compute shared edges identically, and never lets a ray slip between them.
+ *
+ * Both tests hit either side of the triangle, and report barycentric coordinates `u` and `v` so the hit point is
+ * `(1 - u - v) * a + u * b + v * c`.  Each test also comes in versions for packets of four and eight rays.
+ */
+class Triangle {
+public:
+// Attributes
+    Vec3 a; ///< First vertex
+    Vec3 b; ///< Second vertex
+    Vec3 c; ///< Third vertex
+// Methods
+    explicit Triangle();
+    explicit Triangle(const Vec3& a, const Vec3& b, const Vec3& c);
+    Vec3 getNormal() const;
+    bool intersect(const Ray& ray, double tMax, double& t, double& u, double& v) const;
+    unsigned int intersect(const RayPacket4& packet, double t[4]) const;
+    unsigned int intersect(const RayPacket8& packet, double t[8]) const;
+    bool intersectWatertight(const Ray& ray, double tMax, double& t, double& u, double& v) const;
+    unsigned int intersectWatertight(const RayPacket4& packet, double t[4]) const;
+    unsigned int intersectWatertight(const RayPacket8& packet, double t[8]) const;
+    std::string toString() const;
+};
+
+} /* namespace M3d */
+
+std::ostream& operator<<(std::ostream& stream, const M3d::Triangle& triangle);
+#endif
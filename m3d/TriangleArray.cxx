@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+#include "m3d/TriangleArray.h"
+using namespace std;
+namespace M3d {
+
+/**
+ * Constructs an empty array.
+ */
+TriangleArray::TriangleArray() {
+    // pass
+}
+
+/**
+ * Adds a triangle to the end of the array.
+ *
+ * @param triangle Triangle to add
+ */
+void TriangleArray::append(const Triangle& triangle) {
+    a.append(triangle.a);
+    b.append(triangle.b);
+    c.append(triangle.c);
+}
+
+/**
+ * Removes all the triangles.
+ */
+void TriangleArray::clear() {
+    a.clear();
+    b.clear();
+    c.clear();
+}
+
+/**
+ * Finds the closest triangle hit by a ray, using Moller and Trumbore's method.
+ *
+ * @param ray Ray to test
+ * @param tMax Largest distance along the ray to accept
+ * @param index Index of the closest triangle hit, set only if there is a hit
+ * @param t Distance to the closest hit, set only if there is a hit
+ * @return `true` if any triangle was hit
+ */
+bool TriangleArray::findClosest(const Ray& ray, double tMax, size_t& index, double& t) const {
+
+    const size_t n = size();
+    double block[BLOCK_SIZE];
+    double tMin = HUGE_VAL;
+    bool found = false;
+
+    for (size_t begin = 0; begin < n; begin += BLOCK_SIZE) {
+        const size_t end = std::min(begin + BLOCK_SIZE, n);
+        test(ray, std::min(tMax, tMin), begin, end, block);
+        if (findMinimum(block, begin, end, index, tMin)) {
+            found = true;
+        }
+    }
+    if (found) {
+        t = tMin;
+    }
+    return found;
+}
+
+/**
+ * Finds the closest triangle hit by a ray, using the watertight method.
+ *
+ * @param ray Ray to test
+ * @param tMax Largest distance along the ray to accept
+ * @param index Index of the closest triangle hit, set only if there is a hit
+ * @param t Distance to the closest hit, set only if there is a hit
+ * @return `true` if any triangle was hit
+ */
+bool TriangleArray::findClosestWatertight(const Ray& ray, double tMax, size_t& index, double& t) const {
+
+    const size_t n = size();
+    double block[BLOCK_SIZE];
+    double tMin = HUGE_VAL;
+    bool found = false;
+    int k[3];
+    Vec3 shear;
+
+    ray.findShear(k, shear);
+    for (size_t begin = 0; begin < n; begin += BLOCK_SIZE) {
+        const size_t end = std::min(begin + BLOCK_SIZE, n);
+        testWatertight(ray, k, shear, std::min(tMax, tMin), begin, end, block);
+        if (findMinimum(block, begin, end, index, tMin)) {
+            found = true;
+        }
+    }
+    if (found) {
+        t = tMin;
+    }
+    return found;
+}
+
+/**
+ * Returns a copy of one of the triangles.
+ *
+ * @param i Index of the triangle
+ */
+Triangle TriangleArray::get(size_t i) const {
+    return Triangle(a.get(i), b.get(i), c.get(i));
+}
+
+/**
+ * Tests a ray against every triangle, using Moller and Trumbore's method.
+ *
+ * @param ray Ray to test
+ * @param tMax Largest distance along the ray to accept
+ * @param t Array to store the distance to each triangle in, with room for every triangle
+ * @return Number of triangles hit
+ */
+size_t TriangleArray::intersect(const Ray& ray, double tMax, double* t) const {
+
+    const size_t n = size();
+
+    test(ray, tMax, 0, n, t);
+    return n - std::count(t, t + n, HUGE_VAL);
+}
+
+/**
+ * Tests a ray against every triangle, using the watertight method.
+ *
+ * @param ray Ray to test
+ * @param tMax Largest distance along the ray to accept
+ * @param t Array to store the distance to each triangle in, with room for every triangle
+ * @return Number of triangles hit
+ */
+size_t TriangleArray::intersectWatertight(const Ray& ray, double tMax, double* t) const {
+
+    const size_t n = size();
+    int k[3];
+    Vec3 shear;
+
+    ray.findShear(k, shear);
+    testWatertight(ray, k, shear, tMax, 0, n, t);
+    return n - std::count(t, t + n, HUGE_VAL);
+}
+
+/**
+ * Makes room for a number of triangles without changing the size.
+ *
+ * @param capacity Number of triangles to make room for
+ */
+void TriangleArray::reserve(size_t capacity) {
+    a.reserve(capacity);
+    b.reserve(capacity);
+    c.reserve(capacity);
+}
+
+/**
+ * Returns the number of triangles.
+ */
+size_t TriangleArray::size() const {
+    return a.size();
+}
+
+// HELPERS
+
+/*
+ * Tests a ray against a range of triangles with Moller and Trumbore's method, storing distances from the start of `t`.
+ */
+void TriangleArray::test(const Ray& ray, double tMax, size_t begin, size_t end, double* t) const {
+
+    if (begin >= end) {
+        return;
+    }
+
+    const double* ax = &a.x[0];
+    const double* ay = &a.y[0];
+    const double* az = &a.z[0];
+    const double* bx = &b.x[0];
+    const double* by = &b.y[0];
+    const double* bz = &b.z[0];
+    const double* cx = &c.x[0];
+    const double* cy = &c.y[0];
+    const double* cz = &c.z[0];
+    const Vec3& d = ray.direction;
+    const Vec3& o = ray.origin;
+
+    for (size_t i = begin; i < end; ++i) {
+        const double e1x = bx[i] - ax[i];
+        const double e1y = by[i] - ay[i];
+        const double e1z = bz[i] - az[i];
+        const double e2x = cx[i] - ax[i];
+        const double e2y = cy[i] - ay[i];
+        const double e2z = cz[i] - az[i];
+        const double px = (d.y * e2z) - (d.z * e2y);
+        const double py = (d.z * e2x) - (d.x * e2z);
+        const double pz = (d.x * e2y) - (d.y * e2x);
+        const double det = (e1x * px) + (e1y * py) + (e1z * pz);
+        const double inv = 1 / det;
+        const double sx = o.x - ax[i];
+        const double sy = o.y - ay[i];
+        const double sz = o.z - az[i];
+        const double u = ((sx * px) + (sy * py) + (sz * pz)) * inv;
+        const double qx = (sy * e1z) - (sz * e1y);
+        const double qy = (sz * e1x) - (sx * e1z);
+        const double qz = (sx * e1y) - (sy * e1x);
+        const double v = ((d.x * qx) + (d.y * qy) + (d.z * qz)) * inv;
+        const double distance = ((e2x * qx) + (e2y * qy) + (e2z * qz)) * inv;
+        const bool hit = (det != 0) & (u >= 0) & (v >= 0) & ((u + v) <= 1) & (distance >= 0) & (distance <= tMax);
+        t[i - begin] = hit ? distance : HUGE_VAL;
+    }
+}
+
+/*
+ * Tests a sheared ray against a range of triangles with the watertight method, storing distances from the start of `t`.
+ *
+ * The axes of the shear are the same for every triangle, so they are resolved to component arrays once up front.
+ */
+void TriangleArray::testWatertight(const Ray& ray, const int k[3], const Vec3& shear, double tMax, size_t begin,
+                                   size_t end, double* t) const {
+
+    if (begin >= end) {
+        return;
+    }
+
+    const double* as[3] = { &a.x[0], &a.y[0], &a.z[0] };
+    const double* bs[3] = { &b.x[0], &b.y[0], &b.z[0] };
+    const double* cs[3] = { &c.x[0], &c.y[0], &c.z[0] };
+    const double* ax = as[k[0]];
+    const double* ay = as[k[1]];
+    const double* az = as[k[2]];
+    const double* bx = bs[k[0]];
+    const double* by = bs[k[1]];
+    const double* bz = bs[k[2]];
+    const double* cx = cs[k[0]];
+    const double* cy = cs[k[1]];
+    const double* cz = cs[k[2]];
+    const double ox = ray.origin[k[0]];
+    const double oy = ray.origin[k[1]];
+    const double oz = ray.origin[k[2]];
+
+    for (size_t i = begin; i < end; ++i) {
+        const double paz = az[i] - oz;
+        const double pbz = bz[i] - oz;
+        const double pcz = cz[i] - oz;
+        const double pax = (ax[i] - ox) - (shear.x * paz);
+        const double pay = (ay[i] - oy) - (shear.y * paz);
+        const double pbx = (bx[i] - ox) - (shear.x * pbz);
+        const double pby = (by[i] - oy) - (shear.y * pbz);
+        const double pcx = (cx[i] - ox) - (shear.x * pcz);
+        const double pcy = (cy[i] - oy) - (shear.y * pcz);
+        const double ea = (pcx * pby) - (pcy * pbx);
+        const double eb = (pax * pcy) - (pay * pcx);
+        const double ec = (pbx * pay) - (pby * pax);
+        const double det = ea + eb + ec;
+        const double distance = (shear.z * ((ea * paz) + (eb * pbz) + (ec * pcz))) / det;
+        const bool inside = ((ea >= 0) & (eb >= 0) & (ec >= 0)) | ((ea <= 0) & (eb <= 0) & (ec <= 0));
+        const bool hit = inside & (det != 0) & (distance >= 0) & (distance <= tMax);
+        t[i - begin] = hit ? distance : HUGE_VAL;
+    }
+}
+
+/*
+ * Finds the smallest distance in a block that is less than a limit, updating the limit and index if there is one.
+ *
+ * Misses are stored as `HUGE_VAL`, so a limit of `HUGE_VAL` accepts every hit, including one exactly at the largest
+ * distance the block was tested with.  Ties keep the earlier triangle.
+ */
+bool TriangleArray::findMinimum(const double* t, size_t begin, size_t end, size_t& index, double& tMin) {
+
+    bool found = false;
+
+    for (size_t i = begin; i < end; ++i) {
+        if (t[i - begin] < tMin) {
+            tMin = t[i - begin];
+            index = i;
+            found = true;
+        }
+    }
+    return found;
+}
+
+} /* namespace M3d */
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_TRIANGLEARRAY_H
+#define M3D_TRIANGLEARRAY_H
+#include "m3d/common.h"
+#include "m3d/Ray.h"
+#include "m3d/Triangle.h"
+#include "m3d/Vec3.h"
+#include "m3d/Vec3Array.h"
+namespace M3d {
+
+
+/**
+ * Array of triangles stored as separate arrays of vertex components, for testing one ray against many triangles.
+ *
+ * Each test runs the same steps for every triangle in a block, so with the components in separate arrays they compile
+ * to SIMD instructions.  Tests come in the same two kinds as in `Triangle`.  Distances for triangles that are missed
+ * are set to `HUGE_VAL`.
+ */
+class TriangleArray {
+public:
+// Attributes
+    Vec3Array a; ///< First vertices
+    Vec3Array b; ///< Second vertices
+    Vec3Array c; ///< Third vertices
+// Methods
+    explicit TriangleArray();
+    void append(const Triangle& triangle);
+    void clear();
+    bool findClosest(const Ray& ray, double tMax, size_t& index, double& t) const;
+    bool findClosestWatertight(const Ray& ray, double tMax, size_t& index, double& t) const;
+    Triangle get(size_t i) const;
+    size_t intersect(const Ray& ray, double tMax, double* t) const;
+    size_t intersectWatertight(const Ray& ray, double tMax, double* t) const;
+    void reserve(size_t capacity);
+    size_t size() const;
+private:
+// Constants
+    static const size_t BLOCK_SIZE = 256;
+// Helpers
+    void test(const Ray& ray, double tMax, size_t begin, size_t end, double* t) const;
+    void testWatertight(const Ray& ray, const int k[3], const Vec3& shear, double tMax, size_t begin, size_t end,
+                        double* t) const;
+    static bool findMinimum(const double* t, size_t begin, size_t end, size_t& index, double& tMin);
+};
+
+} /* namespace M3d */
+#endif
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/TriangleArray.h"
+using namespace std;
+
+/*
+ * Constants
+ */
+const double TOLERANCE = 1e-9;
+
+
+/**
+ * Unit test for TriangleArray.
+ */
+class TriangleArrayTest : public CppUnit::TestFixture {
+private:
+    M3d::TriangleArray triangles;
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + (upper - lower) * (rand() / (double) RAND_MAX);
+    }
+
+    /**
+     * Returns a random point in a cube.
+     */
+    static M3d::Vec3 randomPoint(double size) {
+        return M3d::Vec3(random(-size, size), random(-size, size), random(-size, size));
+    }
+
+public:
+
+    /**
+     * Fills the array with small random triangles.
+     */
+    void setUp() {
+        triangles.clear();
+        triangles.reserve(1000);
+        for (int i = 0; i < 1000; ++i) {
+            const M3d::Vec3 center = randomPoint(5);
+            triangles.append(M3d::Triangle(center + randomPoint(1), center + randomPoint(1), center + randomPoint(1)));
+        }
+    }
+
+    /**
+     * Ensures triangles can be added and read back.
+     */
+    void testAppend() {
+        CPPUNIT_ASSERT_EQUAL((size_t) 1000, triangles.size());
+        const M3d::Triangle triangle(M3d::Vec3(1, 2, 3), M3d::Vec3(4, 5, 6), M3d::Vec3(7, 8, 9));
+        triangles.append(triangle);
+        CPPUNIT_ASSERT(triangles.get(1000).b == triangle.b);
+        CPPUNIT_ASSERT(triangles.get(1000).c == triangle.c);
+        triangles.clear();
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, triangles.size());
+    }
+
+    /**
+     * Ensures testing every triangle gives the same distances as testing each one.
+     */
+    void testIntersect() {
+        vector<double> t(triangles.size()), w(triangles.size());
+        for (int i = 0; i < 50; ++i) {
+            const M3d::Vec3 origin = randomPoint(10);
+            const M3d::Ray ray(origin, randomPoint(2) - origin);
+            const size_t count = triangles.intersect(ray, 12, &t[0]);
+            const size_t countWatertight = triangles.intersectWatertight(ray, 12, &w[0]);
+            size_t expected = 0;
+            for (size_t j = 0; j < triangles.size(); ++j) {
+                double d = HUGE_VAL, u, v;
+                if (triangles.get(j).intersect(ray, 12, d, u, v)) {
+                    ++expected;
+                }
+                CPPUNIT_ASSERT_EQUAL(d, t[j]);
+                if (triangles.get(j).intersectWatertight(ray, 12, d, u, v)) {
+                    CPPUNIT_ASSERT_DOUBLES_EQUAL(d, w[j], TOLERANCE);
+                } else {
+                    CPPUNIT_ASSERT_EQUAL(HUGE_VAL, w[j]);
+                }
+            }
+            CPPUNIT_ASSERT_EQUAL(expected, count);
+            CPPUNIT_ASSERT_EQUAL(expected, countWatertight);
+        }
+    }
+
+    /**
+     * Ensures the closest hit is the smallest distance from testing each triangle.
+     */
+    void testFindClosest() {
+        int hits = 0;
+        for (int i = 0; i < 50; ++i) {
+            const M3d::Vec3 origin = randomPoint(10);
+            const M3d::Ray ray(origin, randomPoint(2) - origin);
+            double expected = HUGE_VAL;
+            size_t closest = 0;
+            for (size_t j = 0; j < triangles.size(); ++j) {
+                double t = HUGE_VAL, u, v;
+                if (triangles.get(j).intersect(ray, expected, t, u, v) && t < expected) {
+                    expected = t;
+                    closest = j;
+                }
+            }
+
+            size_t index = 0, indexWatertight = 0;
+            double t = HUGE_VAL, tWatertight = HUGE_VAL;
+            const bool found = triangles.findClosest(ray, HUGE_VAL, index, t);
+            const bool foundWatertight = triangles.findClosestWatertight(ray, HUGE_VAL, indexWatertight, tWatertight);
+            CPPUNIT_ASSERT_EQUAL(expected < HUGE_VAL, found);
+            CPPUNIT_ASSERT_EQUAL(found, foundWatertight);
+            if (found) {
+                CPPUNIT_ASSERT_EQUAL(closest, index);
+                CPPUNIT_ASSERT_EQUAL(expected, t);
+                CPPUNIT_ASSERT_EQUAL(closest, indexWatertight);
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(expected, tWatertight, TOLERANCE);
+                ++hits;
+            }
+        }
+        CPPUNIT_ASSERT(hits > 0);
+    }
+
+    /**
+     * Ensures a hit exactly at the largest distance is accepted, as by single triangles and packets.
+     */
+    void testFindClosestAtLimit() {
+        const M3d::Triangle triangle(M3d::Vec3(-1, -1, -2), M3d::Vec3(1, -1, -2), M3d::Vec3(0, 1, -2));
+        const M3d::Ray ray(M3d::Vec3(0, 0, 0), M3d::Vec3(0, 0, -1));
+        triangles.clear();
+        triangles.append(M3d::Triangle(M3d::Vec3(5, 5, 5), M3d::Vec3(6, 5, 5), M3d::Vec3(5, 6, 5)));
+        triangles.append(triangle);
+        triangles.append(triangle);
+
+        size_t index = 0;
+        double t = 0;
+        CPPUNIT_ASSERT(triangles.findClosest(ray, 2, index, t));
+        CPPUNIT_ASSERT_EQUAL((size_t) 1, index);
+        CPPUNIT_ASSERT_EQUAL(2.0, t);
+        index = 0;
+        t = 0;
+        CPPUNIT_ASSERT(triangles.findClosestWatertight(ray, 2, index, t));
+        CPPUNIT_ASSERT_EQUAL((size_t) 1, index);
+        CPPUNIT_ASSERT_EQUAL(2.0, t);
+
+        M3d::RayPacket4 packet;
+        double limits[4] = { 2, 2, 2, 2 }, watertightLimits[4] = { 2, 2, 2, 2 };
+        for (int i = 0; i < 4; ++i) {
+            packet.setRay(i, ray);
+        }
+        CPPUNIT_ASSERT_EQUAL(15u, triangle.intersect(packet, limits));
+        CPPUNIT_ASSERT_EQUAL(15u, triangle.intersectWatertight(packet, watertightLimits));
+        CPPUNIT_ASSERT(!triangles.findClosest(ray, 1.5, index, t));
+    }
+
+    CPPUNIT_TEST_SUITE(TriangleArrayTest);
+    CPPUNIT_TEST(testAppend);
+    CPPUNIT_TEST(testIntersect);
+    CPPUNIT_TEST(testFindClosest);
+    CPPUNIT_TEST(testFindClosestAtLimit);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(TriangleArrayTest::suite());
+    runner.run();
+    return 0;
+}
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cmath>
+#include <cstdlib>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/Triangle.h"
+using namespace std;
+
+/*
+ * Constants
+ */
+const double TOLERANCE = 1e-9;
+
+
+/**
+ * Unit test for Triangle.
+ */
+class TriangleTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + (upper - lower) * (rand() / (double) RAND_MAX);
+    }
+
+    /**
+     * Returns a random point in a cube.
+     */
+    static M3d::Vec3 randomPoint(double size) {
+        return M3d::Vec3(random(-size, size), random(-size, size), random(-size, size));
+    }
+
+    /**
+     * Returns a random ray starting near a triangle and pointing roughly at it.
+     */
+    static M3d::Ray randomRay(const M3d::Triangle& triangle) {
+        const M3d::Vec3 center = (triangle.a + triangle.b + triangle.c) / 3;
+        const M3d::Vec3 origin = randomPoint(5);
+        return M3d::Ray(origin, (center + randomPoint(1)) - origin);
+    }
+
+public:
+
+    /**
+     * Ensures the normal follows the winding of the vertices.
+     */
+    void testGetNormal() {
+        const M3d::Triangle triangle(M3d::Vec3(0, 0, 0), M3d::Vec3(2, 0, 0), M3d::Vec3(0, 3, 0));
+        CPPUNIT_ASSERT(triangle.getNormal() == M3d::Vec3(0, 0, 1));
+    }
+
+    /**
+     * Ensures Moller and Trumbore's test finds the distance and barycentric coordinates of hits.
+     */
+    void testIntersect() {
+
+        const M3d::Triangle triangle(M3d::Vec3(0, 0, -2), M3d::Vec3(4, 0, -2), M3d::Vec3(0, 4, -2));
+        double t = -1, u = -1, v = -1;
+
+        // Front and back
+        CPPUNIT_ASSERT(triangle.intersect(M3d::Ray(M3d::Vec3(1, 2, 0), M3d::Vec3(0, 0, -1)), HUGE_VAL, t, u, v));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(2.0, t, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.25, u, TOLERANCE);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, v, TOLERANCE);
+        CPPUNIT_ASSERT(triangle.intersect(M3d::Ray(M3d::Vec3(1, 1, -5), M3d::Vec3(0, 0, 2)), HUGE_VAL, t, u, v));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(1.5, t, TOLERANCE);
+
+        // Outside, behind, too far and parallel
+        t = -1;
+        CPPUNIT_ASSERT(!triangle.intersect(M3d::Ray(M3d::Vec3(3, 3, 0), M3d::Vec3(0, 0, -1)), HUGE_VAL, t, u, v));
+        CPPUNIT_ASSERT(!triangle.intersect(M3d::Ray(M3d::Vec3(1, 1, 0), M3d::Vec3(0, 0, 1)), HUGE_VAL, t, u, v));
+        CPPUNIT_ASSERT(!triangle.intersect(M3d::Ray(M3d::Vec3(1, 1, 0), M3d::Vec3(0, 0, -1)), 1.5, t, u, v));
+        CPPUNIT_ASSERT(!triangle.intersect(M3d::Ray(M3d::Vec3(1, 1, -2), M3d::Vec3(1, 0, 0)), HUGE_VAL, t, u, v));
+        CPPUNIT_ASSERT_EQUAL(-1.0, t);
+    }
+
+    /**
+     * Ensures the watertight test agrees with Moller and Trumbore's test away from edges.
+     */
+    void testIntersectWatertight() {
+        int hits = 0;
+        for (int i = 0; i < 2000; ++i) {
+            const M3d::Triangle triangle(randomPoint(2), randomPoint(2), randomPoint(2));
+            const M3d::Ray ray = randomRay(triangle);
+            double t1 = -1, u1, v1, t2 = -1, u2, v2;
+            const bool hit1 = triangle.intersect(ray, HUGE_VAL, t1, u1, v1);
+            const bool hit2 = triangle.intersectWatertight(ray, HUGE_VAL, t2, u2, v2);
+            if (hit1 && (u1 < 1e-6 || v1 < 1e-6 || u1 + v1 > 1 - 1e-6)) {
+                continue;
+            }
+            CPPUNIT_ASSERT_EQUAL(hit1, hit2);
+            if (hit1) {
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(t1, t2, 1e-6);
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(u1, u2, 1e-6);
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(v1, v2, 1e-6);
+                ++hits;
+            }
+        }
+        CPPUNIT_ASSERT(hits > 100);
+    }
+
+    /**
+     * Ensures rays through the shared edge of two triangles always hit one of them with the watertight test.
+     */
+    void testIntersectWatertightEdge() {
+        const M3d::Vec3 p0(-1.3, -0.7, 0.1), p1(1.1, -0.9, 0.3), p2(0.9, 1.7, -0.2), p3(-1.1, 1.3, 0.4);
+        const M3d::Triangle first(p0, p1, p2);
+        const M3d::Triangle second(p0, p2, p3);
+        for (int i = 0; i <= 1000; ++i) {
+            const M3d::Vec3 target = p0 + ((p2 - p0) * (i / 1000.0));
+            const M3d::Vec3 origin(random(-0.5, 0.5), random(-0.5, 0.5), 3);
+            const M3d::Ray ray(origin, target - origin);
+            double t, u, v;
+            const bool hit = first.intersectWatertight(ray, HUGE_VAL, t, u, v)
+                    || second.intersectWatertight(ray, HUGE_VAL, t, u, v);
+            CPPUNIT_ASSERT(hit);
+        }
+    }
+
+    /**
+     * Ensures packets of rays give the same results as testing each ray.
+     */
+    void testIntersectPacket() {
+        for (int i = 0; i < 200; ++i) {
+            const M3d::Triangle triangle(randomPoint(2), randomPoint(2), randomPoint(2));
+            M3d::RayPacket8 packet8;
+            M3d::RayPacket4 packet4;
+            double t8[8], w8[8], t4[4], w4[4];
+            for (int j = 0; j < 8; ++j) {
+                packet8.setRay(j, randomRay(triangle));
+                t8[j] = w8[j] = (j == 3) ? 0.5 : HUGE_VAL;
+                if (j < 4) {
+                    packet4.setRay(j, packet8.getRay(j));
+                    t4[j] = w4[j] = t8[j];
+                }
+            }
+
+            const unsigned int mask8 = triangle.intersect(packet8, t8);
+            const unsigned int watertight8 = triangle.intersectWatertight(packet8, w8);
+            const unsigned int mask4 = triangle.intersect(packet4, t4);
+            const unsigned int watertight4 = triangle.intersectWatertight(packet4, w4);
+            CPPUNIT_ASSERT_EQUAL(mask8 & 15, mask4);
+            CPPUNIT_ASSERT_EQUAL(watertight8 & 15, watertight4);
+            for (int j = 0; j < 8; ++j) {
+                double t = (j == 3) ? 0.5 : HUGE_VAL, u, v;
+                const bool hit = triangle.intersect(packet8.getRay(j), t, t, u, v);
+                CPPUNIT_ASSERT_EQUAL(hit, (bool) ((mask8 >> j) & 1));
+                CPPUNIT_ASSERT_EQUAL(t, t8[j]);
+                t = (j == 3) ? 0.5 : HUGE_VAL;
+                const bool watertight = triangle.intersectWatertight(packet8.getRay(j), t, t, u, v);
+                CPPUNIT_ASSERT_EQUAL(watertight, (bool) ((watertight8 >> j) & 1));
+                CPPUNIT_ASSERT_EQUAL(t, w8[j]);
+            }
+        }
+    }
+
+    /**
+     * Ensures toString works correctly.
+     */
+    void testToString() {
+        const M3d::Triangle triangle(M3d::Vec3(1, 2, 3), M3d::Vec3(4, 5, 6), M3d::Vec3(7, 8, 9));
+        CPPUNIT_ASSERT_EQUAL(string("[[1, 2, 3], [4, 5, 6], [7, 8, 9]]"), triangle.toString());
+    }
+
+    CPPUNIT_TEST_SUITE(TriangleTest);
+    CPPUNIT_TEST(testGetNormal);
+    CPPUNIT_TEST(testIntersect);
+    CPPUNIT_TEST(testIntersectWatertight);
+    CPPUNIT_TEST(testIntersectWatertightEdge);
+    CPPUNIT_TEST(testIntersectPacket);
+    CPPUNIT_TEST(testToString);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(TriangleTest::suite());
+    runner.run();
+    return 0;
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <cstring>
+#include "m3d/UniformLayout.h"
+using namespace std;
+namespace M3d {
+
+
+/*
+ * Task writing a range of values, each a fixed number of bytes after the last.
+ */
+template <typename T>
+class UniformLayout::PackTask : public ParallelTask {
+public:
+    PackTask(const T* values, char* out, size_t stride, size_t step)
+            : values(values), out(out), stride(stride), step(step) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            pack(values[i * step], out + (i * stride));
+        }
+    }
+private:
+    const T* values;
+    char* out;
+    size_t stride;
+    size_t step;
+};
+
+// METHODS
+
+/**
+ * Writes a scalar.
+ *
+ * @param value Scalar to write
+ * @param out Where to write it
+ */
+void UniformLayout::pack(float value, void* out) {
+    memcpy(out, &value, sizeof(float));
+}
+
+/**
+ * Writes a three-component vector as three floats, leaving the padding after it alone.
+ *
+ * @param value Vector to write
+ * @param out Where to write it
+ */
+void UniformLayout::pack(const Vec3& value, void* out) {
+    const float floats[3] = { (float) value.x, (float) value.y, (float) value.z };
+    memcpy(out, floats, sizeof(floats));
+}
+
+/**
+ * Writes a four-component vector as four floats.
+ *
+ * @param value Vector to write
+ * @param out Where to write it
+ */
+void UniformLayout::pack(const Vec4& value, void* out) {
+    const float floats[4] = { (float) value.x, (float) value.y, (float) value.z, (float) value.w };
+    memcpy(out, floats, sizeof(floats));
+}
+
+/**
+ * Writes a three-by-three matrix as three columns of four floats, with the last float of each column set to zero.
+ *
+ * @param value Matrix to write
+ * @param out Where to write it
+ */
+void UniformLayout::pack(const Mat3& value, void* out) {
+    float columns[3][3];
+    value.toArrayInColumnMajor(columns);
+    const float floats[12] = { columns[0][0], columns[0][1], columns[0][2], 0,
+                               columns[1][0], columns[1][1], columns[1][2], 0,
+                               columns[2][0], columns[2][1], columns[2][2], 0 };
+    memcpy(out, floats, sizeof(floats));
+}
+
+/**
+ * Writes a four-by-four matrix as four columns of four floats.
+ *
+ * @param value Matrix to write
+ * @param out Where to write it
+ */
+void UniformLayout::pack(const Mat4& value, void* out) {
+    float floats[16];
+    value.toArrayInColumnMajor(floats);
+    memcpy(out, floats, sizeof(floats));
+}
+
+/**
+ * Writes scalars a fixed number of bytes apart, on several threads.
+ *
+ * @param values Start of the scalars
+ * @param count Number of scalars to write
+ * @param out Where to write the first scalar
+ * @param stride Number of bytes from each scalar written to the next
+ * @param step Number of scalars from each scalar read to the next
+ */
+void UniformLayout::pack(const float* values, size_t count, void* out, size_t stride, size_t step) {
+    PackTask<float> task(values, static_cast<char*>(out), stride, step);
+    Parallel::run(task, count, GRAIN_SIZE);
+}
+
+/**
+ * Writes three-component vectors a fixed number of bytes apart, on several threads.
+ *
+ * @param values Start of the vectors
+ * @param count Number of vectors to write
+ * @param out Where to write the first vector
+ * @param stride Number of bytes from each vector written to the next
+ * @param step Number of vectors from each vector read to the next
+ */
+void UniformLayout::pack(const Vec3* values, size_t count, void* out, size_t stride, size_t step) {
+    PackTask<Vec3> task(values, static_cast<char*>(out), stride, step);
+    Parallel::run(task, count, GRAIN_SIZE);
+}
+
+/**
+ * Writes four-component vectors a fixed number of bytes apart, on several threads.
+ *
+ * @param values Start of the vectors
+ * @param count Number of vectors to write
+ * @param out Where to write the first vector
+ * @param stride Number of bytes from each vector written to the next
+ * @param step Number of vectors from each vector read to the next
+ */
+void UniformLayout::pack(const Vec4* values, size_t count, void* out, size_t stride, size_t step) {
+    PackTask<Vec4> task(values, static_cast<char*>(out), stride, step);
+    Parallel::run(task, count, GRAIN_SIZE);
+}
+
+/**
+ * Writes three-by-three matrices a fixed number of bytes apart, on several threads.
+ *
+ * @param values Start of the matrices
+ * @param count Number of matrices to write
+ * @param out Where to write the first matrix
+ * @param stride Number of bytes from each matrix written to the next
+ * @param step Number of matrices from each matrix read to the next
+ */
+void UniformLayout::pack(const Mat3* values, size_t count, void* out, size_t stride, size_t step) {
+    PackTask<Mat3> task(values, static_cast<char*>(out), stride, step);
+    Parallel::run(task, count, GRAIN_SIZE);
+}
+
+/**
+ * Writes four-by-four matrices a fixed number of bytes apart, on several threads.
+ *
+ * @param values Start of the matrices
+ * @param count Number of matrices to write
+ * @param out Where to write the first matrix
+ * @param stride Number of bytes from each matrix written to the next
+ * @param step Number of matrices from each matrix read to the next
+ */
+void UniformLayout::pack(const Mat4* values, size_t count, void* out, size_t stride, size_t step) {
+    PackTask<Mat4> task(values, static_cast<char*>(out), stride, step);
+    Parallel::run(task, count, GRAIN_SIZE);
+}
+
+} /* namespace M3d */
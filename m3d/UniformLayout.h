@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_UNIFORMLAYOUT_H
+#define M3D_UNIFORMLAYOUT_H
+#include "m3d/common.h"
+#include "m3d/Mat3.h"
+#include "m3d/Mat4.h"
+#include "m3d/Parallel.h"
+#include "m3d/Vec3.h"
+#include "m3d/Vec4.h"
+namespace M3d {
+
+
+/**
+ * Utility for writing values into GPU buffers laid out by the std140 or std430 rules.
+ *
+ * Values are converted to floats.  Vectors are written without padding, since a scalar may follow a three-component
+ * vector in its last slot.  Each column of a matrix takes four floats, with the padding of three-row columns set to
+ * zero.  Buffers need no particular alignment.  Offsets and strides inside a block are found at compile time with
+ * `UniformBlock` and `UniformMember`.
+ */
+class UniformLayout {
+public:
+// Types
+    /** Set of rules for laying out a block */
+    enum Standard { STD140, STD430 };
+// Methods
+    static void pack(float value, void* out);
+    static void pack(const Vec3& value, void* out);
+    static void pack(const Vec4& value, void* out);
+    static void pack(const Mat3& value, void* out);
+    static void pack(const Mat4& value, void* out);
+    static void pack(const float* values, size_t count, void* out, size_t stride, size_t step = 1);
+    static void pack(const Vec3* values, size_t count, void* out, size_t stride, size_t step = 1);
+    static void pack(const Vec4* values, size_t count, void* out, size_t stride, size_t step = 1);
+    static void pack(const Mat3* values, size_t count, void* out, size_t stride, size_t step = 1);
+    static void pack(const Mat4* values, size_t count, void* out, size_t stride, size_t step = 1);
+private:
+// Types
+    template <typename T> class PackTask;
+// Constants
+    static const size_t GRAIN_SIZE = 16384;
+};
+
+
+/**
+ * Base alignment and size in bytes of a type in a block, outside of any array.
+ */
+template <typename T>
+struct UniformTraits;
+
+/** Traits of `float` */
+template <>
+struct UniformTraits<float> {
+    static const size_t ALIGNMENT = 4;
+    static const size_t SIZE = 4;
+};
+
+/** Traits of `vec3` */
+template <>
+struct UniformTraits<Vec3> {
+    static const size_t ALIGNMENT = 16;
+    static const size_t SIZE = 12;
+};
+
+/** Traits of `vec4` */
+template <>
+struct UniformTraits<Vec4> {
+    static const size_t ALIGNMENT = 16;
+    static const size_t SIZE = 16;
+};
+
+/** Traits of `mat3`, as three columns of four floats */
+template <>
+struct UniformTraits<Mat3> {
+    static const size_t ALIGNMENT = 16;
+    static const size_t SIZE = 48;
+};
+
+/** Traits of `mat4` */
+template <>
+struct UniformTraits<Mat4> {
+    static const size_t ALIGNMENT = 16;
+    static const size_t SIZE = 64;
+};
+
+
+/**
+ * Start of a block, before its first member.
+ */
+template <UniformLayout::Standard S>
+struct UniformBlock {
+    static const UniformLayout::Standard STANDARD = S; ///< Rules the block is laid out by
+    static const size_t END = 0; ///< Offset just past the last member
+    static const size_t BLOCK_ALIGNMENT = (S == UniformLayout::STD140) ? 16 : 4; ///< Alignment of the block so far
+};
+
+
+/**
+ * Member of a block placed after another member, with its offset found at compile time.
+ *
+ * Members are chained by type, so a block with a matrix, a vector and an array of four floats is
+ *
+ *     typedef UniformBlock<UniformLayout::STD140> Start;
+ *     typedef UniformMember<Mat4, Start> Model;
+ *     typedef UniformMember<Vec4, Model> Color;
+ *     typedef UniformMember<float, Color, 4> Weights;
+ *
+ * giving `Color::OFFSET` of 64, `Weights::OFFSET` of 80 and `Weights::BLOCK_SIZE` of 144.  `BLOCK_SIZE` of the last
+ * member is also the stride between blocks placed one after another in a buffer.
+ *
+ * @param T Type of the member, one of `float`, `Vec3`, `Vec4`, `Mat3` or `Mat4`
+ * @param PREVIOUS Member before this one, or the `UniformBlock` starting the block
+ * @param COUNT Number of elements if the member is an array, or one if it is not
+ */
+template <typename T, typename PREVIOUS, size_t COUNT = 1>
+struct UniformMember {
+// Constants
+    static const UniformLayout::Standard STANDARD = PREVIOUS::STANDARD; ///< Rules the block is laid out by
+    static const size_t ALIGNMENT = ((COUNT > 1) && (STANDARD == UniformLayout::STD140))
+            ? ((UniformTraits<T>::ALIGNMENT + 15) / 16) * 16 : UniformTraits<T>::ALIGNMENT; ///< Alignment of member
+    static const size_t STRIDE = ((UniformTraits<T>::SIZE + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT; ///< Array stride
+    static const size_t OFFSET = ((PREVIOUS::END + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT; ///< Offset in block
+    static const size_t END = OFFSET + ((COUNT > 1) ? (STRIDE * COUNT) : UniformTraits<T>::SIZE); ///< Offset past it
+    static const size_t BLOCK_ALIGNMENT = (PREVIOUS::BLOCK_ALIGNMENT > ALIGNMENT)
+            ? PREVIOUS::BLOCK_ALIGNMENT : ALIGNMENT; ///< Alignment of the block so far
+    static const size_t BLOCK_SIZE = ((END + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT) * BLOCK_ALIGNMENT; ///< Block size
+// Methods
+    static void write(void* block, const T& value);
+    static void writeArray(void* block, const T* values);
+    static void writeBlocks(void* blocks, size_t count, size_t stride, const T* values);
+};
+
+/**
+ * Writes the member into a block.
+ *
+ * @param block Start of the block
+ * @param value Value of the member, or of its first element if it is an array
+ */
+template <typename T, typename PREVIOUS, size_t COUNT>
+void UniformMember<T, PREVIOUS, COUNT>::write(void* block, const T& value) {
+    UniformLayout::pack(value, static_cast<char*>(block) + OFFSET);
+}
+
+/**
+ * Writes every element of an array member into a block.
+ *
+ * @param block Start of the block
+ * @param values Elements of the array, `COUNT` of them
+ */
+template <typename T, typename PREVIOUS, size_t COUNT>
+void UniformMember<T, PREVIOUS, COUNT>::writeArray(void* block, const T* values) {
+    UniformLayout::pack(values, COUNT, static_cast<char*>(block) + OFFSET, STRIDE);
+}
+
+/**
+ * Writes the member into each of a run of blocks, such as per-instance data, on several threads.
+ *
+ * @param blocks Start of the first block
+ * @param count Number of blocks
+ * @param stride Number of bytes from the start of one block to the next, usually `BLOCK_SIZE` of the last member
+ * @param values Values of the member for each block in turn, with `COUNT` elements each for arrays
+ */
+template <typename T, typename PREVIOUS, size_t COUNT>
+void UniformMember<T, PREVIOUS, COUNT>::writeBlocks(void* blocks, size_t count, size_t stride, const T* values) {
+    for (size_t i = 0; i < COUNT; ++i) {
+        UniformLayout::pack(values + i, count, static_cast<char*>(blocks) + OFFSET + (i * STRIDE), stride, COUNT);
+    }
+}
+
+} /* namespace M3d */
+#endif
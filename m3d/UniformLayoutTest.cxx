@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/UniformLayout.h"
+using namespace std;
+
+/*
+ * Blocks holding one of each type, by both sets of rules
+ */
+typedef M3d::UniformBlock<M3d::UniformLayout::STD140> Start140;
+typedef M3d::UniformMember<float, Start140> A140;
+typedef M3d::UniformMember<M3d::Vec3, A140> B140;
+typedef M3d::UniformMember<float, B140> C140;
+typedef M3d::UniformMember<M3d::Mat3, C140> D140;
+typedef M3d::UniformMember<float, D140, 3> E140;
+typedef M3d::UniformMember<M3d::Vec4, E140> F140;
+typedef M3d::UniformMember<M3d::Mat4, F140> G140;
+typedef M3d::UniformBlock<M3d::UniformLayout::STD430> Start430;
+typedef M3d::UniformMember<float, Start430> A430;
+typedef M3d::UniformMember<M3d::Vec3, A430> B430;
+typedef M3d::UniformMember<float, B430> C430;
+typedef M3d::UniformMember<M3d::Mat3, C430> D430;
+typedef M3d::UniformMember<float, D430, 3> E430;
+typedef M3d::UniformMember<M3d::Vec4, E430> F430;
+typedef M3d::UniformMember<M3d::Mat4, F430> G430;
+
+/* Offsets must be usable as constants */
+typedef char BlockSizeCheck[G140::BLOCK_SIZE - 208 + 1];
+
+
+/**
+ * Unit test for UniformLayout.
+ */
+class UniformLayoutTest : public CppUnit::TestFixture {
+private:
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + ((upper - lower) * rand() / RAND_MAX);
+    }
+
+    /**
+     * Returns the floats in part of a buffer.
+     */
+    static vector<float> getFloats(const vector<char>& buf, size_t offset, size_t count) {
+        vector<float> floats(count);
+        memcpy(&floats[0], &buf[offset], count * sizeof(float));
+        return floats;
+    }
+
+public:
+
+    /**
+     * Resets the number of threads.
+     */
+    void tearDown() {
+        M3d::Parallel::setConcurrency(0);
+    }
+
+    /**
+     * Ensures offsets follow the std140 rules, where arrays and blocks are aligned to four floats.
+     */
+    void testOffsetsStd140() {
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, (size_t) A140::OFFSET);
+        CPPUNIT_ASSERT_EQUAL((size_t) 16, (size_t) B140::OFFSET);
+        CPPUNIT_ASSERT_EQUAL((size_t) 28, (size_t) C140::OFFSET);
+        CPPUNIT_ASSERT_EQUAL((size_t) 32, (size_t) D140::OFFSET);
+        CPPUNIT_ASSERT_EQUAL((size_t) 80, (size_t) E140::OFFSET);
+        CPPUNIT_ASSERT_EQUAL((size_t) 16, (size_t) E140::STRIDE);
+        CPPUNIT_ASSERT_EQUAL((size_t) 128, (size_t) F140::OFFSET);
+        CPPUNIT_ASSERT_EQUAL((size_t) 144, (size_t) G140::OFFSET);
+        CPPUNIT_ASSERT_EQUAL((size_t) 208, (size_t) G140::BLOCK_SIZE);
+        CPPUNIT_ASSERT_EQUAL((size_t) 16, (size_t) A140::BLOCK_SIZE);
+    }
+
+    /**
+     * Ensures offsets follow the std430 rules, where arrays of scalars are packed.
+     */
+    void testOffsetsStd430() {
+        CPPUNIT_ASSERT_EQUAL((size_t) 16, (size_t) B430::OFFSET);
+        CPPUNIT_ASSERT_EQUAL((size_t) 28, (size_t) C430::OFFSET);
+        CPPUNIT_ASSERT_EQUAL((size_t) 32, (size_t) D430::OFFSET);
+        CPPUNIT_ASSERT_EQUAL((size_t) 80, (size_t) E430::OFFSET);
+        CPPUNIT_ASSERT_EQUAL((size_t) 4, (size_t) E430::STRIDE);
+        CPPUNIT_ASSERT_EQUAL((size_t) 96, (size_t) F430::OFFSET);
+        CPPUNIT_ASSERT_EQUAL((size_t) 112, (size_t) G430::OFFSET);
+        CPPUNIT_ASSERT_EQUAL((size_t) 176, (size_t) G430::BLOCK_SIZE);
+        CPPUNIT_ASSERT_EQUAL((size_t) 4, (size_t) A430::BLOCK_SIZE);
+        CPPUNIT_ASSERT_EQUAL((size_t) 32, (size_t) B430::BLOCK_SIZE);
+    }
+
+    /**
+     * Ensures members are written at their offsets, with matrix columns padded and nothing else touched.
+     */
+    void testWrite() {
+        vector<char> buf(G140::BLOCK_SIZE, 'x');
+        const float weights[3] = { 7, 8, 9 };
+        const double elements[9] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+        A140::write(&buf[0], 1.5f);
+        B140::write(&buf[0], M3d::Vec3(1, 2, 3));
+        C140::write(&buf[0], 4.0f);
+        D140::write(&buf[0], M3d::Mat3::fromArrayInColumnMajor(elements));
+        E140::writeArray(&buf[0], weights);
+        F140::write(&buf[0], M3d::Vec4(1, 2, 3, 4));
+
+        const float vec3[4] = { 1, 2, 3, 4 };
+        const float mat3[12] = { 1, 2, 3, 0, 4, 5, 6, 0, 7, 8, 9, 0 };
+        CPPUNIT_ASSERT(getFloats(buf, 0, 1) == vector<float>(1, 1.5f));
+        CPPUNIT_ASSERT(vector<char>(12, 'x') == vector<char>(&buf[4], &buf[16]));
+        CPPUNIT_ASSERT(getFloats(buf, 16, 4) == vector<float>(vec3, vec3 + 4));
+        CPPUNIT_ASSERT(getFloats(buf, 32, 12) == vector<float>(mat3, mat3 + 12));
+        CPPUNIT_ASSERT(getFloats(buf, 80, 1) == vector<float>(1, 7.0f));
+        CPPUNIT_ASSERT(getFloats(buf, 96, 1) == vector<float>(1, 8.0f));
+        CPPUNIT_ASSERT(getFloats(buf, 112, 1) == vector<float>(1, 9.0f));
+        CPPUNIT_ASSERT(vector<char>(12, 'x') == vector<char>(&buf[116], &buf[128]));
+        CPPUNIT_ASSERT(getFloats(buf, 128, 4) == vector<float>(vec3, vec3 + 4));
+        CPPUNIT_ASSERT(vector<char>(64, 'x') == vector<char>(&buf[144], &buf[208]));
+    }
+
+    /**
+     * Ensures writing a member of many blocks at once matches writing each block on its own.
+     */
+    void testWriteBlocks() {
+        const size_t count = 40000;
+        vector<M3d::Mat4> models(count);
+        vector<M3d::Vec3> offsets(count);
+        vector<float> weights(3 * count);
+        for (size_t i = 0; i < count; ++i) {
+            for (int j = 0; j < 4; ++j) {
+                models[i][j] = M3d::Vec4(random(-1, 1), random(-1, 1), random(-1, 1), random(-1, 1));
+            }
+            offsets[i] = M3d::Vec3(random(-1, 1), random(-1, 1), random(-1, 1));
+            weights[3 * i] = (float) i;
+            weights[(3 * i) + 1] = (float) random(0, 1);
+            weights[(3 * i) + 2] = -(float) i;
+        }
+
+        M3d::Parallel::setConcurrency(4);
+        vector<char> batch(count * G430::BLOCK_SIZE, 'x');
+        G430::writeBlocks(&batch[0], count, G430::BLOCK_SIZE, &models[0]);
+        B430::writeBlocks(&batch[0], count, G430::BLOCK_SIZE, &offsets[0]);
+        E430::writeBlocks(&batch[0], count, G430::BLOCK_SIZE, &weights[0]);
+
+        vector<char> single(count * G430::BLOCK_SIZE, 'x');
+        for (size_t i = 0; i < count; ++i) {
+            char* const block = &single[i * G430::BLOCK_SIZE];
+            G430::write(block, models[i]);
+            B430::write(block, offsets[i]);
+            E430::writeArray(block, &weights[3 * i]);
+        }
+        CPPUNIT_ASSERT(batch == single);
+        CPPUNIT_ASSERT(getFloats(batch, (5 * G430::BLOCK_SIZE) + E430::OFFSET, 3)[2] == -5.0f);
+    }
+
+    CPPUNIT_TEST_SUITE(UniformLayoutTest);
+    CPPUNIT_TEST(testOffsetsStd140);
+    CPPUNIT_TEST(testOffsetsStd430);
+    CPPUNIT_TEST(testWrite);
+    CPPUNIT_TEST(testWriteBlocks);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(UniformLayoutTest::suite());
+    runner.run();
+    return 0;
+}
@@ -24,7 +24,7 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 #include "config.h"
-#include <sstream>
+#include <ostream>
 #include <stdexcept>
 #include "m3d/Vec3.h"
 using namespace std;
@@ -442,6 +442,39 @@ Vec3& Vec3::operator/=(const Vec3& v) {
     return *this;
 }
 
+/**
+ * Writes the vector as text, the same way as `toString`, without allocating memory.
+ *
+ * Each component is written with the fewest digits that read back as exactly the same number.
+ *
+ * @param buf Buffer to write into, ended with a null character and cut short if too small
+ * @param size Number of characters the buffer can hold, where `FORMAT_SIZE` is always enough
+ * @return Length of the text, which is more than was written if the buffer was too small
+ */
+size_t Vec3::formatTo(char* buf, size_t size) const {
+    char text[FORMAT_SIZE];
+    const double values[3] = { x, y, z };
+    return Format::copy(text, Format::formatList(text, values, 3), buf, size);
+}
+
+/**
+ * Reads a vector from text written by `formatTo` or `toString`.
+ *
+ * @param text Text to read from, where whitespace is allowed before and between tokens
+ * @param v Vector to store the result in, unchanged if the text is malformed
+ * @return Position after the vector, or `NULL` if the text does not start with one
+ */
+const char* Vec3::parse(const char* text, Vec3& v) {
+    double values[3];
+    text = Format::parseList(text, values, 3);
+    if (text != NULL) {
+        v.x = values[0];
+        v.y = values[1];
+        v.z = values[2];
+    }
+    return text;
+}
+
 /**
  * Copies the vector's components to a double array.
  *
@@ -468,11 +501,8 @@ void Vec3::toArray(float arr[3]) const {
  * Returns a string represention of this vector.
  */
 string Vec3::toString() const {
-
-    stringstream stream;
-
-    stream << (*this);
-    return stream.str();
+    char text[FORMAT_SIZE];
+    return string(text, formatTo(text, FORMAT_SIZE));
 }
 
 } /* namespace M3d */
@@ -485,8 +515,9 @@ string Vec3::toString() const {
  * @return Reference to the stream
  */
 ostream& operator<<(ostream &out, const M3d::Vec3 &u) {
-    out << "[";
-    out << u.x << ", " << u.y << ", " << u.z;
-    out << "]";
-    return out;
+    if (!M3d::Format::isDefault(out)) {
+        return out << "[" << u.x << ", " << u.y << ", " << u.z << "]";
+    }
+    char text[M3d::Vec3::FORMAT_SIZE];
+    return out.write(text, u.formatTo(text, sizeof(text)));
 }
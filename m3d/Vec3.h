@@ -28,6 +28,7 @@
 #include "m3d/common.h"
 #include <cmath>
 #include <iomanip>
+#include "m3d/Format.h"
 namespace M3d {
 
 
@@ -36,6 +37,8 @@ namespace M3d {
  */
 class Vec3 {
 public:
+// Constants
+    static const size_t FORMAT_SIZE = 81; ///< Characters needed to format any vector, including the null character
 // Attributes
     double x; ///< X coordinate
     double y; ///< Y coordinate
@@ -46,6 +49,7 @@ public:
     explicit Vec3(double x, double y, double z);
     explicit Vec3(double arr[3]);
     explicit Vec3(float arr[3]);
+    static const char* parse(const char* text, Vec3& v);
     double operator[](int i) const;
     double& operator[](int i);
     Vec3 operator+() const;
@@ -68,6 +72,7 @@ public:
     Vec3 operator/(const Vec3 &v) const;
     Vec3& operator/=(double d);
     Vec3& operator/=(const Vec3 &v);
+    size_t formatTo(char* buf, size_t size) const;
     void toArray(double arr[3]) const;
     void toArray(float arr[3]) const;
     std::string toString() const;
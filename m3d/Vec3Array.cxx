@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/Vec3Array.h"
+using namespace std;
+namespace M3d {
+
+/**
+ * Constructs an empty array.
+ */
+Vec3Array::Vec3Array() {
+    // pass
+}
+
+/**
+ * Constructs an array of zero vectors.
+ *
+ * @param size Number of vectors
+ */
+Vec3Array::Vec3Array(size_t size) : x(size), y(size), z(size) {
+    // pass
+}
+
+/**
+ * Creates an array by copying vectors from a regular array.
+ *
+ * @param arr Vectors to copy
+ * @param size Number of vectors in the array
+ * @return Array with copies of the vectors
+ */
+Vec3Array Vec3Array::fromVec3s(const Vec3* arr, size_t size) {
+    Vec3Array result(size);
+    for (size_t i = 0; i < size; ++i) {
+        result.x[i] = arr[i].x;
+        result.y[i] = arr[i].y;
+        result.z[i] = arr[i].z;
+    }
+    return result;
+}
+
+/**
+ * Adds a vector to the end of the array.
+ *
+ * @param v Vector to add
+ */
+void Vec3Array::append(const Vec3& v) {
+    x.push_back(v.x);
+    y.push_back(v.y);
+    z.push_back(v.z);
+}
+
+/**
+ * Removes all vectors from the array.
+ */
+void Vec3Array::clear() {
+    x.clear();
+    y.clear();
+    z.clear();
+}
+
+/**
+ * Returns a copy of a vector in the array.
+ *
+ * @param i Index of vector, assumed in bounds
+ * @return Copy of the vector
+ */
+Vec3 Vec3Array::get(size_t i) const {
+    return Vec3(x[i], y[i], z[i]);
+}
+
+/**
+ * Reserves room for vectors without changing the size of the array.
+ *
+ * @param capacity Number of vectors to reserve room for
+ */
+void Vec3Array::reserve(size_t capacity) {
+    x.reserve(capacity);
+    y.reserve(capacity);
+    z.reserve(capacity);
+}
+
+/**
+ * Changes the number of vectors in the array, filling new ones with zeros.
+ *
+ * @param size New number of vectors
+ */
+void Vec3Array::resize(size_t size) {
+    x.resize(size);
+    y.resize(size);
+    z.resize(size);
+}
+
+/**
+ * Replaces a vector in the array.
+ *
+ * @param i Index of vector, assumed in bounds
+ * @param v Vector to copy
+ */
+void Vec3Array::set(size_t i, const Vec3& v) {
+    x[i] = v.x;
+    y[i] = v.y;
+    z[i] = v.z;
+}
+
+/**
+ * Returns the number of vectors in the array.
+ */
+size_t Vec3Array::size() const {
+    return x.size();
+}
+
+/**
+ * Copies the vectors to a regular array.
+ *
+ * @param arr Array to copy to, assumed large enough
+ */
+void Vec3Array::toVec3s(Vec3* arr) const {
+    const size_t n = size();
+    for (size_t i = 0; i < n; ++i) {
+        arr[i].x = x[i];
+        arr[i].y = y[i];
+        arr[i].z = z[i];
+    }
+}
+
+} /* namespace M3d */
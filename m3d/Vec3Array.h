@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_VEC3ARRAY_H
+#define M3D_VEC3ARRAY_H
+#include "m3d/common.h"
+#include <vector>
+#include "m3d/Vec3.h"
+namespace M3d {
+
+
+/**
+ * Array of three-component vectors stored as separate arrays of components.
+ *
+ * Keeping each component contiguous lets batch operations process several vectors at once with SIMD instructions.
+ */
+class Vec3Array {
+public:
+// Attributes
+    std::vector<double> x; ///< X coordinates
+    std::vector<double> y; ///< Y coordinates
+    std::vector<double> z; ///< Z coordinates
+// Methods
+    explicit Vec3Array();
+    explicit Vec3Array(size_t size);
+    static Vec3Array fromVec3s(const Vec3* arr, size_t size);
+    void append(const Vec3& v);
+    void clear();
+    Vec3 get(size_t i) const;
+    void reserve(size_t capacity);
+    void resize(size_t size);
+    void set(size_t i, const Vec3& v);
+    size_t size() const;
+    void toVec3s(Vec3* arr) const;
+};
+
+} /* namespace M3d */
+#endif
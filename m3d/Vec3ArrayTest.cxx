@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/Vec3Array.h"
+using namespace std;
+
+
+/**
+ * Unit test for Vec3Array.
+ */
+class Vec3ArrayTest : public CppUnit::TestFixture {
+public:
+
+    /**
+     * Ensures append stores each component in its own array.
+     */
+    void testAppend() {
+        M3d::Vec3Array arr;
+        arr.append(M3d::Vec3(1, 2, 3));
+        arr.append(M3d::Vec3(4, 5, 6));
+        CPPUNIT_ASSERT_EQUAL((size_t) 2, arr.size());
+        CPPUNIT_ASSERT_EQUAL(1.0, arr.x[0]);
+        CPPUNIT_ASSERT_EQUAL(4.0, arr.x[1]);
+        CPPUNIT_ASSERT_EQUAL(5.0, arr.y[1]);
+        CPPUNIT_ASSERT_EQUAL(6.0, arr.z[1]);
+    }
+
+    /**
+     * Ensures get and set work correctly.
+     */
+    void testGetSet() {
+        M3d::Vec3Array arr(3);
+        CPPUNIT_ASSERT(arr.get(2) == M3d::Vec3(0, 0, 0));
+        arr.set(2, M3d::Vec3(7, 8, 9));
+        CPPUNIT_ASSERT(arr.get(2) == M3d::Vec3(7, 8, 9));
+    }
+
+    /**
+     * Ensures converting to and from regular arrays preserves the vectors.
+     */
+    void testFromVec3sToVec3s() {
+        M3d::Vec3 vecs[2];
+        vecs[0] = M3d::Vec3(1, 2, 3);
+        vecs[1] = M3d::Vec3(4, 5, 6);
+        const M3d::Vec3Array arr = M3d::Vec3Array::fromVec3s(vecs, 2);
+        M3d::Vec3 copies[2];
+        arr.toVec3s(copies);
+        CPPUNIT_ASSERT(copies[0] == vecs[0]);
+        CPPUNIT_ASSERT(copies[1] == vecs[1]);
+    }
+
+    /**
+     * Ensures resize and clear change the size of every component array.
+     */
+    void testResizeClear() {
+        M3d::Vec3Array arr;
+        arr.resize(5);
+        CPPUNIT_ASSERT_EQUAL((size_t) 5, arr.size());
+        CPPUNIT_ASSERT_EQUAL((size_t) 5, arr.z.size());
+        arr.clear();
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, arr.size());
+        CPPUNIT_ASSERT_EQUAL((size_t) 0, arr.y.size());
+    }
+
+    CPPUNIT_TEST_SUITE(Vec3ArrayTest);
+    CPPUNIT_TEST(testAppend);
+    CPPUNIT_TEST(testGetSet);
+    CPPUNIT_TEST(testFromVec3sToVec3s);
+    CPPUNIT_TEST(testResizeClear);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(Vec3ArrayTest::suite());
+    runner.run();
+    return 0;
+}
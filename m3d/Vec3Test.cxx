@@ -24,6 +24,8 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 #include "config.h"
+#include <iomanip>
+#include <sstream>
 #include <cppunit/TestFixture.h>
 #include <cppunit/extensions/HelperMacros.h>
 #include <cppunit/ui/text/TestRunner.h>
@@ -332,6 +334,56 @@ public:
         CPPUNIT_ASSERT_EQUAL(6.0, r.z);
     }
 
+    /**
+     * Ensures formatTo writes the shortest exact text and cuts it short when the buffer is too small.
+     */
+    void testFormatTo() {
+
+        M3d::Vec3 u(1, -0.5, 0.1 + 0.2);
+        char buf[M3d::Vec3::FORMAT_SIZE];
+
+        CPPUNIT_ASSERT_EQUAL((size_t) 30, u.formatTo(buf, sizeof(buf)));
+        CPPUNIT_ASSERT_EQUAL(string("[1, -0.5, 0.30000000000000004]"), string(buf));
+        CPPUNIT_ASSERT_EQUAL((size_t) 30, u.formatTo(buf, 5));
+        CPPUNIT_ASSERT_EQUAL(string("[1, "), string(buf));
+        CPPUNIT_ASSERT_EQUAL(string("[1, -0.5, 0.30000000000000004]"), u.toString());
+    }
+
+    /**
+     * Ensures streams print exact values by default, and follow precision, width and notation when they are set.
+     */
+    void testOperatorInsert() {
+
+        const M3d::Vec3 u(1, -0.5, 0.1 + 0.2);
+        ostringstream exact, precise, wide, fixed;
+
+        exact << u;
+        CPPUNIT_ASSERT_EQUAL(string("[1, -0.5, 0.30000000000000004]"), exact.str());
+        precise << setprecision(3) << u;
+        CPPUNIT_ASSERT_EQUAL(string("[1, -0.5, 0.3]"), precise.str());
+        wide << setw(3) << u << u;
+        CPPUNIT_ASSERT_EQUAL(string("  [1, -0.5, 0.3][1, -0.5, 0.30000000000000004]"), wide.str());
+        fixed << std::fixed << setprecision(2) << u;
+        CPPUNIT_ASSERT_EQUAL(string("[1.00, -0.50, 0.30]"), fixed.str());
+    }
+
+    /**
+     * Ensures parse reads back what toString writes and rejects anything else.
+     */
+    void testParse() {
+
+        M3d::Vec3 u(1.0 / 3.0, -2e-300, 4);
+        M3d::Vec3 v;
+        const string text = u.toString() + ";";
+
+        const char* end = M3d::Vec3::parse(text.c_str(), v);
+        CPPUNIT_ASSERT(end != NULL);
+        CPPUNIT_ASSERT_EQUAL(';', *end);
+        CPPUNIT_ASSERT(u == v);
+        CPPUNIT_ASSERT(M3d::Vec3::parse("[1, 2]", v) == NULL);
+        CPPUNIT_ASSERT(u == v);
+    }
+
     /**
      * Ensures `Vec3::Vec3(double)` works correctly.
      */
@@ -366,6 +418,9 @@ public:
     CPPUNIT_TEST(testNormalize);
     CPPUNIT_TEST(testMin);
     CPPUNIT_TEST(testMax);
+    CPPUNIT_TEST(testFormatTo);
+    CPPUNIT_TEST(testOperatorInsert);
+    CPPUNIT_TEST(testParse);
     CPPUNIT_TEST(testVec3Double);
     CPPUNIT_TEST_SUITE_END();
 };
@@ -26,7 +26,7 @@
 #include "config.h"
 #include <cmath>
 #include <iomanip>
-#include <sstream>
+#include <ostream>
 #include <stdexcept>
 #include "m3d/Vec4.h"
 using namespace std;
@@ -454,6 +454,40 @@ Vec4& Vec4::operator/=(const Vec4 &v) {
     return *this;
 }
 
+/**
+ * Writes the vector as text, the same way as `toString`, without allocating memory.
+ *
+ * Each component is written with the fewest digits that read back as exactly the same number.
+ *
+ * @param buf Buffer to write into, ended with a null character and cut short if too small
+ * @param size Number of characters the buffer can hold, where `FORMAT_SIZE` is always enough
+ * @return Length of the text, which is more than was written if the buffer was too small
+ */
+size_t Vec4::formatTo(char* buf, size_t size) const {
+    char text[FORMAT_SIZE];
+    const double values[4] = { x, y, z, w };
+    return Format::copy(text, Format::formatList(text, values, 4), buf, size);
+}
+
+/**
+ * Reads a vector from text written by `formatTo` or `toString`.
+ *
+ * @param text Text to read from, where whitespace is allowed before and between tokens
+ * @param v Vector to store the result in, unchanged if the text is malformed
+ * @return Position after the vector, or `NULL` if the text does not start with one
+ */
+const char* Vec4::parse(const char* text, Vec4& v) {
+    double values[4];
+    text = Format::parseList(text, values, 4);
+    if (text != NULL) {
+        v.x = values[0];
+        v.y = values[1];
+        v.z = values[2];
+        v.w = values[3];
+    }
+    return text;
+}
+
 /**
  * Copies the vector's components to a double array.
  *
@@ -482,11 +516,8 @@ void Vec4::toArray(float arr[4]) {
  * Returns a string representation of this vector.
  */
 string Vec4::toString() const {
-
-    stringstream stream;
-
-    stream << (*this);
-    return stream.str();
+    char text[FORMAT_SIZE];
+    return string(text, formatTo(text, FORMAT_SIZE));
 }
 
 /**
@@ -508,8 +539,9 @@ Vec3 Vec4::toVec3() const {
  * @return Reference to the stream
  */
 ostream& operator<<(ostream &out, const M3d::Vec4 &v) {
-    out << "[";
-    out << v.x << ", " << v.y << ", " << v.z << ", " << v.w;
-    out << "]";
-    return out;
+    if (!M3d::Format::isDefault(out)) {
+        return out << "[" << v.x << ", " << v.y << ", " << v.z << ", " << v.w << "]";
+    }
+    char text[M3d::Vec4::FORMAT_SIZE];
+    return out.write(text, v.formatTo(text, sizeof(text)));
 }
@@ -35,6 +35,7 @@ namespace M3d {
  */
 class Vec4 {
 public:
+    static const size_t FORMAT_SIZE = 107; ///< Characters needed to format any vector, including the null character
     double x; ///< X coordinate
     double y; ///< Y coordinate
     double z; ///< Z coordinate
@@ -46,6 +47,7 @@ public:
     explicit Vec4(double x, double y, double z, double w);
     explicit Vec4(double arr[4]);
     explicit Vec4(float arr[4]);
+    static const char* parse(const char* text, Vec4& v);
     double operator[](int i) const;
     double& operator[](int i);
     bool operator==(const Vec4 &v) const;
@@ -68,6 +70,7 @@ public:
     Vec4 operator/(double f) const;
     Vec4& operator/=(const Vec4 &v);
     Vec4& operator/=(double f);
+    size_t formatTo(char* buf, size_t size) const;
     void toArray(double arr[4]);
     void toArray(float arr[4]);
     std::string toString() const;
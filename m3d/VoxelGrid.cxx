@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "m3d/VoxelGrid.h"
+using namespace std;
+namespace M3d {
+
+
+/*
+ * Task computing the codes of the voxels holding a range of points.
+ */
+class VoxelGrid::CodeTask : public ParallelTask {
+public:
+    CodeTask(const VoxelGrid& grid, const Vec3Array& points, uint64_t* keys, uint32_t* values) :
+            grid(grid), points(points), keys(keys), values(values) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            grid.findCode(points.get(i), keys[i]);
+            values[i] = (uint32_t) i;
+        }
+    }
+private:
+    const VoxelGrid& grid;
+    const Vec3Array& points;
+    uint64_t* keys;
+    uint32_t* values;
+};
+
+
+/*
+ * Task averaging the points in a range of voxels.
+ */
+class VoxelGrid::CentroidTask : public ParallelTask {
+public:
+    CentroidTask(VoxelGrid& grid, const Vec3Array& points) : grid(grid), points(points) { }
+    virtual void run(size_t, size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            const uint32_t first = grid.offsets[v];
+            const uint32_t last = grid.offsets[v + 1];
+            double x = 0, y = 0, z = 0;
+            for (uint32_t i = first; i < last; ++i) {
+                const uint32_t j = grid.indices[i];
+                x += points.x[j];
+                y += points.y[j];
+                z += points.z[j];
+            }
+            const double scale = 1.0 / (last - first);
+            grid.centroids.x[v] = x * scale;
+            grid.centroids.y[v] = y * scale;
+            grid.centroids.z[v] = z * scale;
+        }
+    }
+private:
+    VoxelGrid& grid;
+    const Vec3Array& points;
+};
+
+
+/*
+ * Task checking occupancy for a range of words of a bitmask, so no two chunks write the same word.
+ */
+class VoxelGrid::OccupancyTask : public ParallelTask {
+public:
+    OccupancyTask(const VoxelGrid& grid, const Vec3Array& queries, int level, uint32_t* mask, size_t* counts) :
+            grid(grid), queries(queries), level(level), mask(mask), counts(counts) { }
+    virtual void run(size_t chunk, size_t begin, size_t end) {
+        const size_t last = std::min(end * 32, queries.size());
+        double margin[32];
+        counts[chunk] = 0;
+        for (size_t first = begin * 32; first < last; first += 32) {
+            const size_t stop = std::min(first + 32, last);
+            for (size_t i = first; i < stop; ++i) {
+                margin[i - first] = grid.isOccupied(queries.get(i), level) ? 0 : -1;
+            }
+            counts[chunk] += Bitmask::setFromMargins(margin, first, stop, mask);
+        }
+    }
+private:
+    const VoxelGrid& grid;
+    const Vec3Array& queries;
+    int level;
+    uint32_t* mask;
+    size_t* counts;
+};
+
+// METHODS
+
+/**
+ * Constructs an empty grid with voxels one unit wide.
+ */
+VoxelGrid::VoxelGrid() : voxelSize(1), inverseVoxelSize(1), origin(0, 0, 0), offsets(1, 0) {
+    // pass
+}
+
+/**
+ * Constructs an empty grid.
+ *
+ * @param voxelSize Width of each voxel
+ * @throws invalid_argument if voxel size is not positive
+ */
+VoxelGrid::VoxelGrid(double voxelSize) :
+        voxelSize(voxelSize), inverseVoxelSize(1 / voxelSize), origin(0, 0, 0), offsets(1, 0) {
+    if (!(voxelSize > 0)) {
+        throw invalid_argument("[VoxelGrid] Voxel size must be positive!");
+    }
+}
+
+/**
+ * Builds the grid over a set of points, replacing anything already in it.
+ *
+ * @param points Points to put in the grid
+ * @throws out_of_range if the points span more than `MAX_VOXELS_PER_AXIS` voxels along any axis
+ */
+void VoxelGrid::build(const Vec3Array& points) {
+
+    const size_t size = points.size();
+
+    // Place the origin on a voxel boundary below every point
+    const Aabb bounds = Aabb::fromPoints(points);
+    if (size > 0) {
+        origin = Vec3(findBoundary(bounds.lower.x), findBoundary(bounds.lower.y), findBoundary(bounds.lower.z));
+        const Vec3 span = (bounds.upper - origin) * inverseVoxelSize;
+        if (std::max(std::max(span.x, span.y), span.z) >= MAX_VOXELS_PER_AXIS) {
+            throw out_of_range("[VoxelGrid] Points span too many voxels!");
+        }
+    }
+
+    // Sort points by the codes of their voxels
+    vector<uint64_t> keys(size);
+    indices.resize(size);
+    if (size > 0) {
+        CodeTask codeTask(*this, points, &keys[0], &indices[0]);
+        Parallel::run(codeTask, size, GRAIN_SIZE);
+        sortMortonCodes(&keys[0], &indices[0], size);
+    }
+
+    // Find where each voxel starts
+    codes.clear();
+    offsets.clear();
+    for (size_t i = 0; i < size; ++i) {
+        if ((i == 0) || (keys[i] != keys[i - 1])) {
+            codes.push_back(keys[i]);
+            offsets.push_back((uint32_t) i);
+        }
+    }
+    offsets.push_back((uint32_t) size);
+
+    // Average the points in each voxel
+    centroids.resize(codes.size());
+    CentroidTask centroidTask(*this, points);
+    Parallel::run(centroidTask, codes.size(), GRAIN_SIZE);
+}
+
+/**
+ * Counts the occupied nodes at one level of the octree.
+ *
+ * @param level Level of the nodes, in [0 .. MAX_LEVEL], where level zero counts voxels
+ * @return Number of nodes holding at least one point
+ * @throws out_of_range if level is out of range
+ */
+size_t VoxelGrid::countNodes(int level) const {
+
+    if ((level < 0) || (level > MAX_LEVEL)) {
+        throw out_of_range("[VoxelGrid] Level out of bounds!");
+    }
+
+    const int shift = 3 * level;
+    size_t count = 0;
+
+    for (size_t i = 0; i < codes.size(); ++i) {
+        if ((i == 0) || ((codes[i] >> shift) != (codes[i - 1] >> shift))) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+/**
+ * Replaces the points in each voxel with their centroid.
+ *
+ * @param points Points to downsample
+ * @param voxelSize Width of each voxel
+ * @param result Array to store one centroid per occupied voxel in, in Morton order
+ */
+void VoxelGrid::downsample(const Vec3Array& points, double voxelSize, Vec3Array& result) {
+    VoxelGrid grid(voxelSize);
+    grid.build(points);
+    result = grid.centroids;
+}
+
+/**
+ * Finds the voxel holding a point.
+ *
+ * @param point Point to look up
+ * @param voxel Index of the voxel, set only if it is occupied
+ * @return `true` if the voxel holding the point is occupied
+ */
+bool VoxelGrid::findVoxel(const Vec3& point, size_t& voxel) const {
+
+    uint64_t code;
+    if (!findCode(point, code)) {
+        return false;
+    }
+
+    const vector<uint64_t>::const_iterator it = lower_bound(codes.begin(), codes.end(), code);
+    if ((it == codes.end()) || (*it != code)) {
+        return false;
+    }
+    voxel = it - codes.begin();
+    return true;
+}
+
+/**
+ * Returns the average of the points in each voxel, in the same order as the codes.
+ */
+const Vec3Array& VoxelGrid::getCentroids() const {
+    return centroids;
+}
+
+/**
+ * Returns the Morton code of each occupied voxel, in increasing order.
+ */
+const uint64_t* VoxelGrid::getCodes() const {
+    return codes.empty() ? NULL : &codes[0];
+}
+
+/**
+ * Returns indices of the points given to `build`, sorted by voxel.
+ */
+const uint32_t* VoxelGrid::getIndices() const {
+    return indices.empty() ? NULL : &indices[0];
+}
+
+/**
+ * Returns where the points of each voxel start in the sorted indices, followed by the number of points.
+ */
+const uint32_t* VoxelGrid::getOffsets() const {
+    return &offsets[0];
+}
+
+/**
+ * Returns the lower corner of the voxel with coordinates zero.
+ */
+Vec3 VoxelGrid::getOrigin() const {
+    return origin;
+}
+
+/**
+ * Returns the number of occupied voxels.
+ */
+size_t VoxelGrid::getVoxelCount() const {
+    return codes.size();
+}
+
+/**
+ * Returns the width of each voxel.
+ */
+double VoxelGrid::getVoxelSize() const {
+    return voxelSize;
+}
+
+/**
+ * Checks if the octree node holding a point contains any points.
+ *
+ * @param point Point to look up
+ * @param level Level of the node, in [0 .. MAX_LEVEL], where level zero is a single voxel
+ * @return `true` if the node is occupied
+ * @throws out_of_range if level is out of range
+ */
+bool VoxelGrid::isOccupied(const Vec3& point, int level) const {
+
+    if ((level < 0) || (level > MAX_LEVEL)) {
+        throw out_of_range("[VoxelGrid] Level out of bounds!");
+    }
+
+    uint64_t code;
+    return findCode(point, code) && hasNode(code, level);
+}
+
+/**
+ * Checks occupancy for many points on several threads.
+ *
+ * @param queries Points to look up
+ * @param level Level of the nodes, in [0 .. MAX_LEVEL], where level zero is a single voxel
+ * @param mask Bitmask to store results in, which is resized to hold one bit per query
+ * @return Number of queries in occupied nodes
+ * @throws out_of_range if level is out of range
+ */
+size_t VoxelGrid::markOccupied(const Vec3Array& queries, int level, vector<uint32_t>& mask) const {
+
+    if ((level < 0) || (level > MAX_LEVEL)) {
+        throw out_of_range("[VoxelGrid] Level out of bounds!");
+    }
+
+    const size_t words = (queries.size() + 31) / 32;
+    vector<size_t> counts(Parallel::countChunks(words, GRAIN_SIZE / 32));
+
+    mask.resize(words);
+    if (words > 0) {
+        OccupancyTask task(*this, queries, level, &mask[0], &counts[0]);
+        Parallel::run(task, words, GRAIN_SIZE / 32);
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        count += counts[i];
+    }
+    return count;
+}
+
+// HELPERS
+
+/*
+ * Finds the closest voxel boundary at or below a coordinate.
+ */
+double VoxelGrid::findBoundary(double value) const {
+    const double boundary = floor(value * inverseVoxelSize) * voxelSize;
+    return (boundary > value) ? (boundary - voxelSize) : boundary;
+}
+
+/*
+ * Computes the code of the voxel holding a point, or returns false if the point is outside the grid.
+ */
+bool VoxelGrid::findCode(const Vec3& point, uint64_t& code) const {
+
+    const Vec3 cell = (point - origin) * inverseVoxelSize;
+    const double x = floor(cell.x);
+    const double y = floor(cell.y);
+    const double z = floor(cell.z);
+
+    if (!((x >= 0) && (y >= 0) && (z >= 0))) {
+        return false;
+    } else if ((x >= MAX_VOXELS_PER_AXIS) || (y >= MAX_VOXELS_PER_AXIS) || (z >= MAX_VOXELS_PER_AXIS)) {
+        return false;
+    }
+    code = encodeMorton63((uint32_t) x, (uint32_t) y, (uint32_t) z);
+    return true;
+}
+
+/*
+ * Checks if any voxel falls under the node at a level containing a voxel.
+ */
+bool VoxelGrid::hasNode(uint64_t code, int level) const {
+
+    const int shift = 3 * level;
+    const uint64_t first = (code >> shift) << shift;
+    const uint64_t last = first + ((UINT64_C(1) << shift) - 1);
+
+    const vector<uint64_t>::const_iterator it = lower_bound(codes.begin(), codes.end(), first);
+    return (it != codes.end()) && (*it <= last);
+}
+
+} /* namespace M3d */
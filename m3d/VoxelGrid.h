@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef M3D_VOXELGRID_H
+#define M3D_VOXELGRID_H
+#include "m3d/common.h"
+#include <stdint.h>
+#include <vector>
+#include "m3d/Aabb.h"
+#include "m3d/Bitmask.h"
+#include "m3d/Morton.h"
+#include "m3d/Parallel.h"
+#include "m3d/Vec3.h"
+#include "m3d/Vec3Array.h"
+namespace M3d {
+
+
+/**
+ * Sparse grid of voxels holding points, which doubles as a linear octree.
+ *
+ * Points are quantized to voxels of equal size starting from the lower corner of their bounds, and each occupied
+ * voxel is keyed by the 63-bit Morton code of its coordinates.  Building computes the codes, sorts the points by them
+ * and finds the centroid of each voxel, with every step running on several threads.  Only occupied voxels are stored,
+ * as one sorted array of codes.
+ *
+ * Because the codes are sorted, the voxels under any octree node are next to each other, and the node at level `L`
+ * containing a voxel is just its code shifted right by `3L` bits.  Occupancy can therefore be checked at any level by
+ * searching the codes, where level zero is a single voxel and each level above doubles the size of a node.
+ *
+ * The centroids make up a voxel-grid downsampling filter, replacing the points in each voxel with their average.
+ */
+class VoxelGrid {
+public:
+// Constants
+    static const int MAX_LEVEL = 21; ///< Level of the octree node covering every voxel
+    static const size_t MAX_VOXELS_PER_AXIS = 2097152; ///< Most voxels the points can span along any axis
+// Methods
+    explicit VoxelGrid();
+    explicit VoxelGrid(double voxelSize);
+    void build(const Vec3Array& points);
+    size_t countNodes(int level) const;
+    static void downsample(const Vec3Array& points, double voxelSize, Vec3Array& result);
+    bool findVoxel(const Vec3& point, size_t& voxel) const;
+    const Vec3Array& getCentroids() const;
+    const uint64_t* getCodes() const;
+    const uint32_t* getIndices() const;
+    const uint32_t* getOffsets() const;
+    Vec3 getOrigin() const;
+    size_t getVoxelCount() const;
+    double getVoxelSize() const;
+    bool isOccupied(const Vec3& point, int level = 0) const;
+    size_t markOccupied(const Vec3Array& queries, int level, std::vector<uint32_t>& mask) const;
+private:
+// Types
+    class CentroidTask;
+    class CodeTask;
+    class OccupancyTask;
+// Constants
+    static const size_t GRAIN_SIZE = 65536;
+// Attributes
+    double voxelSize;
+    double inverseVoxelSize;
+    Vec3 origin;
+    std::vector<uint64_t> codes;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> indices;
+    Vec3Array centroids;
+// Helpers
+    double findBoundary(double value) const;
+    bool findCode(const Vec3& point, uint64_t& code) const;
+    bool hasNode(uint64_t code, int level) const;
+};
+
+} /* namespace M3d */
+#endif
@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2012, Andrew Brown
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "m3d/common.h"
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <stdexcept>
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include "m3d/VoxelGrid.h"
+using namespace std;
+
+/*
+ * Constants
+ */
+const double TOLERANCE = 1e-9;
+
+
+/**
+ * Unit test for VoxelGrid.
+ */
+class VoxelGridTest : public CppUnit::TestFixture {
+private:
+    M3d::Vec3Array points;
+
+    /**
+     * Returns a random number in a range.
+     */
+    static double random(double lower, double upper) {
+        return lower + (upper - lower) * (rand() / (double) RAND_MAX);
+    }
+
+    /**
+     * Makes an array of random points in a cube.
+     */
+    static M3d::Vec3Array randomPoints(size_t size, double extent) {
+        M3d::Vec3Array arr(size);
+        for (size_t i = 0; i < size; ++i) {
+            arr.set(i, M3d::Vec3(random(-extent, extent), random(-extent, extent), random(-extent, extent)));
+        }
+        return arr;
+    }
+
+    /**
+     * Finds the integer coordinates of the voxel holding a point, relative to an origin.
+     */
+    static M3d::Vec3 findVoxel(const M3d::Vec3& point, const M3d::Vec3& origin, double size) {
+        const M3d::Vec3 cell = (point - origin) / size;
+        return M3d::Vec3(floor(cell.x), floor(cell.y), floor(cell.z));
+    }
+
+public:
+
+    /**
+     * Prepares the fixture before running each test case.
+     */
+    void setUp() {
+        points = randomPoints(5000, 10);
+    }
+
+    /**
+     * Restores the default number of threads after each test case.
+     */
+    void tearDown() {
+        M3d::Parallel::setConcurrency(0);
+    }
+
+    /**
+     * Ensures the constructor rejects voxels without a positive size.
+     */
+    void testConstructorInvalid() {
+        CPPUNIT_ASSERT_THROW(M3d::VoxelGrid(-1), invalid_argument);
+    }
+
+    /**
+     * Ensures build groups points by voxel and averages each voxel, the same as bucketing them in a map.
+     */
+    void testBuild() {
+
+        M3d::Parallel::setConcurrency(4);
+        M3d::VoxelGrid grid(2.5);
+        grid.build(points);
+
+        // Bucket points in a map
+        const M3d::Vec3 origin = grid.getOrigin();
+        map<uint64_t, pair<M3d::Vec3,size_t> > buckets;
+        for (size_t i = 0; i < points.size(); ++i) {
+            const M3d::Vec3 v = findVoxel(points.get(i), origin, 2.5);
+            CPPUNIT_ASSERT(v.x >= 0 && v.y >= 0 && v.z >= 0);
+            const uint64_t code = M3d::encodeMorton63((uint32_t) v.x, (uint32_t) v.y, (uint32_t) v.z);
+            pair<M3d::Vec3,size_t>& bucket = buckets[code];
+            bucket.first = bucket.first + points.get(i);
+            ++bucket.second;
+        }
+
+        // Compare
+        CPPUNIT_ASSERT_EQUAL(buckets.size(), grid.getVoxelCount());
+        size_t v = 0;
+        for (map<uint64_t, pair<M3d::Vec3,size_t> >::const_iterator it = buckets.begin(); it != buckets.end(); ++it) {
+            CPPUNIT_ASSERT_EQUAL(it->first, grid.getCodes()[v]);
+            CPPUNIT_ASSERT_EQUAL(it->second.second, (size_t) (grid.getOffsets()[v + 1] - grid.getOffsets()[v]));
+            const M3d::Vec3 centroid = it->second.first / (double) it->second.second;
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(centroid.x, grid.getCentroids().x[v], TOLERANCE);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(centroid.y, grid.getCentroids().y[v], TOLERANCE);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(centroid.z, grid.getCentroids().z[v], TOLERANCE);
+            ++v;
+        }
+        CPPUNIT_ASSERT_EQUAL(points.size(), (size_t) grid.getOffsets()[grid.getVoxelCount()]);
+    }
+
+    /**
+     * Ensures build rejects points spread over too many voxels.
+     */
+    void testBuildTooLarge() {
+        M3d::VoxelGrid grid(1e-6);
+        CPPUNIT_ASSERT_THROW(grid.build(points), out_of_range);
+    }
+
+    /**
+     * Ensures downsample gives the centroids of the grid.
+     */
+    void testDownsample() {
+
+        M3d::Vec3Array result;
+        M3d::VoxelGrid::downsample(points, 4, result);
+
+        M3d::VoxelGrid grid(4);
+        grid.build(points);
+        CPPUNIT_ASSERT_EQUAL(grid.getVoxelCount(), result.size());
+        CPPUNIT_ASSERT(result.size() < points.size());
+        for (size_t i = 0; i < result.size(); ++i) {
+            CPPUNIT_ASSERT_EQUAL(grid.getCentroids().x[i], result.x[i]);
+        }
+    }
+
+    /**
+     * Ensures findVoxel finds the voxel each point was put in.
+     */
+    void testFindVoxel() {
+
+        M3d::VoxelGrid grid(1.5);
+        grid.build(points);
+
+        for (size_t v = 0; v < grid.getVoxelCount(); ++v) {
+            for (uint32_t i = grid.getOffsets()[v]; i < grid.getOffsets()[v + 1]; ++i) {
+                size_t voxel = grid.getVoxelCount();
+                CPPUNIT_ASSERT(grid.findVoxel(points.get(grid.getIndices()[i]), voxel));
+                CPPUNIT_ASSERT_EQUAL(v, voxel);
+            }
+        }
+        size_t voxel;
+        CPPUNIT_ASSERT(!grid.findVoxel(M3d::Vec3(-100, 0, 0), voxel));
+    }
+
+    /**
+     * Ensures isOccupied and countNodes agree with the voxel coordinates at every level.
+     */
+    void testIsOccupied() {
+
+        M3d::Vec3Array sparse = randomPoints(200, 40);
+        M3d::VoxelGrid grid(1);
+        grid.build(sparse);
+        const M3d::Vec3 origin = grid.getOrigin();
+
+        for (int level = 0; level <= 4; ++level) {
+            const double scale = 1 << level;
+            map<uint64_t, bool> nodes;
+            for (size_t i = 0; i < sparse.size(); ++i) {
+                const M3d::Vec3 v = findVoxel(sparse.get(i), origin, scale);
+                nodes[M3d::encodeMorton63((uint32_t) v.x, (uint32_t) v.y, (uint32_t) v.z)] = true;
+            }
+            CPPUNIT_ASSERT_EQUAL(nodes.size(), grid.countNodes(level));
+            for (size_t i = 0; i < 500; ++i) {
+                const M3d::Vec3 query(random(-40, 40), random(-40, 40), random(-40, 40));
+                const M3d::Vec3 v = findVoxel(query, origin, scale);
+                const bool expected = (v.x >= 0 && v.y >= 0 && v.z >= 0)
+                        && nodes.count(M3d::encodeMorton63((uint32_t) v.x, (uint32_t) v.y, (uint32_t) v.z)) > 0;
+                CPPUNIT_ASSERT_EQUAL(expected, grid.isOccupied(query, level));
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL((size_t) 1, grid.countNodes(M3d::VoxelGrid::MAX_LEVEL));
+        CPPUNIT_ASSERT_THROW(grid.isOccupied(origin, M3d::VoxelGrid::MAX_LEVEL + 1), out_of_range);
+    }
+
+    /**
+     * Ensures the batch occupancy check agrees with the single one on several threads.
+     */
+    void testMarkOccupied() {
+
+        M3d::VoxelGrid grid(0.5);
+        grid.build(points);
+
+        const M3d::Vec3Array queries = randomPoints(100000, 11);
+        M3d::Parallel::setConcurrency(4);
+        vector<uint32_t> mask;
+        const size_t count = grid.markOccupied(queries, 1, mask);
+
+        CPPUNIT_ASSERT_EQUAL((queries.size() + 31) / 32, mask.size());
+        size_t expected = 0;
+        for (size_t i = 0; i < queries.size(); ++i) {
+            const bool occupied = grid.isOccupied(queries.get(i), 1);
+            CPPUNIT_ASSERT_EQUAL(occupied, M3d::Bitmask::get(mask, i));
+            expected += occupied ? 1 : 0;
+        }
+        CPPUNIT_ASSERT_EQUAL(expected, count);
+        CPPUNIT_ASSERT(count > 0 && count < queries.size());
+    }
+
+    CPPUNIT_TEST_SUITE(VoxelGridTest);
+    CPPUNIT_TEST(testConstructorInvalid);
+    CPPUNIT_TEST(testBuild);
+    CPPUNIT_TEST(testBuildTooLarge);
+    CPPUNIT_TEST(testDownsample);
+    CPPUNIT_TEST(testFindVoxel);
+    CPPUNIT_TEST(testIsOccupied);
+    CPPUNIT_TEST(testMarkOccupied);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+int main(int argc, char *argv[]) {
+    CppUnit::TextUi::TestRunner runner;
+    runner.addTest(VoxelGridTest::suite());
+    runner.run();
+    return 0;
+}